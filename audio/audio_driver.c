@@ -28,6 +28,12 @@
 #define AUDIO_BUFFER_FREE_SAMPLES_COUNT (8 * 1024)
 #endif
 
+/* Samples pushed through the whole convert/DSP/resample chain
+ * at a time, so intermediate data stays in L1. */
+#ifndef AUDIO_BLOCK_SAMPLES
+#define AUDIO_BLOCK_SAMPLES 512
+#endif
+
 typedef struct audio_driver_input_data
 {
    float *data;
@@ -43,6 +49,7 @@ typedef struct audio_driver_input_data
    bool use_float;
 
    float *outsamples;
+   float *block_outsamples;
    int16_t *conv_outsamples;
 
    int16_t *rewind_buf;
@@ -295,6 +302,10 @@ void uninit_audio(void)
       free(audio_data.outsamples);
    audio_data.outsamples = NULL;
 
+   if (audio_data.block_outsamples)
+      free(audio_data.block_outsamples);
+   audio_data.block_outsamples = NULL;
+
    event_command(EVENT_CMD_DSP_FILTER_DEINIT);
 
    compute_audio_buffer_statistics();
@@ -394,7 +405,9 @@ void init_audio(void)
 
    if (!rarch_resampler_realloc(&driver->resampler_data,
             &driver->resampler,
-         settings->audio.resampler, audio_data.orig_src_ratio))
+         settings->audio.resampler,
+         (enum resampler_quality)settings->audio.resampler_quality,
+         audio_data.orig_src_ratio))
    {
       RARCH_ERR("Failed to initialize resampler \"%s\".\n",
             settings->audio.resampler);
@@ -402,7 +415,7 @@ void init_audio(void)
    }
 
    retro_assert(audio_data.data = (float*)
-         malloc(max_bufsamples * sizeof(float)));
+         malloc(AUDIO_BLOCK_SAMPLES * sizeof(float)));
 
    if (!audio_data.data)
       goto error;
@@ -417,6 +430,13 @@ void init_audio(void)
    if (!audio_data.outsamples)
       goto error;
 
+   retro_assert(audio_data.block_outsamples = (float*)
+         malloc(AUDIO_BLOCK_SAMPLES * AUDIO_MAX_RATIO *
+            settings->slowmotion_ratio * sizeof(float)));
+
+   if (!audio_data.block_outsamples)
+      goto error;
+
    audio_data.rate_control = false;
    if (!audio_data.audio_callback.callback && driver->audio_active &&
          settings->audio.rate_control)
@@ -557,12 +577,19 @@ void audio_driver_set_nonblocking_state(bool enable)
  * Writes audio samples to audio driver. Will first
  * perform DSP processing (if enabled) and resampling.
  *
+ * The samples are processed AUDIO_BLOCK_SAMPLES at a time,
+ * each block going through every stage before the next
+ * one is converted.
+ *
  * Returns: true (1) if audio samples were written to the audio
  * driver, false (0) in case of an error.
  **/
 bool audio_driver_flush(const int16_t *data, size_t samples)
 {
+   size_t i;
+   ssize_t written;
    bool is_slowmotion, is_paused;
+   retro_time_t output_start, output_time;
    static struct retro_perf_counter audio_convert_s16 = {0};
    static struct retro_perf_counter audio_convert_float = {0};
    static struct retro_perf_counter audio_dsp         = {0};
@@ -595,32 +622,9 @@ bool audio_driver_flush(const int16_t *data, size_t samples)
       return false;
 
    rarch_perf_init(&audio_convert_s16, "audio_convert_s16");
-   retro_perf_start(&audio_convert_s16);
-   audio_convert_s16_to_float(audio_data.data, data, samples,
-         audio_data.volume_gain);
-   retro_perf_stop(&audio_convert_s16);
-
-   src_data.data_in               = audio_data.data;
-   src_data.input_frames          = samples >> 1;
-
-   dsp_data.input                 = audio_data.data;
-   dsp_data.input_frames          = samples >> 1;
-
-   if (audio_data.dsp)
-   {
-      rarch_perf_init(&audio_dsp, "audio_dsp");
-      retro_perf_start(&audio_dsp);
-      rarch_dsp_filter_process(audio_data.dsp, &dsp_data);
-      retro_perf_stop(&audio_dsp);
-
-      if (dsp_data.output)
-      {
-         src_data.data_in      = dsp_data.output;
-         src_data.input_frames = dsp_data.output_frames;
-      }
-   }
-
-   src_data.data_out = audio_data.outsamples;
+   rarch_perf_init(&audio_dsp, "audio_dsp");
+   rarch_perf_init(&resampler_proc, "resampler_proc");
+   rarch_perf_init(&audio_convert_float, "audio_convert_float");
 
    if (audio_data.rate_control)
       audio_driver_readjust_input_rate();
@@ -632,28 +636,75 @@ bool audio_driver_flush(const int16_t *data, size_t samples)
    if (is_slowmotion)
       src_data.ratio *= settings->slowmotion_ratio;
 
-   rarch_perf_init(&resampler_proc, "resampler_proc");
-   retro_perf_start(&resampler_proc);
-   rarch_resampler_process(driver->resampler,
-         driver->resampler_data, &src_data);
-   retro_perf_stop(&resampler_proc);
+   for (i = 0; i < samples; i += AUDIO_BLOCK_SAMPLES)
+   {
+      size_t block = samples - i;
 
-   output_data   = audio_data.outsamples;
-   output_frames = src_data.output_frames;
+      if (block > AUDIO_BLOCK_SAMPLES)
+         block = AUDIO_BLOCK_SAMPLES;
 
-   if (!audio_data.use_float)
-   {
-      rarch_perf_init(&audio_convert_float, "audio_convert_float");
-      retro_perf_start(&audio_convert_float);
-      audio_convert_float_to_s16(audio_data.conv_outsamples,
-            (const float*)output_data, output_frames * 2);
-      retro_perf_stop(&audio_convert_float);
+      retro_perf_start(&audio_convert_s16);
+      audio_convert_s16_to_float(audio_data.data, data + i, block,
+            audio_data.volume_gain);
+      retro_perf_stop(&audio_convert_s16);
 
-      output_data = audio_data.conv_outsamples;
-      output_size = sizeof(int16_t);
+      src_data.data_in               = audio_data.data;
+      src_data.input_frames          = block >> 1;
+
+      if (audio_data.dsp)
+      {
+         dsp_data.input              = audio_data.data;
+         dsp_data.input_frames       = block >> 1;
+
+         retro_perf_start(&audio_dsp);
+         rarch_dsp_filter_process(audio_data.dsp, &dsp_data);
+         retro_perf_stop(&audio_dsp);
+
+         if (dsp_data.output)
+         {
+            src_data.data_in      = dsp_data.output;
+            src_data.input_frames = dsp_data.output_frames;
+         }
+      }
+
+      /* Float output can be resampled straight into place,
+       * otherwise go through a block-sized scratch buffer. */
+      src_data.data_out = audio_data.use_float ?
+         audio_data.outsamples + output_frames * 2 :
+         audio_data.block_outsamples;
+
+      retro_perf_start(&resampler_proc);
+      rarch_resampler_process(driver->resampler,
+            driver->resampler_data, &src_data);
+      retro_perf_stop(&resampler_proc);
+
+      if (!audio_data.use_float)
+      {
+         /* The input may live in conv_outsamples (see
+          * audio_driver_sample), so collect the converted
+          * output in outsamples instead. */
+         retro_perf_start(&audio_convert_float);
+         audio_convert_float_to_s16(
+               (int16_t*)audio_data.outsamples + output_frames * 2,
+               audio_data.block_outsamples, src_data.output_frames * 2);
+         retro_perf_stop(&audio_convert_float);
+      }
+
+      output_frames += src_data.output_frames;
    }
 
-   if (audio->write(driver->audio_data, output_data, output_frames * output_size * 2) < 0)
+   output_data = audio_data.outsamples;
+
+   if (!audio_data.use_float)
+      output_size = sizeof(int16_t);
+
+   output_start = retro_get_time_usec();
+   written      = audio->write(driver->audio_data, output_data,
+         output_frames * output_size * 2);
+   output_time  = retro_get_time_usec() - output_start;
+   rarch_main_ctl(RARCH_MAIN_CTL_ADD_OUTPUT_TIME, &output_time);
+
+   if (written < 0)
    {
       driver->audio_active = false;
       return false;
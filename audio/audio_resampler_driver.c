@@ -17,6 +17,7 @@
 #include "audio_resampler_driver.h"
 #ifdef RARCH_INTERNAL
 #include "../performance.h"
+#include "../configuration.h"
 #endif
 #include <file/config_file_userdata.h>
 #include <string.h>
@@ -38,6 +39,7 @@ static const struct resampler_config resampler_config = {
    config_userdata_get_int_array,
    config_userdata_get_string,
    config_userdata_free,
+   NULL,
 };
 
 /**
@@ -148,6 +150,7 @@ static resampler_simd_mask_t resampler_get_cpu_features(void)
  * resampler_append_plugs:
  * @re                         : Resampler handle
  * @backend                    : Resampler backend that is about to be set.
+ * @quality                    : Quality tier.
  * @bw_ratio                   : Bandwidth ratio.
  *
  * Initializes resampler driver based on queried CPU features.
@@ -156,11 +159,19 @@ static resampler_simd_mask_t resampler_get_cpu_features(void)
  **/
 static bool resampler_append_plugs(void **re,
       const rarch_resampler_t **backend,
+      enum resampler_quality quality,
       double bw_ratio)
 {
-   resampler_simd_mask_t mask = resampler_get_cpu_features();
+   struct resampler_config config = resampler_config;
+   resampler_simd_mask_t mask     = resampler_get_cpu_features();
+#ifdef RARCH_INTERNAL
+   settings_t *settings           = config_get_ptr();
+
+   if (settings)
+      config.cache_dir = settings->cache_directory;
+#endif
 
-   *re = (*backend)->init(&resampler_config, bw_ratio, mask);
+   *re = (*backend)->init(&config, bw_ratio, quality, mask);
 
    if (!*re)
       return false;
@@ -172,6 +183,7 @@ static bool resampler_append_plugs(void **re,
  * @re                         : Resampler handle
  * @backend                    : Resampler backend that is about to be set.
  * @ident                      : Identifier name for resampler we want.
+ * @quality                    : Quality tier, for resamplers that have them.
  * @bw_ratio                   : Bandwidth ratio.
  *
  * Reallocates resampler. Will free previous handle before 
@@ -180,7 +192,7 @@ static bool resampler_append_plugs(void **re,
  * Returns: true (1) if successful, otherwise false (0).
  **/
 bool rarch_resampler_realloc(void **re, const rarch_resampler_t **backend,
-      const char *ident, double bw_ratio)
+      const char *ident, enum resampler_quality quality, double bw_ratio)
 {
    if (*re && *backend)
       (*backend)->free(*re);
@@ -188,7 +200,7 @@ bool rarch_resampler_realloc(void **re, const rarch_resampler_t **backend,
    *re      = NULL;
    *backend = find_resampler_driver(ident);
 
-   if (!resampler_append_plugs(re, backend, bw_ratio))
+   if (!resampler_append_plugs(re, backend, quality, bw_ratio))
       goto error;
 
    return true;
@@ -103,12 +103,27 @@ struct resampler_config
    /* Avoid problems where resampler plug and host are 
     * linked against different C runtimes. */
    resampler_config_free_t free; 
+
+   /* Directory resamplers may cache precomputed data in.
+    * NULL or empty if caching is not wanted. */
+   const char *cache_dir;
+};
+
+enum resampler_quality
+{
+   RESAMPLER_QUALITY_DONTCARE = 0,
+   RESAMPLER_QUALITY_LOWEST,
+   RESAMPLER_QUALITY_LOWER,
+   RESAMPLER_QUALITY_NORMAL,
+   RESAMPLER_QUALITY_HIGHER,
+   RESAMPLER_QUALITY_HIGHEST
 };
 
 /* Bandwidth factor. Will be < 1.0 for downsampling, > 1.0 for upsampling. 
  * Corresponds to expected resampling ratio. */
 typedef void *(*resampler_init_t)(const struct resampler_config *config,
-      double bandwidth_mod, resampler_simd_mask_t mask);
+      double bandwidth_mod, enum resampler_quality quality,
+      resampler_simd_mask_t mask);
 
 /* Frees the handle. */
 typedef void (*resampler_free_t)(void *data);
@@ -177,6 +192,7 @@ const char *audio_resampler_driver_find_ident(int index);
  * @re                         : Resampler handle
  * @backend                    : Resampler backend that is about to be set.
  * @ident                      : Identifier name for resampler we want.
+ * @quality                    : Quality tier, for resamplers that have them.
  * @bw_ratio                   : Bandwidth ratio.
  *
  * Reallocates resampler. Will free previous handle before 
@@ -185,7 +201,7 @@ const char *audio_resampler_driver_find_ident(int index);
  * Returns: true (1) if successful, otherwise false (0).
  **/
 bool rarch_resampler_realloc(void **re, const rarch_resampler_t **backend,
-      const char *ident, double bw_ratio);
+      const char *ident, enum resampler_quality quality, double bw_ratio);
 
 /* Convenience macros.
  * freep makes sure to set handles to NULL to avoid double-free 
@@ -18,7 +18,6 @@
 #include <rthreads/rthreads.h>
 #include "../general.h"
 #include "../performance.h"
-#include <queues/fifo_buffer.h>
 #include <stdlib.h>
 #include <string.h>
 
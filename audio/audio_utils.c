@@ -17,7 +17,9 @@
 #include <boolean.h>
 #include "audio_utils.h"
 
-#if defined(__SSE2__)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
 #include <emmintrin.h>
 #elif defined(__ALTIVEC__)
 #include <altivec.h>
@@ -25,6 +27,8 @@
 
 #ifdef RARCH_INTERNAL
 #include "../performance.h"
+#else
+#include "../libretro.h"
 #endif
 
 /**
@@ -138,6 +142,77 @@ void audio_convert_float_to_s16_SSE2(int16_t *out,
 
    audio_convert_float_to_s16_C(out, in, samples - i);
 }
+
+#if defined(__AVX2__)
+/**
+ * audio_convert_s16_to_float_AVX2:
+ * @out               : output buffer
+ * @in                : input buffer
+ * @samples           : size of samples to be converted
+ * @gain              : gain applied to the audio volume
+ *
+ * Converts audio samples from signed integer 16-bit
+ * to floating point.
+ *
+ * AVX2 implementation callback function.
+ **/
+void audio_convert_s16_to_float_AVX2(float *out,
+      const int16_t *in, size_t samples, float gain)
+{
+   size_t i;
+   __m256 factor = _mm256_set1_ps(gain / 0x8000);
+
+   for (i = 0; i + 16 <= samples; i += 16, in += 16, out += 16)
+   {
+      __m128i input_l = _mm_loadu_si128((const __m128i *)(in + 0));
+      __m128i input_r = _mm_loadu_si128((const __m128i *)(in + 8));
+      __m256 output_l = _mm256_mul_ps(
+            _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(input_l)), factor);
+      __m256 output_r = _mm256_mul_ps(
+            _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(input_r)), factor);
+
+      _mm256_storeu_ps(out + 0, output_l);
+      _mm256_storeu_ps(out + 8, output_r);
+   }
+
+   audio_convert_s16_to_float_SSE2(out, in, samples - i, gain);
+}
+
+/**
+ * audio_convert_float_to_s16_AVX2:
+ * @out               : output buffer
+ * @in                : input buffer
+ * @samples           : size of samples to be converted
+ *
+ * Converts audio samples from floating point 
+ * to signed integer 16-bit.
+ *
+ * AVX2 implementation callback function.
+ **/
+void audio_convert_float_to_s16_AVX2(int16_t *out,
+      const float *in, size_t samples)
+{
+   size_t i;
+   __m256 factor = _mm256_set1_ps((float)0x8000);
+
+   for (i = 0; i + 16 <= samples; i += 16, in += 16, out += 16)
+   {
+      __m256i ints_l = _mm256_cvtps_epi32(
+            _mm256_mul_ps(_mm256_loadu_ps(in + 0), factor));
+      __m256i ints_r = _mm256_cvtps_epi32(
+            _mm256_mul_ps(_mm256_loadu_ps(in + 8), factor));
+
+      /* packs works within 128-bit lanes, so
+       * the middle quadwords need swapping back. */
+      __m256i packed = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(ints_l, ints_r), _MM_SHUFFLE(3, 1, 2, 0));
+
+      _mm256_storeu_si256((__m256i *)out, packed);
+   }
+
+   audio_convert_float_to_s16_SSE2(out, in, samples - i);
+}
+#endif
 #elif defined(__ALTIVEC__)
 /**
  * audio_convert_s16_to_float_altivec:
@@ -28,8 +28,42 @@ extern "C" {
 #endif
 
 #if defined(__SSE2__)
+#if defined(__AVX2__)
+#define audio_convert_s16_to_float audio_convert_s16_to_float_AVX2
+#define audio_convert_float_to_s16 audio_convert_float_to_s16_AVX2
+
+/**
+ * audio_convert_s16_to_float_AVX2:
+ * @out               : output buffer
+ * @in                : input buffer
+ * @samples           : size of samples to be converted
+ * @gain              : gain applied to the audio volume
+ *
+ * Converts audio samples from signed integer 16-bit
+ * to floating point.
+ *
+ * AVX2 implementation callback function.
+ **/
+void audio_convert_s16_to_float_AVX2(float *out,
+      const int16_t *in, size_t samples, float gain);
+
+/**
+ * audio_convert_float_to_s16_AVX2:
+ * @out               : output buffer
+ * @in                : input buffer
+ * @samples           : size of samples to be converted
+ *
+ * Converts audio samples from floating point 
+ * to signed integer 16-bit.
+ *
+ * AVX2 implementation callback function.
+ **/
+void audio_convert_float_to_s16_AVX2(int16_t *out,
+      const float *in, size_t samples);
+#else
 #define audio_convert_s16_to_float audio_convert_s16_to_float_SSE2
 #define audio_convert_float_to_s16 audio_convert_float_to_s16_SSE2
+#endif
 
 /**
  * audio_convert_s16_to_float_SSE2:
@@ -19,7 +19,7 @@
 #include <alsa/asoundlib.h>
 
 #include <rthreads/rthreads.h>
-#include <queues/fifo_buffer.h>
+#include <queues/spsc_ring.h>
 
 #include "../../driver.h"
 #include "../../general.h"
@@ -28,6 +28,10 @@
                   goto error; \
                }
 
+/* Upper bound on a blocking write's sleep, so it can
+ * notice that the worker thread died. */
+#define ALSA_THREAD_WAIT_US 100000
+
 typedef struct alsa_thread
 {
    snd_pcm_t *pcm;
@@ -40,11 +44,8 @@ typedef struct alsa_thread
    size_t period_size;
    snd_pcm_uframes_t period_frames;
 
-   fifo_buffer_t *buffer;
+   spsc_ring_t *buffer;
    sthread_t *worker_thread;
-   slock_t *fifo_lock;
-   scond_t *cond;
-   slock_t *cond_lock;
 } alsa_thread_t;
 
 static void alsa_worker_thread(void *data)
@@ -60,15 +61,9 @@ static void alsa_worker_thread(void *data)
 
    while (!alsa->thread_dead)
    {
-      size_t avail;
-      size_t fifo_size;
       snd_pcm_sframes_t frames;
-      slock_lock(alsa->fifo_lock);
-      avail = fifo_read_avail(alsa->buffer);
-      fifo_size = min(alsa->period_size, avail);
-      fifo_read(alsa->buffer, buf, fifo_size);
-      scond_signal(alsa->cond);
-      slock_unlock(alsa->fifo_lock);
+      size_t fifo_size = spsc_ring_read(alsa->buffer,
+            buf, alsa->period_size);
 
       /* If underrun, fill rest with silence. */
       memset(buf + fifo_size, 0, alsa->period_size - fifo_size);
@@ -96,10 +91,8 @@ static void alsa_worker_thread(void *data)
    }
 
 end:
-   slock_lock(alsa->cond_lock);
    alsa->thread_dead = true;
-   scond_signal(alsa->cond);
-   slock_unlock(alsa->cond_lock);
+   spsc_ring_wake(alsa->buffer);
    free(buf);
 }
 
@@ -133,13 +126,7 @@ static void alsa_thread_free(void *data)
          sthread_join(alsa->worker_thread);
       }
       if (alsa->buffer)
-         fifo_free(alsa->buffer);
-      if (alsa->cond)
-         scond_free(alsa->cond);
-      if (alsa->fifo_lock)
-         slock_free(alsa->fifo_lock);
-      if (alsa->cond_lock)
-         slock_free(alsa->cond_lock);
+         spsc_ring_free(alsa->buffer);
       if (alsa->pcm)
       {
          snd_pcm_drop(alsa->pcm);
@@ -211,11 +198,8 @@ static void *alsa_thread_init(const char *device,
    snd_pcm_hw_params_free(params);
    snd_pcm_sw_params_free(sw_params);
 
-   alsa->fifo_lock = slock_new();
-   alsa->cond_lock = slock_new();
-   alsa->cond = scond_new();
-   alsa->buffer = fifo_new(alsa->buffer_size);
-   if (!alsa->fifo_lock || !alsa->cond_lock || !alsa->cond || !alsa->buffer)
+   alsa->buffer = spsc_ring_new(alsa->buffer_size);
+   if (!alsa->buffer)
       goto error;
 
    alsa->worker_thread = sthread_create(alsa_worker_thread, alsa);
@@ -248,40 +232,18 @@ static ssize_t alsa_thread_write(void *data, const void *buf, size_t size)
       return -1;
 
    if (alsa->nonblock)
-   {
-      size_t avail;
-      size_t write_amt;
-      slock_lock(alsa->fifo_lock);
-      avail = fifo_write_avail(alsa->buffer);
-      write_amt = min(avail, size);
-      fifo_write(alsa->buffer, buf, write_amt);
-      slock_unlock(alsa->fifo_lock);
-      return write_amt;
-   }
+      return spsc_ring_write(alsa->buffer, buf, size);
    else
    {
       size_t written = 0;
       while (written < size && !alsa->thread_dead)
       {
-         size_t avail;
-         slock_lock(alsa->fifo_lock);
-         avail = fifo_write_avail(alsa->buffer);
+         size_t write_amt = spsc_ring_write(alsa->buffer,
+               (const char*)buf + written, size - written);
 
-         if (avail == 0)
-         {
-            slock_unlock(alsa->fifo_lock);
-            slock_lock(alsa->cond_lock);
-            if (!alsa->thread_dead)
-               scond_wait(alsa->cond, alsa->cond_lock);
-            slock_unlock(alsa->cond_lock);
-         }
-         else
-         {
-            size_t write_amt = min(size - written, avail);
-            fifo_write(alsa->buffer, (const char*)buf + written, write_amt);
-            slock_unlock(alsa->fifo_lock);
-            written += write_amt;
-         }
+         if (write_amt == 0)
+            spsc_ring_wait_write(alsa->buffer, 1, ALSA_THREAD_WAIT_US);
+         written += write_amt;
       }
       return written;
    }
@@ -322,14 +284,10 @@ static bool alsa_thread_start(void *data)
 static size_t alsa_thread_write_avail(void *data)
 {
    alsa_thread_t *alsa = (alsa_thread_t*)data;
-   size_t val;
 
    if (alsa->thread_dead)
       return 0;
-   slock_lock(alsa->fifo_lock);
-   val = fifo_write_avail(alsa->buffer);
-   slock_unlock(alsa->fifo_lock);
-   return val;
+   return spsc_ring_write_avail(alsa->buffer);
 }
 
 static size_t alsa_thread_buffer_size(void *data)
@@ -27,8 +27,7 @@
 #include <AudioUnit/AUComponent.h>
 
 #include <boolean.h>
-#include <queues/fifo_buffer.h>
-#include <rthreads/rthreads.h>
+#include <queues/spsc_ring.h>
 #include <retro_endianness.h>
 
 #include "../../driver.h"
@@ -42,11 +41,16 @@
 
 #endif
 
+/* How long a blocking write sleeps before it rechecks; on iOS
+ * a full timeout means the audio session was interrupted. */
+#if TARGET_OS_IPHONE
+#define COREAUDIO_WAIT_US 3000000
+#else
+#define COREAUDIO_WAIT_US 100000
+#endif
+
 typedef struct coreaudio
 {
-   slock_t *lock;
-   scond_t *cond;
-
 #ifdef OSX_PPC
    ComponentInstance dev;
 #else
@@ -55,7 +59,7 @@ typedef struct coreaudio
    bool dev_alive;
    bool is_paused;
 
-   fifo_buffer_t *buffer;
+   spsc_ring_t *buffer;
    bool nonblock;
    size_t buffer_size;
 } coreaudio_t;
@@ -80,10 +84,7 @@ static void coreaudio_free(void *data)
    }
 
    if (dev->buffer)
-      fifo_free(dev->buffer);
-
-   slock_free(dev->lock);
-   scond_free(dev->cond);
+      spsc_ring_free(dev->buffer);
 
    free(dev);
 }
@@ -109,25 +110,16 @@ static OSStatus audio_write_cb(void *userdata,
    write_avail = io_data->mBuffers[0].mDataByteSize;
    outbuf = io_data->mBuffers[0].mData;
 
-   slock_lock(dev->lock);
-
-   if (fifo_read_avail(dev->buffer) < write_avail)
+   if (spsc_ring_read_avail(dev->buffer) < write_avail)
    {
       *action_flags = kAudioUnitRenderAction_OutputIsSilence;
 
       /* Seems to be needed. */
       memset(outbuf, 0, write_avail);
-
-      slock_unlock(dev->lock);
-
-      /* Technically possible to deadlock without. */
-      scond_signal(dev->cond); 
       return noErr;
    }
 
-   fifo_read(dev->buffer, outbuf, write_avail);
-   slock_unlock(dev->lock);
-   scond_signal(dev->cond);
+   spsc_ring_read(dev->buffer, outbuf, write_avail);
    return noErr;
 }
 
@@ -218,9 +210,6 @@ static void *coreaudio_init(const char *device,
    if (!dev)
       return NULL;
 
-   dev->lock = slock_new();
-   dev->cond = scond_new();
-
 #if TARGET_OS_IPHONE
    if (!session_initialized)
    {
@@ -319,7 +308,7 @@ static void *coreaudio_init(const char *device,
    fifo_size *= 2 * sizeof(float);
    dev->buffer_size = fifo_size;
 
-   dev->buffer = fifo_new(fifo_size);
+   dev->buffer = spsc_ring_new(fifo_size);
    if (!dev->buffer)
       goto error;
 
@@ -345,34 +334,23 @@ static ssize_t coreaudio_write(void *data, const void *buf_, size_t size)
 
    while (!g_interrupted && size > 0)
    {
-      size_t write_avail;
-
-      slock_lock(dev->lock);
-
-      write_avail = fifo_write_avail(dev->buffer);
-      if (write_avail > size)
-         write_avail = size;
+      size_t write_avail = spsc_ring_write(dev->buffer, buf, size);
 
-      fifo_write(dev->buffer, buf, write_avail);
       buf += write_avail;
       written += write_avail;
       size -= write_avail;
 
       if (dev->nonblock)
-      {
-         slock_unlock(dev->lock);
          break;
-      }
 
 #if TARGET_OS_IPHONE
-      if (write_avail == 0 && !scond_wait_timeout(
-               dev->cond, dev->lock, 3000000))
+      if (write_avail == 0 && !spsc_ring_wait_write(
+               dev->buffer, 1, COREAUDIO_WAIT_US))
          g_interrupted = true;
 #else
       if (write_avail == 0)
-         scond_wait(dev->cond, dev->lock);
+         spsc_ring_wait_write(dev->buffer, 1, COREAUDIO_WAIT_US);
 #endif
-      slock_unlock(dev->lock);
    }
 
    return written;
@@ -419,14 +397,8 @@ static bool coreaudio_use_float(void *data)
 
 static size_t coreaudio_write_avail(void *data)
 {
-   size_t avail;
    coreaudio_t *dev = (coreaudio_t*)data;
-
-   slock_lock(dev->lock);
-   avail = fifo_write_avail(dev->buffer);
-   slock_unlock(dev->lock);
-
-   return avail;
+   return spsc_ring_write_avail(dev->buffer);
 }
 
 static size_t coreaudio_buffer_size(void *data)
@@ -22,31 +22,28 @@
 #include "SDL_audio.h"
 
 #include <boolean.h>
-#include <rthreads/rthreads.h>
-#include <queues/fifo_buffer.h>
+#include <queues/spsc_ring.h>
 #include <retro_inline.h>
 
 #include "../../driver.h"
 #include "../../general.h"
 
+/* Wakeups come from the audio callback; the timeout only
+ * matters if SDL stops calling it. */
+#define SDL_AUDIO_WAIT_US 100000
+
 typedef struct sdl_audio
 {
    bool nonblock;
    bool is_paused;
 
-   slock_t *lock;
-   scond_t *cond;
-   fifo_buffer_t *buffer;
+   spsc_ring_t *buffer;
 } sdl_audio_t;
 
 static void sdl_audio_cb(void *data, Uint8 *stream, int len)
 {
    sdl_audio_t *sdl = (sdl_audio_t*)data;
-   size_t avail = fifo_read_avail(sdl->buffer);
-   size_t write_size = len > (int)avail ? avail : len;
-
-   fifo_read(sdl->buffer, stream, write_size);
-   scond_signal(sdl->cond);
+   size_t write_size = spsc_ring_read(sdl->buffer, stream, len);
 
    /* If underrun, fill rest with silence. */
    memset(stream + write_size, 0, len - write_size);
@@ -108,21 +105,23 @@ static void *sdl_audio_init(const char *device,
 
    settings->audio.out_rate = out.freq;
 
-   sdl->lock = slock_new();
-   sdl->cond = scond_new();
-
    RARCH_LOG("SDL audio: Requested %u ms latency, got %d ms\n", 
          latency, (int)(out.samples * 4 * 1000 / settings->audio.out_rate));
 
    /* Create a buffer twice as big as needed and prefill the buffer. */
    bufsize = out.samples * 4 * sizeof(int16_t);
    tmp = calloc(1, bufsize);
-   sdl->buffer = fifo_new(bufsize);
+   sdl->buffer = spsc_ring_new(bufsize);
 
-   if (tmp)
+   if (sdl->buffer && tmp)
+      spsc_ring_write(sdl->buffer, tmp, bufsize);
+   free(tmp);
+
+   if (!sdl->buffer)
    {
-      fifo_write(sdl->buffer, tmp, bufsize);
-      free(tmp);
+      SDL_CloseAudio();
+      free(sdl);
+      return NULL;
    }
 
    SDL_PauseAudio(0);
@@ -135,41 +134,19 @@ static ssize_t sdl_audio_write(void *data, const void *buf, size_t size)
    sdl_audio_t *sdl = (sdl_audio_t*)data;
 
    if (sdl->nonblock)
-   {
-      size_t avail, write_amt;
-
-      SDL_LockAudio();
-      avail = fifo_write_avail(sdl->buffer);
-      write_amt = avail > size ? size : avail;
-      fifo_write(sdl->buffer, buf, write_amt);
-      SDL_UnlockAudio();
-      ret = write_amt;
-   }
+      ret = spsc_ring_write(sdl->buffer, buf, size);
    else
    {
       size_t written = 0;
 
       while (written < size)
       {
-         size_t avail;
-
-         SDL_LockAudio();
-         avail = fifo_write_avail(sdl->buffer);
-
-         if (avail == 0)
-         {
-            SDL_UnlockAudio();
-            slock_lock(sdl->lock);
-            scond_wait(sdl->cond, sdl->lock);
-            slock_unlock(sdl->lock);
-         }
-         else
-         {
-            size_t write_amt = size - written > avail ? avail : size - written;
-            fifo_write(sdl->buffer, (const char*)buf + written, write_amt);
-            SDL_UnlockAudio();
-            written += write_amt;
-         }
+         size_t write_amt = spsc_ring_write(sdl->buffer,
+               (const char*)buf + written, size - written);
+
+         if (write_amt == 0)
+            spsc_ring_wait_write(sdl->buffer, 1, SDL_AUDIO_WAIT_US);
+         written += write_amt;
       }
       ret = written;
    }
@@ -218,9 +195,7 @@ static void sdl_audio_free(void *data)
 
    if (sdl)
    {
-      fifo_free(sdl->buffer);
-      slock_free(sdl->lock);
-      scond_free(sdl->cond);
+      spsc_ring_free(sdl->buffer);
    }
    free(sdl);
 }
@@ -17,6 +17,7 @@
 
 #include <math.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -25,6 +26,7 @@
 #endif
 
 #include <retro_inline.h>
+#include <retro_miscellaneous.h>
 #include <filters.h>
 #include <memalign.h>
 
@@ -38,50 +40,18 @@
  * HIGHEST: 140 dB
  */
 
-/* TODO, make all this more configurable. */
+/* Quality used when the caller doesn't care.
+ * The old compile-time switches still pick it. */
 #if defined(SINC_LOWEST_QUALITY)
-#define SINC_WINDOW_LANCZOS
-#define CUTOFF 0.98
-#define PHASE_BITS 12
-#define SINC_COEFF_LERP 0
-#define SUBPHASE_BITS 10
-#define SIDELOBES 2
-#define ENABLE_AVX 0
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_LOWEST
 #elif defined(SINC_LOWER_QUALITY)
-#define SINC_WINDOW_LANCZOS
-#define CUTOFF 0.98
-#define PHASE_BITS 12
-#define SUBPHASE_BITS 10
-#define SINC_COEFF_LERP 0
-#define SIDELOBES 4
-#define ENABLE_AVX 0
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_LOWER
 #elif defined(SINC_HIGHER_QUALITY)
-#define SINC_WINDOW_KAISER
-#define SINC_WINDOW_KAISER_BETA 10.5
-#define CUTOFF 0.90
-#define PHASE_BITS 10
-#define SUBPHASE_BITS 14
-#define SINC_COEFF_LERP 1
-#define SIDELOBES 32
-#define ENABLE_AVX 1
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_HIGHER
 #elif defined(SINC_HIGHEST_QUALITY)
-#define SINC_WINDOW_KAISER
-#define SINC_WINDOW_KAISER_BETA 14.5
-#define CUTOFF 0.962
-#define PHASE_BITS 10
-#define SUBPHASE_BITS 14
-#define SINC_COEFF_LERP 1
-#define SIDELOBES 128
-#define ENABLE_AVX 1
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_HIGHEST
 #else
-#define SINC_WINDOW_KAISER
-#define SINC_WINDOW_KAISER_BETA 5.5
-#define CUTOFF 0.825
-#define PHASE_BITS 8
-#define SUBPHASE_BITS 16
-#define SINC_COEFF_LERP 1
-#define SIDELOBES 8
-#define ENABLE_AVX 0
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_NORMAL
 #endif
 
 /* For the little amount of taps we're using,
@@ -89,16 +59,55 @@
  * AVX code is kept here though as by increasing number
  * of sinc taps, the AVX code is clearly faster than SSE1.
  */
+#define SINC_AVX_MIN_TAPS 32
+
+/* AVX can be built without -mavx on GCC-compatible compilers,
+ * so one x86 binary can pick it at runtime. */
+#if defined(__AVX__)
+#define SINC_HAVE_AVX
+#define SINC_AVX_TARGET
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SINC_HAVE_AVX
+#define SINC_AVX_TARGET __attribute__((target("avx")))
+#endif
 
-#if defined(__AVX__) && ENABLE_AVX
+#ifdef SINC_HAVE_AVX
 #include <immintrin.h>
 #endif
 
-#define PHASES (1 << (PHASE_BITS + SUBPHASE_BITS))
+#if defined(__ARM_NEON__) && !defined(VITA)
+#include <arm_neon.h>
+#endif
 
-#define TAPS (SIDELOBES * 2)
-#define SUBPHASE_MASK ((1 << SUBPHASE_BITS) - 1)
-#define SUBPHASE_MOD (1.0f / (1 << SUBPHASE_BITS))
+#define SINC_CACHE_MAGIC   0x434e4953 /* "SINC" */
+#define SINC_CACHE_VERSION 1
+
+enum sinc_window
+{
+   SINC_WINDOW_LANCZOS = 0,
+   SINC_WINDOW_KAISER
+};
+
+struct sinc_quality
+{
+   enum sinc_window window;
+   double kaiser_beta;
+   double cutoff;
+   unsigned phase_bits;
+   unsigned subphase_bits;
+   unsigned sidelobes;
+   bool lerp;
+};
+
+/* Indexed by enum resampler_quality. */
+static const struct sinc_quality sinc_qualities[] = {
+   { SINC_WINDOW_KAISER,   5.5,  0.825, 8,  16, 8,   true  }, /* DONTCARE */
+   { SINC_WINDOW_LANCZOS,  0.0,  0.98,  12, 10, 2,   false }, /* LOWEST */
+   { SINC_WINDOW_LANCZOS,  0.0,  0.98,  12, 10, 4,   false }, /* LOWER */
+   { SINC_WINDOW_KAISER,   5.5,  0.825, 8,  16, 8,   true  }, /* NORMAL */
+   { SINC_WINDOW_KAISER,   10.5, 0.90,  10, 14, 32,  true  }, /* HIGHER */
+   { SINC_WINDOW_KAISER,   14.5, 0.962, 10, 14, 128, true  }, /* HIGHEST */
+};
 
 typedef struct rarch_sinc_resampler
 {
@@ -111,25 +120,43 @@ typedef struct rarch_sinc_resampler
    unsigned ptr;
    uint32_t time;
 
+   uint32_t phases;
+   unsigned subphase_bits;
+   uint32_t subphase_mask;
+   float subphase_mod;
+
+   void (*process)(struct rarch_sinc_resampler *resamp, float *out_buffer);
+
    /* A buffer for phase_table, buffer_l and buffer_r 
     * are created in a single calloc().
     * Ensure that we get as good cache locality as we can hope for. */
    float *main_buffer;
 } rarch_sinc_resampler_t;
 
-#if defined(SINC_WINDOW_LANCZOS)
-#define window_function(idx)  (lanzcos_window_function(idx))
-#elif defined(SINC_WINDOW_KAISER)
-#define window_function(idx)  (kaiser_window_function(idx, SINC_WINDOW_KAISER_BETA))
-#else
-#error "No SINC window function defined."
-#endif
+struct sinc_cache_header
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t quality;
+   uint32_t taps;
+   uint32_t elems;
+   uint32_t pad;
+   double cutoff;
+};
+
+static INLINE double window_function(const struct sinc_quality *q,
+      double idx)
+{
+   if (q->window == SINC_WINDOW_KAISER)
+      return kaiser_window_function(idx, q->kaiser_beta);
+   return lanzcos_window_function(idx);
+}
 
-static void init_sinc_table(rarch_sinc_resampler_t *resamp, double cutoff,
+static void init_sinc_table(const struct sinc_quality *q, double cutoff,
       float *phase_table, int phases, int taps, bool calculate_delta)
 {
    int i, j;
-   double    window_mod = window_function(0.0); /* Need to normalize w(0) to 1.0. */
+   double    window_mod = window_function(q, 0.0); /* Need to normalize w(0) to 1.0. */
    int           stride = calculate_delta ? 2 : 1;
    double     sidelobes = taps / 2.0;
 
@@ -145,7 +172,7 @@ static void init_sinc_table(rarch_sinc_resampler_t *resamp, double cutoff,
          sinc_phase = sidelobes * window_phase;
 
          val = cutoff * sinc(M_PI * sinc_phase * cutoff) * 
-            window_function(window_phase) / window_mod;
+            window_function(q, window_phase) / window_mod;
          phase_table[i * stride * taps + j] = val;
       }
    }
@@ -176,16 +203,88 @@ static void init_sinc_table(rarch_sinc_resampler_t *resamp, double cutoff,
          sinc_phase = sidelobes * window_phase;
 
          val = cutoff * sinc(M_PI * sinc_phase * cutoff) * 
-            window_function(window_phase) / window_mod;
+            window_function(q, window_phase) / window_mod;
          delta = (val - phase_table[phase * stride * taps + j]);
          phase_table[(phase * stride + 1) * taps + j] = delta;
       }
    }
 }
 
-#if !(defined(__AVX__) && ENABLE_AVX) && !defined(__SSE__)
-static INLINE void process_sinc_C(rarch_sinc_resampler_t *resamp,
-      float *out_buffer)
+/**
+ * sinc_cache_path:
+ * @s                  : output path
+ * @len                : size of @s
+ * @dir                : cache directory
+ * @quality            : quality tier
+ * @taps               : number of taps
+ * @cutoff             : filter cutoff
+ *
+ * Builds the path a filter bank is cached at.
+ *
+ * Returns: false (0) if there is no cache directory.
+ **/
+static bool sinc_cache_path(char *s, size_t len, const char *dir,
+      unsigned quality, unsigned taps, double cutoff)
+{
+   if (!dir || !*dir)
+      return false;
+   snprintf(s, len, "%s/sinc-q%u-t%u-c%u.bin", dir, quality, taps,
+         (unsigned)(cutoff * 1000000.0));
+   return true;
+}
+
+static bool sinc_cache_load(const char *path, unsigned quality,
+      unsigned taps, double cutoff, float *table, size_t elems)
+{
+   struct sinc_cache_header header;
+   bool ret = false;
+   FILE *file = fopen(path, "rb");
+
+   if (!file)
+      return false;
+
+   if (fread(&header, sizeof(header), 1, file) == 1
+         && header.magic   == SINC_CACHE_MAGIC
+         && header.version == SINC_CACHE_VERSION
+         && header.quality == quality
+         && header.taps    == taps
+         && header.elems   == elems
+         && header.cutoff  == cutoff)
+      ret = fread(table, sizeof(float), elems, file) == elems;
+
+   fclose(file);
+   return ret;
+}
+
+static void sinc_cache_save(const char *path, unsigned quality,
+      unsigned taps, double cutoff, const float *table, size_t elems)
+{
+   struct sinc_cache_header header = {0};
+   FILE *file = fopen(path, "wb");
+
+   if (!file)
+      return;
+
+   header.magic   = SINC_CACHE_MAGIC;
+   header.version = SINC_CACHE_VERSION;
+   header.quality = quality;
+   header.taps    = taps;
+   header.elems   = elems;
+   header.cutoff  = cutoff;
+
+   if (fwrite(&header, sizeof(header), 1, file) != 1
+         || fwrite(table, sizeof(float), elems, file) != elems)
+   {
+      fclose(file);
+      remove(path);
+      return;
+   }
+
+   fclose(file);
+}
+
+static INLINE void process_sinc_C_body(rarch_sinc_resampler_t *resamp,
+      float *out_buffer, bool lerp)
 {
    unsigned i;
    float sum_l              = 0.0f;
@@ -193,23 +292,18 @@ static INLINE void process_sinc_C(rarch_sinc_resampler_t *resamp,
    const float *buffer_l    = resamp->buffer_l + resamp->ptr;
    const float *buffer_r    = resamp->buffer_r + resamp->ptr;
    unsigned taps            = resamp->taps;
-   unsigned phase           = resamp->time >> SUBPHASE_BITS;
-#if SINC_COEFF_LERP
-   const float *phase_table = resamp->phase_table + phase * taps * 2;
+   unsigned phase           = resamp->time >> resamp->subphase_bits;
+   const float *phase_table = resamp->phase_table +
+      phase * taps * (lerp ? 2 : 1);
    const float *delta_table = phase_table + taps;
    float delta              = (float)
-      (resamp->time & SUBPHASE_MASK) * SUBPHASE_MOD;
-#else
-   const float *phase_table = resamp->phase_table + phase * taps;
-#endif
+      (resamp->time & resamp->subphase_mask) * resamp->subphase_mod;
 
    for (i = 0; i < taps; i++)
    {
-#if SINC_COEFF_LERP
-      float sinc_val = phase_table[i] + delta_table[i] * delta;
-#else
       float sinc_val = phase_table[i];
-#endif
+      if (lerp)
+         sinc_val   += delta_table[i] * delta;
       sum_l         += buffer_l[i] * sinc_val;
       sum_r         += buffer_r[i] * sinc_val;
    }
@@ -217,13 +311,25 @@ static INLINE void process_sinc_C(rarch_sinc_resampler_t *resamp,
    out_buffer[0] = sum_l;
    out_buffer[1] = sum_r;
 }
-#endif
 
-#if defined(__AVX__) && ENABLE_AVX
-#define process_sinc_func process_sinc
-static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
+static void process_sinc_C(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   process_sinc_C_body(resamp, out_buffer, false);
+}
+
+static void process_sinc_C_lerp(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   process_sinc_C_body(resamp, out_buffer, true);
+}
+
+#ifdef SINC_HAVE_AVX
+static INLINE SINC_AVX_TARGET void process_sinc_avx_body(
+      rarch_sinc_resampler_t *resamp, float *out_buffer, bool lerp)
 {
    unsigned i;
+   __m256 res_l, res_r;
    __m256 sum_l             = _mm256_setzero_ps();
    __m256 sum_r             = _mm256_setzero_ps();
 
@@ -231,36 +337,38 @@ static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
    const float *buffer_r    = resamp->buffer_r + resamp->ptr;
 
    unsigned taps            = resamp->taps;
-   unsigned phase           = resamp->time >> SUBPHASE_BITS;
-#if SINC_COEFF_LERP
-   const float *phase_table = resamp->phase_table + phase * taps * 2;
+   unsigned phase           = resamp->time >> resamp->subphase_bits;
+   const float *phase_table = resamp->phase_table +
+      phase * taps * (lerp ? 2 : 1);
    const float *delta_table = phase_table + taps;
    __m256 delta             = _mm256_set1_ps((float)
-         (resamp->time & SUBPHASE_MASK) * SUBPHASE_MOD);
-#else
-   const float *phase_table = resamp->phase_table + phase * taps;
-#endif
+         (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
 
    for (i = 0; i < taps; i += 8)
    {
       __m256 buf_l  = _mm256_loadu_ps(buffer_l + i);
       __m256 buf_r  = _mm256_loadu_ps(buffer_r + i);
+      __m256 sinc   = _mm256_load_ps(phase_table + i);
 
-#if SINC_COEFF_LERP
-      __m256 deltas = _mm256_load_ps(delta_table + i);
-      __m256 sinc   = _mm256_add_ps(_mm256_load_ps(phase_table + i),
-            _mm256_mul_ps(deltas, delta));
+#if defined(__FMA__)
+      if (lerp)
+         sinc       = _mm256_fmadd_ps(_mm256_load_ps(delta_table + i),
+               delta, sinc);
+      sum_l         = _mm256_fmadd_ps(buf_l, sinc, sum_l);
+      sum_r         = _mm256_fmadd_ps(buf_r, sinc, sum_r);
 #else
-      __m256 sinc   = _mm256_load_ps(phase_table + i);
-#endif
+      if (lerp)
+         sinc       = _mm256_add_ps(sinc,
+               _mm256_mul_ps(_mm256_load_ps(delta_table + i), delta));
       sum_l         = _mm256_add_ps(sum_l, _mm256_mul_ps(buf_l, sinc));
       sum_r         = _mm256_add_ps(sum_r, _mm256_mul_ps(buf_r, sinc));
+#endif
    }
 
    /* hadd on AVX is weird, and acts on low-lanes 
     * and high-lanes separately. */
-   __m256 res_l = _mm256_hadd_ps(sum_l, sum_l);
-   __m256 res_r = _mm256_hadd_ps(sum_r, sum_r);
+   res_l = _mm256_hadd_ps(sum_l, sum_l);
+   res_r = _mm256_hadd_ps(sum_r, sum_r);
    res_l        = _mm256_hadd_ps(res_l, res_l);
    res_r        = _mm256_hadd_ps(res_r, res_r);
    res_l        = _mm256_add_ps(_mm256_permute2f128_ps(res_l, res_l, 1), res_l);
@@ -271,9 +379,23 @@ static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
    _mm_store_ss(out_buffer + 0, _mm256_extractf128_ps(res_l, 0));
    _mm_store_ss(out_buffer + 1, _mm256_extractf128_ps(res_r, 0));
 }
-#elif defined(__SSE__)
-#define process_sinc_func process_sinc
-static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
+
+static SINC_AVX_TARGET void process_sinc_avx(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   process_sinc_avx_body(resamp, out_buffer, false);
+}
+
+static SINC_AVX_TARGET void process_sinc_avx_lerp(
+      rarch_sinc_resampler_t *resamp, float *out_buffer)
+{
+   process_sinc_avx_body(resamp, out_buffer, true);
+}
+#endif
+
+#if defined(__SSE__)
+static INLINE void process_sinc_sse_body(rarch_sinc_resampler_t *resamp,
+      float *out_buffer, bool lerp)
 {
    unsigned i;
    __m128 sum;
@@ -284,28 +406,22 @@ static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
    const float *buffer_r    = resamp->buffer_r + resamp->ptr;
 
    unsigned taps            = resamp->taps;
-   unsigned phase           = resamp->time >> SUBPHASE_BITS;
-#if SINC_COEFF_LERP
-   const float *phase_table = resamp->phase_table + phase * taps * 2;
+   unsigned phase           = resamp->time >> resamp->subphase_bits;
+   const float *phase_table = resamp->phase_table +
+      phase * taps * (lerp ? 2 : 1);
    const float *delta_table = phase_table + taps;
    __m128 delta             = _mm_set1_ps((float)
-         (resamp->time & SUBPHASE_MASK) * SUBPHASE_MOD);
-#else
-   const float *phase_table = resamp->phase_table + phase * taps;
-#endif
+         (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
 
    for (i = 0; i < taps; i += 4)
    {
       __m128 buf_l = _mm_loadu_ps(buffer_l + i);
       __m128 buf_r = _mm_loadu_ps(buffer_r + i);
-
-#if SINC_COEFF_LERP
-      __m128 deltas = _mm_load_ps(delta_table + i);
-      __m128 _sinc  = _mm_add_ps(_mm_load_ps(phase_table + i),
-            _mm_mul_ps(deltas, delta));
-#else
       __m128 _sinc = _mm_load_ps(phase_table + i);
-#endif
+
+      if (lerp)
+         _sinc     = _mm_add_ps(_sinc,
+               _mm_mul_ps(_mm_load_ps(delta_table + i), delta));
       sum_l        = _mm_add_ps(sum_l, _mm_mul_ps(buf_l, _sinc));
       sum_r        = _mm_add_ps(sum_r, _mm_mul_ps(buf_r, _sinc));
    }
@@ -335,18 +451,21 @@ static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
    /* movehl { X, R, X, L } == { X, R, X, R } */
    _mm_store_ss(out_buffer + 1, _mm_movehl_ps(sum, sum));
 }
-#elif defined(__ARM_NEON__) && !defined(VITA)
 
-#if SINC_COEFF_LERP
-#error "NEON asm does not support SINC lerp."
-#endif
+static void process_sinc_sse(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   process_sinc_sse_body(resamp, out_buffer, false);
+}
 
-/* Need to make this function pointer as Android doesn't 
- * have built-in targets for NEON and plain ARMv7a.
- */
-static void (*process_sinc_func)(rarch_sinc_resampler_t *resamp,
-      float *out_buffer);
+static void process_sinc_sse_lerp(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   process_sinc_sse_body(resamp, out_buffer, true);
+}
+#endif
 
+#if defined(__ARM_NEON__) && !defined(VITA)
 /* Assumes that taps >= 8, and that taps is a multiple of 8. */
 void process_sinc_neon_asm(float *out, const float *left, 
       const float *right, const float *coeff, unsigned taps);
@@ -357,21 +476,56 @@ static void process_sinc_neon(rarch_sinc_resampler_t *resamp,
    const float *buffer_l    = resamp->buffer_l + resamp->ptr;
    const float *buffer_r    = resamp->buffer_r + resamp->ptr;
 
-   unsigned phase           = resamp->time >> SUBPHASE_BITS;
+   unsigned phase           = resamp->time >> resamp->subphase_bits;
    unsigned taps            = resamp->taps;
    const float *phase_table = resamp->phase_table + phase * taps;
 
    process_sinc_neon_asm(out_buffer, buffer_l, buffer_r, phase_table, taps);
 }
-#else /* Plain ol' C99 */
-#define process_sinc_func process_sinc_C
+
+/* The NEON asm does not support SINC lerp, so use intrinsics. */
+static void process_sinc_neon_lerp(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   unsigned i;
+   float32x2_t sum;
+   float32x4_t sum_l        = vdupq_n_f32(0.0f);
+   float32x4_t sum_r        = vdupq_n_f32(0.0f);
+
+   const float *buffer_l    = resamp->buffer_l + resamp->ptr;
+   const float *buffer_r    = resamp->buffer_r + resamp->ptr;
+
+   unsigned taps            = resamp->taps;
+   unsigned phase           = resamp->time >> resamp->subphase_bits;
+   const float *phase_table = resamp->phase_table + phase * taps * 2;
+   const float *delta_table = phase_table + taps;
+   float32x4_t delta        = vdupq_n_f32((float)
+         (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
+
+   for (i = 0; i < taps; i += 4)
+   {
+      float32x4_t sinc = vmlaq_f32(vld1q_f32(phase_table + i),
+            vld1q_f32(delta_table + i), delta);
+
+      sum_l            = vmlaq_f32(sum_l, vld1q_f32(buffer_l + i), sinc);
+      sum_r            = vmlaq_f32(sum_r, vld1q_f32(buffer_r + i), sinc);
+   }
+
+   /* sum = { L, R } */
+   sum = vpadd_f32(
+         vadd_f32(vget_low_f32(sum_l), vget_high_f32(sum_l)),
+         vadd_f32(vget_low_f32(sum_r), vget_high_f32(sum_r)));
+
+   vst1_f32(out_buffer, sum);
+}
 #endif
 
 static void resampler_sinc_process(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *re = (rarch_sinc_resampler_t*)re_;
 
-   uint32_t ratio        = PHASES / data->ratio;
+   uint32_t phases       = re->phases;
+   uint32_t ratio        = phases / data->ratio;
    const float *input    = data->data_in;
    float *output         = data->data_out;
    size_t frames         = data->input_frames;
@@ -379,7 +533,7 @@ static void resampler_sinc_process(void *re_, struct resampler_data *data)
 
    while (frames)
    {
-      while (frames && re->time >= PHASES)
+      while (frames && re->time >= phases)
       {
          /* Push in reverse to make filter more obvious. */
          if (!re->ptr)
@@ -389,13 +543,13 @@ static void resampler_sinc_process(void *re_, struct resampler_data *data)
          re->buffer_l[re->ptr + re->taps] = re->buffer_l[re->ptr] = *input++;
          re->buffer_r[re->ptr + re->taps] = re->buffer_r[re->ptr] = *input++;
 
-         re->time -= PHASES;
+         re->time -= phases;
          frames--;
       }
 
-      while (re->time < PHASES)
+      while (re->time < phases)
       {
-         process_sinc_func(re, output);
+         re->process(re, output);
          output += 2;
          out_frames++;
          re->time += ratio;
@@ -413,21 +567,70 @@ static void resampler_sinc_free(void *re)
    free(resampler);
 }
 
+/**
+ * resampler_sinc_select_kernel:
+ * @re                 : sinc resampler handle
+ * @mask               : SIMD features of the running CPU
+ * @lerp               : coefficients are interpolated
+ *
+ * Picks the fastest kernel the CPU supports for the
+ * current number of taps.
+ *
+ * Returns: the SIMD width taps must be a multiple of.
+ **/
+static unsigned resampler_sinc_select_kernel(rarch_sinc_resampler_t *re,
+      resampler_simd_mask_t mask, bool lerp)
+{
+   (void)mask;
+
+#ifdef SINC_HAVE_AVX
+   if ((mask & RESAMPLER_SIMD_AVX) && re->taps >= SINC_AVX_MIN_TAPS)
+   {
+      re->process = lerp ? process_sinc_avx_lerp : process_sinc_avx;
+      return 8;
+   }
+#endif
+#if defined(__SSE__)
+   re->process = lerp ? process_sinc_sse_lerp : process_sinc_sse;
+   return 4;
+#elif defined(__ARM_NEON__) && !defined(VITA)
+   if (mask & RESAMPLER_SIMD_NEON)
+   {
+      re->process = lerp ? process_sinc_neon_lerp : process_sinc_neon;
+      return 8;
+   }
+#endif
+
+   re->process = lerp ? process_sinc_C_lerp : process_sinc_C;
+   return 4;
+}
+
 static void *resampler_sinc_new(const struct resampler_config *config,
-      double bandwidth_mod, resampler_simd_mask_t mask)
+      double bandwidth_mod, enum resampler_quality quality,
+      resampler_simd_mask_t mask)
 {
+   char cache_path[PATH_MAX_LENGTH];
+   unsigned align;
    size_t phase_elems, elems;
    double cutoff;
+   const struct sinc_quality *q = NULL;
    rarch_sinc_resampler_t *re = (rarch_sinc_resampler_t*)
       calloc(1, sizeof(*re));
 
    if (!re)
       return NULL;
 
-   (void)config;
+   if (quality == RESAMPLER_QUALITY_DONTCARE
+         || quality > RESAMPLER_QUALITY_HIGHEST)
+      quality = SINC_DEFAULT_QUALITY;
 
-   re->taps = TAPS;
-   cutoff   = CUTOFF;
+   q                 = &sinc_qualities[quality];
+   re->taps          = q->sidelobes * 2;
+   re->phases        = 1u << (q->phase_bits + q->subphase_bits);
+   re->subphase_bits = q->subphase_bits;
+   re->subphase_mask = (1u << q->subphase_bits) - 1;
+   re->subphase_mod  = 1.0f / (1u << q->subphase_bits);
+   cutoff            = q->cutoff;
 
    /* Downsampling, must lower cutoff, and extend number of 
     * taps accordingly to keep same stopband attenuation. */
@@ -438,33 +641,41 @@ static void *resampler_sinc_new(const struct resampler_config *config,
    }
 
    /* Be SIMD-friendly. */
-#if (defined(__AVX__) && ENABLE_AVX) || (defined(__ARM_NEON__)&& !defined(VITA))
-   re->taps = (re->taps + 7) & ~7;
-#else
-   re->taps = (re->taps + 3) & ~3;
-#endif
+   align    = resampler_sinc_select_kernel(re, mask, q->lerp);
+   re->taps = (re->taps + align - 1) & ~(align - 1);
 
-   phase_elems = (1 << PHASE_BITS) * re->taps;
-#if SINC_COEFF_LERP
-   phase_elems *= 2;
-#endif
+   phase_elems = (1 << q->phase_bits) * re->taps;
+   if (q->lerp)
+      phase_elems *= 2;
    elems = phase_elems + 4 * re->taps;
 
    re->main_buffer = (float*)memalign_alloc(128, sizeof(float) * elems);
    if (!re->main_buffer)
       goto error;
 
+   memset(re->main_buffer, 0, sizeof(float) * elems);
+
    re->phase_table = re->main_buffer;
    re->buffer_l = re->main_buffer + phase_elems;
    re->buffer_r = re->buffer_l + 2 * re->taps;
 
-   init_sinc_table(re, cutoff, re->phase_table,
-         1 << PHASE_BITS, re->taps, SINC_COEFF_LERP);
-
-#if defined(__ARM_NEON__) && !defined(VITA)
-   process_sinc_func = mask & RESAMPLER_SIMD_NEON 
-      ? process_sinc_neon : process_sinc_C;
-#endif
+   /* The high quality tables take a while to compute,
+    * so keep them around between runs. */
+   if (sinc_cache_path(cache_path, sizeof(cache_path),
+            config ? config->cache_dir : NULL, quality, re->taps, cutoff))
+   {
+      if (!sinc_cache_load(cache_path, quality, re->taps, cutoff,
+               re->phase_table, phase_elems))
+      {
+         init_sinc_table(q, cutoff, re->phase_table,
+               1 << q->phase_bits, re->taps, q->lerp);
+         sinc_cache_save(cache_path, quality, re->taps, cutoff,
+               re->phase_table, phase_elems);
+      }
+   }
+   else
+      init_sinc_table(q, cutoff, re->phase_table,
+            1 << q->phase_bits, re->taps, q->lerp);
 
    return re;
 
@@ -62,7 +62,8 @@ int main(int argc, char *argv[])
       return 1;
    }
 
-   if (!rarch_resampler_realloc(&re, &resampler, RESAMPLER_IDENT, out_rate / in_rate))
+   if (!rarch_resampler_realloc(&re, &resampler, RESAMPLER_IDENT,
+            RESAMPLER_QUALITY_DONTCARE, out_rate / in_rate))
    {
       fprintf(stderr, "Failed to allocate resampler ...\n");
       return 1;
@@ -0,0 +1,207 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmarks the audio_driver_flush() chain.
+ * Reports ns per stereo frame for each stage on its own, then
+ * for the whole chain run as separate full-buffer passes and
+ * as AUDIO_BLOCK_SAMPLES-sized blocks.
+ * DSP plugins are loaded at runtime and are not covered here. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "../audio_resampler_driver.h"
+#include "../audio_utils.h"
+
+#define BENCH_IN_RATE      32040.0
+#define BENCH_OUT_RATE     48000.0
+#define BENCH_FLUSH        8192
+#define BENCH_BLOCK        512
+#define BENCH_ITERATIONS   2000
+
+static uint64_t bench_get_cpu_features(void)
+{
+   return 0;
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void report(const char *ident, double elapsed, size_t frames)
+{
+   printf("%-28s %8.2f ns/frame\n", ident, elapsed * 1e9 / frames);
+}
+
+int main(void)
+{
+   unsigned i, j;
+   double start;
+   int16_t *input;
+   float   *input_f, *output_f, *block_f;
+   int16_t *output_i;
+   void *re                           = NULL;
+   const rarch_resampler_t *resampler = &sinc_resampler;
+   double ratio                       = BENCH_OUT_RATE / BENCH_IN_RATE;
+   size_t frames                      = (size_t)BENCH_FLUSH / 2 * BENCH_ITERATIONS;
+   size_t out_max                     = (size_t)(BENCH_FLUSH * ratio) + 16;
+
+   perf_get_cpu_features_cb = bench_get_cpu_features;
+   audio_convert_init_simd();
+
+   input    = (int16_t*)malloc(BENCH_FLUSH * sizeof(int16_t));
+   input_f  = (float*)malloc(BENCH_FLUSH * sizeof(float));
+   output_f = (float*)malloc(out_max * sizeof(float));
+   block_f  = (float*)malloc(((size_t)(BENCH_BLOCK * ratio) + 16) * sizeof(float));
+   output_i = (int16_t*)malloc(out_max * sizeof(int16_t));
+
+   if (!input || !input_f || !output_f || !block_f || !output_i)
+      return 1;
+
+   for (i = 0; i < BENCH_FLUSH; i += 2)
+   {
+      input[i + 0] = (int16_t)(12000.0 * sin(i * 0.01));
+      input[i + 1] = (int16_t)(12000.0 * cos(i * 0.013));
+   }
+
+   re = resampler->init(NULL, ratio, RESAMPLER_QUALITY_NORMAL,
+         RESAMPLER_SIMD_SSE | RESAMPLER_SIMD_SSE2);
+   if (!re)
+      return 1;
+
+   printf("Flush of %u samples, %.0f Hz -> %.0f Hz.\n",
+         BENCH_FLUSH, BENCH_IN_RATE, BENCH_OUT_RATE);
+
+   start = get_time();
+   for (i = 0; i < BENCH_ITERATIONS; i++)
+      audio_convert_s16_to_float_C(input_f, input, BENCH_FLUSH, 1.0f);
+   report("s16 -> float (C)", get_time() - start, frames);
+
+   start = get_time();
+   for (i = 0; i < BENCH_ITERATIONS; i++)
+      audio_convert_s16_to_float(input_f, input, BENCH_FLUSH, 1.0f);
+   report("s16 -> float", get_time() - start, frames);
+
+   start = get_time();
+   for (i = 0; i < BENCH_ITERATIONS; i++)
+   {
+      struct resampler_data data = {0};
+      data.data_in      = input_f;
+      data.data_out     = output_f;
+      data.input_frames = BENCH_FLUSH / 2;
+      data.ratio        = ratio;
+      resampler->process(re, &data);
+   }
+   report("sinc resampler", get_time() - start, frames);
+
+   /* Every quality tier, with the kernel the CPU would get. */
+   for (j = RESAMPLER_QUALITY_LOWEST; j <= RESAMPLER_QUALITY_HIGHEST; j++)
+   {
+      char ident[64];
+      resampler_simd_mask_t mask = RESAMPLER_SIMD_SSE | RESAMPLER_SIMD_SSE2;
+      void *tier                 = NULL;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+      if (__builtin_cpu_supports("avx"))
+         mask |= RESAMPLER_SIMD_AVX;
+#endif
+
+      tier = resampler->init(NULL, ratio, (enum resampler_quality)j, mask);
+      if (!tier)
+         return 1;
+
+      start = get_time();
+      for (i = 0; i < BENCH_ITERATIONS / 10; i++)
+      {
+         struct resampler_data data = {0};
+         data.data_in      = input_f;
+         data.data_out     = output_f;
+         data.input_frames = BENCH_FLUSH / 2;
+         data.ratio        = ratio;
+         resampler->process(tier, &data);
+      }
+      snprintf(ident, sizeof(ident), "sinc, quality %u", j);
+      report(ident, get_time() - start, frames / 10);
+
+      resampler->free(tier);
+   }
+
+   start = get_time();
+   for (i = 0; i < BENCH_ITERATIONS; i++)
+      audio_convert_float_to_s16_C(output_i, output_f, BENCH_FLUSH);
+   report("float -> s16 (C)", get_time() - start, frames);
+
+   start = get_time();
+   for (i = 0; i < BENCH_ITERATIONS; i++)
+      audio_convert_float_to_s16(output_i, output_f, BENCH_FLUSH);
+   report("float -> s16", get_time() - start, frames);
+
+   /* Whole chain, one full pass per stage. */
+   start = get_time();
+   for (i = 0; i < BENCH_ITERATIONS; i++)
+   {
+      struct resampler_data data = {0};
+
+      audio_convert_s16_to_float(input_f, input, BENCH_FLUSH, 1.0f);
+
+      data.data_in      = input_f;
+      data.data_out     = output_f;
+      data.input_frames = BENCH_FLUSH / 2;
+      data.ratio        = ratio;
+      resampler->process(re, &data);
+
+      audio_convert_float_to_s16(output_i, output_f, data.output_frames * 2);
+   }
+   report("chain, full passes", get_time() - start, frames);
+
+   /* Whole chain, the way audio_driver_flush() runs it. */
+   start = get_time();
+   for (i = 0; i < BENCH_ITERATIONS; i++)
+   {
+      size_t output_frames = 0;
+
+      for (j = 0; j < BENCH_FLUSH; j += BENCH_BLOCK)
+      {
+         struct resampler_data data = {0};
+
+         audio_convert_s16_to_float(input_f, input + j, BENCH_BLOCK, 1.0f);
+
+         data.data_in      = input_f;
+         data.data_out     = block_f;
+         data.input_frames = BENCH_BLOCK / 2;
+         data.ratio        = ratio;
+         resampler->process(re, &data);
+
+         audio_convert_float_to_s16(output_i + output_frames * 2,
+               block_f, data.output_frames * 2);
+         output_frames += data.output_frames;
+      }
+   }
+   report("chain, blocked", get_time() - start, frames);
+
+   resampler->free(re);
+   free(input);
+   free(input_f);
+   free(output_f);
+   free(block_f);
+   free(output_i);
+   return 0;
+}
@@ -300,7 +300,8 @@ int main(int argc, char *argv[])
    assert(input);
    assert(output);
 
-   if (!rarch_resampler_realloc(&re, &resampler, RESAMPLER_IDENT, ratio))
+   if (!rarch_resampler_realloc(&re, &resampler, RESAMPLER_IDENT,
+            RESAMPLER_QUALITY_DONTCARE, ratio))
    {
       free(input);
       free(output);
@@ -18,12 +18,26 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32) && !defined(_XBOX)
+#include <windows.h>
+#include <io.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include <boolean.h>
+#include <file/file_path.h>
+#include <compat/strl.h>
 
 #include <rthreads/rthreads.h>
 
 #include "general.h"
 
+/* SRAM is compared and copied in blocks of this size, so
+ * only the blocks that changed are copied. */
+#define AUTOSAVE_BLOCK_SIZE 4096
+
 struct autosave
 {
    volatile bool quit;
@@ -38,6 +52,12 @@ struct autosave
    const char *path;
    size_t bufsize;
    unsigned interval;
+   bool sync;
+
+   /* Written first, then renamed over path. */
+   char tmp_path[PATH_MAX_LENGTH];
+
+   size_t num_blocks;
 };
 
 /**
@@ -62,6 +82,141 @@ static void autosave_unlock(autosave_t *handle)
    slock_unlock(handle->lock);
 }
 
+/**
+ * autosave_copy_dirty:
+ * @handle          : pointer to autosave object
+ *
+ * Copies the blocks of SRAM that differ from the last save.
+ * Must be called with the lock held, so the core can't write
+ * to a block between its compare and its copy.
+ *
+ * Returns: number of blocks copied.
+ **/
+static size_t autosave_copy_dirty(autosave_t *handle)
+{
+   size_t i;
+   size_t count        = 0;
+   uint8_t *saved      = (uint8_t*)handle->buffer;
+   const uint8_t *sram = (const uint8_t*)handle->retro_buffer;
+
+   for (i = 0; i < handle->num_blocks; i++)
+   {
+      size_t offset = i * AUTOSAVE_BLOCK_SIZE;
+      size_t len    = handle->bufsize - offset;
+
+      if (len > AUTOSAVE_BLOCK_SIZE)
+         len = AUTOSAVE_BLOCK_SIZE;
+
+      if (!memcmp(saved + offset, sram + offset, len))
+         continue;
+
+      memcpy(saved + offset, sram + offset, len);
+      count++;
+   }
+
+   return count;
+}
+
+/**
+ * autosave_sync_file:
+ * @file            : file to sync.
+ *
+ * Flushes @file all the way to the disk, where the platform
+ * allows it.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool autosave_sync_file(FILE *file)
+{
+#if defined(_WIN32) && !defined(_XBOX)
+   return _commit(_fileno(file)) == 0;
+#elif defined(__unix__) || defined(__APPLE__)
+   return fsync(fileno(file)) == 0;
+#else
+   (void)file;
+   return true;
+#endif
+}
+
+/**
+ * autosave_replace:
+ * @handle          : pointer to autosave object
+ *
+ * Renames the temporary file over the save file, so it always
+ * holds either the old or the new save, even on a crash or power
+ * loss in between. With sync set, the directory is synced too,
+ * so the rename itself makes it to the disk.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool autosave_replace(autosave_t *handle)
+{
+#if defined(_WIN32) && !defined(_XBOX)
+   return MoveFileExA(handle->tmp_path, handle->path,
+         MOVEFILE_REPLACE_EXISTING
+         | (handle->sync ? MOVEFILE_WRITE_THROUGH : 0)) != 0;
+#else
+   if (rename(handle->tmp_path, handle->path) != 0)
+   {
+      /* Some platforms can't rename over an existing file. */
+      remove(handle->path);
+      if (rename(handle->tmp_path, handle->path) != 0)
+         return false;
+   }
+
+#if defined(__unix__) || defined(__APPLE__)
+   if (handle->sync)
+   {
+      int fd;
+      char dir[PATH_MAX_LENGTH] = {0};
+
+      fill_pathname_basedir(dir, handle->path, sizeof(dir));
+      fd = open(*dir ? dir : ".", O_RDONLY);
+      if (fd >= 0)
+      {
+         fsync(fd);
+         close(fd);
+      }
+   }
+#endif
+
+   return true;
+#endif
+}
+
+/**
+ * autosave_write:
+ * @handle          : pointer to autosave object
+ *
+ * Writes the saved copy of SRAM to a temporary file and
+ * replaces the save file with it.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool autosave_write(autosave_t *handle)
+{
+   bool failed = false;
+   FILE *file  = fopen(handle->tmp_path, "wb");
+
+   if (!file)
+      return false;
+
+   failed |= fwrite(handle->buffer, 1, handle->bufsize, file)
+      != handle->bufsize;
+   failed |= fflush(file) != 0;
+   if (handle->sync)
+      failed |= !autosave_sync_file(file);
+   failed |= fclose(file) != 0;
+
+   if (failed || !autosave_replace(handle))
+   {
+      remove(handle->tmp_path);
+      return false;
+   }
+
+   return true;
+}
+
 /**
  * autosave_thread:
  * @data            : pointer to autosave object
@@ -75,41 +230,27 @@ static void autosave_thread(void *data)
 
    while (!save->quit)
    {
-      bool differ;
+      size_t dirty;
 
       autosave_lock(save);
-      differ = memcmp(save->buffer, save->retro_buffer,
-            save->bufsize) != 0;
-      if (differ)
-         memcpy(save->buffer, save->retro_buffer, save->bufsize);
+      dirty = autosave_copy_dirty(save);
       autosave_unlock(save);
 
-      if (differ)
+      if (dirty)
       {
-         /* Should probably deal with this more elegantly. */
-         FILE *file = fopen(save->path, "wb");
-
-         if (file)
+         /* Avoid spamming down stderr ... */
+         if (first_log)
          {
-            bool failed = false;
-
-            /* Avoid spamming down stderr ... */
-            if (first_log)
-            {
-               RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
-                     save->path, save->interval);
-               first_log = false;
-            }
-            else
-               RARCH_LOG("SRAM changed ... autosaving ...\n");
-
-            failed |= fwrite(save->buffer, 1, save->bufsize, file)
-               != save->bufsize;
-            failed |= fflush(file) != 0;
-            failed |= fclose(file) != 0;
-            if (failed)
-               RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
+            RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
+                  save->path, save->interval);
+            first_log = false;
          }
+         else
+            RARCH_LOG("SRAM changed ... autosaving %u of %u blocks ...\n",
+                  (unsigned)dirty, (unsigned)save->num_blocks);
+
+         if (!autosave_write(save))
+            RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
       }
 
       slock_lock(save->cond_lock);
@@ -128,6 +269,7 @@ static void autosave_thread(void *data)
  * @data            : pointer to buffer
  * @size            : size of @data buffer
  * @interval        : interval at which saves should be performed.
+ * @sync            : flush each save all the way to the disk.
  *
  * Create and initialize autosave object.
  *
@@ -135,7 +277,7 @@ static void autosave_thread(void *data)
  * NULL.
  **/
 autosave_t *autosave_new(const char *path, const void *data, size_t size,
-      unsigned interval)
+      unsigned interval, bool sync)
 {
    autosave_t *handle = (autosave_t*)calloc(1, sizeof(*handle));
    if (!handle)
@@ -143,9 +285,14 @@ autosave_t *autosave_new(const char *path, const void *data, size_t size,
 
    handle->bufsize      = size;
    handle->interval     = interval;
+   handle->sync         = sync;
    handle->path         = path;
    handle->buffer       = malloc(size);
    handle->retro_buffer = data;
+   handle->num_blocks   = (size + AUTOSAVE_BLOCK_SIZE - 1) / AUTOSAVE_BLOCK_SIZE;
+
+   strlcpy(handle->tmp_path, path, sizeof(handle->tmp_path));
+   strlcat(handle->tmp_path, ".tmp", sizeof(handle->tmp_path));
 
    if (!handle->buffer)
    {
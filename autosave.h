@@ -22,6 +22,7 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <boolean.h>
 
 typedef struct autosave autosave_t;
 
@@ -31,6 +32,7 @@ typedef struct autosave autosave_t;
  * @data            : pointer to buffer
  * @size            : size of @data buffer
  * @interval        : interval at which saves should be performed.
+ * @sync            : flush each save all the way to the disk.
  *
  * Create and initialize autosave object.
  *
@@ -38,7 +40,7 @@ typedef struct autosave autosave_t;
  * NULL.
  **/
 autosave_t *autosave_new(const char *path, const void *data,
-      size_t size, unsigned interval);
+      size_t size, unsigned interval, bool sync);
 
 /**
  * autosave_free:
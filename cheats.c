@@ -27,6 +27,7 @@
 #include "general.h"
 #include "runloop.h"
 #include "dynamic.h"
+#include "runahead.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -73,11 +74,16 @@ void cheat_manager_apply_cheats(cheat_manager_t *handle)
       return;
 
    core.retro_cheat_reset();
+   runahead_cheat_reset();
 
    for (i = 0; i < handle->size; i++)
    {
-      if (handle->cheats[i].state)
-         core.retro_cheat_set(idx++, true, handle->cheats[i].code);
+      if (!handle->cheats[i].state)
+         continue;
+
+      core.retro_cheat_set(idx, true, handle->cheats[i].code);
+      runahead_cheat_set(idx, true, handle->cheats[i].code);
+      idx++;
    }
    
 #ifdef HAVE_CHEEVOS
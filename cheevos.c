@@ -120,10 +120,35 @@ typedef struct
 {
    cheevos_cond_t *conds;
    unsigned        count;
-
-   const char* expression;
 } cheevos_condset_t;
 
+/* The conditions of a whole set of achievements, compiled into flat
+ * arrays once they are loaded, so testing them every frame walks
+ * memory in order instead of chasing pointers. */
+typedef struct
+{
+   /* Two per condition, its source and then its target. Addresses
+    * are resolved to pointers into the core's memory up front. */
+   const uint8_t **var_memory;
+   unsigned       *var_value;
+   unsigned       *var_previous;
+   uint8_t        *var_size;
+   uint8_t        *var_type;
+
+   /* One per condition. */
+   uint8_t        *cond_type;
+   uint8_t        *cond_op;
+   unsigned       *cond_req_hits;
+   unsigned       *cond_curr_hits;
+
+   /* Condset i has the conditions set_start[i] up to
+    * set_start[i + 1], so there's one more than there are sets. */
+   unsigned       *set_start;
+
+   unsigned        num_conds;
+   unsigned        num_sets;
+} cheevos_program_t;
+
 typedef struct
 {
    unsigned    id;
@@ -136,16 +161,25 @@ typedef struct
    int         active;
    int         modified;
 
+   /* Only kept until the set is compiled. */
    cheevos_condset_t *condsets;
    unsigned count;
+
+   /* First condset of the achievement in the compiled program. */
+   unsigned first_set;
 } cheevo_t;
 
 typedef struct
 {
    cheevo_t *cheevos;
    unsigned  count;
+
+   cheevos_program_t program;
 } cheevoset_t;
 
+/* Memory regions addresses are looked up in, in order. */
+#define CHEEVOS_NUM_REGIONS 4
+
 typedef struct
 {
    int loaded;
@@ -156,6 +190,10 @@ typedef struct
    char token[32];
 
    async_job_t *jobs;
+
+   /* What the compiled addresses were resolved against. */
+   const uint8_t *region_data[CHEEVOS_NUM_REGIONS];
+   size_t         region_size[CHEEVOS_NUM_REGIONS];
 } cheevos_locals_t;
 
 cheevos_locals_t cheevos_locals =
@@ -598,16 +636,20 @@ static unsigned cheevos_count_conds_in_set(const char *memaddr, unsigned set)
             count++;
       }
       while (*memaddr == '_' || *memaddr == 'R' || *memaddr == 'P'); /* AND, ResetIf, PauseIf */
+
+      index++;
    }
    while (*memaddr == 'S'); /* Repeat for all subconditions if they exist */
 
    return count;
 }
 
-static void cheevos_parse_memaddr(cheevos_cond_t *cond, const char *memaddr)
+static void cheevos_parse_memaddr(cheevos_condset_t *condset, const char *memaddr)
 {
    do
    {
+      cheevos_cond_t *cond = condset++->conds;
+
       do
       {
          while (*memaddr == ' ' || *memaddr == '_' || *memaddr == '|' || *memaddr == 'S')
@@ -711,12 +753,12 @@ static int cheevos_new_cheevo(cheevos_readud_t *ud)
                return -1;
 
             memset((void*)condset->conds, 0, condset->count * sizeof(cheevos_cond_t));
-            condset->expression = cheevos_dupstr(&ud->memaddr);
-            cheevos_parse_memaddr(condset->conds, ud->memaddr.string);
          }
          else
             condset->conds = NULL;
       }
+
+      cheevos_parse_memaddr(cheevo->condsets, ud->memaddr.string);
    }
 
    return 0;
@@ -870,107 +912,260 @@ static int cheevos_parse(const char *json)
 }
 
 /*****************************************************************************
-Test all the achievements (call once per frame).
+Compile the achievements of a set into a program.
 *****************************************************************************/
 
-static const uint8_t *cheevos_get_memory(unsigned offset)
+static void cheevos_free_condsets(cheevo_t *cheevo)
+{
+   unsigned i;
+
+   if (!cheevo->condsets)
+      return;
+
+   for (i = 0; i < cheevo->count; i++)
+      free((void*)cheevo->condsets[i].conds);
+
+   free((void*)cheevo->condsets);
+   cheevo->condsets = NULL;
+}
+
+static void cheevos_free_program(cheevos_program_t *program)
+{
+   free((void*)program->var_memory);
+   free((void*)program->var_value);
+   free((void*)program->var_previous);
+   free((void*)program->var_size);
+   free((void*)program->var_type);
+   free((void*)program->cond_type);
+   free((void*)program->cond_op);
+   free((void*)program->cond_req_hits);
+   free((void*)program->cond_curr_hits);
+   free((void*)program->set_start);
+   memset((void*)program, 0, sizeof(*program));
+}
+
+static void cheevos_compile_var(cheevos_program_t *program, unsigned index,
+      const cheevos_var_t *var)
 {
-   size_t size = core.retro_get_memory_size(RETRO_MEMORY_SYSTEM_RAM);
-   uint8_t *memory;
+   program->var_memory[index]   = NULL;
+   program->var_value[index]    = var->value;
+   program->var_previous[index] = var->previous;
+   program->var_size[index]     = var->size;
+   program->var_type[index]     = var->type;
+}
 
-   if (offset < size)
+static int cheevos_compile_set(cheevoset_t *set)
+{
+   unsigned num_conds = 0, num_sets = 0, i, j, k;
+   cheevos_program_t *program = &set->program;
+
+   for (i = 0; i < set->count; i++)
    {
-      memory = (uint8_t*)core.retro_get_memory_data(RETRO_MEMORY_SYSTEM_RAM);
-      return memory + offset;
+      num_sets += set->cheevos[i].count;
+
+      for (j = 0; j < set->cheevos[i].count; j++)
+         num_conds += set->cheevos[i].condsets[j].count;
    }
 
-   offset -= size;
-   size = core.retro_get_memory_size(RETRO_MEMORY_SAVE_RAM);
+   /* One extra, so nothing is allocated with a size of zero. */
+   program->var_memory     = (const uint8_t**)calloc(num_conds * 2 + 1, sizeof(*program->var_memory));
+   program->var_value      = (unsigned*)calloc(num_conds * 2 + 1, sizeof(*program->var_value));
+   program->var_previous   = (unsigned*)calloc(num_conds * 2 + 1, sizeof(*program->var_previous));
+   program->var_size       = (uint8_t*)calloc(num_conds * 2 + 1, sizeof(*program->var_size));
+   program->var_type       = (uint8_t*)calloc(num_conds * 2 + 1, sizeof(*program->var_type));
+   program->cond_type      = (uint8_t*)calloc(num_conds + 1, sizeof(*program->cond_type));
+   program->cond_op        = (uint8_t*)calloc(num_conds + 1, sizeof(*program->cond_op));
+   program->cond_req_hits  = (unsigned*)calloc(num_conds + 1, sizeof(*program->cond_req_hits));
+   program->cond_curr_hits = (unsigned*)calloc(num_conds + 1, sizeof(*program->cond_curr_hits));
+   program->set_start      = (unsigned*)calloc(num_sets + 1, sizeof(*program->set_start));
 
-   if (offset < size)
+   if (  !program->var_memory || !program->var_value || !program->var_previous
+      || !program->var_size || !program->var_type || !program->cond_type
+      || !program->cond_op || !program->cond_req_hits
+      || !program->cond_curr_hits || !program->set_start)
    {
-      memory = (uint8_t*)core.retro_get_memory_data(RETRO_MEMORY_SAVE_RAM);
-      return memory + offset;
+      cheevos_free_program(program);
+      return -1;
    }
 
-   offset -= size;
-   size = core.retro_get_memory_size(RETRO_MEMORY_VIDEO_RAM);
+   program->num_conds = 0;
+   program->num_sets  = 0;
 
-   if (offset < size)
+   for (i = 0; i < set->count; i++)
    {
-      memory = (uint8_t*)core.retro_get_memory_data(RETRO_MEMORY_VIDEO_RAM);
-      return memory + offset;
+      cheevo_t *cheevo  = set->cheevos + i;
+      cheevo->first_set = program->num_sets;
+
+      for (j = 0; j < cheevo->count; j++)
+      {
+         const cheevos_condset_t *condset = cheevo->condsets + j;
+
+         program->set_start[program->num_sets++] = program->num_conds;
+
+         for (k = 0; k < condset->count; k++)
+         {
+            const cheevos_cond_t *cond = condset->conds + k;
+            unsigned index             = program->num_conds++;
+
+            program->cond_type[index]      = cond->type;
+            program->cond_op[index]        = cond->op;
+            program->cond_req_hits[index]  = cond->req_hits;
+            program->cond_curr_hits[index] = cond->curr_hits;
+
+            cheevos_compile_var(program, index * 2, &cond->source);
+            cheevos_compile_var(program, index * 2 + 1, &cond->target);
+         }
+      }
+
+      cheevos_free_condsets(cheevo);
    }
 
-   offset -= size;
-   size = core.retro_get_memory_size(RETRO_MEMORY_RTC);
+   program->set_start[program->num_sets] = program->num_conds;
+   return 0;
+}
+
+/*****************************************************************************
+Test all the achievements (call once per frame).
+*****************************************************************************/
 
-   if (offset < size)
+static const uint8_t *cheevos_get_memory(unsigned offset)
+{
+   unsigned i;
+
+   for (i = 0; i < CHEEVOS_NUM_REGIONS; i++)
    {
-      memory = (uint8_t*)core.retro_get_memory_data(RETRO_MEMORY_RTC);
-      return memory + offset;
+      size_t size = cheevos_locals.region_size[i];
+
+      if (offset < size)
+         return cheevos_locals.region_data[i] ?
+            cheevos_locals.region_data[i] + offset : NULL;
+
+      offset -= size;
    }
 
    return NULL;
 }
 
-static unsigned cheevos_get_var_value(cheevos_var_t *var)
+static void cheevos_resolve_program(cheevos_program_t *program)
 {
-   unsigned previous = var->previous;
-   unsigned live_val = 0;
-   const uint8_t *memory;
+   unsigned i;
 
-   if (var->type == CHEEVOS_VAR_TYPE_VALUE_COMP)
-      return var->value;
+   for (i = 0; i < program->num_conds * 2; i++)
+   {
+      if (program->var_type[i] == CHEEVOS_VAR_TYPE_ADDRESS
+            || program->var_type[i] == CHEEVOS_VAR_TYPE_DELTA_MEM)
+         program->var_memory[i] = cheevos_get_memory(program->var_value[i]);
+   }
+}
 
-   if (var->type == CHEEVOS_VAR_TYPE_ADDRESS || var->type == CHEEVOS_VAR_TYPE_DELTA_MEM)
+/* The core can move or resize its memory at any time, so it is
+ * looked up once per frame, and the addresses are only resolved
+ * again when it has changed. */
+static void cheevos_update_memory(void)
+{
+   static const unsigned ids[CHEEVOS_NUM_REGIONS] =
    {
-      /* TODO Check with Scott if the bank id is needed */
-      memory = cheevos_get_memory(var->value);
-      
-      if (memory)
+      RETRO_MEMORY_SYSTEM_RAM,
+      RETRO_MEMORY_SAVE_RAM,
+      RETRO_MEMORY_VIDEO_RAM,
+      RETRO_MEMORY_RTC
+   };
+
+   unsigned i;
+   int changed = 0;
+
+   for (i = 0; i < CHEEVOS_NUM_REGIONS; i++)
+   {
+      size_t size         = core.retro_get_memory_size(ids[i]);
+      const uint8_t *data = (const uint8_t*)core.retro_get_memory_data(ids[i]);
+
+      if (size != cheevos_locals.region_size[i] || data != cheevos_locals.region_data[i])
       {
-         live_val = memory[0];
-
-         if (var->size >= CHEEVOS_VAR_SIZE_BIT_0 && var->size <= CHEEVOS_VAR_SIZE_BIT_7)
-            live_val = (live_val & (1 << (var->size - CHEEVOS_VAR_SIZE_BIT_0))) != 0;
-         else if (var->size == CHEEVOS_VAR_SIZE_NIBBLE_LOWER)
-            live_val &= 0x0f;
-         else if (var->size == CHEEVOS_VAR_SIZE_NIBBLE_UPPER)
-            live_val = (live_val >> 4) & 0x0f;
-         else if (var->size == CHEEVOS_VAR_SIZE_EIGHT_BITS)
-            ; /* nothing */
-         else if (var->size == CHEEVOS_VAR_SIZE_SIXTEEN_BITS)
-            live_val |= memory[1] << 8;
-         else if (var->size == CHEEVOS_VAR_SIZE_THIRTYTWO_BITS)
-         {
-            live_val |= memory[1] << 8;
-            live_val |= memory[2] << 16;
-            live_val |= memory[3] << 24;
-         }
+         cheevos_locals.region_size[i] = size;
+         cheevos_locals.region_data[i] = data;
+         changed = 1;
       }
-      else
-         live_val = 0;
-      
-      if (var->type == CHEEVOS_VAR_TYPE_DELTA_MEM)
+   }
+
+   if (changed)
+   {
+      cheevos_resolve_program(&cheevos_locals.core.program);
+      cheevos_resolve_program(&cheevos_locals.unofficial.program);
+   }
+}
+
+static unsigned cheevos_get_var_value(cheevos_program_t *program, unsigned var)
+{
+   unsigned previous;
+   unsigned live_val = 0;
+   const uint8_t *memory;
+
+   switch (program->var_type[var])
+   {
+      case CHEEVOS_VAR_TYPE_VALUE_COMP:
+         return program->var_value[var];
+
+      case CHEEVOS_VAR_TYPE_ADDRESS:
+      case CHEEVOS_VAR_TYPE_DELTA_MEM:
+         break;
+
+      default:
+         /* We shouldn't get here... */
+         return 0;
+   }
+
+   /* TODO Check with Scott if the bank id is needed */
+   memory = program->var_memory[var];
+
+   if (memory)
+   {
+      switch (program->var_size[var])
       {
-         var->previous = live_val;
-         return previous;
+         case CHEEVOS_VAR_SIZE_BIT_0:
+         case CHEEVOS_VAR_SIZE_BIT_1:
+         case CHEEVOS_VAR_SIZE_BIT_2:
+         case CHEEVOS_VAR_SIZE_BIT_3:
+         case CHEEVOS_VAR_SIZE_BIT_4:
+         case CHEEVOS_VAR_SIZE_BIT_5:
+         case CHEEVOS_VAR_SIZE_BIT_6:
+         case CHEEVOS_VAR_SIZE_BIT_7:
+            live_val = (memory[0] >> (program->var_size[var] - CHEEVOS_VAR_SIZE_BIT_0)) & 1;
+            break;
+         case CHEEVOS_VAR_SIZE_NIBBLE_LOWER:
+            live_val = memory[0] & 0x0f;
+            break;
+         case CHEEVOS_VAR_SIZE_NIBBLE_UPPER:
+            live_val = (memory[0] >> 4) & 0x0f;
+            break;
+         case CHEEVOS_VAR_SIZE_SIXTEEN_BITS:
+            live_val = memory[0] | memory[1] << 8;
+            break;
+         case CHEEVOS_VAR_SIZE_THIRTYTWO_BITS:
+            live_val = memory[0] | memory[1] << 8 | memory[2] << 16
+               | (unsigned)memory[3] << 24;
+            break;
+         default:
+            live_val = memory[0];
+            break;
       }
+   }
 
-      return live_val;
+   if (program->var_type[var] == CHEEVOS_VAR_TYPE_DELTA_MEM)
+   {
+      previous = program->var_previous[var];
+      program->var_previous[var] = live_val;
+      return previous;
    }
 
-   /* We shouldn't get here... */
-   return 0;
+   return live_val;
 }
 
-static int cheevos_test_condition(cheevos_cond_t *cond)
+static int cheevos_test_condition(cheevos_program_t *program, unsigned cond)
 {
-   unsigned sval = cheevos_get_var_value(&cond->source);
-   unsigned tval = cheevos_get_var_value(&cond->target);
+   unsigned sval = cheevos_get_var_value(program, cond * 2);
+   unsigned tval = cheevos_get_var_value(program, cond * 2 + 1);
 
-   switch (cond->op)
+   switch (program->cond_op[cond])
    {
       case CHEEVOS_COND_OP_EQUALS:
          return sval == tval;
@@ -995,24 +1190,28 @@ static int cheevos_test_condition(cheevos_cond_t *cond)
    }
 }
 
-static int cheevos_test_cond_set(const cheevos_condset_t *condset, int *dirty_conds, int *reset_conds, int match_any)
+static int cheevos_test_cond_set(cheevos_program_t *program, unsigned set, int *dirty_conds, int *reset_conds, int match_any)
 {
    int cond_valid = 0;
    int set_valid = 1;
-   const cheevos_cond_t *end = condset->conds + condset->count;
-   cheevos_cond_t *cond;
+   const unsigned begin = program->set_start[set];
+   const unsigned end = program->set_start[set + 1];
+   const uint8_t *type = program->cond_type;
+   const unsigned *req_hits = program->cond_req_hits;
+   unsigned *curr_hits = program->cond_curr_hits;
+   unsigned cond;
 
    /* Now, read all Pause conditions, and if any are true, do not process further (retain old state) */
-   for (cond = condset->conds; cond < end; cond++)
+   for (cond = begin; cond < end; cond++)
    {
-      if (cond->type == CHEEVOS_COND_TYPE_PAUSE_IF)
+      if (type[cond] == CHEEVOS_COND_TYPE_PAUSE_IF)
       {
          /* Reset by default, set to 1 if hit! */
-         cond->curr_hits = 0;
+         curr_hits[cond] = 0;
 
-         if (cheevos_test_condition(cond))
+         if (cheevos_test_condition(program, cond))
          {
-            cond->curr_hits = 1;
+            curr_hits[cond] = 1;
             *dirty_conds = 1;
 
             /* Early out: this achievement is paused, do not process any further! */
@@ -1022,25 +1221,25 @@ static int cheevos_test_cond_set(const cheevos_condset_t *condset, int *dirty_co
    }
 
    /* Read all standard conditions, and process as normal: */
-   for (cond = condset->conds; cond < end; cond++)
+   for (cond = begin; cond < end; cond++)
    {
-      if (cond->type == CHEEVOS_COND_TYPE_PAUSE_IF || cond->type == CHEEVOS_COND_TYPE_RESET_IF)
+      if (type[cond] == CHEEVOS_COND_TYPE_PAUSE_IF || type[cond] == CHEEVOS_COND_TYPE_RESET_IF)
          continue;
 
-      if (cond->req_hits != 0 && cond->curr_hits >= cond->req_hits)
+      if (req_hits[cond] != 0 && curr_hits[cond] >= req_hits[cond])
          continue;
 
-      cond_valid = cheevos_test_condition(cond);
+      cond_valid = cheevos_test_condition(program, cond);
 
       if (cond_valid)
       {
-         cond->curr_hits++;
+         curr_hits[cond]++;
          *dirty_conds = 1;
 
          /* Process this logic, if this condition is true: */
-         if (cond->req_hits == 0)
+         if (req_hits[cond] == 0)
             ; /* Not a hit-based requirement: ignore any additional logic! */
-         else if (cond->curr_hits < cond->req_hits)
+         else if (curr_hits[cond] < req_hits[cond])
             cond_valid = 0; /* Not entirely valid yet! */
 
          if (match_any)
@@ -1052,11 +1251,11 @@ static int cheevos_test_cond_set(const cheevos_condset_t *condset, int *dirty_co
    }
 
    /* Now, ONLY read reset conditions! */
-   for (cond = condset->conds; cond < end; cond++)
+   for (cond = begin; cond < end; cond++)
    {
-      if (cond->type == CHEEVOS_COND_TYPE_RESET_IF)
+      if (type[cond] == CHEEVOS_COND_TYPE_RESET_IF)
       {
-         cond_valid = cheevos_test_condition(cond);
+         cond_valid = cheevos_test_condition(program, cond);
 
          if (cond_valid)
          {
@@ -1070,56 +1269,48 @@ static int cheevos_test_cond_set(const cheevos_condset_t *condset, int *dirty_co
    return set_valid;
 }
 
-static int cheevos_reset_cond_set(cheevos_condset_t *condset, int deltas)
+static int cheevos_reset_cond_set(cheevos_program_t *program, unsigned set, int deltas)
 {
    int dirty = 0;
-   const cheevos_cond_t *end = condset->conds + condset->count;
-   cheevos_cond_t *cond;
+   const unsigned end = program->set_start[set + 1];
+   unsigned cond;
 
-   if (deltas)
+   for (cond = program->set_start[set]; cond < end; cond++)
    {
-      for (cond = condset->conds; cond < end; cond++)
-      {
-         dirty |= cond->curr_hits != 0;
-         cond->curr_hits = 0;
+      dirty |= program->cond_curr_hits[cond] != 0;
+      program->cond_curr_hits[cond] = 0;
 
-         cond->source.previous = cond->source.value;
-         cond->target.previous = cond->target.value;
-      }
-   }
-   else
-   {
-      for (cond = condset->conds; cond < end; cond++)
+      if (deltas)
       {
-         dirty |= cond->curr_hits != 0;
-         cond->curr_hits = 0;
+         program->var_previous[cond * 2]     = program->var_value[cond * 2];
+         program->var_previous[cond * 2 + 1] = program->var_value[cond * 2 + 1];
       }
    }
 
    return dirty;
 }
 
-static int cheevos_test_cheevo(cheevo_t *cheevo)
+static int cheevos_test_cheevo(cheevos_program_t *program, cheevo_t *cheevo)
 {
    int dirty_conds = 0;
    int reset_conds = 0;
    int ret_val = 0;
    int ret_val_sub_cond = cheevo->count == 1;
-   cheevos_condset_t *condset = cheevo->condsets;
-   const cheevos_condset_t *end = condset + cheevo->count;
+   unsigned set = cheevo->first_set;
+   const unsigned end = set + cheevo->count;
    int dirty;
 
-   if (condset < end)
+   if (set < end)
    {
-      ret_val = cheevos_test_cond_set(condset, &dirty_conds, &reset_conds, 0);
-      condset++;
+      ret_val = cheevos_test_cond_set(program, set, &dirty_conds, &reset_conds, 0);
+      set++;
    }
 
-   while (condset < end)
+   while (set < end)
    {
-      int res = cheevos_test_cond_set(condset, &dirty_conds, &reset_conds, 0);
+      int res = cheevos_test_cond_set(program, set, &dirty_conds, &reset_conds, 0);
       ret_val_sub_cond |= res;
-      condset++;
+      set++;
    }
 
    if (dirty_conds)
@@ -1129,8 +1320,8 @@ static int cheevos_test_cheevo(cheevo_t *cheevo)
    {
       dirty = 0;
 
-      for (condset = cheevo->condsets; condset < end; condset++)
-         dirty |= cheevos_reset_cond_set(condset, 0);
+      for (set = cheevo->first_set; set < end; set++)
+         dirty |= cheevos_reset_cond_set(program, set, 0);
 
       if (dirty)
          cheevo->dirty |= CHEEVOS_DIRTY_CONDITIONS;
@@ -1219,14 +1410,14 @@ static void cheevos_unlocker(void *payload)
    }
 }
 
-static void cheevos_test_cheevo_set(const cheevoset_t *set)
+static void cheevos_test_cheevo_set(cheevoset_t *set)
 {
    const cheevo_t *end = set->cheevos + set->count;
    cheevo_t *cheevo;
 
    for (cheevo = set->cheevos; cheevo < end; cheevo++)
    {
-      if (cheevo->active && cheevos_test_cheevo(cheevo))
+      if (cheevo->active && cheevos_test_cheevo(&set->program, cheevo))
       {
          RARCH_LOG("CHEEVOS %s\n", cheevo->title);
          RARCH_LOG("CHEEVOS %s\n", cheevo->description);
@@ -1243,13 +1434,24 @@ static void cheevos_test_cheevo_set(const cheevoset_t *set)
 
 void cheevos_test(void)
 {
+   static struct retro_perf_counter cheevos_test_perf = {0};
    settings_t *settings         = config_get_ptr();
+
+   if (!cheevos_locals.loaded)
+      return;
+
    if (settings->cheevos.enable && !cheevos_globals.cheats_are_enabled && !cheevos_globals.cheats_were_enabled)
    {
+      rarch_perf_init(&cheevos_test_perf, "cheevos_test");
+      retro_perf_start(&cheevos_test_perf);
+
+      cheevos_update_memory();
       cheevos_test_cheevo_set(&cheevos_locals.core);
 
       if (settings->cheevos.test_unofficial)
          cheevos_test_cheevo_set(&cheevos_locals.unofficial);
+
+      retro_perf_stop(&cheevos_test_perf);
    }
 }
 
@@ -1257,23 +1459,18 @@ void cheevos_test(void)
 Free the loaded achievements.
 *****************************************************************************/
 
-static void cheevos_free_condset(const cheevos_condset_t *set)
-{
-   free((void*)set->conds);
-}
-
-static void cheevos_free_cheevo(const cheevo_t *cheevo)
+static void cheevos_free_cheevo(cheevo_t *cheevo)
 {
    free((void*)cheevo->title);
    free((void*)cheevo->description);
    free((void*)cheevo->author);
    free((void*)cheevo->badge);
-   cheevos_free_condset(cheevo->condsets);
+   cheevos_free_condsets(cheevo);
 }
 
-static void cheevos_free_cheevo_set(const cheevoset_t *set)
+static void cheevos_free_cheevo_set(cheevoset_t *set)
 {
-   const cheevo_t *cheevo = set->cheevos;
+   cheevo_t *cheevo = set->cheevos;
    const cheevo_t *end = cheevo + set->count;
 
    while (cheevo < end)
@@ -1282,6 +1479,7 @@ static void cheevos_free_cheevo_set(const cheevoset_t *set)
    }
 
    free((void*)set->cheevos);
+   cheevos_free_program(&set->program);
 }
 
 void cheevos_unload(void)
@@ -1525,41 +1723,25 @@ static INLINE unsigned cheevos_next_power_of_2(unsigned n)
    return n + 1;
 }
 
-static size_t cheevos_eval_md5(const struct retro_game_info *info, MD5_CTX *ctx)
+static size_t cheevos_eval_md5(const struct retro_game_info *info, rhash_ctx_t *ctx)
 {
-   MD5_Init(ctx);
+   int64_t size;
+
+   rhash_init(ctx, RHASH_MD5);
    
    if (info->data)
    {
-      MD5_Update(ctx, info->data, info->size);
+      rhash_update(ctx, info->data, info->size);
       return info->size;
    }
-   else
-   {
-      RFILE *file = retro_fopen(info->path, RFILE_MODE_READ, 0);
-      size_t size = 0;
-      
-      if (!file)
-         return 0;
-      
-      for (;;)
-      {
-         uint8_t buffer[4096];
-         ssize_t num_read = retro_fread(file, (void*)buffer, sizeof(buffer));
-         
-         if (num_read <= 0)
-            break;
-         
-         MD5_Update(ctx, (void*)buffer, num_read);
-         size += num_read;
-      }
-      
-      retro_fclose(file);
-      return size;
-   }
+
+   /* Streamed through a fixed buffer, so big content isn't loaded
+    * whole just to be hashed. */
+   size = rhash_update_file(ctx, info->path, 0, -1);
+   return size > 0 ? (size_t)size : 0;
 }
 
-static void cheevos_fill_md5(size_t size, size_t total, MD5_CTX *ctx)
+static void cheevos_fill_md5(size_t size, size_t total, rhash_ctx_t *ctx)
 {
    ssize_t fill = total - size;
    char buffer[4096];
@@ -1573,32 +1755,32 @@ static void cheevos_fill_md5(size_t size, size_t total, MD5_CTX *ctx)
       if (len > fill)
          len = fill;
 
-      MD5_Update(ctx, (void*)buffer, len);
+      rhash_update(ctx, (void*)buffer, len);
       fill -= len;
    }
 }
 
 static unsigned cheevos_find_game_id_generic(const struct retro_game_info *info, retro_time_t timeout)
 {
-   MD5_CTX ctx;
-   uint8_t hash[16];
+   rhash_ctx_t ctx;
+   rhash_result_t hash;
    retro_time_t to;
    size_t size;
    
    size = cheevos_eval_md5(info, &ctx);
-   MD5_Final(hash, &ctx);
+   rhash_final(&ctx, &hash);
    
    if (!size)
       return 0;
    
    to = timeout;
-   return cheevos_get_game_id(hash, &to);
+   return cheevos_get_game_id(hash.md5, &to);
 }
 
 static unsigned cheevos_find_game_id_snes(const struct retro_game_info *info, retro_time_t timeout)
 {
-   MD5_CTX ctx;
-   uint8_t hash[16];
+   rhash_ctx_t ctx;
+   rhash_result_t hash;
    retro_time_t to;
    size_t size;
    
@@ -1606,21 +1788,21 @@ static unsigned cheevos_find_game_id_snes(const struct retro_game_info *info, re
    
    if (!size)
    {
-      MD5_Final(hash, &ctx);
+      rhash_final(&ctx, &hash);
       return 0;
    }
    
    cheevos_fill_md5(size, CHEEVOS_EIGHT_MB, &ctx);
-   MD5_Final(hash, &ctx);
+   rhash_final(&ctx, &hash);
    
    to = timeout;
-   return cheevos_get_game_id(hash, &to);
+   return cheevos_get_game_id(hash.md5, &to);
 }
 
 static unsigned cheevos_find_game_id_genesis(const struct retro_game_info *info, retro_time_t timeout)
 {
-   MD5_CTX ctx;
-   uint8_t hash[16];
+   rhash_ctx_t ctx;
+   rhash_result_t hash;
    retro_time_t to;
    size_t size;
    
@@ -1628,15 +1810,15 @@ static unsigned cheevos_find_game_id_genesis(const struct retro_game_info *info,
    
    if (!size)
    {
-      MD5_Final(hash, &ctx);
+      rhash_final(&ctx, &hash);
       return 0;
    }
    
    cheevos_fill_md5(size, CHEEVOS_SIX_MB, &ctx);
-   MD5_Final(hash, &ctx);
+   rhash_final(&ctx, &hash);
    
    to = timeout;
-   return cheevos_get_game_id(hash, &to);
+   return cheevos_get_game_id(hash.md5, &to);
 }
 
 static unsigned cheevos_find_game_id_nes(const struct retro_game_info *info, retro_time_t timeout)
@@ -1652,8 +1834,8 @@ static unsigned cheevos_find_game_id_nes(const struct retro_game_info *info, ret
    } header;
    
    size_t rom_size;
-   MD5_CTX ctx;
-   uint8_t hash[16];
+   rhash_ctx_t ctx;
+   rhash_result_t hash;
    retro_time_t to;
    
    if (info->data)
@@ -1691,43 +1873,21 @@ static unsigned cheevos_find_game_id_nes(const struct retro_game_info *info, ret
       if (rom_size + sizeof(header) > info->size)
          return 0;
       
-      MD5_Init(&ctx);
-      MD5_Update(&ctx, (void*)((char*)info->data + sizeof(header)), rom_size);
-      MD5_Final(hash, &ctx);
+      rhash_init(&ctx, RHASH_MD5);
+      rhash_update(&ctx, (void*)((char*)info->data + sizeof(header)), rom_size);
    }
    else
    {
-      RFILE *file = retro_fopen(info->path, RFILE_MODE_READ, 0);
+      rhash_init(&ctx, RHASH_MD5);
       
-      if (!file)
+      if (rhash_update_file(&ctx, info->path, sizeof(header), rom_size) < 0)
          return 0;
-      
-      MD5_Init(&ctx);
-      retro_fseek(file, sizeof(header), SEEK_SET);
-      
-      for (;;)
-      {
-         uint8_t buffer[4096];
-         ssize_t num_read = retro_fread(file, (void*)buffer, sizeof(buffer));
-         
-         if (num_read <= 0)
-            break;
-         
-         if (num_read >= rom_size)
-         {
-            MD5_Update(&ctx, (void*)buffer, rom_size);
-            break;
-         }
-         
-         MD5_Update(&ctx, (void*)buffer, num_read);
-         rom_size -= num_read;
-      }
-      
-      retro_fclose(file);
    }
    
+   rhash_final(&ctx, &hash);
+   
    to = timeout;
-   return cheevos_get_game_id(hash, &to);
+   return cheevos_get_game_id(hash.md5, &to);
 }
 
 typedef struct
@@ -1876,6 +2036,17 @@ int cheevos_load(const struct retro_game_info *info)
          cheevos_deactivate_unlocks(game_id, &timeout);
          free((void*)json);
          cheevos_locals.loaded = 1;
+
+         /* Compile the conditions for cheevos_test(). */
+         memset((void*)cheevos_locals.region_data, 0, sizeof(cheevos_locals.region_data));
+         memset((void*)cheevos_locals.region_size, 0, sizeof(cheevos_locals.region_size));
+
+         if (cheevos_compile_set(&cheevos_locals.core) || cheevos_compile_set(&cheevos_locals.unofficial))
+         {
+            cheevos_unload();
+            rarch_main_msg_queue_push("Error loading achievements", 0, 5 * 60, false);
+            return -1;
+         }
          
          async_job_add(cheevos_locals.jobs, cheevos_playing, (void*)(uintptr_t)game_id);
          return 0;
@@ -16,6 +16,7 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifndef _WIN32
@@ -255,8 +256,14 @@ static bool cmd_set_shader(const char *arg)
    return video_driver_set_shader(type, arg);
 }
 
+static bool cmd_rewind_seconds(const char *arg)
+{
+   return rewind_seek_seconds((float)strtod(arg, NULL));
+}
+
 static const struct cmd_action_map action_map[] = {
-   { "SET_SHADER", cmd_set_shader, "<shader path>" },
+   { "SET_SHADER",     cmd_set_shader,     "<shader path>" },
+   { "REWIND_SECONDS", cmd_rewind_seconds, "<seconds>" },
 };
 
 static bool command_get_arg(const char *tok,
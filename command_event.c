@@ -26,6 +26,7 @@
 #include "screenshot.h"
 #include "msg_hash.h"
 #include "retroarch.h"
+#include "runahead.h"
 #include "dir_list_special.h"
 
 #ifdef HAVE_CHEEVOS
@@ -124,7 +125,8 @@ static void event_init_autosave(void)
       global->autosave.list[i] = autosave_new(path,
             core.retro_get_memory_data(type),
             core.retro_get_memory_size(type),
-            settings->autosave_interval);
+            settings->autosave_interval,
+            settings->autosave_sync);
 
       if (!global->autosave.list[i])
          RARCH_WARN("%s\n", msg_hash_to_str(MSG_AUTOSAVE_FAILED));
@@ -544,6 +546,8 @@ static void event_deinit_core(bool reinit)
    cheevos_unload();
 #endif
 
+   runahead_deinit();
+
    core.retro_unload_game();
    core.retro_deinit();
 
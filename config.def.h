@@ -351,6 +351,10 @@ static bool bundle_assets_extract_enable = false;
 
 static const bool def_history_list_enable = true;
 
+/* Write playlists made by the database scanner in the
+ * compact binary format instead of text. */
+static const bool def_playlist_compact = false;
+
 static const unsigned int def_user_language = 0;
 
 #if (defined(__APPLE__) && defined(__MACH__) && defined(OSX)) || (defined(_WIN32) && !defined(_XBOX))
@@ -419,6 +423,11 @@ static const unsigned hard_sync_frames = 0;
  */
 static const unsigned frame_delay = 0;
 
+/* Picks the frame delay automatically every frame, as long as it
+ * leaves the core enough time to run before the next VSync.
+ * Overrides frame_delay. */
+static const bool frame_delay_auto = false;
+
 /* Inserts a black frame inbetween frames.
  * Useful for 120 Hz monitors who want to play 60 Hz material with eliminated
  * ghosting. video_refresh_rate should still be configured as if it
@@ -635,6 +644,10 @@ static const bool rate_control = false;
  * is allowed to adjust input rate. */
 static const float rate_control_delta = 0.005;
 
+/* Quality of the sinc resampler (RESAMPLER_QUALITY_*).
+ * Higher tiers cost more CPU time per audio frame. */
+static const unsigned audio_resampler_quality = RESAMPLER_QUALITY_NORMAL;
+
 /* Maximum timing skew. Defines how much adjust_system_rates
  * is allowed to adjust input rate. */
 static const float max_timing_skew = 0.05;
@@ -658,6 +671,36 @@ static const unsigned rewind_buffer_size = 20 << 20; /* 20MiB */
 /* How many frames to rewind at a time. */
 static const unsigned rewind_granularity = 1;
 
+/* Compresses rewind deltas on a separate thread while the
+ * next frame runs. Helps cores with large save states. */
+static const bool rewind_threaded = false;
+
+/* Stores a full save state every N rewind steps, so that
+ * rewinding far back in one go doesn't have to go through
+ * every step in between. 0 disables keyframes. */
+static const unsigned rewind_keyframe_interval = 0;
+
+/* Keeps the rewind buffer in a file next to the save states
+ * instead of in memory. This allows for much larger rewind
+ * buffers, and the history is kept across sessions. */
+static const bool rewind_persistent = false;
+
+/* Runs the core ahead by this many hidden frames every frame and
+ * shows the last one, then goes back to where it was. Hides the
+ * game's own input lag at the cost of running the core
+ * run_ahead_frames + 1 times per frame. Needs save state support. */
+static const bool run_ahead_enable = false;
+
+/* Number of frames to run ahead. Should match the number of lag
+ * frames the game has, more than that skips frames visibly. */
+static const unsigned run_ahead_frames = 1;
+
+/* Runs the hidden frames on a second copy of the core, so the
+ * first one never gets a state loaded and its audio is not
+ * disturbed. Uses twice the memory. Takes effect on the next
+ * content load. */
+static const bool run_ahead_secondary_instance = false;
+
 /* Pause gameplay when gameplay loses focus. */
 static const bool pause_nonactive = true;
 
@@ -665,6 +708,12 @@ static const bool pause_nonactive = true;
  * It is measured in seconds. A value of 0 disables autosave. */
 static const unsigned autosave_interval = 0;
 
+/* Flushes every autosave all the way to the disk, so a power
+ * loss right after can't lose it. Autosaves are always written
+ * to a temporary file first, so the save file itself is never
+ * left half written either way. */
+static const bool autosave_sync = true;
+
 /* When being client over netplay, use keybinds for
  * user 1 rather than user 2. */
 static const bool netplay_client_swap_input = true;
@@ -0,0 +1,82 @@
+#ifndef QB_CONFIG_H__
+#define QB_CONFIG_H__
+
+#define PACKAGE_NAME "retroarch"
+#define HAVE_7ZIP 1
+/* #undef HAVE_AL */
+/* #undef HAVE_ALSA */
+#define HAVE_C99 1
+/* #undef HAVE_CG */
+#define HAVE_CHEEVOS 1
+#define HAVE_COMMAND 1
+/* #undef HAVE_D3D9 */
+/* #undef HAVE_DISPMANX */
+/* #undef HAVE_DRM */
+#define HAVE_DYLIB 1
+#define HAVE_DYNAMIC 1
+#define HAVE_EGL 1
+/* #undef HAVE_EXYNOS */
+#define HAVE_FBO 1
+/* #undef HAVE_FFMPEG */
+/* #undef HAVE_FLOATHARD */
+/* #undef HAVE_FLOATSOFTFP */
+#define HAVE_FREETYPE 1
+/* #undef HAVE_GBM */
+#define HAVE_GETADDRINFO 1
+#define HAVE_GETOPT_LONG 1
+/* #undef HAVE_GLES */
+/* #undef HAVE_GLES3 */
+#if __cplusplus || __STDC_VERSION__ >= 199901L
+#define HAVE_IMAGEVIEWER 1
+#endif
+/* #undef HAVE_JACK */
+/* #undef HAVE_KMS */
+#define HAVE_LIBRETRODB 1
+/* #undef HAVE_LIBUSB */
+#define HAVE_LIBXML2 1
+/* #undef HAVE_MALI_FBDEV */
+#define HAVE_MMAP 1
+/* #undef HAVE_NEON */
+#define HAVE_NETPLAY 1
+#define HAVE_NETWORKING 1
+#define HAVE_NETWORK_CMD 1
+#define HAVE_NOUNUSED 1
+#define HAVE_NOUNUSED_VARIABLE 1
+/* #undef HAVE_OMAP */
+#define HAVE_OPENGL 1
+#define HAVE_OSS 1
+/* #undef HAVE_OSS_BSD */
+/* #undef HAVE_OSS_LIB */
+#define HAVE_PARPORT 1
+/* #undef HAVE_PRESERVE_DYLIB */
+/* #undef HAVE_PULSE */
+/* #undef HAVE_PYTHON */
+/* #undef HAVE_QT */
+#define HAVE_RGUI 1
+/* #undef HAVE_ROAR */
+/* #undef HAVE_RSOUND */
+/* #undef HAVE_SDL */
+/* #undef HAVE_SDL2 */
+/* #undef HAVE_SOCKET_LEGACY */
+/* #undef HAVE_SSE */
+#define HAVE_STB_FONT 1
+#define HAVE_STDIN_CMD 1
+#define HAVE_STRCASESTR 1
+/* #undef HAVE_STRL */
+/* #undef HAVE_SUNXI */
+#define HAVE_THREADS 1
+/* #undef HAVE_UDEV */
+/* #undef HAVE_V4L2 */
+/* #undef HAVE_VG */
+/* #undef HAVE_VIDEOCORE */
+/* #undef HAVE_VIVANTE_FBDEV */
+/* #undef HAVE_WAYLAND */
+/* #undef HAVE_X11 */
+/* #undef HAVE_XEXT */
+/* #undef HAVE_XF86VM */
+/* #undef HAVE_XINERAMA */
+/* #undef HAVE_XKBCOMMON */
+/* #undef HAVE_XSHM */
+/* #undef HAVE_XVIDEO */
+#define HAVE_ZLIB 1
+#endif
@@ -458,6 +458,7 @@ static void config_set_defaults(void)
 #endif
 
    settings->history_list_enable         = def_history_list_enable;
+   settings->playlist_compact            = def_playlist_compact;
    settings->load_dummy_on_core_shutdown = load_dummy_on_core_shutdown;
 
 #ifdef HAVE_FFMPEG
@@ -478,6 +479,7 @@ static void config_set_defaults(void)
    settings->video.hard_sync             = hard_sync;
    settings->video.hard_sync_frames      = hard_sync_frames;
    settings->video.frame_delay           = frame_delay;
+   settings->video.frame_delay_auto      = frame_delay_auto;
    settings->video.black_frame_insertion = black_frame_insertion;
    settings->video.swap_interval         = swap_interval;
    settings->video.threaded              = video_threaded;
@@ -541,6 +543,7 @@ static void config_set_defaults(void)
    settings->audio.rate_control                = rate_control;
    settings->audio.rate_control_delta          = rate_control_delta;
    settings->audio.max_timing_skew             = max_timing_skew;
+   settings->audio.resampler_quality           = audio_resampler_quality;
    settings->audio.volume                      = audio_volume;
 
    audio_driver_set_volume_gain(db_to_gain(settings->audio.volume));
@@ -548,10 +551,17 @@ static void config_set_defaults(void)
    settings->rewind_enable                     = rewind_enable;
    settings->rewind_buffer_size                = rewind_buffer_size;
    settings->rewind_granularity                = rewind_granularity;
+   settings->rewind_threaded                   = rewind_threaded;
+   settings->rewind_keyframe_interval          = rewind_keyframe_interval;
+   settings->rewind_persistent                 = rewind_persistent;
+   settings->run_ahead_enable                  = run_ahead_enable;
+   settings->run_ahead_frames                  = run_ahead_frames;
+   settings->run_ahead_secondary_instance      = run_ahead_secondary_instance;
    settings->slowmotion_ratio                  = slowmotion_ratio;
    settings->fastforward_ratio                 = fastforward_ratio;
    settings->pause_nonactive                   = pause_nonactive;
    settings->autosave_interval                 = autosave_interval;
+   settings->autosave_sync                     = autosave_sync;
 
    settings->block_sram_overwrite              = block_sram_overwrite;
    settings->savestate_auto_index              = savestate_auto_index;
@@ -1310,6 +1320,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT_BASE(conf, settings, video.frame_delay, "video_frame_delay");
    if (settings->video.frame_delay > 15)
       settings->video.frame_delay = 15;
+   CONFIG_GET_BOOL_BASE(conf, settings, video.frame_delay_auto, "video_frame_delay_auto");
 
    CONFIG_GET_BOOL_BASE(conf, settings, video.black_frame_insertion, "video_black_frame_insertion");
    CONFIG_GET_INT_BASE(conf, settings, video.swap_interval, "video_swap_interval");
@@ -1461,6 +1472,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_FLOAT_BASE(conf, settings, audio.max_timing_skew, "audio_max_timing_skew");
    CONFIG_GET_FLOAT_BASE(conf, settings, audio.volume, "audio_volume");
    CONFIG_GET_STRING_BASE(conf, settings, audio.resampler, "audio_resampler");
+   CONFIG_GET_INT_BASE(conf, settings, audio.resampler_quality, "audio_resampler_quality");
    audio_driver_set_volume_gain(db_to_gain(settings->audio.volume));
 
    CONFIG_GET_STRING_BASE(conf, settings, camera.device, "camera_device");
@@ -1606,6 +1618,17 @@ static bool config_load_file(const char *path, bool set_defaults)
    }
 
    CONFIG_GET_INT_BASE(conf, settings, rewind_granularity, "rewind_granularity");
+   CONFIG_GET_BOOL_BASE(conf, settings, rewind_threaded, "rewind_threaded");
+   CONFIG_GET_INT_BASE(conf, settings, rewind_keyframe_interval, "rewind_keyframe_interval");
+   CONFIG_GET_BOOL_BASE(conf, settings, rewind_persistent, "rewind_persistent");
+
+   CONFIG_GET_BOOL_BASE(conf, settings, run_ahead_enable, "run_ahead_enable");
+   CONFIG_GET_INT_BASE(conf, settings, run_ahead_frames, "run_ahead_frames");
+   if (settings->run_ahead_frames < 1)
+      settings->run_ahead_frames = 1;
+   if (settings->run_ahead_frames > 6)
+      settings->run_ahead_frames = 6;
+   CONFIG_GET_BOOL_BASE(conf, settings, run_ahead_secondary_instance, "run_ahead_secondary_instance");
    CONFIG_GET_FLOAT_BASE(conf, settings, slowmotion_ratio, "slowmotion_ratio");
    if (settings->slowmotion_ratio < 1.0f)
       settings->slowmotion_ratio = 1.0f;
@@ -1619,6 +1642,7 @@ static bool config_load_file(const char *path, bool set_defaults)
 
    CONFIG_GET_BOOL_BASE(conf, settings, pause_nonactive, "pause_nonactive");
    CONFIG_GET_INT_BASE(conf, settings, autosave_interval, "autosave_interval");
+   CONFIG_GET_BOOL_BASE(conf, settings, autosave_sync, "autosave_sync");
 
    CONFIG_GET_PATH_BASE(conf, settings, content_database, "content_database_path");
    CONFIG_GET_PATH_BASE(conf, settings, cheat_database, "cheat_database_path");
@@ -1638,6 +1662,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_PATH_BASE(conf, settings, content_history_directory, "content_history_dir");
 
    CONFIG_GET_BOOL_BASE(conf, settings, history_list_enable, "history_list_enable");
+   CONFIG_GET_BOOL_BASE(conf, settings, playlist_compact, "playlist_compact");
 
    CONFIG_GET_PATH_BASE(conf, settings, content_history_path, "content_history_path");
    CONFIG_GET_INT_BASE(conf, settings, content_history_size, "content_history_size");
@@ -2473,6 +2498,13 @@ bool config_save_file(const char *path)
    config_set_bool(conf,  "audio_sync",    settings->audio.sync);
    config_set_int(conf,   "audio_block_frames", settings->audio.block_frames);
    config_set_int(conf,   "rewind_granularity", settings->rewind_granularity);
+   config_set_bool(conf,  "rewind_threaded", settings->rewind_threaded);
+   config_set_int(conf,   "rewind_keyframe_interval", settings->rewind_keyframe_interval);
+   config_set_bool(conf,  "rewind_persistent", settings->rewind_persistent);
+   config_set_bool(conf,  "run_ahead_enable", settings->run_ahead_enable);
+   config_set_int(conf,   "run_ahead_frames", settings->run_ahead_frames);
+   config_set_bool(conf,  "run_ahead_secondary_instance",
+         settings->run_ahead_secondary_instance);
    config_set_path(conf,  "video_shader", settings->video.shader_path);
    config_set_bool(conf,  "video_shader_enable",
          settings->video.shader_enable);
@@ -2482,6 +2514,7 @@ bool config_save_file(const char *path)
          settings->video.windowed_fullscreen);
    config_set_float(conf, "video_scale", settings->video.scale);
    config_set_int(conf,   "autosave_interval", settings->autosave_interval);
+   config_set_bool(conf,  "autosave_sync", settings->autosave_sync);
    config_set_bool(conf,  "video_crop_overscan", settings->video.crop_overscan);
    config_set_bool(conf,  "video_scale_integer", settings->video.scale_integer);
 #ifdef GEKKO
@@ -2532,6 +2565,8 @@ bool config_save_file(const char *path)
    config_set_int(conf,   "video_hard_sync_frames",
          settings->video.hard_sync_frames);
    config_set_int(conf,   "video_frame_delay", settings->video.frame_delay);
+   config_set_bool(conf,  "video_frame_delay_auto",
+         settings->video.frame_delay_auto);
    config_set_bool(conf,  "video_black_frame_insertion",
          settings->video.black_frame_insertion);
    config_set_bool(conf,  "video_disable_composition",
@@ -2599,6 +2634,8 @@ bool config_save_file(const char *path)
    config_set_path(conf, "resampler_directory",
          settings->resampler_directory);
    config_set_string(conf, "audio_resampler", settings->audio.resampler);
+   config_set_int(conf, "audio_resampler_quality",
+         settings->audio.resampler_quality);
    config_set_path(conf, "savefile_directory",
          *global->dir.savefile ? global->dir.savefile : "default");
    config_set_path(conf, "savestate_directory",
@@ -2721,6 +2758,8 @@ bool config_save_file(const char *path)
          settings->savestate_auto_load);
    config_set_bool(conf, "history_list_enable",
          settings->history_list_enable);
+   config_set_bool(conf, "playlist_compact",
+         settings->playlist_compact);
 
    config_set_float(conf, "fastforward_ratio", settings->fastforward_ratio);
    config_set_float(conf, "slowmotion_ratio", settings->slowmotion_ratio);
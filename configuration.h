@@ -54,6 +54,7 @@ typedef struct settings
       unsigned swap_interval;
       unsigned hard_sync_frames;
       unsigned frame_delay;
+      bool frame_delay_auto;
 #ifdef GEKKO
       unsigned viwidth;
       bool vfilter;
@@ -201,6 +202,7 @@ typedef struct settings
       float max_timing_skew;
       float volume; /* dB scale. */
       char resampler[32];
+      unsigned resampler_quality;
    } audio;
 
    struct
@@ -322,15 +324,24 @@ typedef struct settings
    char playlist_directory[PATH_MAX_LENGTH];
 
    bool history_list_enable;
+   bool playlist_compact;
    bool rewind_enable;
    size_t rewind_buffer_size;
    unsigned rewind_granularity;
+   bool rewind_threaded;
+   unsigned rewind_keyframe_interval;
+   bool rewind_persistent;
+
+   bool run_ahead_enable;
+   unsigned run_ahead_frames;
+   bool run_ahead_secondary_instance;
 
    float slowmotion_ratio;
    float fastforward_ratio;
 
    bool pause_nonactive;
    unsigned autosave_interval;
+   bool autosave_sync;
 
    bool block_sram_overwrite;
    bool savestate_auto_index;
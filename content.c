@@ -43,6 +43,7 @@
 #include "dynamic.h"
 #include "movie.h"
 #include "patch.h"
+#include "runahead.h"
 #include "system.h"
 
 #ifdef HAVE_CHEEVOS
@@ -512,11 +513,18 @@ static bool load_content(const struct retro_subsystem_info *special,
    }
 
    if (special)
+   {
       ret = core.retro_load_game_special(special->id, info, content->size);
+      if (ret)
+         runahead_load_secondary(special, info, content->size);
+   }
    else
    {
       ret = core.retro_load_game(*content->elems[0].data ? info : NULL);
-      
+      if (ret)
+         runahead_load_secondary(NULL,
+               *content->elems[0].data ? info : NULL, content->size);
+
 #ifdef HAVE_CHEEVOS
       /* Load the achievements into memory if the game has content. */
 
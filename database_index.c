@@ -0,0 +1,624 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <retro_file.h>
+#include <retro_endianness.h>
+
+#include "database_index.h"
+#include "libretro-db/libretrodb.h"
+#include "libretro-db/rmsgpack.h"
+
+/* Cache file layout, all integers little endian:
+ *
+ *   "RARCHIDX", version (u32), database count (u32)
+ *   per database:
+ *     path length (u32), path, size (u64), mtime (u64),
+ *     CRC32 key count (u32), serial key count (u32),
+ *     keys as key (u32) + record offset (u64)
+ */
+#define DATABASE_INDEX_MAGIC        "RARCHIDX"
+#define DATABASE_INDEX_VERSION      1
+#define DATABASE_INDEX_KEY_SIZE     12
+#define DATABASE_INDEX_MIN_SLOTS    64
+
+typedef struct database_index_key
+{
+   uint32_t key;
+   uint64_t offset;
+} database_index_key_t;
+
+struct database_index_keys
+{
+   database_index_key_t *data;
+   size_t count;
+   size_t capacity;
+};
+
+struct database_index_db
+{
+   char *path;
+   uint64_t size;
+   uint64_t mtime;
+   struct database_index_keys crc;
+   struct database_index_keys serial;
+};
+
+/* Open addressing with linear probing. A slot with offset 0 is empty,
+ * which no record can have since every .rdb starts with its header. */
+typedef struct database_index_slot
+{
+   uint32_t key;
+   uint32_t db;
+   uint64_t offset;
+} database_index_slot_t;
+
+struct database_index_table
+{
+   database_index_slot_t *slots;
+   size_t mask;
+};
+
+struct database_index
+{
+   struct database_index_db *dbs;
+   size_t db_count;
+   struct database_index_table crc;
+   struct database_index_table serial;
+   size_t size;
+};
+
+struct database_index_reader
+{
+   const uint8_t *data;
+   size_t size;
+   size_t pos;
+   bool error;
+};
+
+static uint32_t database_index_hash_serial(const char *data, size_t len)
+{
+   size_t i;
+   uint32_t hash = 5381;
+
+   /* Binary serials are zero padded. */
+   while (len && data[len - 1] == '\0')
+      len--;
+
+   for (i = 0; i < len; i++)
+      hash = (hash << 5) + hash + (uint8_t)data[i];
+   return hash;
+}
+
+static bool database_index_keys_push(struct database_index_keys *keys,
+      uint32_t key, uint64_t offset)
+{
+   if (keys->count == keys->capacity)
+   {
+      size_t capacity           = keys->capacity ? keys->capacity * 2 : 256;
+      database_index_key_t *tmp = (database_index_key_t*)
+         realloc(keys->data, capacity * sizeof(*tmp));
+
+      if (!tmp)
+         return false;
+
+      keys->data     = tmp;
+      keys->capacity = capacity;
+   }
+
+   keys->data[keys->count].key    = key;
+   keys->data[keys->count].offset = offset;
+   keys->count++;
+   return true;
+}
+
+static void database_index_db_free(struct database_index_db *db)
+{
+   free(db->path);
+   free(db->crc.data);
+   free(db->serial.data);
+   memset(db, 0, sizeof(*db));
+}
+
+static bool database_index_db_stat(struct database_index_db *db)
+{
+   struct stat st;
+
+   if (stat(db->path, &st) != 0)
+      return false;
+
+   db->size  = (uint64_t)st.st_size;
+   db->mtime = (uint64_t)st.st_mtime;
+   return true;
+}
+
+/* Walks every record of one database and collects its keys, reading
+ * them straight out of the encoded records. */
+static bool database_index_db_scan(struct database_index_db *db)
+{
+   size_t len;
+   int64_t offset;
+   const uint8_t *record    = NULL;
+   bool ret                 = false;
+   libretrodb_t *rdb        = libretrodb_new();
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+
+   if (!rdb || !cur)
+      goto end;
+
+   if (libretrodb_open(db->path, rdb) != 0)
+      goto end;
+
+   if (libretrodb_cursor_open(rdb, cur, NULL) != 0)
+      goto close;
+
+   while ((offset = libretrodb_cursor_tell(cur)) > 0
+         && libretrodb_cursor_read_raw(cur, &record, &len) == 0)
+   {
+      struct rmsgpack_dom_value crc, serial;
+      bool pushed     = true;
+      bool has_crc    = rmsgpack_raw_map_value(record, len,
+            "crc", 3, &crc) > 0;
+      bool has_serial = rmsgpack_raw_map_value(record, len,
+            "serial", 6, &serial) > 0;
+
+      if (has_crc && crc.type == RDT_BINARY && crc.val.binary.len == 4)
+      {
+         uint32_t value;
+         memcpy(&value, crc.val.binary.buff, sizeof(value));
+         pushed = database_index_keys_push(&db->crc,
+               swap_if_little32(value), (uint64_t)offset);
+      }
+
+      if (pushed && has_serial && serial.type == RDT_STRING)
+         pushed = database_index_keys_push(&db->serial,
+               database_index_hash_serial(serial.val.string.buff,
+                  serial.val.string.len), (uint64_t)offset);
+      else if (pushed && has_serial && serial.type == RDT_BINARY)
+         pushed = database_index_keys_push(&db->serial,
+               database_index_hash_serial(serial.val.binary.buff,
+                  serial.val.binary.len), (uint64_t)offset);
+
+      if (!pushed)
+         goto close;
+   }
+
+   ret = true;
+
+close:
+   libretrodb_cursor_close(cur);
+   libretrodb_close(rdb);
+end:
+   if (cur)
+      libretrodb_cursor_free(cur);
+   if (rdb)
+      libretrodb_free(rdb);
+   return ret;
+}
+
+static const uint8_t *database_index_read(
+      struct database_index_reader *reader, size_t len)
+{
+   const uint8_t *data = reader->data + reader->pos;
+
+   if (reader->error || len > reader->size - reader->pos)
+   {
+      reader->error = true;
+      return NULL;
+   }
+
+   reader->pos += len;
+   return data;
+}
+
+static uint32_t database_index_read32(struct database_index_reader *reader)
+{
+   uint32_t value       = 0;
+   const uint8_t *data  = database_index_read(reader, sizeof(value));
+
+   if (data)
+      memcpy(&value, data, sizeof(value));
+   return swap_if_big32(value);
+}
+
+static uint64_t database_index_read64(struct database_index_reader *reader)
+{
+   uint64_t value       = 0;
+   const uint8_t *data  = database_index_read(reader, sizeof(value));
+
+   if (data)
+      memcpy(&value, data, sizeof(value));
+   return swap_if_big64(value);
+}
+
+static bool database_index_read_keys(struct database_index_reader *reader,
+      struct database_index_keys *keys, uint32_t count)
+{
+   uint32_t i;
+
+   if ((size_t)count > (reader->size - reader->pos) / DATABASE_INDEX_KEY_SIZE)
+   {
+      reader->error = true;
+      return false;
+   }
+
+   if (!count)
+      return true;
+
+   keys->data = (database_index_key_t*)malloc(count * sizeof(*keys->data));
+   if (!keys->data)
+      return false;
+
+   keys->capacity = count;
+   keys->count    = count;
+
+   for (i = 0; i < count; i++)
+   {
+      keys->data[i].key    = database_index_read32(reader);
+      keys->data[i].offset = database_index_read64(reader);
+   }
+
+   return true;
+}
+
+/* Returns the databases stored in @path, or NULL if the file is
+ * missing, from another version or damaged. */
+static struct database_index_db *database_index_cache_load(
+      const char *path, size_t *count)
+{
+   uint32_t i, db_count;
+   struct database_index_reader reader = {0};
+   struct database_index_db *dbs       = NULL;
+   void *buf                           = NULL;
+   ssize_t len                         = 0;
+   const uint8_t *magic                = NULL;
+
+   *count = 0;
+
+   if (!path || retro_read_file(path, &buf, &len) != 1 || len <= 0)
+      goto error;
+
+   reader.data = (const uint8_t*)buf;
+   reader.size = (size_t)len;
+
+   magic = database_index_read(&reader, strlen(DATABASE_INDEX_MAGIC));
+   if (!magic || memcmp(magic, DATABASE_INDEX_MAGIC,
+            strlen(DATABASE_INDEX_MAGIC)) != 0)
+      goto error;
+
+   if (database_index_read32(&reader) != DATABASE_INDEX_VERSION)
+      goto error;
+
+   db_count = database_index_read32(&reader);
+   if (reader.error || db_count > reader.size)
+      goto error;
+
+   dbs = (struct database_index_db*)calloc(db_count + 1, sizeof(*dbs));
+   if (!dbs)
+      goto error;
+
+   for (i = 0; i < db_count; i++)
+   {
+      uint32_t crc_count, serial_count;
+      uint32_t path_len    = database_index_read32(&reader);
+      const uint8_t *name  = database_index_read(&reader, path_len);
+
+      if (!name)
+         goto error;
+
+      dbs[i].path = (char*)malloc(path_len + 1);
+      if (!dbs[i].path)
+         goto error;
+      memcpy(dbs[i].path, name, path_len);
+      dbs[i].path[path_len] = '\0';
+
+      dbs[i].size   = database_index_read64(&reader);
+      dbs[i].mtime  = database_index_read64(&reader);
+      crc_count     = database_index_read32(&reader);
+      serial_count  = database_index_read32(&reader);
+
+      if (     !database_index_read_keys(&reader, &dbs[i].crc, crc_count)
+            || !database_index_read_keys(&reader, &dbs[i].serial, serial_count))
+         goto error;
+   }
+
+   free(buf);
+   *count = db_count;
+   return dbs;
+
+error:
+   if (dbs)
+   {
+      for (i = 0; dbs[i].path; i++)
+         database_index_db_free(&dbs[i]);
+      free(dbs);
+   }
+   free(buf);
+   return NULL;
+}
+
+static uint8_t *database_index_write32(uint8_t *out, uint32_t value)
+{
+   value = swap_if_big32(value);
+   memcpy(out, &value, sizeof(value));
+   return out + sizeof(value);
+}
+
+static uint8_t *database_index_write64(uint8_t *out, uint64_t value)
+{
+   value = swap_if_big64(value);
+   memcpy(out, &value, sizeof(value));
+   return out + sizeof(value);
+}
+
+static uint8_t *database_index_write_keys(uint8_t *out,
+      const struct database_index_keys *keys)
+{
+   size_t i;
+
+   for (i = 0; i < keys->count; i++)
+   {
+      out = database_index_write32(out, keys->data[i].key);
+      out = database_index_write64(out, keys->data[i].offset);
+   }
+
+   return out;
+}
+
+static bool database_index_cache_save(const database_index_t *index,
+      const char *path)
+{
+   size_t i;
+   bool ret;
+   uint8_t *buf, *out;
+   size_t size = strlen(DATABASE_INDEX_MAGIC) + 8;
+
+   for (i = 0; i < index->db_count; i++)
+   {
+      const struct database_index_db *db = &index->dbs[i];
+      size += 28 + strlen(db->path)
+         + (db->crc.count + db->serial.count) * DATABASE_INDEX_KEY_SIZE;
+   }
+
+   buf = (uint8_t*)malloc(size);
+   if (!buf)
+      return false;
+
+   memcpy(buf, DATABASE_INDEX_MAGIC, strlen(DATABASE_INDEX_MAGIC));
+   out = buf + strlen(DATABASE_INDEX_MAGIC);
+   out = database_index_write32(out, DATABASE_INDEX_VERSION);
+   out = database_index_write32(out, (uint32_t)index->db_count);
+
+   for (i = 0; i < index->db_count; i++)
+   {
+      const struct database_index_db *db = &index->dbs[i];
+      size_t path_len                    = strlen(db->path);
+
+      out = database_index_write32(out, (uint32_t)path_len);
+      memcpy(out, db->path, path_len);
+      out += path_len;
+      out = database_index_write64(out, db->size);
+      out = database_index_write64(out, db->mtime);
+      out = database_index_write32(out, (uint32_t)db->crc.count);
+      out = database_index_write32(out, (uint32_t)db->serial.count);
+      out = database_index_write_keys(out, &db->crc);
+      out = database_index_write_keys(out, &db->serial);
+   }
+
+   ret = retro_write_file(path, buf, (ssize_t)size);
+   free(buf);
+   return ret;
+}
+
+static const struct database_index_keys *database_index_db_keys(
+      const struct database_index_db *db, bool serial)
+{
+   return serial ? &db->serial : &db->crc;
+}
+
+static bool database_index_table_build(struct database_index_table *table,
+      const database_index_t *index, bool serial)
+{
+   size_t i, j, slots = DATABASE_INDEX_MIN_SLOTS;
+   size_t count       = 0;
+
+   for (i = 0; i < index->db_count; i++)
+      count += database_index_db_keys(&index->dbs[i], serial)->count;
+
+   /* Keep the load factor at or below one half. */
+   while (slots < count * 2)
+      slots *= 2;
+
+   table->slots = (database_index_slot_t*)calloc(slots, sizeof(*table->slots));
+   if (!table->slots)
+      return false;
+   table->mask  = slots - 1;
+
+   /* Inserting in database order keeps equal keys in that order
+    * along the probe sequence. */
+   for (i = 0; i < index->db_count; i++)
+   {
+      const struct database_index_keys *keys =
+         database_index_db_keys(&index->dbs[i], serial);
+
+      for (j = 0; j < keys->count; j++)
+      {
+         size_t slot = keys->data[j].key & table->mask;
+
+         while (table->slots[slot].offset)
+            slot = (slot + 1) & table->mask;
+
+         table->slots[slot].key    = keys->data[j].key;
+         table->slots[slot].db     = (uint32_t)i;
+         table->slots[slot].offset = keys->data[j].offset;
+      }
+   }
+
+   return true;
+}
+
+static size_t database_index_table_find(
+      const struct database_index_table *table, uint32_t key,
+      database_index_match_t *matches, size_t max)
+{
+   size_t count = 0;
+   size_t slot  = key & table->mask;
+
+   while (table->slots[slot].offset && count < max)
+   {
+      if (table->slots[slot].key == key)
+      {
+         matches[count].db     = table->slots[slot].db;
+         matches[count].offset = table->slots[slot].offset;
+         count++;
+      }
+      slot = (slot + 1) & table->mask;
+   }
+
+   return count;
+}
+
+database_index_t *database_index_new(const struct string_list *databases,
+      const char *cache_path)
+{
+   size_t i, j, cached_count;
+   struct database_index_db *cached = NULL;
+   database_index_t *index          = (database_index_t*)
+      calloc(1, sizeof(*index));
+   bool dirty                       = false;
+
+   if (!index || !databases)
+      goto error;
+
+   index->dbs = (struct database_index_db*)
+      calloc(databases->size + 1, sizeof(*index->dbs));
+   if (!index->dbs)
+      goto error;
+
+   cached = database_index_cache_load(cache_path, &cached_count);
+   if (cached_count != databases->size)
+      dirty = true;
+
+   for (i = 0; i < databases->size; i++)
+   {
+      struct database_index_db *db = &index->dbs[index->db_count++];
+
+      db->path = strdup(databases->elems[i].data);
+      if (!db->path)
+         goto error;
+
+      /* Still indexed if it can't be stat'ed, just never cached. */
+      if (!database_index_db_stat(db))
+         db->mtime = db->size = 0;
+
+      for (j = 0; j < cached_count; j++)
+      {
+         struct database_index_db *old = &cached[j];
+
+         if (     old->path
+               && db->size
+               && old->size  == db->size
+               && old->mtime == db->mtime
+               && !strcmp(old->path, db->path))
+         {
+            db->crc       = old->crc;
+            db->serial    = old->serial;
+            memset(&old->crc, 0, sizeof(old->crc));
+            memset(&old->serial, 0, sizeof(old->serial));
+            free(old->path);
+            old->path     = NULL;
+            break;
+         }
+      }
+
+      if (j == cached_count)
+      {
+         dirty = true;
+         /* Don't cache a partial scan. */
+         if (!database_index_db_scan(db))
+            db->mtime = db->size = 0;
+      }
+
+      index->size += db->crc.count + db->serial.count;
+   }
+
+   if (     !database_index_table_build(&index->crc, index, false)
+         || !database_index_table_build(&index->serial, index, true))
+      goto error;
+
+   if (dirty && cache_path)
+      database_index_cache_save(index, cache_path);
+
+   if (cached)
+   {
+      for (j = 0; j < cached_count; j++)
+         database_index_db_free(&cached[j]);
+      free(cached);
+   }
+
+   return index;
+
+error:
+   if (cached)
+   {
+      for (j = 0; j < cached_count; j++)
+         database_index_db_free(&cached[j]);
+      free(cached);
+   }
+   database_index_free(index);
+   return NULL;
+}
+
+void database_index_free(database_index_t *index)
+{
+   size_t i;
+
+   if (!index)
+      return;
+
+   for (i = 0; i < index->db_count; i++)
+      database_index_db_free(&index->dbs[i]);
+
+   free(index->dbs);
+   free(index->crc.slots);
+   free(index->serial.slots);
+   free(index);
+}
+
+size_t database_index_find_crc(const database_index_t *index, uint32_t crc,
+      database_index_match_t *matches, size_t max)
+{
+   if (!index)
+      return 0;
+   return database_index_table_find(&index->crc, crc, matches, max);
+}
+
+size_t database_index_find_serial(const database_index_t *index,
+      const char *serial, database_index_match_t *matches, size_t max)
+{
+   if (!index || !serial || !*serial)
+      return 0;
+   return database_index_table_find(&index->serial,
+         database_index_hash_serial(serial, strlen(serial)), matches, max);
+}
+
+size_t database_index_size(const database_index_t *index)
+{
+   return index ? index->size : 0;
+}
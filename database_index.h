@@ -0,0 +1,104 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASE_INDEX_H_
+#define DATABASE_INDEX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <string/string_list.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Hash index over the CRC32 and serial of every record in a set of
+ * .rdb databases, so the content scanner can find the records that
+ * match a file without walking every database.
+ *
+ * The index can be persisted to a cache file. Each database's part of
+ * the cache is keyed on its path, size and modification time, so only
+ * the databases that changed since the cache was written are read
+ * again. */
+
+typedef struct database_index database_index_t;
+
+typedef struct database_index_match
+{
+   /* Position of the database in the list the index was built from. */
+   unsigned db;
+   /* Record offset, for libretrodb_cursor_seek(). */
+   uint64_t offset;
+} database_index_match_t;
+
+/**
+ * database_index_new:
+ * @databases           : List of .rdb paths.
+ * @cache_path          : Cache file to load and update, or NULL.
+ *
+ * Builds the index for @databases, reusing the parts of @cache_path
+ * that are still current and rewriting it if anything changed.
+ *
+ * Returns: index handle, or NULL on allocation failure.
+ **/
+database_index_t *database_index_new(const struct string_list *databases,
+      const char *cache_path);
+
+void database_index_free(database_index_t *index);
+
+/**
+ * database_index_find_crc:
+ * @index               : Index handle.
+ * @crc                 : CRC32 of the content.
+ * @matches             : Filled with up to @max matches.
+ * @max                 : Size of @matches.
+ *
+ * Matches come in database order.
+ *
+ * Returns: number of matches stored in @matches.
+ **/
+size_t database_index_find_crc(const database_index_t *index, uint32_t crc,
+      database_index_match_t *matches, size_t max);
+
+/**
+ * database_index_find_serial:
+ * @index               : Index handle.
+ * @serial              : Serial of the content.
+ * @matches             : Filled with up to @max candidates.
+ * @max                 : Size of @matches.
+ *
+ * Serials are stored as hashes, so the caller has to compare the
+ * serial of each returned record.
+ *
+ * Returns: number of candidates stored in @matches.
+ **/
+size_t database_index_find_serial(const database_index_t *index,
+      const char *serial, database_index_match_t *matches, size_t max);
+
+/**
+ * database_index_size:
+ * @index               : Index handle.
+ *
+ * Returns: total number of CRC32 and serial keys in the index.
+ **/
+size_t database_index_size(const database_index_t *index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,6 +22,7 @@
 
 #include "dir_list_special.h"
 #include "database_info.h"
+#include "libretro-db/rmsgpack.h"
 #include "msg_hash.h"
 #include "general.h"
 
@@ -219,83 +220,104 @@ char *bin_to_hex_alloc(const uint8_t *data, size_t len)
 }
 
 
+/* Record strings point into the database and aren't terminated. */
+static char *database_info_strdup(const struct rmsgpack_dom_value *val)
+{
+   char *s = (char*)malloc(val->val.string.len + 1);
+
+   if (!s)
+      return NULL;
+
+   memcpy(s, val->val.string.buff, val->val.string.len);
+   s[val->val.string.len] = '\0';
+   return s;
+}
+
 static int database_cursor_iterate(libretrodb_cursor_t *cur,
       database_info_t *db_info)
 {
-   unsigned i;
-   struct rmsgpack_dom_value item;
-   const char* str                = NULL;
-
-   if (libretrodb_cursor_read_item(cur, &item) != 0)
+   size_t len;
+   struct rmsgpack_raw_map_iter iter;
+   struct rmsgpack_dom_value key_item, val_item;
+   const struct rmsgpack_dom_value *key = &key_item;
+   const struct rmsgpack_dom_value *val = &val_item;
+   const uint8_t *record                = NULL;
+
+   /* Fields are copied straight out of the encoded record. */
+   if (libretrodb_cursor_read_raw(cur, &record, &len) != 0)
       return -1;
 
-   if (item.type != RDT_MAP)
-   {
-      rmsgpack_dom_value_free(&item);
+   if (rmsgpack_raw_map_begin(&iter, record, len) < 0)
       return 1;
-   }
 
    db_info->analog_supported       = -1;
    db_info->rumble_supported       = -1;
 
-   for (i = 0; i < item.val.map.len; i++)
+   while (rmsgpack_raw_map_next(&iter, &key_item, &val_item) > 0)
    {
-      uint32_t                 value = 0;
-      struct rmsgpack_dom_value *key = &item.val.map.items[i].key;
-      struct rmsgpack_dom_value *val = &item.val.map.items[i].value;
+      char str[64];
+      uint32_t crc32 = 0;
+      uint32_t value = 0;
 
-      if (!key || !val)
+      if (key->type != RDT_STRING || key->val.string.len >= sizeof(str))
          continue;
 
-      str   = key->val.string.buff;
+      memcpy(str, key->val.string.buff, key->val.string.len);
+      str[key->val.string.len] = '\0';
       value = msg_hash_calculate(str);
 
       switch (value)
       {
          case DB_CURSOR_SERIAL:
-            db_info->serial = strdup(val->val.string.buff);
+            db_info->serial = database_info_strdup(val);
             break;
          case DB_CURSOR_ROM_NAME:
-            db_info->rom_name = strdup(val->val.string.buff);
+            db_info->rom_name = database_info_strdup(val);
             break;
          case DB_CURSOR_NAME:
-            db_info->name = strdup(val->val.string.buff);
+            db_info->name = database_info_strdup(val);
             break;
          case DB_CURSOR_DESCRIPTION:
-            db_info->description = strdup(val->val.string.buff);
+            db_info->description = database_info_strdup(val);
             break;
          case DB_CURSOR_PUBLISHER:
-            db_info->publisher = strdup(val->val.string.buff);
+            db_info->publisher = database_info_strdup(val);
             break;
          case DB_CURSOR_DEVELOPER:
-            db_info->developer = string_split(val->val.string.buff, "|");
+            {
+               char *developer = database_info_strdup(val);
+
+               if (developer)
+                  db_info->developer = string_split(developer, "|");
+               free(developer);
+            }
             break;
          case DB_CURSOR_ORIGIN:
-            db_info->origin = strdup(val->val.string.buff);
+            db_info->origin = database_info_strdup(val);
             break;
          case DB_CURSOR_FRANCHISE:
-            db_info->franchise = strdup(val->val.string.buff);
+            db_info->franchise = database_info_strdup(val);
             break;
          case DB_CURSOR_BBFC_RATING:
-            db_info->bbfc_rating = strdup(val->val.string.buff);
+            db_info->bbfc_rating = database_info_strdup(val);
             break;
          case DB_CURSOR_ESRB_RATING:
-            db_info->esrb_rating = strdup(val->val.string.buff);
+            db_info->esrb_rating = database_info_strdup(val);
             break;
          case DB_CURSOR_ELSPA_RATING:
-            db_info->elspa_rating = strdup(val->val.string.buff);
+            db_info->elspa_rating = database_info_strdup(val);
             break;
          case DB_CURSOR_CERO_RATING:
-            db_info->cero_rating = strdup(val->val.string.buff);
+            db_info->cero_rating = database_info_strdup(val);
             break;
          case DB_CURSOR_PEGI_RATING:
-            db_info->pegi_rating = strdup(val->val.string.buff);
+            db_info->pegi_rating = database_info_strdup(val);
             break;
          case DB_CURSOR_ENHANCEMENT_HW:
-            db_info->enhancement_hw = strdup(val->val.string.buff);
+            db_info->enhancement_hw = database_info_strdup(val);
             break;
          case DB_CURSOR_EDGE_MAGAZINE_REVIEW:
-            db_info->edge_magazine_review = strdup(val->val.string.buff);
+            db_info->edge_magazine_review = database_info_strdup(val);
             break;
          case DB_CURSOR_EDGE_MAGAZINE_RATING:
             db_info->edge_magazine_rating = val->val.uint_;
@@ -325,7 +347,8 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
             db_info->size = val->val.uint_;
             break;
          case DB_CURSOR_CHECKSUM_CRC32:
-            db_info->crc32 = swap_if_little32(*(uint32_t*)val->val.binary.buff);
+            memcpy(&crc32, val->val.binary.buff, sizeof(crc32));
+            db_info->crc32 = swap_if_little32(crc32);
             break;
          case DB_CURSOR_CHECKSUM_SHA1:
             db_info->sha1 = bin_to_hex_alloc((uint8_t*)val->val.binary.buff, val->val.binary.len);
@@ -339,8 +362,6 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
       }
    }
 
-   rmsgpack_dom_value_free(&item);
-
    return 0;
 }
 
@@ -512,6 +533,61 @@ end:
    return database_info_list;
 }
 
+/**
+ * database_info_list_new_at:
+ * @rdb_path            : Path to the database.
+ * @offset              : Record offset, as stored by the database index.
+ *
+ * Reads the single record at @offset instead of walking the database.
+ *
+ * Returns: list holding that record, or NULL.
+ **/
+database_info_list_t *database_info_list_new_at(
+      const char *rdb_path, uint64_t offset)
+{
+   database_info_list_t *database_info_list = NULL;
+   libretrodb_t *db                         = libretrodb_new();
+   libretrodb_cursor_t *cur                 = libretrodb_cursor_new();
+
+   if (!db || !cur)
+      goto end;
+
+   if ((database_cursor_open(db, cur, rdb_path, NULL) != 0))
+      goto end;
+
+   if (libretrodb_cursor_seek(cur, offset) != 0)
+      goto end;
+
+   database_info_list = (database_info_list_t*)
+      calloc(1, sizeof(*database_info_list));
+
+   if (!database_info_list)
+      goto end;
+
+   database_info_list->list = (database_info_t*)
+      calloc(1, sizeof(database_info_t));
+
+   if (     !database_info_list->list
+         || database_cursor_iterate(cur, database_info_list->list) != 0)
+   {
+      database_info_list_free(database_info_list);
+      database_info_list = NULL;
+      goto end;
+   }
+
+   database_info_list->count = 1;
+
+end:
+   database_cursor_close(db, cur);
+
+   if (db)
+      libretrodb_free(db);
+   if (cur)
+      libretrodb_cursor_free(cur);
+
+   return database_info_list;
+}
+
 void database_info_list_free(database_info_list_t *database_info_list)
 {
    size_t i;
@@ -197,6 +197,62 @@ void libretro_free_system_info(struct retro_system_info *info)
    free((void*)info->valid_extensions);
    memset(info, 0, sizeof(*info));
 }
+
+#define SYMBOL_LIB(x) do { \
+   function_t func = dylib_proc(lib, #x); \
+   memcpy(&dst->x, &func, sizeof(func)); \
+   if (dst->x == NULL) { RARCH_ERR("Failed to load symbol: \"%s\"\n", #x); return false; } \
+} while (0)
+
+/**
+ * libretro_load_core_symbols:
+ * @lib                          : Handle of a libretro library.
+ * @dst                          : Core to bind the symbols of @lib to.
+ *
+ * Binds a core loaded next to the main one, such as the
+ * run-ahead instance. Unlike init_libretro_sym(), a missing
+ * symbol is not fatal.
+ *
+ * Returns: true (1) if all symbols were found, otherwise false (0).
+ **/
+bool libretro_load_core_symbols(dylib_t lib, struct retro_core_t *dst)
+{
+   SYMBOL_LIB(retro_init);
+   SYMBOL_LIB(retro_deinit);
+
+   SYMBOL_LIB(retro_api_version);
+   SYMBOL_LIB(retro_get_system_info);
+   SYMBOL_LIB(retro_get_system_av_info);
+
+   SYMBOL_LIB(retro_set_environment);
+   SYMBOL_LIB(retro_set_video_refresh);
+   SYMBOL_LIB(retro_set_audio_sample);
+   SYMBOL_LIB(retro_set_audio_sample_batch);
+   SYMBOL_LIB(retro_set_input_poll);
+   SYMBOL_LIB(retro_set_input_state);
+
+   SYMBOL_LIB(retro_set_controller_port_device);
+
+   SYMBOL_LIB(retro_reset);
+   SYMBOL_LIB(retro_run);
+
+   SYMBOL_LIB(retro_serialize_size);
+   SYMBOL_LIB(retro_serialize);
+   SYMBOL_LIB(retro_unserialize);
+
+   SYMBOL_LIB(retro_cheat_reset);
+   SYMBOL_LIB(retro_cheat_set);
+
+   SYMBOL_LIB(retro_load_game);
+   SYMBOL_LIB(retro_load_game_special);
+
+   SYMBOL_LIB(retro_unload_game);
+   SYMBOL_LIB(retro_get_region);
+   SYMBOL_LIB(retro_get_memory_data);
+   SYMBOL_LIB(retro_get_memory_size);
+
+   return true;
+}
 #endif
 
 const struct retro_subsystem_info *libretro_find_subsystem_info(
@@ -744,6 +800,12 @@ bool rarch_environment_cb(unsigned cmd, void *data)
                settings->user_language);
          break;
 
+      case RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER:
+         if (!video_driver_get_current_software_framebuffer(
+                  (struct retro_framebuffer*)data))
+            return false;
+         break;
+
       case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
       {
          enum retro_pixel_format pix_fmt =
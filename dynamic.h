@@ -155,6 +155,19 @@ struct retro_core_t {
 
 extern struct retro_core_t core;
 
+#ifdef HAVE_DYNAMIC
+/**
+ * libretro_load_core_symbols:
+ * @lib                          : Handle of a libretro library.
+ * @dst                          : Core to bind the symbols of @lib to.
+ *
+ * Binds a core loaded next to the main one.
+ *
+ * Returns: true (1) if all symbols were found, otherwise false (0).
+ **/
+bool libretro_load_core_symbols(dylib_t lib, struct retro_core_t *dst);
+#endif
+
 /**
  * init_libretro_sym:
  * @type                        : Type of core to be loaded.
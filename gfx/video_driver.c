@@ -271,6 +271,18 @@ retro_proc_address_t video_driver_get_proc_address(const char *sym)
    return NULL;
 }
 
+bool video_driver_get_current_software_framebuffer(
+      struct retro_framebuffer *framebuffer)
+{
+   driver_t                   *driver = driver_get_ptr();
+   const video_poke_interface_t *poke = video_driver_get_poke_ptr(driver);
+
+   if (poke && poke->get_current_software_framebuffer)
+      return poke->get_current_software_framebuffer(
+            driver->video_data, framebuffer);
+   return false;
+}
+
 bool video_driver_set_shader(enum rarch_shader_type type,
       const char *path)
 {
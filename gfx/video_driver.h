@@ -124,6 +124,11 @@ typedef struct video_poke_interface
    void (*grab_mouse_toggle)(void *data);
 
    struct video_shader *(*get_current_shader)(void *data);
+
+   /* Hand the core a buffer to render the next frame into.
+    * Used by RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER. */
+   bool (*get_current_software_framebuffer)(void *data,
+         struct retro_framebuffer *framebuffer);
 } video_poke_interface_t;
 
 typedef struct video_driver
@@ -270,6 +275,19 @@ uintptr_t video_driver_get_current_framebuffer(void);
 
 retro_proc_address_t video_driver_get_proc_address(const char *sym);
 
+/**
+ * video_driver_get_current_software_framebuffer:
+ * @framebuffer               : Framebuffer requested by the core.
+ *
+ * Gets a buffer owned by the video driver which the core can
+ * render the current frame into, avoiding a copy.
+ * Used by RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER.
+ *
+ * Returns: true (1) if @framebuffer was filled in, otherwise false (0).
+ **/
+bool video_driver_get_current_software_framebuffer(
+      struct retro_framebuffer *framebuffer);
+
 bool video_driver_set_shader(enum rarch_shader_type type,
       const char *shader);
 
@@ -35,67 +35,243 @@ struct rarch_soft_plug
    const struct softfilter_implementation *impl;
 };
 
+/* Work is cut into row bands of roughly this many bytes of input
+ * plus output, so a band's rows stay in L2 while it is filtered.
+ * Scaling filters write up to four output pixels per input pixel,
+ * hence the expansion factor. */
+#define SOFTFILTER_BAND_BYTES       (128 * 1024)
+#define SOFTFILTER_BAND_EXPANSION   5
+#define SOFTFILTER_MIN_BAND_ROWS    4
+/* Enough bands per worker that idle workers have something to
+ * steal when some bands are more expensive than others. */
+#define SOFTFILTER_BANDS_PER_WORKER 4
+
 #ifdef HAVE_THREADS
 #include <rthreads/rthreads.h>
 
+/* Bands owned by one worker. The owner takes from the front,
+ * idle workers steal from the back. */
+struct filter_queue
+{
+   slock_t *lock;
+   unsigned head;
+   unsigned tail;
+};
+
 struct filter_thread_data
 {
    sthread_t *thread;
-   const struct softfilter_work_packet *packet;
-   scond_t *cond;
+   struct rarch_softfilter *filt;
+   unsigned index;
+};
+#endif
+
+struct rarch_softfilter
+{
+   config_file_t *conf;
+
+   const struct softfilter_implementation *impl;
+   void *impl_data;
+
+   struct rarch_soft_plug *plugs;
+   unsigned num_plugs;
+
+   unsigned max_width, max_height;
+   enum retro_pixel_format pix_fmt, out_pix_fmt;
+
+   struct softfilter_work_packet *packets;
+   unsigned threads;
+
+#ifdef HAVE_THREADS
+   /* The thread calling rarch_softfilter_process() is worker 0
+    * and owns queues[0]; thread_data[i] runs worker i + 1. */
+   unsigned workers;
+   struct filter_queue *queues;
+   struct filter_thread_data *thread_data;
+
    slock_t *lock;
-   void *userdata;
+   scond_t *cond;
+   scond_t *done_cond;
+   unsigned generation;
+   unsigned busy;
    bool die;
-   bool done;
+#endif
 };
 
+#ifdef HAVE_THREADS
+static bool filter_queue_pop(struct filter_queue *queue,
+      bool steal, unsigned *index)
+{
+   bool ret = false;
+
+   slock_lock(queue->lock);
+   if (queue->head < queue->tail)
+   {
+      *index = steal ? --queue->tail : queue->head++;
+      ret    = true;
+   }
+   slock_unlock(queue->lock);
+
+   return ret;
+}
+
+/* Runs bands until every queue is empty: first our own,
+ * then whatever is left at the back of the others. */
+static void filter_run_queues(rarch_softfilter_t *filt, unsigned self)
+{
+   unsigned i, index;
+
+   for (;;)
+   {
+      bool found = filter_queue_pop(&filt->queues[self], false, &index);
+
+      for (i = 1; !found && i < filt->workers; i++)
+         found = filter_queue_pop(
+               &filt->queues[(self + i) % filt->workers], true, &index);
+
+      if (!found)
+         break;
+
+      if (filt->packets[index].work)
+         filt->packets[index].work(filt->impl_data,
+               filt->packets[index].thread_data);
+   }
+}
+
 static void filter_thread_loop(void *data)
 {
    struct filter_thread_data *thr = (struct filter_thread_data*)data;
+   rarch_softfilter_t *filt       = thr->filt;
+   unsigned generation            = 0;
 
    for (;;)
    {
       bool die;
-      slock_lock(thr->lock);
-      while (thr->done && !thr->die)
-         scond_wait(thr->cond, thr->lock);
-      die = thr->die;
-      slock_unlock(thr->lock);
+
+      slock_lock(filt->lock);
+      while (filt->generation == generation && !filt->die)
+         scond_wait(filt->cond, filt->lock);
+      generation = filt->generation;
+      die        = filt->die;
+      slock_unlock(filt->lock);
 
       if (die)
          break;
 
-      if (thr->packet && thr->packet->work)
-         thr->packet->work(thr->userdata, thr->packet->thread_data);
+      filter_run_queues(filt, thr->index);
 
-      slock_lock(thr->lock);
-      thr->done = true;
-      scond_signal(thr->cond);
-      slock_unlock(thr->lock);
+      slock_lock(filt->lock);
+      if (--filt->busy == 0)
+         scond_signal(filt->done_cond);
+      slock_unlock(filt->lock);
    }
 }
-#endif
 
-struct rarch_softfilter
+static bool filter_create_workers(rarch_softfilter_t *filt, unsigned workers)
 {
-   config_file_t *conf;
+   unsigned i;
 
-   const struct softfilter_implementation *impl;
-   void *impl_data;
+   filt->queues = (struct filter_queue*)
+      calloc(workers, sizeof(*filt->queues));
+   if (!filt->queues)
+      return false;
+   filt->workers = workers;
 
-   struct rarch_soft_plug *plugs;
-   unsigned num_plugs;
+   for (i = 0; i < workers; i++)
+   {
+      filt->queues[i].lock = slock_new();
+      if (!filt->queues[i].lock)
+         return false;
+   }
 
-   unsigned max_width, max_height;
-   enum retro_pixel_format pix_fmt, out_pix_fmt;
+   if (workers < 2)
+      return true;
 
-   struct softfilter_work_packet *packets;
-   unsigned threads;
+   filt->lock      = slock_new();
+   filt->cond      = scond_new();
+   filt->done_cond = scond_new();
+   if (!filt->lock || !filt->cond || !filt->done_cond)
+      return false;
 
-#ifdef HAVE_THREADS
-   struct filter_thread_data *thread_data;
+   filt->thread_data = (struct filter_thread_data*)
+      calloc(workers - 1, sizeof(*filt->thread_data));
+   if (!filt->thread_data)
+      return false;
+
+   for (i = 0; i < workers - 1; i++)
+   {
+      filt->thread_data[i].filt   = filt;
+      filt->thread_data[i].index  = i + 1;
+      filt->thread_data[i].thread = sthread_create(
+            filter_thread_loop, &filt->thread_data[i]);
+      if (!filt->thread_data[i].thread)
+         return false;
+   }
+
+   return true;
+}
+
+static void filter_free_workers(rarch_softfilter_t *filt)
+{
+   unsigned i;
+
+   if (filt->thread_data)
+   {
+      slock_lock(filt->lock);
+      filt->die = true;
+      scond_broadcast(filt->cond);
+      slock_unlock(filt->lock);
+
+      for (i = 0; i < filt->workers - 1; i++)
+      {
+         if (filt->thread_data[i].thread)
+            sthread_join(filt->thread_data[i].thread);
+      }
+      free(filt->thread_data);
+   }
+
+   if (filt->lock)
+      slock_free(filt->lock);
+   if (filt->cond)
+      scond_free(filt->cond);
+   if (filt->done_cond)
+      scond_free(filt->done_cond);
+
+   if (filt->queues)
+   {
+      for (i = 0; i < filt->workers; i++)
+      {
+         if (filt->queues[i].lock)
+            slock_free(filt->queues[i].lock);
+      }
+      free(filt->queues);
+   }
+}
 #endif
-};
+
+/* Number of row bands to ask the filter for. */
+static unsigned softfilter_band_count(unsigned workers,
+      unsigned max_width, unsigned max_height,
+      enum retro_pixel_format in_pixel_format)
+{
+   unsigned bands, max_bands;
+   size_t row_bytes = max_width * SOFTFILTER_BAND_EXPANSION *
+      (in_pixel_format == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2);
+   size_t band_rows = row_bytes ? SOFTFILTER_BAND_BYTES / row_bytes : 0;
+
+   if (band_rows < SOFTFILTER_MIN_BAND_ROWS)
+      band_rows = SOFTFILTER_MIN_BAND_ROWS;
+
+   bands     = (max_height + band_rows - 1) / band_rows;
+   max_bands = max_height / SOFTFILTER_MIN_BAND_ROWS;
+
+   if (workers > 1 && bands < workers * SOFTFILTER_BANDS_PER_WORKER)
+      bands = workers * SOFTFILTER_BANDS_PER_WORKER;
+   if (bands > max_bands)
+      bands = max_bands;
+
+   return bands ? bands : 1;
+}
 
 static const struct softfilter_implementation *
 softfilter_find_implementation(rarch_softfilter_t *filt, const char *ident)
@@ -126,7 +302,7 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
       softfilter_simd_mask_t cpu_features,
       unsigned threads)
 {
-   unsigned input_fmts, input_fmt, output_fmts, i = 0;
+   unsigned input_fmts, input_fmt, output_fmts, workers, i = 0;
    struct config_file_userdata userdata;
    char key[64]  = {0};
    char name[64] = {0};
@@ -198,10 +374,18 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
    filt->max_width = max_width;
    filt->max_height = max_height;
 
+   workers = threads != RARCH_SOFTFILTER_THREADS_AUTO ? threads :
+      retro_get_cpu_cores();
+#ifndef HAVE_THREADS
+   workers = 1;
+#endif
+
+   /* Filters take the band count as their thread count;
+    * bands are spread over the workers at runtime. */
    filt->impl_data = filt->impl->create(
          &softfilter_config, input_fmt, input_fmt, max_width, max_height,
-         threads != RARCH_SOFTFILTER_THREADS_AUTO ? threads : 
-         retro_get_cpu_cores(), cpu_features,
+         softfilter_band_count(workers, max_width, max_height,
+            in_pixel_format), cpu_features,
          &userdata);
    if (!filt->impl_data)
    {
@@ -216,7 +400,11 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
       return false;
    }
 
-   RARCH_LOG("Using %u threads for softfilter.\n", threads);
+   if (workers > threads)
+      workers = threads;
+
+   RARCH_LOG("Using %u bands on %u threads for softfilter.\n",
+         threads, workers);
 
    filt->packets = (struct softfilter_work_packet*)
       calloc(threads, sizeof(*filt->packets));
@@ -226,29 +414,11 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
       return false;
    }
 
-#ifdef HAVE_THREADS
-   filt->thread_data = (struct filter_thread_data*)
-      calloc(threads, sizeof(*filt->thread_data));
-   if (!filt->thread_data)
-      return false;
    filt->threads = threads;
 
-   for (i = 0; i < threads; i++)
-   {
-      filt->thread_data[i].userdata = filt->impl_data;
-      filt->thread_data[i].done = true;
-
-      filt->thread_data[i].lock = slock_new();
-      if (!filt->thread_data[i].lock)
-         return false;
-      filt->thread_data[i].cond = scond_new();
-      if (!filt->thread_data[i].cond)
-         return false;
-      filt->thread_data[i].thread = sthread_create(
-            filter_thread_loop, &filt->thread_data[i]);
-      if (!filt->thread_data[i].thread)
-         return false;
-   }
+#ifdef HAVE_THREADS
+   if (!filter_create_workers(filt, workers))
+      return false;
 #endif
 
    return true;
@@ -456,19 +626,7 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
 #endif
 
 #ifdef HAVE_THREADS
-   for (i = 0; i < filt->threads; i++)
-   {
-      if (!filt->thread_data[i].thread)
-         continue;
-      slock_lock(filt->thread_data[i].lock);
-      filt->thread_data[i].die = true;
-      scond_signal(filt->thread_data[i].cond);
-      slock_unlock(filt->thread_data[i].lock);
-      sthread_join(filt->thread_data[i].thread);
-      slock_free(filt->thread_data[i].lock);
-      scond_free(filt->thread_data[i].cond);
-   }
-   free(filt->thread_data);
+   filter_free_workers(filt);
 #endif
    free(filt);
 }
@@ -506,29 +664,30 @@ void rarch_softfilter_process(rarch_softfilter_t *filt,
             output, output_stride, input, width, height, input_stride);
    
 #ifdef HAVE_THREADS
-   /* Fire off workers */
-   for (i = 0; i < filt->threads; i++)
+   /* Hand each worker a contiguous run of bands. */
+   for (i = 0; i < filt->workers; i++)
    {
-#if 0
-      RARCH_LOG("Firing off filter thread %u ...\n", i);
-#endif
-      filt->thread_data[i].packet = &filt->packets[i];
-      slock_lock(filt->thread_data[i].lock);
-      filt->thread_data[i].done = false;
-      scond_signal(filt->thread_data[i].cond);
-      slock_unlock(filt->thread_data[i].lock);
+      filt->queues[i].head = (filt->threads * i) / filt->workers;
+      filt->queues[i].tail = (filt->threads * (i + 1)) / filt->workers;
    }
 
-   /* Wait for workers */
-   for (i = 0; i < filt->threads; i++)
+   if (filt->workers > 1)
    {
-#if 0
-      RARCH_LOG("Waiting for filter thread %u ...\n", i);
-#endif
-      slock_lock(filt->thread_data[i].lock);
-      while (!filt->thread_data[i].done)
-         scond_wait(filt->thread_data[i].cond, filt->thread_data[i].lock);
-      slock_unlock(filt->thread_data[i].lock);
+      slock_lock(filt->lock);
+      filt->busy = filt->workers - 1;
+      filt->generation++;
+      scond_broadcast(filt->cond);
+      slock_unlock(filt->lock);
+   }
+
+   filter_run_queues(filt, 0);
+
+   if (filt->workers > 1)
+   {
+      slock_lock(filt->lock);
+      while (filt->busy)
+         scond_wait(filt->done_cond, filt->lock);
+      slock_unlock(filt->lock);
    }
 #else
    for (i = 0; i < filt->threads; i++)
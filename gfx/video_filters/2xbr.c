@@ -233,7 +233,7 @@ static void *twoxbr_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -553,7 +553,7 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
       int first, int last, uint32_t *src,
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned nextline, finish;
+   unsigned y, finish;
    uint32_t pg_red_mask      = RED_MASK8888;
    uint32_t pg_green_mask    = GREEN_MASK8888;
    uint32_t pg_blue_mask     = BLUE_MASK8888;
@@ -563,10 +563,15 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
 
    (void)filt;
 
-   nextline = (last) ? 0 : src_stride;
-   
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows we may read above and below, clamped to the frame. */
+      unsigned above     = first + y;
+      unsigned below     = last + (height - 1 - y);
+      unsigned prevline  = above ? src_stride : 0;
+      unsigned prevline2 = above > 1 ? 2 * src_stride : prevline;
+      unsigned nextline  = below ? src_stride : 0;
+      unsigned nextline2 = below > 1 ? 2 * src_stride : nextline;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
  
@@ -574,14 +579,14 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
       {
          uint32_t E[4];
          uint32_t ex, e, i, ke, ki, ex2, ex3, px;
-         uint32_t A1 = *(in - nextline - nextline - 1);
-         uint32_t B1 = *(in - nextline - nextline);
-         uint32_t C1 = *(in - nextline - nextline + 1);
-         uint32_t A0 = *(in - nextline - 2);
-         uint32_t PA = *(in - nextline - 1);
-         uint32_t PB = *(in - nextline);
-         uint32_t PC = *(in - nextline + 1);
-         uint32_t C4 = *(in - nextline + 2);
+         uint32_t A1 = *(in - prevline2 - 1);
+         uint32_t B1 = *(in - prevline2);
+         uint32_t C1 = *(in - prevline2 + 1);
+         uint32_t A0 = *(in - prevline - 2);
+         uint32_t PA = *(in - prevline - 1);
+         uint32_t PB = *(in - prevline);
+         uint32_t PC = *(in - prevline + 1);
+         uint32_t C4 = *(in - prevline + 2);
          uint32_t D0 = *(in - 2);
          uint32_t PD = *(in - 1);
          uint32_t PE = *(in);
@@ -592,9 +597,9 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
          uint32_t PH = *(in + nextline);
          uint32_t _PI = *(in + nextline + 1);
          uint32_t I4 = *(in + nextline + 2);
-         uint32_t G5 = *(in + nextline + nextline - 1);
-         uint32_t H5 = *(in + nextline + nextline);
-         uint32_t I5 = *(in + nextline + nextline + 1);
+         uint32_t G5 = *(in + nextline2 - 1);
+         uint32_t H5 = *(in + nextline2);
+         uint32_t I5 = *(in + nextline2 + 1);
  
          /*
           * Map of the pixels:          A1 B1 C1
@@ -616,16 +621,22 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
       int first, int last, uint16_t *src,
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
-   unsigned finish;
+   unsigned y, finish;
    struct filter_data *filt = (struct filter_data*)data;
    uint16_t pg_red_mask     = RED_MASK565;
    uint16_t pg_green_mask   = GREEN_MASK565;
    uint16_t pg_blue_mask    = BLUE_MASK565;
    uint16_t pg_lbmask       = PG_LBMASK565;
-   unsigned nextline        = (last) ? 0 : src_stride;
  
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows we may read above and below, clamped to the frame. */
+      unsigned above     = first + y;
+      unsigned below     = last + (height - 1 - y);
+      unsigned prevline  = above ? src_stride : 0;
+      unsigned prevline2 = above > 1 ? 2 * src_stride : prevline;
+      unsigned nextline  = below ? src_stride : 0;
+      unsigned nextline2 = below > 1 ? 2 * src_stride : nextline;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
  
@@ -633,14 +644,14 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
       {
          uint16_t E[4];
          uint16_t ex, e, i, ke, ki, ex2, ex3, px;
-         uint16_t A1 = *(in - nextline - nextline - 1);
-         uint16_t B1 = *(in - nextline - nextline);
-         uint16_t C1 = *(in - nextline - nextline + 1);
-         uint16_t A0 = *(in - nextline - 2);
-         uint16_t PA = *(in - nextline - 1);
-         uint16_t PB = *(in - nextline);
-         uint16_t PC = *(in - nextline + 1);
-         uint16_t C4 = *(in - nextline + 2);
+         uint16_t A1 = *(in - prevline2 - 1);
+         uint16_t B1 = *(in - prevline2);
+         uint16_t C1 = *(in - prevline2 + 1);
+         uint16_t A0 = *(in - prevline - 2);
+         uint16_t PA = *(in - prevline - 1);
+         uint16_t PB = *(in - prevline);
+         uint16_t PC = *(in - prevline + 1);
+         uint16_t C4 = *(in - prevline + 2);
          uint16_t D0 = *(in - 2);
          uint16_t PD = *(in - 1);
          uint16_t PE = *(in);
@@ -651,9 +662,9 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
          uint16_t PH = *(in + nextline);
          uint16_t _PI = *(in + nextline + 1);
          uint16_t I4 = *(in + nextline + 2);
-         uint16_t G5 = *(in + nextline + nextline - 1);
-         uint16_t H5 = *(in + nextline + nextline);
-         uint16_t I5 = *(in + nextline + nextline + 1);
+         uint16_t G5 = *(in + nextline2 - 1);
+         uint16_t H5 = *(in + nextline2);
+         uint16_t I5 = *(in + nextline2 + 1);
  
          /*
           * Map of the pixels:          A1 B1 C1
@@ -726,10 +737,10 @@ static void twoxbr_generic_packets(void *data,
       thr->width = width;
       thr->height = y_end - y_start;
  
-      /* Workers need to know if they can access 
-       * pixels outside their given buffer. */
+      /* Workers need to know how many rows they can 
+       * access outside their given buffer. */
       thr->first = y_start;
-      thr->last = y_end == height;
+      thr->last = height - y_end;
  
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
          packets[i].work = twoxbr_work_cb_rgb565;
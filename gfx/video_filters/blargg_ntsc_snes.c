@@ -39,6 +39,7 @@ struct softfilter_thread_data
    unsigned height;
    int first;
    int last;
+   int burst;
 };
 
 struct filter_data
@@ -128,7 +129,7 @@ static void *blargg_ntsc_snes_generic_create(const struct softfilter_config *con
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -165,26 +166,24 @@ static void blargg_ntsc_snes_generic_destroy(void *data)
 }
 
 static void blargg_ntsc_snes_render_rgb565(void *data, int width, int height,
-      int first, int last,
+      int first, int last, int burst,
       uint16_t *input, int pitch, uint16_t *output, int outpitch)
 {
    struct filter_data *filt = (struct filter_data*)data;
    if(width <= 256)
-      snes_ntsc_blit(filt->ntsc, input, pitch, filt->burst,
+      snes_ntsc_blit(filt->ntsc, input, pitch, burst,
             width, height, output, outpitch * 2, first, last);
    else
-      snes_ntsc_blit_hires(filt->ntsc, input, pitch, filt->burst,
+      snes_ntsc_blit_hires(filt->ntsc, input, pitch, burst,
             width, height, output, outpitch * 2, first, last);
-
-   filt->burst ^= filt->burst_toggle;
 }
 
 static void blargg_ntsc_snes_rgb565(void *data, unsigned width, unsigned height,
-      int first, int last, uint16_t *src, 
+      int first, int last, int burst, uint16_t *src, 
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
    blargg_ntsc_snes_render_rgb565(data, width, height,
-         first, last,
+         first, last, burst,
          src, src_stride,
          dst, dst_stride);
 
@@ -200,7 +199,7 @@ static void blargg_ntsc_snes_work_cb_rgb565(void *data, void *thread_data)
    unsigned height = thr->height;
 
    blargg_ntsc_snes_rgb565(data, width, height,
-         thr->first, thr->last, input,
+         thr->first, thr->last, thr->burst, input,
          thr->in_pitch / SOFTFILTER_BPP_RGB565,
          output,
          thr->out_pitch / SOFTFILTER_BPP_RGB565);
@@ -213,6 +212,7 @@ static void blargg_ntsc_snes_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
@@ -227,15 +227,20 @@ static void blargg_ntsc_snes_generic_packets(void *data,
       thr->width = width;
       thr->height = y_end - y_start;
 
-      /* Workers need to know if they can 
-       * access pixels outside their given buffer. */
+      /* Workers need to know how many rows lie 
+       * outside their given buffer. */
       thr->first = y_start;
-      thr->last = y_end == height;
+      thr->last = height - y_end;
+
+      /* The burst phase advances once per row. */
+      thr->burst = (filt->burst + y_start) % snes_ntsc_burst_count;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
          packets[i].work = blargg_ntsc_snes_work_cb_rgb565;
       packets[i].thread_data = thr;
    }
+
+   filt->burst ^= filt->burst_toggle;
 }
 
 static const struct softfilter_implementation blargg_ntsc_snes_generic = {
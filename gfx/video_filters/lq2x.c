@@ -75,7 +75,7 @@ static void *lq2x_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -114,8 +114,8 @@ static void lq2x_generic_rgb565(unsigned width, unsigned height,
 
    for(y = 0; y < height; y++)
    {
-      int prevline = (y == 0 ? 0 : src_stride);
-      int nextline = (y == height - 1 || last) ? 0 : src_stride;
+      int prevline = (y == 0 && !first) ? 0 : src_stride;
+      int nextline = (y == height - 1 && !last) ? 0 : src_stride;
 
       for(x = 0; x < width; x++)
       {
@@ -159,8 +159,8 @@ static void lq2x_generic_xrgb8888(unsigned width, unsigned height,
 
    for(y = 0; y < height; y++)
    {
-      int prevline = (y == 0 ? 0 : src_stride);
-      int nextline = (y == height - 1 || last) ? 0 : src_stride;
+      int prevline = (y == 0 && !first) ? 0 : src_stride;
+      int nextline = (y == height - 1 && !last) ? 0 : src_stride;
 
       for(x = 0; x < width; x++)
       {
@@ -249,10 +249,10 @@ static void lq2x_generic_packets(void *data,
       thr->width = width;
       thr->height = y_end - y_start;
 
-      /* Workers need to know if they can access pixels 
+      /* Workers need to know how many rows they can access 
        * outside their given buffer. */
       thr->first = y_start;
-      thr->last = y_end == height;
+      thr->last = height - y_end;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
          packets[i].work = lq2x_work_cb_rgb565;
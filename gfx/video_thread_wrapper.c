@@ -18,9 +18,77 @@
 #include <string.h>
 #include <limits.h>
 
+#include <retro_inline.h>
+
 #include "video_thread_wrapper.h"
 #include "../performance.h"
 
+static struct retro_perf_counter thr_frame_superseded = {0};
+static struct retro_perf_counter thr_frame_latency    = {0};
+
+#if defined(__GNUC__)
+/* Frames are handed from the emulation thread to the render
+ * thread by swapping slot indices, so neither side has to
+ * take thr->lock to publish or pick up a frame. */
+#define THREAD_FRAME_LOCKFREE
+#define thread_frame_barrier() __sync_synchronize()
+
+static INLINE unsigned thread_frame_exchange(volatile unsigned *ptr,
+      unsigned val)
+{
+   unsigned old;
+
+   do
+   {
+      old = *ptr;
+   } while (!__sync_bool_compare_and_swap(ptr, old, val));
+
+   return old;
+}
+
+static INLINE bool thread_frame_compare_exchange(volatile unsigned *ptr,
+      unsigned expected, unsigned val)
+{
+   return __sync_bool_compare_and_swap(ptr, expected, val);
+}
+#else
+/* Fallback: caller must hold thr->lock. */
+#define thread_frame_barrier()
+
+static INLINE unsigned thread_frame_exchange(volatile unsigned *ptr,
+      unsigned val)
+{
+   unsigned old = *ptr;
+   *ptr         = val;
+   return old;
+}
+
+static INLINE bool thread_frame_compare_exchange(volatile unsigned *ptr,
+      unsigned expected, unsigned val)
+{
+   if (*ptr != expected)
+      return false;
+   *ptr = val;
+   return true;
+}
+#endif
+
+/**
+ * thread_frame_account:
+ * @perf                      : Performance counter.
+ * @since                     : Tick the measured interval started at.
+ *
+ * Adds the time elapsed since @since to @perf. Used for intervals
+ * that start on one thread and end on another.
+ **/
+static void thread_frame_account(struct retro_perf_counter *perf,
+      retro_perf_tick_t since)
+{
+   retro_perf_start(perf);
+   perf->start = since;
+   retro_perf_stop(perf);
+}
+
 static void *thread_init_never_call(const video_info_t *video,
       const input_driver_t **input, void **input_data)
 {
@@ -368,10 +436,23 @@ static void thread_loop(void *data)
       bool updated = false;
 
       slock_lock(thr->lock);
-      while (thr->send_cmd == CMD_NONE && !thr->frame.updated)
+
+      thr->frame.sleeping = true;
+      thread_frame_barrier();
+
+      while (thr->send_cmd == CMD_NONE &&
+            !(thr->frame.ready & THREAD_VIDEO_FRAME_FRESH))
          scond_wait(thr->cond_thread, thr->lock);
-      if (thr->frame.updated)
+
+      thr->frame.sleeping = false;
+
+      if (thr->frame.ready & THREAD_VIDEO_FRAME_FRESH)
+      {
+         /* Take the latest frame, leaving our old slot for reuse. */
+         thr->frame.read_index = thread_frame_exchange(&thr->frame.ready,
+               thr->frame.read_index) & ~THREAD_VIDEO_FRAME_FRESH;
          updated = true;
+      }
 
       /* To avoid race condition where send_cmd is updated 
        * right after the switch is checked. */
@@ -389,6 +470,10 @@ static void thread_loop(void *data)
          bool               focus = false;
          bool        has_windowed = true;
          struct video_viewport vp = {0};
+         struct thread_video_frame *frame =
+            &thr->frame.slot[thr->frame.read_index];
+
+         thread_frame_account(&thr_frame_latency, frame->pushed);
 
          slock_lock(thr->frame.lock);
 
@@ -396,9 +481,9 @@ static void thread_loop(void *data)
 
          if (thr->driver && thr->driver->frame)
             ret = thr->driver->frame(thr->driver_data,
-               thr->frame.buffer, thr->frame.width, thr->frame.height,
-               thr->frame.count,
-               thr->frame.pitch, *thr->frame.msg ? thr->frame.msg : NULL);
+               frame->dupe ? NULL : frame->buffer,
+               frame->width, frame->height, frame->count,
+               frame->pitch, *frame->msg ? frame->msg : NULL);
 
          slock_unlock(thr->frame.lock);
 
@@ -415,11 +500,11 @@ static void thread_loop(void *data)
             thr->driver->viewport_info(thr->driver_data, &vp);
 
          slock_lock(thr->lock);
-         thr->alive         = alive;
-         thr->focus         = focus;
-         thr->has_windowed  = has_windowed;
-         thr->frame.updated = false;
-         thr->vp            = vp;
+         thr->alive          = alive;
+         thr->focus          = focus;
+         thr->has_windowed   = has_windowed;
+         thr->frame.rendered = frame->seq;
+         thr->vp             = vp;
          scond_signal(thr->cond_cmd);
          slock_unlock(thr->lock);
       }
@@ -486,14 +571,45 @@ static bool thread_has_windowed(void *data)
    return ret;
 }
 
+/**
+ * thread_frame_reclaim:
+ * @thr                       : Pointer to threaded video handle.
+ *
+ * Takes the published slot back if the render thread hasn't
+ * picked it up yet, handing it our write slot in exchange.
+ *
+ * Returns: true if the published slot is now the write slot.
+ **/
+static bool thread_frame_reclaim(thread_video_t *thr)
+{
+   unsigned pending;
+   bool ret;
+
+#ifndef THREAD_FRAME_LOCKFREE
+   slock_lock(thr->lock);
+#endif
+   pending = thr->frame.ready;
+   ret     = (pending & THREAD_VIDEO_FRAME_FRESH) &&
+      thread_frame_compare_exchange(&thr->frame.ready,
+            pending, thr->frame.write_index);
+#ifndef THREAD_FRAME_LOCKFREE
+   slock_unlock(thr->lock);
+#endif
+
+   if (ret)
+      thr->frame.write_index = pending & ~THREAD_VIDEO_FRAME_FRESH;
+   return ret;
+}
+
 static bool thread_frame(void *data, const void *frame_,
       unsigned width, unsigned height, uint64_t frame_count,
       unsigned pitch, const char *msg)
 {
-   unsigned copy_stride;
+   unsigned copy_stride, prev;
    static struct retro_perf_counter thr_frame = {0};
    const uint8_t *src                  = NULL;
    uint8_t *dst                        = NULL;
+   struct thread_video_frame *frame    = NULL;
    thread_video_t *thr                 = (thread_video_t*)data;
 
    /* If called from within read_viewport, we're actually in the 
@@ -509,17 +625,54 @@ static bool thread_frame(void *data, const void *frame_,
    }
 
    rarch_perf_init(&thr_frame, "thr_frame");
+   rarch_perf_init(&thr_frame_superseded, "thr_frame_superseded");
+   rarch_perf_init(&thr_frame_latency, "thr_frame_latency");
    retro_perf_start(&thr_frame);
 
    copy_stride = width * (thr->info.rgb32 
          ? sizeof(uint32_t) : sizeof(uint16_t));
 
-   src = (const uint8_t*)frame_;
-   dst = thr->frame.buffer;
+   /* The write slot is ours alone, so the copy needs no lock. */
+   frame = &thr->frame.slot[thr->frame.write_index];
+   src   = (const uint8_t*)frame_;
+   dst   = frame->buffer;
 
-   slock_lock(thr->lock);
+   /* A dupe must not supersede a real frame the render thread
+    * hasn't picked up yet. Publish that frame again instead,
+    * under its own sequence number. */
+   if (!src && thread_frame_reclaim(thr))
+      frame = &thr->frame.slot[thr->frame.write_index];
+   else
+   {
+      /* Core rendered into the slot directly, see
+       * thread_get_current_software_framebuffer. */
+      if (src == dst)
+      {
+         copy_stride = pitch;
+         thr->zero_copy_count++;
+      }
+      else if (src)
+      {
+         unsigned h;
+         for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
+            memcpy(dst, src, copy_stride);
+      }
 
-   if (!thr->nonblock)
+      frame->dupe   = !src;
+      frame->width  = width;
+      frame->height = height;
+      frame->pitch  = copy_stride;
+      frame->seq    = ++thr->frame.published;
+   }
+
+   frame->count  = frame_count;
+
+   if (msg)
+      strlcpy(frame->msg, msg, sizeof(frame->msg));
+   else
+      *frame->msg = '\0';
+
+   if (!thr->nonblock && thr->frame.rendered != frame->seq - 1)
    {
       settings_t *settings = config_get_ptr();
 
@@ -527,8 +680,13 @@ static bool thread_frame(void *data, const void *frame_,
          roundf(1000000 / settings->video.refresh_rate);
       retro_time_t target = thr->last_time + target_frame_time;
 
-      /* Ideally, use absolute time, but that is only a good idea on POSIX. */
-      while (thr->frame.updated)
+      /* Vsync pacing: give the render thread until the next
+       * refresh to finish the previous frame. If it doesn't,
+       * this frame replaces it instead of being dropped.
+       * Ideally, use absolute time, but that is only a good 
+       * idea on POSIX. */
+      slock_lock(thr->lock);
+      while (thr->frame.rendered != frame->seq - 1)
       {
          retro_time_t current = retro_get_time_usec();
          retro_time_t delta   = target - current;
@@ -539,45 +697,50 @@ static bool thread_frame(void *data, const void *frame_,
          if (!scond_wait_timeout(thr->cond_cmd, thr->lock, delta))
             break;
       }
+      slock_unlock(thr->lock);
    }
 
-   /* Drop frame if updated flag is still set, as thread is 
-    * still working on last frame. */
-   if (!thr->frame.updated)
-   {
-      if (src)
-      {
-         unsigned h;
-         for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
-            memcpy(dst, src, copy_stride);
-      }
-
-      thr->frame.updated = true;
-      thr->frame.width  = width;
-      thr->frame.height = height;
-      thr->frame.count  = frame_count;
-      thr->frame.pitch  = copy_stride;
+   frame->pushed = retro_get_perf_counter();
 
-      if (msg)
-         strlcpy(thr->frame.msg, msg, sizeof(thr->frame.msg));
-      else
-         *thr->frame.msg = '\0';
+#ifdef THREAD_FRAME_LOCKFREE
+   prev = thread_frame_exchange(&thr->frame.ready,
+         thr->frame.write_index | THREAD_VIDEO_FRAME_FRESH);
 
+   /* Only wake the render thread if it is actually asleep. */
+   if (thr->frame.sleeping)
+   {
+      slock_lock(thr->lock);
       scond_signal(thr->cond_thread);
-
-#if defined(HAVE_MENU)
-      if (thr->texture.enable)
-      {
-         while (thr->frame.updated)
-            scond_wait(thr->cond_cmd, thr->lock);
-      }
-#endif
-      thr->hit_count++;
+      slock_unlock(thr->lock);
    }
-   else
+#else
+   slock_lock(thr->lock);
+   prev = thread_frame_exchange(&thr->frame.ready,
+         thr->frame.write_index | THREAD_VIDEO_FRAME_FRESH);
+   scond_signal(thr->cond_thread);
+   slock_unlock(thr->lock);
+#endif
+
+   thr->frame.write_index = prev & ~THREAD_VIDEO_FRAME_FRESH;
+   thr->hit_count++;
+
+   /* Render thread never picked up the previous frame. */
+   if (prev & THREAD_VIDEO_FRAME_FRESH)
+   {
+      thread_frame_account(&thr_frame_superseded,
+            thr->frame.slot[thr->frame.write_index].pushed);
       thr->miss_count++;
+   }
 
-   slock_unlock(thr->lock);
+#if defined(HAVE_MENU)
+   if (thr->texture.enable)
+   {
+      slock_lock(thr->lock);
+      while (thr->frame.rendered != frame->seq)
+         scond_wait(thr->cond_cmd, thr->lock);
+      slock_unlock(thr->lock);
+   }
+#endif
 
    retro_perf_stop(&thr_frame);
 
@@ -595,6 +758,7 @@ static void thread_set_nonblock_state(void *data, bool state)
 static bool thread_init(thread_video_t *thr, const video_info_t *info,
       const input_driver_t **input, void **input_data)
 {
+   unsigned i;
    size_t max_size;
    thread_packet_t pkt = {CMD_INIT};
 
@@ -614,12 +778,22 @@ static bool thread_init(thread_video_t *thr, const video_info_t *info,
    max_size                  = info->input_scale * RARCH_SCALE_BASE;
    max_size                 *= max_size;
    max_size                 *= info->rgb32 ? sizeof(uint32_t) : sizeof(uint16_t);
-   thr->frame.buffer        = (uint8_t*)malloc(max_size);
 
-   if (!thr->frame.buffer)
-      return false;
+   for (i = 0; i < THREAD_VIDEO_FRAME_SLOTS; i++)
+   {
+      thr->frame.slot[i].buffer = (uint8_t*)malloc(max_size);
+
+      if (!thr->frame.slot[i].buffer)
+         return false;
+
+      memset(thr->frame.slot[i].buffer, 0x80, max_size);
+   }
 
-   memset(thr->frame.buffer, 0x80, max_size);
+   thr->frame.slot_size      = max_size;
+   thr->frame.max_width      = info->input_scale * RARCH_SCALE_BASE;
+   thr->frame.write_index    = 0;
+   thr->frame.ready          = 1;
+   thr->frame.read_index     = 2;
 
    thr->last_time       = retro_get_time_usec();
    thr->thread          = sthread_create(thread_loop, thr);
@@ -714,6 +888,7 @@ static bool thread_read_viewport(void *data, uint8_t *buffer)
 
 static void thread_free(void *data)
 {
+   unsigned i;
    thread_video_t *thr = (thread_video_t*)data;
    thread_packet_t pkt = { CMD_FREE };
 
@@ -727,7 +902,8 @@ static void thread_free(void *data)
 #if defined(HAVE_MENU)
    free(thr->texture.frame);
 #endif
-   free(thr->frame.buffer);
+   for (i = 0; i < THREAD_VIDEO_FRAME_SLOTS; i++)
+      free(thr->frame.slot[i].buffer);
    slock_free(thr->frame.lock);
    slock_free(thr->lock);
    scond_free(thr->cond_cmd);
@@ -736,8 +912,8 @@ static void thread_free(void *data)
    free(thr->alpha_mod);
    slock_free(thr->alpha_lock);
 
-   RARCH_LOG("Threaded video stats: Frames pushed: %u, Frames dropped: %u.\n",
-         thr->hit_count, thr->miss_count);
+   RARCH_LOG("Threaded video stats: Frames pushed: %u, Frames superseded: %u, Frames not copied: %u.\n",
+         thr->hit_count, thr->miss_count, thr->zero_copy_count);
 
    free(thr);
 }
@@ -991,6 +1167,41 @@ static void thread_apply_state_changes(void *data)
    slock_unlock(thr->frame.lock);
 }
 
+/* Lets the core render straight into the write slot, so
+ * thread_frame() can publish it without copying. */
+static bool thread_get_current_software_framebuffer(void *data,
+      struct retro_framebuffer *framebuffer)
+{
+   unsigned bpp;
+   thread_video_t *thr = (thread_video_t*)data;
+   enum retro_pixel_format fmt = video_driver_get_pixel_format();
+
+   if (!thr || !framebuffer)
+      return false;
+
+   bpp = (fmt == RETRO_PIXEL_FORMAT_XRGB8888) 
+      ? sizeof(uint32_t) : sizeof(uint16_t);
+
+   /* Filtered frames are copied out of the filter's own
+    * buffer anyway, so there is nothing to gain. */
+   if (video_driver_frame_filter_alive() ||
+         thr->info.rgb32 != (fmt == RETRO_PIXEL_FORMAT_XRGB8888))
+      return false;
+
+   if (!framebuffer->width || !framebuffer->height ||
+         framebuffer->width > thr->frame.max_width ||
+         (size_t)framebuffer->width * framebuffer->height * bpp 
+         > thr->frame.slot_size)
+      return false;
+
+   framebuffer->data         = thr->frame.slot[thr->frame.write_index].buffer;
+   framebuffer->pitch        = framebuffer->width * bpp;
+   framebuffer->format       = fmt;
+   framebuffer->memory_flags = RETRO_MEMORY_TYPE_CACHED;
+
+   return true;
+}
+
 /* This is read-only state which should not 
  * have any kind of race condition. */
 static struct video_shader *thread_get_current_shader(void *data)
@@ -1024,6 +1235,7 @@ static const video_poke_interface_t thread_poke = {
    NULL,
 
    thread_get_current_shader,
+   thread_get_current_software_framebuffer,
 };
 
 static void thread_get_poke_interface(void *data,
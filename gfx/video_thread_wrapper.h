@@ -144,6 +144,22 @@ typedef struct
    } data;
 } thread_packet_t;
 
+#define THREAD_VIDEO_FRAME_SLOTS 3
+#define THREAD_VIDEO_FRAME_FRESH 0x80000000u
+
+struct thread_video_frame
+{
+   uint8_t *buffer;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   unsigned seq;
+   bool dupe;
+   uint64_t count;
+   retro_perf_tick_t pushed;
+   char msg[PATH_MAX_LENGTH];
+};
+
 typedef struct thread_video
 {
    slock_t *lock;
@@ -188,6 +204,7 @@ typedef struct thread_video
    retro_time_t last_time;
    unsigned hit_count;
    unsigned miss_count;
+   unsigned zero_copy_count;
 
    float *alpha_mod;
    unsigned alpha_mods;
@@ -207,14 +224,27 @@ typedef struct thread_video
    struct
    {
       slock_t *lock;
-      uint8_t *buffer;
-      unsigned width;
-      unsigned height;
-      unsigned pitch;
-      bool updated;
+      struct thread_video_frame slot[THREAD_VIDEO_FRAME_SLOTS];
+      size_t slot_size;
+      unsigned max_width;
+
+      /* Triple buffer hand-off. write_index is owned by the
+       * emulation thread, read_index by the render thread.
+       * ready holds the slot last published, with
+       * THREAD_VIDEO_FRAME_FRESH set until the render thread
+       * picks it up. */
+      unsigned write_index;
+      unsigned read_index;
+      volatile unsigned ready;
+
+      /* Sequence numbers of the last published and last
+       * rendered frame. Used for vsync pacing. */
+      unsigned published;
+      volatile unsigned rendered;
+
+      /* Set while the render thread waits on cond_thread. */
+      volatile bool sleeping;
       bool within_thread;
-      uint64_t count;
-      char msg[PATH_MAX_LENGTH];
    } frame;
 
    video_driver_t video_thread;
@@ -92,7 +92,6 @@ ACHIEVEMENTS
 #endif
 
 #include "../libretro-common/formats/json/jsonsax.c"
-#include "../libretro-common/utils/md5.c"
 #include "../net_http_special.c"
 #include "../cheevos.c"
 #endif
@@ -102,6 +101,7 @@ CHEATS
 ============================================================ */
 #include "../cheats.c"
 #include "../libretro-common/hash/rhash.c"
+#include "../libretro-common/utils/md5.c"
 
 /*============================================================
 UI COMMON CONTEXT
@@ -640,6 +640,7 @@ CONFIGURATION
 REWIND
 ============================================================ */
 #include "../rewind.c"
+#include "../runahead.c"
 
 /*============================================================
 FRONTEND
@@ -740,6 +741,7 @@ THREAD
 #include "../libretro-common/rthreads/rthreads.c"
 #include "../libretro-common/rthreads/rsemaphore.c"
 #include "../libretro-common/rthreads/async_job.c"
+#include "../libretro-common/queues/spsc_ring.c"
 #include "../gfx/video_thread_wrapper.c"
 #include "../audio/audio_thread_wrapper.c"
 #include "../autosave.c"
@@ -763,6 +765,7 @@ DATA RUNLOOP
 #ifdef HAVE_LIBRETRODB
 #include "../tasks/task_database.c"
 #include "../tasks/task_database_cue.c"
+#include "../tasks/task_database_scan.c"
 #endif
 
 /*============================================================
@@ -919,12 +922,12 @@ XML
  LIBRETRODB
 ============================================================ */
 #ifdef HAVE_LIBRETRODB
-#include "../libretro-db/bintree.c"
 #include "../libretro-db/libretrodb.c"
 #include "../libretro-db/rmsgpack.c"
 #include "../libretro-db/rmsgpack_dom.c"
 #include "../libretro-db/query.c"
 #include "../database_info.c"
+#include "../database_index.c"
 #endif
 
 
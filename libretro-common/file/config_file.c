@@ -124,6 +124,71 @@ static char *extract_value(char *line, bool is_value)
    return NULL;
 }
 
+static size_t config_index_slot(uint32_t hash, size_t mask)
+{
+   /* djb2 leaves the low bits of similar keys close together. */
+   hash ^= hash >> 16;
+   hash *= 0x85ebca6bU;
+   hash ^= hash >> 13;
+   return hash & mask;
+}
+
+static void config_index_insert(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   size_t mask = conf->index_size - 1;
+   size_t i    = config_index_slot(entry->key_hash, mask);
+
+   while (conf->index[i])
+   {
+      /* Earlier entries win, same as walking the list. */
+      if (conf->index[i]->key_hash == entry->key_hash
+            && !strcmp(conf->index[i]->key, entry->key))
+         return;
+      i = (i + 1) & mask;
+   }
+
+   conf->index[i] = entry;
+   conf->index_count++;
+}
+
+/* Sizes the index for every entry in the list and fills it in
+ * list order. On failure lookups fall back to walking the list. */
+static void config_index_rebuild(config_file_t *conf)
+{
+   struct config_entry_list *entry = NULL;
+   size_t entries                  = 0;
+   size_t size                     = 16;
+
+   for (entry = conf->entries; entry; entry = entry->next)
+      entries++;
+
+   while (size < (entries + 1) * 2)
+      size *= 2;
+
+   free(conf->index);
+   conf->index       = (struct config_entry_list**)
+      calloc(size, sizeof(*conf->index));
+   conf->index_size  = conf->index ? size : 0;
+   conf->index_count = 0;
+
+   if (!conf->index)
+      return;
+
+   for (entry = conf->entries; entry; entry = entry->next)
+      config_index_insert(conf, entry);
+}
+
+/* Call after @entry has been linked into the list. */
+static void config_index_add(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   if (!conf->index || (conf->index_count + 1) * 2 > conf->index_size)
+      config_index_rebuild(conf);
+   else
+      config_index_insert(conf, entry);
+}
+
 static void set_list_readonly(struct config_entry_list *list)
 {
    while (list)
@@ -136,35 +201,24 @@ static void set_list_readonly(struct config_entry_list *list)
 /* Move semantics? */
 static void add_child_list(config_file_t *parent, config_file_t *child)
 {
-   if (parent->entries)
-   {
-      struct config_entry_list *head = parent->entries;
-      while (head->next)
-         head = head->next;
+   struct config_entry_list *entry = child->entries;
 
-      set_list_readonly(child->entries);
-      head->next = child->entries;
-   }
-   else
-   {
-      set_list_readonly(child->entries);
-      parent->entries = child->entries;
-   }
+   if (!entry)
+      return;
 
-   child->entries = NULL;
+   set_list_readonly(child->entries);
 
-   /* Rebase tail. */
    if (parent->entries)
-   {
-      struct config_entry_list *head = 
-         (struct config_entry_list*)parent->entries;
-
-      while (head->next)
-         head = head->next;
-      parent->tail = head;
-   }
+      parent->tail->next = child->entries;
    else
-      parent->tail = NULL;
+      parent->entries    = child->entries;
+
+   parent->tail   = child->tail;
+   child->entries = NULL;
+   child->tail    = NULL;
+
+   for (; entry; entry = entry->next)
+      config_index_add(parent, entry);
 }
 
 static void add_include_list(config_file_t *conf, const char *path)
@@ -352,7 +406,13 @@ bool config_append_file(config_file_t *conf, const char *path)
    {
       new_conf->tail->next = conf->entries;
       conf->entries        = new_conf->entries; /* Pilfer. */
+      if (!conf->tail)
+         conf->tail        = new_conf->tail;
       new_conf->entries    = NULL;
+      new_conf->tail       = NULL;
+
+      /* The new entries come first now, so they win lookups. */
+      config_index_rebuild(conf);
    }
 
    config_file_free(new_conf);
@@ -411,6 +471,7 @@ static config_file_t *config_file_new_internal(
                conf->entries = list;
 
             conf->tail = list;
+            config_index_add(conf, list);
          }
 
          free(line);
@@ -476,6 +537,7 @@ config_file_t *config_file_new_from_string(const char *from_string)
                conf->entries = list;
 
             conf->tail = list;
+            config_index_add(conf, list);
          }
       }
 
@@ -521,38 +583,43 @@ void config_file_free(config_file_t *conf)
       free(hold);
    }
 
+   free(conf->index);
    free(conf->path);
    free(conf);
 }
 
 static struct config_entry_list *config_get_entry(const config_file_t *conf,
-      const char *key, struct config_entry_list **prev)
+      const char *key)
 {
-   struct config_entry_list *entry;
-   struct config_entry_list *previous = NULL;
+   struct config_entry_list *entry = NULL;
+   uint32_t hash                   = djb2_calculate(key);
 
-   uint32_t hash = djb2_calculate(key);
+   if (conf->index)
+   {
+      size_t mask = conf->index_size - 1;
+      size_t i    = config_index_slot(hash, mask);
+
+      for (; (entry = conf->index[i]); i = (i + 1) & mask)
+      {
+         if (hash == entry->key_hash && !strcmp(key, entry->key))
+            return entry;
+      }
 
-   if (prev)
-      previous = *prev;
+      return NULL;
+   }
 
    for (entry = conf->entries; entry; entry = entry->next)
    {
       if (hash == entry->key_hash && !strcmp(key, entry->key))
          return entry;
-
-      previous = entry;
    }
 
-   if (prev)
-      *prev = previous;
-
    return NULL;
 }
 
 bool config_get_double(config_file_t *conf, const char *key, double *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       *in = strtod(entry->value, NULL);
@@ -562,7 +629,7 @@ bool config_get_double(config_file_t *conf, const char *key, double *in)
 
 bool config_get_float(config_file_t *conf, const char *key, float *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -575,7 +642,7 @@ bool config_get_float(config_file_t *conf, const char *key, float *in)
 
 bool config_get_int(config_file_t *conf, const char *key, int *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -591,7 +658,7 @@ bool config_get_int(config_file_t *conf, const char *key, int *in)
 
 bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -607,7 +674,7 @@ bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 
 bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -623,7 +690,7 @@ bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 
 bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -639,7 +706,7 @@ bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 
 bool config_get_char(config_file_t *conf, const char *key, char *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -654,7 +721,7 @@ bool config_get_char(config_file_t *conf, const char *key, char *in)
 
 bool config_get_string(config_file_t *conf, const char *key, char **str)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       *str = strdup(entry->value);
@@ -665,7 +732,7 @@ bool config_get_string(config_file_t *conf, const char *key, char **str)
 bool config_get_array(config_file_t *conf, const char *key,
       char *buf, size_t size)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       return strlcpy(buf, entry->value, size) < size;
@@ -679,7 +746,7 @@ bool config_get_path(config_file_t *conf, const char *key,
 #if defined(RARCH_CONSOLE)
    return config_get_array(conf, key, buf, size);
 #else
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       fill_pathname_expand_special(buf, entry->value, size);
@@ -690,7 +757,7 @@ bool config_get_path(config_file_t *conf, const char *key,
 
 bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -711,8 +778,7 @@ bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 
 void config_set_string(config_file_t *conf, const char *key, const char *val)
 {
-   struct config_entry_list *last  = conf->entries;
-   struct config_entry_list *entry = config_get_entry(conf, key, &last);
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry && !entry->readonly)
    {
@@ -726,13 +792,17 @@ void config_set_string(config_file_t *conf, const char *key, const char *val)
    if (!entry)
       return;
 
-   entry->key   = strdup(key);
-   entry->value = strdup(val);
+   entry->key      = strdup(key);
+   entry->value    = strdup(val);
+   entry->key_hash = djb2_calculate(key);
 
-   if (last)
-      last->next = entry;
+   if (conf->entries)
+      conf->tail->next = entry;
    else
-      conf->entries = entry;
+      conf->entries    = entry;
+
+   conf->tail = entry;
+   config_index_add(conf, entry);
 }
 
 void config_set_path(config_file_t *conf, const char *entry, const char *val)
@@ -843,16 +913,7 @@ void config_file_dump(config_file_t *conf, FILE *file)
 
 bool config_entry_exists(config_file_t *conf, const char *entry)
 {
-   struct config_entry_list *list = conf->entries;
-
-   while (list)
-   {
-      if (!strcmp(entry, list->key))
-         return true;
-      list = list->next;
-   }
-
-   return false;
+   return config_get_entry(conf, entry) != NULL;
 }
 
 bool config_get_entry_list_head(config_file_t *conf,
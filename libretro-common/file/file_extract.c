@@ -245,6 +245,39 @@ void zlib_deflate_init(void *data, int level)
       deflateInit(stream, level);
 }
 
+bool zlib_deflate_init_raw(void *data, int level)
+{
+   z_stream *stream = (z_stream*)data;
+
+   if (!stream)
+      return false;
+   if (deflateInit2(stream, level, Z_DEFLATED, -MAX_WBITS,
+            8, Z_DEFAULT_STRATEGY) != Z_OK)
+      return false;
+   return true;
+}
+
+bool zlib_deflate_set_dictionary(void *data,
+      const uint8_t *dict, uint32_t size)
+{
+   z_stream *stream = (z_stream*)data;
+
+   if (!stream)
+      return false;
+   if (deflateSetDictionary(stream, dict, size) != Z_OK)
+      return false;
+   return true;
+}
+
+size_t zlib_deflate_bound(void *data, size_t size)
+{
+   z_stream *stream = (z_stream*)data;
+
+   if (!stream)
+      return 0;
+   return deflateBound(stream, size);
+}
+
 bool zlib_inflate_init(void *data)
 {
    z_stream *stream = (z_stream*)data;
@@ -329,6 +362,22 @@ int zlib_deflate_data_to_file(void *data)
    return 0;
 }
 
+int zlib_deflate_data_to_file_flush(void *data)
+{
+   int zstatus;
+   z_stream *stream = (z_stream*)data;
+
+   if (!stream)
+      return -1;
+
+   zstatus = deflate(stream, Z_SYNC_FLUSH);
+
+   if (zstatus == Z_OK && stream->avail_in == 0 && stream->avail_out != 0)
+      return 1;
+
+   return 0;
+}
+
 int zlib_inflate_data_to_file_iterate(void *data)
 {
    int zstatus;
@@ -353,6 +402,36 @@ uint32_t zlib_crc32_calculate(const uint8_t *data, size_t length)
    return crc32(0, data, length);
 }
 
+uint32_t zlib_adler32_calculate(const uint8_t *data, size_t length)
+{
+   return adler32(adler32(0, NULL, 0), data, (uInt)length);
+}
+
+/* Same as zlib's adler32_combine(), which the bundled zlib
+ * doesn't have. */
+uint32_t zlib_adler32_combine(uint32_t adler1, uint32_t adler2,
+      size_t length2)
+{
+   static const uint32_t base = 65521;
+   uint32_t rem  = (uint32_t)(length2 % base);
+   uint32_t sum1 = adler1 & 0xffff;
+   uint32_t sum2 = (rem * sum1) % base;
+
+   sum1 += (adler2 & 0xffff) + base - 1;
+   sum2 += (adler1 >> 16) + (adler2 >> 16) + base - rem;
+
+   if (sum1 >= base)
+      sum1 -= base;
+   if (sum1 >= base)
+      sum1 -= base;
+   if (sum2 >= base << 1)
+      sum2 -= base << 1;
+   if (sum2 >= base)
+      sum2 -= base;
+
+   return sum1 | (sum2 << 16);
+}
+
 uint32_t zlib_crc32_adjust(uint32_t crc, uint8_t data)
 {
    /* zlib and nall have different assumptions on "sign" for this 
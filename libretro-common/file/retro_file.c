@@ -149,7 +149,7 @@ RFILE *retro_fopen(const char *path, unsigned mode, ssize_t len)
          mode_int = 0777;
          flags    = CELL_FS_O_RDWR;
 #elif defined(HAVE_BUFFERED_IO)
-         mode_str = "w+";
+         mode_str = "r+b";
 #else
          flags    = O_RDWR;
 #ifdef _WIN32
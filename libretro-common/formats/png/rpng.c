@@ -76,6 +76,7 @@ struct idat_buffer
 {
    uint8_t *data;
    size_t size;
+   size_t capacity;
 };
 
 struct png_chunk
@@ -89,18 +90,19 @@ struct rpng_process_t
 {
    bool initialized;
    bool inflate_initialized;
-   bool adam7_pass_initialized;
    bool pass_initialized;
-   uint32_t *data;
+   bool stream_end;
    uint32_t *palette;
-   struct png_ihdr ihdr;
+   struct png_ihdr ihdr;       /* Of the current pass. */
    uint8_t *prev_scanline;
    uint8_t *decoded_scanline;
-   uint8_t *inflate_buf;
-   size_t restore_buf_size;
-   size_t adam7_restore_buf_size;
-   size_t data_restore_buf_size;
+   uint8_t *inflate_buf;       /* Window of inflated, filtered scanlines. */
+   const uint8_t *scanline;    /* Filter byte and the current scanline. */
+   uint32_t *pass_line;        /* Adam7 scanline before deinterlacing. */
    size_t inflate_buf_size;
+   size_t inflate_pos;         /* Start of the next scanline in inflate_buf. */
+   size_t inflate_end;
+   size_t idat_pos;            /* IDAT data inflated so far. */
    unsigned bpp;
    unsigned pitch;
    unsigned h;
@@ -108,11 +110,9 @@ struct rpng_process_t
    {
       unsigned width;
       unsigned height;
-      size_t   size;
       unsigned pos;
    } pass;
    void *stream;
-   zlib_file_handle_t handle;
 };
 
 struct rpng
@@ -128,6 +128,16 @@ struct rpng
    uint32_t palette[256];
 };
 
+/* Inflated data is handed out a scanline at a time from a window
+ * this much larger than one. Inflating a single scanline per call
+ * would keep zlib off its fast path for the end of every line. */
+#define PNG_INFLATE_WINDOW 0x8000
+
+/* The SIMD filters move 4 bytes for 3 byte pixels too. The byte
+ * past a pixel is rewritten by the next one, and the line buffers
+ * are padded for the last. */
+#define PNG_SCANLINE_PADDING 4
+
 enum png_process_code
 {
    PNG_PROCESS_ERROR     = -2,
@@ -349,8 +359,7 @@ static void png_reverse_filter_copy_line_plt(uint32_t *data,
 }
 
 static void png_pass_geom(const struct png_ihdr *ihdr,
-      unsigned width, unsigned height,
-      unsigned *bpp_out, unsigned *pitch_out, size_t *pass_size)
+      unsigned *bpp_out, unsigned *pitch_out)
 {
    unsigned bpp;
    unsigned pitch;
@@ -383,31 +392,22 @@ static void png_pass_geom(const struct png_ihdr *ihdr,
          break;
    }
 
-   if (pass_size)
-      *pass_size = (pitch + 1) * ihdr->height;
    if (bpp_out)
       *bpp_out = bpp;
    if (pitch_out)
       *pitch_out = pitch;
 }
 
-static void png_reverse_filter_adam7_deinterlace_pass(uint32_t *data,
-      const struct png_ihdr *ihdr,
-      const uint32_t *input, unsigned pass_width, unsigned pass_height,
-      const struct adam7_pass *pass)
+static void png_reverse_filter_adam7_deinterlace_line(uint32_t *data,
+      const struct png_ihdr *ihdr, const uint32_t *input,
+      unsigned pass_width, unsigned y, const struct adam7_pass *pass)
 {
-   unsigned x, y;
+   unsigned x;
 
-   data += pass->y * ihdr->width + pass->x;
+   data += (pass->y + y * pass->stride_y) * ihdr->width + pass->x;
 
-   for (y = 0; y < pass_height;
-         y++, data += ihdr->width * pass->stride_y, input += pass_width)
-   {
-      uint32_t *out = data;
-     
-      for (x = 0; x < pass_width; x++, out += pass->stride_x)
-         *out = input[x];
-   }
+   for (x = 0; x < pass_width; x++, data += pass->stride_x)
+      *data = input[x];
 }
 
 static void png_reverse_filter_deinit(struct rpng_process_t *pngp)
@@ -418,6 +418,12 @@ static void png_reverse_filter_deinit(struct rpng_process_t *pngp)
    if (pngp->prev_scanline)
       free(pngp->prev_scanline);
    pngp->prev_scanline    = NULL;
+   if (pngp->inflate_buf)
+      free(pngp->inflate_buf);
+   pngp->inflate_buf      = NULL;
+   if (pngp->pass_line)
+      free(pngp->pass_line);
+   pngp->pass_line        = NULL;
 
    pngp->pass_initialized = false;
    pngp->h                = 0;
@@ -433,116 +439,314 @@ static const struct adam7_pass passes[] = {
    { 0, 1, 1, 2 },
 };
 
+/* Sets up the geometry of the next Adam7 pass that has any pixels
+ * in it, or of the whole image when it isn't interlaced.
+ * Returns 1 when there are no passes left. */
 static int png_reverse_filter_init(const struct png_ihdr *ihdr,
       struct rpng_process_t *pngp)
 {
-   size_t pass_size;
+   pngp->ihdr = *ihdr;
 
-   if (!pngp->adam7_pass_initialized && ihdr->interlace)
+   if (ihdr->interlace)
    {
-      if (ihdr->width <= passes[pngp->pass.pos].x ||
-            ihdr->height <= passes[pngp->pass.pos].y) /* Empty pass */
-         return 1;
+      const struct adam7_pass *pass;
+
+      /* Skip passes that are empty in small images. */
+      for (; pngp->pass.pos < ARRAY_SIZE(passes); pngp->pass.pos++)
+         if (ihdr->width  > passes[pngp->pass.pos].x &&
+             ihdr->height > passes[pngp->pass.pos].y)
+            break;
 
-      pngp->pass.width  = (ihdr->width - 
-            passes[pngp->pass.pos].x + passes[pngp->pass.pos].stride_x - 1) / passes[pngp->pass.pos].stride_x;
-      pngp->pass.height = (ihdr->height - passes[pngp->pass.pos].y + 
-            passes[pngp->pass.pos].stride_y - 1) / passes[pngp->pass.pos].stride_y;
+      if (pngp->pass.pos >= ARRAY_SIZE(passes))
+         return 1;
 
-      pngp->data = (uint32_t*)malloc(
-            pngp->pass.width * pngp->pass.height * sizeof(uint32_t));
+      pass              = &passes[pngp->pass.pos];
 
-      if (!pngp->data)
-         return -1;
+      pngp->pass.width  = (ihdr->width - pass->x
+            + pass->stride_x - 1) / pass->stride_x;
+      pngp->pass.height = (ihdr->height - pass->y
+            + pass->stride_y - 1) / pass->stride_y;
 
-      pngp->ihdr        = *ihdr;
       pngp->ihdr.width  = pngp->pass.width;
       pngp->ihdr.height = pngp->pass.height;
+   }
 
-      png_pass_geom(&pngp->ihdr, pngp->pass.width,
-            pngp->pass.height, NULL, NULL, &pngp->pass.size);
+   png_pass_geom(&pngp->ihdr, &pngp->bpp, &pngp->pitch);
 
-      if (pngp->pass.size > zlib_stream_get_total_out(pngp->stream))
-      {
-         free(pngp->data);
-         return -1;
-      }
+   /* Each pass starts out with an all-zero line above it. */
+   memset(pngp->prev_scanline, 0, pngp->pitch + PNG_SCANLINE_PADDING);
 
-      pngp->adam7_pass_initialized = true;
+   pngp->h                = 0;
+   pngp->pass_initialized = true;
 
-      return 0;
+   return 0;
+}
+
+#if defined(__SSE2__)
+static INLINE __m128i png_load_pixel(const uint8_t *src)
+{
+   int32_t val;
+   memcpy(&val, src, sizeof(val));
+   return _mm_cvtsi32_si128(val);
+}
+
+static INLINE void png_store_pixel(uint8_t *dst, __m128i val)
+{
+   int32_t out = _mm_cvtsi128_si32(val);
+   memcpy(dst, &out, sizeof(out));
+}
+
+static void png_unfilter_up(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch)
+{
+   unsigned i;
+
+   for (i = 0; i + 16 <= pitch; i += 16)
+      _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi8(
+               _mm_loadu_si128((const __m128i*)(in + i)),
+               _mm_loadu_si128((const __m128i*)(prev + i))));
+
+   for (; i < pitch; i++)
+      out[i] = in[i] + prev[i];
+}
+
+/* Sub, Average and Paeth for 3 and 4 byte pixels, one pixel per
+ * step with the left and upper left pixels kept in registers. */
+static void png_unfilter_sub_pixels(uint8_t *out, const uint8_t *in,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      a = _mm_add_epi8(a, png_load_pixel(in + i));
+      png_store_pixel(out + i, a);
    }
+}
 
-   if (pngp->pass_initialized)
-      return 0;
+static void png_unfilter_avg_pixels(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a   = _mm_setzero_si128();
+   __m128i one = _mm_set1_epi8(1);
 
-   png_pass_geom(ihdr, ihdr->width, ihdr->height, &pngp->bpp, &pngp->pitch, &pass_size);
+   for (i = 0; i < pitch; i += bpp)
+   {
+      __m128i b   = png_load_pixel(prev + i);
+      /* avg_epu8 rounds up, PNG wants the sum shifted down. */
+      __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+            _mm_and_si128(_mm_xor_si128(a, b), one));
 
-   if (zlib_stream_get_total_out(pngp->stream) < pass_size)
-      return -1;
+      a = _mm_add_epi8(avg, png_load_pixel(in + i));
+      png_store_pixel(out + i, a);
+   }
+}
 
-   pngp->restore_buf_size      = 0;
-   pngp->data_restore_buf_size = 0;
-   pngp->prev_scanline    = (uint8_t*)calloc(1, pngp->pitch);
-   pngp->decoded_scanline = (uint8_t*)calloc(1, pngp->pitch);
+static void png_unfilter_paeth_pixels(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i zero = _mm_setzero_si128();
+   __m128i a    = zero;
+   __m128i c    = zero;
 
-   if (!pngp->prev_scanline || !pngp->decoded_scanline)
-      goto error;
+   /* Same as paeth(), on 16-bit lanes. */
+   for (i = 0; i < pitch; i += bpp)
+   {
+      __m128i b      = _mm_unpacklo_epi8(png_load_pixel(prev + i), zero);
+      __m128i pa     = _mm_sub_epi16(b, c);
+      __m128i pb     = _mm_sub_epi16(a, c);
+      __m128i pc     = _mm_add_epi16(pa, pb);
+      __m128i not_a, not_b, pred, x;
+
+      pa    = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+      pb    = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+      pc    = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+      not_a = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+      not_b = _mm_cmpgt_epi16(pb, pc);
+      pred  = _mm_or_si128(_mm_and_si128(not_b, c), _mm_andnot_si128(not_b, b));
+      pred  = _mm_or_si128(_mm_and_si128(not_a, pred), _mm_andnot_si128(not_a, a));
+
+      x     = _mm_add_epi8(_mm_packus_epi16(pred, pred),
+            png_load_pixel(in + i));
+      png_store_pixel(out + i, x);
+
+      a     = _mm_unpacklo_epi8(x, zero);
+      c     = b;
+   }
+}
+#define PNG_HAVE_UNFILTER_PIXELS
+#elif defined(RPNG_HAVE_NEON)
+static INLINE uint8x8_t png_load_pixel(const uint8_t *src)
+{
+   uint32_t val;
+   memcpy(&val, src, sizeof(val));
+   return vreinterpret_u8_u32(vdup_n_u32(val));
+}
 
-   pngp->h = 0;
-   pngp->pass_initialized = true;
+static INLINE void png_store_pixel(uint8_t *dst, uint8x8_t val)
+{
+   uint32_t out = vget_lane_u32(vreinterpret_u32_u8(val), 0);
+   memcpy(dst, &out, sizeof(out));
+}
 
-   return 0;
+static void png_unfilter_up(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch)
+{
+   unsigned i;
 
-error:
-   png_reverse_filter_deinit(pngp);
-   return -1;
+   for (i = 0; i + 16 <= pitch; i += 16)
+      vst1q_u8(out + i, vaddq_u8(vld1q_u8(in + i), vld1q_u8(prev + i)));
+
+   for (; i < pitch; i++)
+      out[i] = in[i] + prev[i];
+}
+
+/* Sub, Average and Paeth for 3 and 4 byte pixels, one pixel per
+ * step with the left and upper left pixels kept in registers. */
+static void png_unfilter_sub_pixels(uint8_t *out, const uint8_t *in,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      a = vadd_u8(a, png_load_pixel(in + i));
+      png_store_pixel(out + i, a);
+   }
+}
+
+static void png_unfilter_avg_pixels(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      a = vadd_u8(vhadd_u8(a, png_load_pixel(prev + i)),
+            png_load_pixel(in + i));
+      png_store_pixel(out + i, a);
+   }
+}
+
+static void png_unfilter_paeth_pixels(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+   uint8x8_t c = vdup_n_u8(0);
+
+   /* Same as paeth(), |a + b - 2c| needs 16 bits. */
+   for (i = 0; i < pitch; i += bpp)
+   {
+      uint8x8_t b      = png_load_pixel(prev + i);
+      uint16x8_t pa    = vmovl_u8(vabd_u8(b, c));
+      uint16x8_t pb    = vmovl_u8(vabd_u8(a, c));
+      uint16x8_t pc    = vabdq_u16(vaddl_u8(a, b), vshll_n_u8(c, 1));
+      uint8x8_t not_a  = vmovn_u16(vorrq_u16(
+               vcgtq_u16(pa, pb), vcgtq_u16(pa, pc)));
+      uint8x8_t not_b  = vmovn_u16(vcgtq_u16(pb, pc));
+      uint8x8_t pred   = vbsl_u8(not_a, vbsl_u8(not_b, c, b), a);
+
+      a = vadd_u8(pred, png_load_pixel(in + i));
+      png_store_pixel(out + i, a);
+      c = b;
+   }
+}
+#define PNG_HAVE_UNFILTER_PIXELS
+#else
+static void png_unfilter_up(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch)
+{
+   unsigned i;
+
+   for (i = 0; i < pitch; i++)
+      out[i] = in[i] + prev[i];
 }
+#endif
 
-static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
-      struct rpng_process_t *pngp, unsigned filter)
+static bool png_reverse_filter_line(struct rpng_process_t *pngp,
+      unsigned filter)
 {
    unsigned i;
+   unsigned bpp         = pngp->bpp;
+   unsigned pitch       = pngp->pitch;
+   const uint8_t *in    = pngp->scanline + 1;
+   const uint8_t *prev  = pngp->prev_scanline;
+   uint8_t *out         = pngp->decoded_scanline;
+#ifdef PNG_HAVE_UNFILTER_PIXELS
+   bool pixels          = bpp == 3 || bpp == 4;
+#endif
 
    switch (filter)
    {
       case PNG_FILTER_NONE:
-         memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
+         memcpy(out, in, pitch);
          break;
       case PNG_FILTER_SUB:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->decoded_scanline[i - pngp->bpp] + pngp->inflate_buf[i];
+#ifdef PNG_HAVE_UNFILTER_PIXELS
+         if (pixels)
+         {
+            png_unfilter_sub_pixels(out, in, pitch, bpp);
+            break;
+         }
+#endif
+         for (i = 0; i < bpp; i++)
+            out[i] = in[i];
+         for (i = bpp; i < pitch; i++)
+            out[i] = out[i - bpp] + in[i];
          break;
       case PNG_FILTER_UP:
-         for (i = 0; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->prev_scanline[i] + pngp->inflate_buf[i];
+         png_unfilter_up(out, in, prev, pitch);
          break;
       case PNG_FILTER_AVERAGE:
-         for (i = 0; i < pngp->bpp; i++)
+#ifdef PNG_HAVE_UNFILTER_PIXELS
+         if (pixels)
          {
-            uint8_t avg = pngp->prev_scanline[i] >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
+            png_unfilter_avg_pixels(out, in, prev, pitch, bpp);
+            break;
          }
-         for (i = pngp->bpp; i < pngp->pitch; i++)
+#endif
+         for (i = 0; i < bpp; i++)
+         {
+            uint8_t avg = prev[i] >> 1;
+            out[i] = avg + in[i];
+         }
+         for (i = bpp; i < pitch; i++)
          {
-            uint8_t avg = (pngp->decoded_scanline[i - pngp->bpp] + pngp->prev_scanline[i]) >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
+            uint8_t avg = (out[i - bpp] + prev[i]) >> 1;
+            out[i] = avg + in[i];
          }
          break;
       case PNG_FILTER_PAETH:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = paeth(0, pngp->prev_scanline[i], 0) + pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = paeth(pngp->decoded_scanline[i - pngp->bpp],
-                  pngp->prev_scanline[i], pngp->prev_scanline[i - pngp->bpp]) + pngp->inflate_buf[i];
+#ifdef PNG_HAVE_UNFILTER_PIXELS
+         if (pixels)
+         {
+            png_unfilter_paeth_pixels(out, in, prev, pitch, bpp);
+            break;
+         }
+#endif
+         for (i = 0; i < bpp; i++)
+            out[i] = paeth(0, prev[i], 0) + in[i];
+         for (i = bpp; i < pitch; i++)
+            out[i] = paeth(out[i - bpp], prev[i], prev[i - bpp]) + in[i];
          break;
 
       default:
-         return PNG_PROCESS_ERROR_END;
+         return false;
    }
 
+   return true;
+}
+
+static void png_reverse_filter_copy_line(uint32_t *data,
+      const struct png_ihdr *ihdr, const struct rpng_process_t *pngp)
+{
    switch (ihdr->color_type)
    {
       case PNG_IHDR_COLOR_GRAY:
@@ -563,158 +767,114 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
          png_reverse_filter_copy_line_rgba(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
          break;
    }
-
-   memcpy(pngp->prev_scanline, pngp->decoded_scanline, pngp->pitch);
-
-   return PNG_PROCESS_NEXT;
 }
 
-static int png_reverse_filter_regular_iterate(uint32_t **data, const struct png_ihdr *ihdr,
-      struct rpng_process_t *pngp)
+/* Points pngp->scanline at the filter byte and the data of the
+ * next scanline of the pass. When the window runs out, what is left
+ * of it moves to the front and the IDAT data is inflated further,
+ * picking up where the last call ended. */
+static bool png_inflate_scanline(rpng_t *rpng)
 {
-   int ret = PNG_PROCESS_END;
+   struct rpng_process_t *pngp = &rpng->process;
+   size_t size                 = pngp->pitch + 1;
 
-   if (pngp->h < ihdr->height)
+   if (pngp->inflate_end - pngp->inflate_pos < size)
    {
-      unsigned filter = *pngp->inflate_buf++;
-      pngp->restore_buf_size += 1;
-      ret = png_reverse_filter_copy_line(*data,
-            ihdr, pngp, filter);
-   }
+      memmove(pngp->inflate_buf, pngp->inflate_buf + pngp->inflate_pos,
+            pngp->inflate_end - pngp->inflate_pos);
+      pngp->inflate_end -= pngp->inflate_pos;
+      pngp->inflate_pos  = 0;
 
-   if (ret == PNG_PROCESS_END || ret == PNG_PROCESS_ERROR_END)
-      goto end;
+      while (pngp->inflate_end < size)
+      {
+         int zstatus;
+         uint32_t avail_in  = rpng->idat_buf.size - pngp->idat_pos;
+         uint32_t avail_out = pngp->inflate_buf_size - pngp->inflate_end;
 
-   pngp->h++;
-   pngp->inflate_buf           += pngp->pitch;
-   pngp->restore_buf_size      += pngp->pitch;
+         /* Out of compressed data before the image is complete. */
+         if (pngp->stream_end || !avail_in)
+            return false;
 
-   *data                       += ihdr->width;
-   pngp->data_restore_buf_size += ihdr->width;
+         zlib_set_stream(pngp->stream, avail_in, avail_out,
+               rpng->idat_buf.data + pngp->idat_pos,
+               pngp->inflate_buf + pngp->inflate_end);
 
-   return PNG_PROCESS_NEXT;
+         zstatus = zlib_inflate_data_to_file_iterate(pngp->stream);
 
-end:
-   png_reverse_filter_deinit(pngp);
+         if (zstatus == -1)
+            return false;
+         if (zstatus == 1)
+            pngp->stream_end = true;
 
-   pngp->inflate_buf -= pngp->restore_buf_size;
-   *data             -= pngp->data_restore_buf_size;
-   pngp->data_restore_buf_size = 0;
-   return ret;
+         pngp->idat_pos    += avail_in  - zlib_stream_get_avail_in(pngp->stream);
+         pngp->inflate_end += avail_out - zlib_stream_get_avail_out(pngp->stream);
+      }
+   }
+
+   pngp->scanline     = pngp->inflate_buf + pngp->inflate_pos;
+   pngp->inflate_pos += size;
+   return true;
 }
 
-static int png_reverse_filter_adam7_iterate(uint32_t **data_,
-      const struct png_ihdr *ihdr,
-      struct rpng_process_t *pngp)
+static int png_reverse_filter_iterate(rpng_t *rpng, uint32_t **data)
 {
-   int ret = 0;
-   bool to_next = pngp->pass.pos < ARRAY_SIZE(passes);
-   uint32_t *data = *data_;
+   struct rpng_process_t *pngp = &rpng->process;
+   const struct png_ihdr *ihdr = &rpng->ihdr;
 
-   if (!to_next)
-      return PNG_PROCESS_END;
+   if (!pngp->pass_initialized && png_reverse_filter_init(ihdr, pngp) == 1)
+      goto end;
 
-   ret = png_reverse_filter_init(ihdr, pngp);
+   if (!png_inflate_scanline(rpng))
+      goto error;
 
-   if (ret == 1)
-      return PNG_PROCESS_NEXT;
-   if (ret == -1)
+   if (!png_reverse_filter_line(pngp, pngp->scanline[0]))
+   {
+      png_reverse_filter_deinit(pngp);
       return PNG_PROCESS_ERROR_END;
+   }
 
-   if (png_reverse_filter_init(&pngp->ihdr, pngp) == -1)
-      return PNG_PROCESS_ERROR;
-
-   do{
-      ret = png_reverse_filter_regular_iterate(&pngp->data,
-            &pngp->ihdr, pngp);
-   }while(ret == PNG_PROCESS_NEXT);
-
-   if (ret == PNG_PROCESS_ERROR || ret == PNG_PROCESS_ERROR_END)
-      return PNG_PROCESS_ERROR;
-
-   pngp->inflate_buf            += pngp->pass.size;
-   pngp->adam7_restore_buf_size += pngp->pass.size;
-
-   zlib_stream_decrement_total_out(pngp->stream, pngp->pass.size);
-
-   png_reverse_filter_adam7_deinterlace_pass(data,
-         ihdr, pngp->data, pngp->pass.width, pngp->pass.height, &passes[pngp->pass.pos]);
-
-   free(pngp->data);
-
-   pngp->pass.width  = 0;
-   pngp->pass.height = 0;
-   pngp->pass.size   = 0;
-   pngp->adam7_pass_initialized = false;
-
-   return PNG_PROCESS_NEXT;
-}
-
-static int png_reverse_filter_adam7(uint32_t **data_,
-      const struct png_ihdr *ihdr,
-      struct rpng_process_t *pngp)
-{
-   int ret = png_reverse_filter_adam7_iterate(data_,
-         ihdr, pngp);
+   if (ihdr->interlace)
+   {
+      png_reverse_filter_copy_line(pngp->pass_line, &pngp->ihdr, pngp);
+      png_reverse_filter_adam7_deinterlace_line(*data, ihdr,
+            pngp->pass_line, pngp->pass.width, pngp->h,
+            &passes[pngp->pass.pos]);
+   }
+   else
+      png_reverse_filter_copy_line(*data + pngp->h * ihdr->width,
+            ihdr, pngp);
 
-   switch (ret)
    {
-      case PNG_PROCESS_ERROR_END:
-      case PNG_PROCESS_END:
-         break;
-      case PNG_PROCESS_NEXT:
-         pngp->pass.pos++;
-         return 0;
-      case PNG_PROCESS_ERROR:
-         if (pngp->data)
-            free(pngp->data);
-         pngp->inflate_buf -= pngp->adam7_restore_buf_size;
-         pngp->adam7_restore_buf_size = 0;
-         return -1;
+      uint8_t *tmp           = pngp->prev_scanline;
+      pngp->prev_scanline    = pngp->decoded_scanline;
+      pngp->decoded_scanline = tmp;
    }
 
-   pngp->inflate_buf -= pngp->adam7_restore_buf_size;
-   pngp->adam7_restore_buf_size = 0;
-   return ret;
-}
+   if (++pngp->h < pngp->ihdr.height)
+      return PNG_PROCESS_NEXT;
 
-static int png_reverse_filter_iterate(rpng_t *rpng, uint32_t **data)
-{
-   if (!rpng)
-      return false;
+   pngp->pass_initialized = false;
 
-   if (rpng->ihdr.interlace)
-      return png_reverse_filter_adam7(data, &rpng->ihdr, &rpng->process);
+   if (ihdr->interlace && ++pngp->pass.pos < ARRAY_SIZE(passes))
+      return PNG_PROCESS_NEXT;
+
+end:
+   png_reverse_filter_deinit(pngp);
+   return PNG_PROCESS_END;
 
-   return png_reverse_filter_regular_iterate(data, &rpng->ihdr, &rpng->process);
+error:
+   png_reverse_filter_deinit(pngp);
+   return PNG_PROCESS_ERROR;
 }
 
+/* Sets up the output and the line buffers. The IDAT data is
+ * inflated a window at a time as the lines get unfiltered, so no
+ * buffer ever holds the whole inflated image. */
 static int rpng_load_image_argb_process_inflate_init(rpng_t *rpng,
       uint32_t **data, unsigned *width, unsigned *height)
 {
-   int zstatus;
-   bool to_continue = (zlib_stream_get_avail_in(rpng->process.stream) > 0
-         && zlib_stream_get_avail_out(rpng->process.stream) > 0);
-
-   if (!to_continue)
-      goto end;
-
-   zstatus = zlib_inflate_data_to_file_iterate(rpng->process.stream);
-
-   switch (zstatus)
-   {
-      case 1:
-         goto end;
-      case -1:
-         goto error;
-      default:
-         break;
-   }
-
-   return 0;
-
-end:
-   zlib_stream_free(rpng->process.stream);
+   unsigned pitch;
+   struct rpng_process_t *pngp = &rpng->process;
 
    *width  = rpng->ihdr.width;
    *height = rpng->ihdr.height;
@@ -727,24 +887,36 @@ end:
          rpng->ihdr.height * sizeof(uint32_t));
 #endif
    if (!*data)
-      goto false_end;
+      goto error;
 
-   rpng->process.adam7_restore_buf_size = 0;
-   rpng->process.restore_buf_size = 0;
-   rpng->process.palette = rpng->palette;
+   png_pass_geom(&rpng->ihdr, NULL, &pitch);
+
+   pngp->palette          = rpng->palette;
+   pngp->prev_scanline    = (uint8_t*)malloc(pitch + PNG_SCANLINE_PADDING);
+   pngp->decoded_scanline = (uint8_t*)malloc(pitch + PNG_SCANLINE_PADDING);
+   pngp->inflate_buf_size = pitch + 1 + PNG_INFLATE_WINDOW;
+   pngp->inflate_buf      = (uint8_t*)malloc(
+         pngp->inflate_buf_size + PNG_SCANLINE_PADDING);
+   pngp->inflate_pos      = 0;
+   pngp->inflate_end      = 0;
+
+   if (!pngp->prev_scanline || !pngp->decoded_scanline || !pngp->inflate_buf)
+      goto error;
 
-   if (rpng->ihdr.interlace != 1)
-      if (png_reverse_filter_init(&rpng->ihdr, &rpng->process) == -1)
-         goto false_end;
+   if (rpng->ihdr.interlace)
+   {
+      pngp->pass_line = (uint32_t*)malloc(
+            rpng->ihdr.width * sizeof(uint32_t));
+      if (!pngp->pass_line)
+         goto error;
+   }
 
-   rpng->process.inflate_initialized = true;
+   pngp->inflate_initialized = true;
    return 1;
 
 error:
-   zlib_stream_free(rpng->process.stream);
-
-false_end:
-   rpng->process.inflate_initialized = false;
+   png_reverse_filter_deinit(pngp);
+   pngp->inflate_initialized = false;
    return -1;
 }
 
@@ -766,26 +938,29 @@ static bool png_read_plte(uint8_t *buf,
 
 bool png_realloc_idat(const struct png_chunk *chunk, struct idat_buffer *buf)
 {
-   uint8_t *new_buffer = (uint8_t*)realloc(buf->data, buf->size + chunk->size);
+   uint8_t *new_buffer;
+   size_t capacity = buf->capacity ? buf->capacity : 4096;
+
+   /* Grow geometrically, images often come in many small IDATs. */
+   while (capacity < buf->size + chunk->size)
+      capacity *= 2;
+
+   if (capacity == buf->capacity)
+      return true;
+
+   new_buffer = (uint8_t*)realloc(buf->data, capacity);
 
    if (!new_buffer)
       return false;
 
-   buf->data  = new_buffer;
+   buf->data     = new_buffer;
+   buf->capacity = capacity;
    return true;
 }
 
 static bool rpng_load_image_argb_process_init(rpng_t *rpng,
       uint32_t **data, unsigned *width, unsigned *height)
 {
-   rpng->process.inflate_buf_size = 0;
-   rpng->process.inflate_buf      = NULL;
-
-   png_pass_geom(&rpng->ihdr, rpng->ihdr.width,
-         rpng->ihdr.height, NULL, NULL, &rpng->process.inflate_buf_size);
-   if (rpng->ihdr.interlace == 1) /* To be sure. */
-      rpng->process.inflate_buf_size *= 2;
-
    rpng->process.stream = zlib_stream_new();
 
    if (!rpng->process.stream)
@@ -794,17 +969,7 @@ static bool rpng_load_image_argb_process_init(rpng_t *rpng,
    if (!zlib_inflate_init(rpng->process.stream))
       return false;
 
-   rpng->process.inflate_buf = (uint8_t*)malloc(rpng->process.inflate_buf_size);
-   if (!rpng->process.inflate_buf)
-      return false;
-
-   zlib_set_stream(
-         rpng->process.stream,
-         rpng->idat_buf.size,
-         rpng->process.inflate_buf_size,
-         rpng->idat_buf.data,
-         rpng->process.inflate_buf);
-
+   rpng->process.idat_pos    = 0;
    rpng->process.initialized = true;
 
    return true;
@@ -851,7 +1016,6 @@ static bool png_parse_ihdr(uint8_t *buf,
 
 bool rpng_nbio_load_image_argb_iterate(rpng_t *rpng)
 {
-   unsigned i;
    unsigned ret;
    uint8_t *buf = (uint8_t*)rpng->buff_data;
 
@@ -860,13 +1024,6 @@ bool rpng_nbio_load_image_argb_iterate(rpng_t *rpng)
    if (!read_chunk_header(buf, &chunk))
       return false;
 
-#if 0
-   for (i = 0; i < 4; i++)
-   {
-      fprintf(stderr, "chunktype: %c\n", chunk.type[i]);
-   }
-#endif
-
    switch (png_chunk_type(&chunk))
    {
       case PNG_CHUNK_NOOP:
@@ -923,8 +1080,7 @@ bool rpng_nbio_load_image_argb_iterate(rpng_t *rpng)
 
          buf += 8;
 
-         for (i = 0; i < chunk.size; i++)
-            rpng->idat_buf.data[i + rpng->idat_buf.size] = buf[i];
+         memcpy(rpng->idat_buf.data + rpng->idat_buf.size, buf, chunk.size);
 
          rpng->idat_buf.size += chunk.size;
 
@@ -968,6 +1124,10 @@ int rpng_nbio_load_image_argb_process(rpng_t *rpng,
       return 0;
    }
 
+   /* Callers may pass fresh variables on every call. */
+   *width  = rpng->ihdr.width;
+   *height = rpng->ihdr.height;
+
    return png_reverse_filter_iterate(rpng, data);
 }
 
@@ -978,8 +1138,7 @@ void rpng_nbio_load_image_free(rpng_t *rpng)
 
    if (rpng->idat_buf.data)
       free(rpng->idat_buf.data);
-   if (rpng->process.inflate_buf)
-      free(rpng->process.inflate_buf);
+   png_reverse_filter_deinit(&rpng->process);
    if (rpng->process.stream)
    {
       zlib_stream_free(rpng->process.stream);
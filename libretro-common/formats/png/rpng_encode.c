@@ -25,6 +25,9 @@
 #include <string.h>
 
 #include <retro_file.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #include "rpng_internal.h"
 
@@ -147,9 +150,43 @@ static void copy_bgr24_line(uint8_t *dst, const uint8_t *src, unsigned width)
 
 static unsigned count_sad(const uint8_t *data, size_t size)
 {
-   size_t i;
+   size_t i     = 0;
    unsigned cnt = 0;
-   for (i = 0; i < size; i++)
+
+#if defined(__SSE2__)
+   {
+      const __m128i zero = _mm_setzero_si128();
+      __m128i sum        = zero;
+
+      /* |x| of a signed byte is min(x, -x) taken as unsigned. */
+      for (; i + 16 <= size; i += 16)
+      {
+         __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+         v         = _mm_min_epu8(v, _mm_sub_epi8(zero, v));
+         sum       = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+      }
+
+      cnt = _mm_cvtsi128_si32(sum)
+         + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+   }
+#elif defined(RPNG_HAVE_NEON)
+   {
+      uint32x4_t sum = vdupq_n_u32(0);
+
+      /* vabsq_s8(-128) stays 0x80, which is 128 unsigned. */
+      for (; i + 16 <= size; i += 16)
+      {
+         uint8x16_t v = vreinterpretq_u8_s8(
+               vabsq_s8(vld1q_s8((const int8_t*)(data + i))));
+         sum          = vpadalq_u16(sum, vpaddlq_u8(v));
+      }
+
+      cnt = vgetq_lane_u32(sum, 0) + vgetq_lane_u32(sum, 1)
+         + vgetq_lane_u32(sum, 2) + vgetq_lane_u32(sum, 3);
+   }
+#endif
+
+   for (; i < size; i++)
       cnt += abs((int8_t)data[i]);
    return cnt;
 }
@@ -157,9 +194,16 @@ static unsigned count_sad(const uint8_t *data, size_t size)
 static unsigned filter_up(uint8_t *target, const uint8_t *line,
       const uint8_t *prev, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
    width *= bpp;
-   for (i = 0; i < width; i++)
+
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)),
+               _mm_loadu_si128((const __m128i*)(prev + i))));
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - prev[i];
 
    return count_sad(target, width);
@@ -172,7 +216,14 @@ static unsigned filter_sub(uint8_t *target, const uint8_t *line,
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i];
-   for (i = bpp; i < width; i++)
+
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)),
+               _mm_loadu_si128((const __m128i*)(line + i - bpp))));
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - line[i - bpp];
 
    return count_sad(target, width);
@@ -185,7 +236,25 @@ static unsigned filter_avg(uint8_t *target, const uint8_t *line,
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i] - (prev[i] >> 1);
-   for (i = bpp; i < width; i++)
+
+#if defined(__SSE2__)
+   {
+      const __m128i one = _mm_set1_epi8(1);
+
+      /* pavgb rounds up, so take the low bit of a ^ b back off. */
+      for (; i + 16 <= width; i += 16)
+      {
+         __m128i a   = _mm_loadu_si128((const __m128i*)(line + i - bpp));
+         __m128i b   = _mm_loadu_si128((const __m128i*)(prev + i));
+         __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+               _mm_and_si128(_mm_xor_si128(a, b), one));
+
+         _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+                  _mm_loadu_si128((const __m128i*)(line + i)), avg));
+      }
+   }
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - ((line[i - bpp] + prev[i]) >> 1);
 
    return count_sad(target, width);
@@ -199,71 +268,122 @@ static unsigned filter_paeth(uint8_t *target,
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i] - paeth(0, prev[i], 0);
-   for (i = bpp; i < width; i++)
+
+#if defined(__SSE2__)
+   {
+      const __m128i zero = _mm_setzero_si128();
+
+      /* Same choice as paeth(), on 16-bit lanes:
+       * pa = |b - c|, pb = |a - c|, pc = |a + b - 2c|. */
+      for (; i + 8 <= width; i += 8)
+      {
+         __m128i a  = _mm_unpacklo_epi8(
+               _mm_loadl_epi64((const __m128i*)(line + i - bpp)), zero);
+         __m128i b  = _mm_unpacklo_epi8(
+               _mm_loadl_epi64((const __m128i*)(prev + i)), zero);
+         __m128i c  = _mm_unpacklo_epi8(
+               _mm_loadl_epi64((const __m128i*)(prev + i - bpp)), zero);
+         __m128i x  = _mm_unpacklo_epi8(
+               _mm_loadl_epi64((const __m128i*)(line + i)), zero);
+         __m128i bc = _mm_sub_epi16(b, c);
+         __m128i ac = _mm_sub_epi16(a, c);
+         __m128i abc = _mm_add_epi16(bc, ac);
+         __m128i pa = _mm_max_epi16(bc, _mm_sub_epi16(zero, bc));
+         __m128i pb = _mm_max_epi16(ac, _mm_sub_epi16(zero, ac));
+         __m128i pc = _mm_max_epi16(abc, _mm_sub_epi16(zero, abc));
+         __m128i not_a = _mm_or_si128(
+               _mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+         __m128i not_b = _mm_cmpgt_epi16(pb, pc);
+         __m128i pred  = _mm_or_si128(
+               _mm_andnot_si128(not_a, a),
+               _mm_and_si128(not_a, _mm_or_si128(
+                     _mm_andnot_si128(not_b, b),
+                     _mm_and_si128(not_b, c))));
+
+         _mm_storel_epi64((__m128i*)(target + i), _mm_packus_epi16(
+                  _mm_and_si128(_mm_sub_epi16(x, pred), _mm_set1_epi16(0xff)),
+                  zero));
+      }
+   }
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - paeth(line[i - bpp], prev[i], prev[i - bpp]);
 
    return count_sad(target, width);
 }
 
-static bool rpng_save_image(const char *path,
-      const uint8_t *data,
-      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
+static void copy_line(uint8_t *dst, const uint8_t *src,
+      unsigned width, unsigned bpp)
 {
-   unsigned h;
-   bool ret = true;
-   struct png_ihdr ihdr = {0};
-
-   size_t encode_buf_size  = 0;
-   uint8_t *encode_buf     = NULL;
-   uint8_t *deflate_buf    = NULL;
-   uint8_t *rgba_line      = NULL;
-   uint8_t *up_filtered    = NULL;
-   uint8_t *sub_filtered   = NULL;
-   uint8_t *avg_filtered   = NULL;
-   uint8_t *paeth_filtered = NULL;
-   uint8_t *prev_encoded   = NULL;
-   uint8_t *encode_target  = NULL;
-   void *stream            = NULL;
-
-   RFILE *file = retro_fopen(path, RFILE_MODE_WRITE, -1);
-   if (!file)
-      GOTO_END_ERROR();
-
-   if (retro_fwrite(file, png_magic, sizeof(png_magic)) != sizeof(png_magic))
-      GOTO_END_ERROR();
-
-   ihdr.width = width;
-   ihdr.height = height;
-   ihdr.depth = 8;
-   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
-   if (!png_write_ihdr(file, &ihdr))
-      GOTO_END_ERROR();
+   if (bpp == sizeof(uint32_t))
+      copy_argb_line(dst, (const uint32_t*)src, width);
+   else
+      copy_bgr24_line(dst, src, width);
+}
 
-   encode_buf_size = (width * bpp + 1) * height;
-   encode_buf = (uint8_t*)malloc(encode_buf_size);
-   if (!encode_buf)
-      GOTO_END_ERROR();
+/* The image is encoded in bands of rows. Every band is filtered
+ * and deflated on its own thread, and the raw deflate streams are
+ * joined into one zlib stream like pigz does. Each band ends on a
+ * byte boundary with a sync flush and is primed with the 32 KiB
+ * before it, so the output stays close to a single stream's size.
+ *
+ * The number of bands only depends on the image size, so the same
+ * image always encodes to the same file. */
+#define RPNG_ENCODE_BAND_SIZE (256 * 1024)
+#define RPNG_ENCODE_MAX_BANDS 8
+#define RPNG_ENCODE_WINDOW    (32 * 1024)
 
-   prev_encoded = (uint8_t*)calloc(1, width * bpp);
-   if (!prev_encoded)
+struct rpng_encode_band
+{
+   const uint8_t *data;    /* Input image. */
+   unsigned width;
+   unsigned pitch;
+   unsigned bpp;
+   int level;
+
+   unsigned first_row;
+   unsigned rows;
+   bool last;
+
+   /* Filtered rows of the whole image. */
+   uint8_t *encode_buf;
+   size_t offset;
+   size_t size;
+
+   uint8_t *deflate_buf;
+   size_t deflate_size;
+   uint32_t adler;
+   bool ok;
+};
+
+static bool rpng_encode_filter_band(struct rpng_encode_band *band)
+{
+   unsigned h;
+   bool ret                = true;
+   unsigned width          = band->width;
+   unsigned bpp            = band->bpp;
+   size_t line_size        = width * bpp;
+   const uint8_t *data     = band->data + (size_t)band->first_row * band->pitch;
+   uint8_t *encode_target  = band->encode_buf + band->offset;
+   uint8_t *rgba_line      = (uint8_t*)malloc(line_size);
+   uint8_t *prev_encoded   = (uint8_t*)calloc(1, line_size);
+   uint8_t *up_filtered    = (uint8_t*)malloc(line_size);
+   uint8_t *sub_filtered   = (uint8_t*)malloc(line_size);
+   uint8_t *avg_filtered   = (uint8_t*)malloc(line_size);
+   uint8_t *paeth_filtered = (uint8_t*)malloc(line_size);
+
+   if (!rgba_line || !prev_encoded || !up_filtered
+         || !sub_filtered || !avg_filtered || !paeth_filtered)
       GOTO_END_ERROR();
 
-   rgba_line      = (uint8_t*)malloc(width * bpp);
-   up_filtered    = (uint8_t*)malloc(width * bpp);
-   sub_filtered   = (uint8_t*)malloc(width * bpp);
-   avg_filtered   = (uint8_t*)malloc(width * bpp);
-   paeth_filtered = (uint8_t*)malloc(width * bpp);
-   if (!rgba_line || !up_filtered || !sub_filtered || !avg_filtered || !paeth_filtered)
-      GOTO_END_ERROR();
+   /* Up, average and Paeth look at the row above the band. */
+   if (band->first_row)
+      copy_line(prev_encoded, data - band->pitch, width, bpp);
 
-   encode_target = encode_buf;
-   for (h = 0; h < height;
-         h++, encode_target += width * bpp, data += pitch)
+   for (h = 0; h < band->rows;
+         h++, encode_target += line_size, data += band->pitch)
    {
-      if (bpp == sizeof(uint32_t))
-         copy_argb_line(rgba_line, (const uint32_t*)data, width);
-      else
-         copy_bgr24_line(rgba_line, data, width);
+      copy_line(rgba_line, data, width, bpp);
 
       /* Try every filtering method, and choose the method
        * which has most entries as zero.
@@ -272,7 +392,7 @@ static bool rpng_save_image(const char *path,
        * simple to implement.
        */
       {
-         unsigned none_score  = count_sad(rgba_line, width * bpp);
+         unsigned none_score  = count_sad(rgba_line, line_size);
          unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, width, bpp);
          unsigned sub_score   = filter_sub(sub_filtered, rgba_line, width, bpp);
          unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, width, bpp);
@@ -281,6 +401,7 @@ static bool rpng_save_image(const char *path,
          uint8_t filter       = 0;
          unsigned min_sad     = none_score;
          const uint8_t *chosen_filtered = rgba_line;
+         uint8_t *swap        = NULL;
 
          if (sub_score < min_sad)
          {
@@ -311,41 +432,226 @@ static bool rpng_save_image(const char *path,
          }
 
          *encode_target++ = filter;
-         memcpy(encode_target, chosen_filtered, width * bpp);
+         memcpy(encode_target, chosen_filtered, line_size);
 
-         memcpy(prev_encoded, rgba_line, width * bpp);
+         swap         = prev_encoded;
+         prev_encoded = rgba_line;
+         rgba_line    = swap;
       }
    }
 
-   deflate_buf = (uint8_t*)malloc(encode_buf_size * 2); /* Just to be sure. */
-   if (!deflate_buf)
-      GOTO_END_ERROR();
+end:
+   free(rgba_line);
+   free(prev_encoded);
+   free(up_filtered);
+   free(sub_filtered);
+   free(avg_filtered);
+   free(paeth_filtered);
+   return ret;
+}
 
-   stream = zlib_stream_new();
+static bool rpng_encode_deflate_band(struct rpng_encode_band *band)
+{
+   size_t bound;
+   size_t dict_size;
+   bool ret              = true;
+   const uint8_t *input  = band->encode_buf + band->offset;
+   void *stream          = zlib_stream_new();
 
    if (!stream)
       GOTO_END_ERROR();
 
-   zlib_set_stream(
-         stream,
-         encode_buf_size,
-         encode_buf_size * 2,
-         encode_buf,
-         deflate_buf + 8);
+   if (!zlib_deflate_init_raw(stream, band->level))
+   {
+      free(stream);
+      stream = NULL;
+      GOTO_END_ERROR();
+   }
 
-   zlib_deflate_init(stream, 9);
+   dict_size = band->offset < RPNG_ENCODE_WINDOW
+      ? band->offset : RPNG_ENCODE_WINDOW;
+   if (dict_size && !zlib_deflate_set_dictionary(stream,
+            input - dict_size, (uint32_t)dict_size))
+      GOTO_END_ERROR();
+
+   /* Room for the sync flush marker as well. */
+   bound            = zlib_deflate_bound(stream, band->size) + 16;
+   band->deflate_buf = (uint8_t*)malloc(bound);
+   if (!band->deflate_buf)
+      GOTO_END_ERROR();
 
-   if (zlib_deflate_data_to_file(stream) != 1)
+   zlib_set_stream(stream, (uint32_t)band->size, (uint32_t)bound,
+         input, band->deflate_buf);
+
+   if (band->last)
    {
+      if (zlib_deflate_data_to_file(stream) != 1)
+         GOTO_END_ERROR();
+   }
+   else if (zlib_deflate_data_to_file_flush(stream) != 1)
+      GOTO_END_ERROR();
+
+   band->deflate_size = (size_t)zlib_stream_get_total_out(stream);
+   band->adler        = zlib_adler32_calculate(input, band->size);
+
+end:
+   /* zlib_stream_free() only ends inflate streams. */
+   if (stream)
       zlib_stream_deflate_free(stream);
+   free(stream);
+   return ret;
+}
+
+static void rpng_encode_filter_thread(void *data)
+{
+   struct rpng_encode_band *band = (struct rpng_encode_band*)data;
+   band->ok = rpng_encode_filter_band(band);
+}
+
+static void rpng_encode_deflate_thread(void *data)
+{
+   struct rpng_encode_band *band = (struct rpng_encode_band*)data;
+   band->ok = rpng_encode_deflate_band(band);
+}
+
+/* Runs @func on every band, the first on this thread. */
+static bool rpng_encode_run(struct rpng_encode_band *bands,
+      unsigned num_bands, void (*func)(void*))
+{
+   unsigned i;
+   bool ret = true;
+#ifdef HAVE_THREADS
+   sthread_t *threads[RPNG_ENCODE_MAX_BANDS] = {NULL};
+
+   for (i = 1; i < num_bands; i++)
+      threads[i] = sthread_create(func, &bands[i]);
+#endif
+
+   func(&bands[0]);
+
+   for (i = 1; i < num_bands; i++)
+   {
+#ifdef HAVE_THREADS
+      if (threads[i])
+      {
+         sthread_join(threads[i]);
+         continue;
+      }
+#endif
+      func(&bands[i]);
+   }
+
+   for (i = 0; i < num_bands; i++)
+      ret = ret && bands[i].ok;
+
+   return ret;
+}
+
+static bool rpng_save_image(const char *path,
+      const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, unsigned bpp,
+      int level)
+{
+   unsigned i, rows_per_band;
+   bool ret = true;
+   struct png_ihdr ihdr = {0};
+   struct rpng_encode_band bands[RPNG_ENCODE_MAX_BANDS];
+
+   size_t encode_buf_size  = 0;
+   size_t line_size        = width * bpp + 1;
+   size_t idat_size        = 0;
+   unsigned num_bands      = 0;
+   uint32_t adler          = 0;
+   uint8_t *encode_buf     = NULL;
+   uint8_t *idat_buf       = NULL;
+   uint8_t *idat_target    = NULL;
+
+   RFILE *file = retro_fopen(path, RFILE_MODE_WRITE, -1);
+
+   memset(bands, 0, sizeof(bands));
+
+   if (!file)
       GOTO_END_ERROR();
+
+   if (retro_fwrite(file, png_magic, sizeof(png_magic)) != sizeof(png_magic))
+      GOTO_END_ERROR();
+
+   ihdr.width = width;
+   ihdr.height = height;
+   ihdr.depth = 8;
+   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
+   if (!png_write_ihdr(file, &ihdr))
+      GOTO_END_ERROR();
+
+   encode_buf_size = line_size * height;
+   encode_buf = (uint8_t*)malloc(encode_buf_size);
+   if (!encode_buf)
+      GOTO_END_ERROR();
+
+   num_bands = (unsigned)(encode_buf_size / RPNG_ENCODE_BAND_SIZE);
+   if (num_bands > RPNG_ENCODE_MAX_BANDS)
+      num_bands = RPNG_ENCODE_MAX_BANDS;
+   if (num_bands > height)
+      num_bands = height;
+   if (num_bands < 1)
+      num_bands = 1;
+
+   /* Rounding rows_per_band up can leave the last bands empty. */
+   rows_per_band = (height + num_bands - 1) / num_bands;
+   num_bands     = (height + rows_per_band - 1) / rows_per_band;
+
+   for (i = 0; i < num_bands; i++)
+   {
+      struct rpng_encode_band *band = &bands[i];
+      unsigned first_row            = i * rows_per_band;
+
+      band->data       = data;
+      band->width      = width;
+      band->pitch      = pitch;
+      band->bpp        = bpp;
+      band->level      = level;
+      band->first_row  = first_row;
+      band->rows       = first_row + rows_per_band > height
+         ? height - first_row : rows_per_band;
+      band->last       = i == num_bands - 1;
+      band->encode_buf = encode_buf;
+      band->offset     = first_row * line_size;
+      band->size       = band->rows * line_size;
    }
 
-   zlib_stream_deflate_free(stream);
+   if (!rpng_encode_run(bands, num_bands, rpng_encode_filter_thread))
+      GOTO_END_ERROR();
 
-   memcpy(deflate_buf + 4, "IDAT", 4);
-   dword_write_be(deflate_buf + 0, zlib_stream_get_total_out(stream));
-   if (!png_write_idat(file, deflate_buf, zlib_stream_get_total_out(stream) + 8))
+   if (!rpng_encode_run(bands, num_bands, rpng_encode_deflate_thread))
+      GOTO_END_ERROR();
+
+   /* Chunk header, zlib header, the bands and the Adler-32. */
+   idat_size = 8 + 2 + 4;
+   for (i = 0; i < num_bands; i++)
+      idat_size += bands[i].deflate_size;
+
+   idat_buf = (uint8_t*)malloc(idat_size);
+   if (!idat_buf)
+      GOTO_END_ERROR();
+
+   dword_write_be(idat_buf + 0, (uint32_t)(idat_size - 8));
+   memcpy(idat_buf + 4, "IDAT", 4);
+
+   /* Deflate, 32K window, and the FLEVEL zlib would use for @level. */
+   idat_buf[8]  = 0x78;
+   idat_buf[9]  = level < 2 ? 0x01 : level < 6 ? 0x5e : level == 6 ? 0x9c : 0xda;
+   idat_target  = idat_buf + 10;
+
+   adler = zlib_adler32_calculate(NULL, 0);
+   for (i = 0; i < num_bands; i++)
+   {
+      memcpy(idat_target, bands[i].deflate_buf, bands[i].deflate_size);
+      idat_target += bands[i].deflate_size;
+      adler        = zlib_adler32_combine(adler, bands[i].adler, bands[i].size);
+   }
+   dword_write_be(idat_target, adler);
+
+   if (!png_write_idat(file, idat_buf, idat_size))
       GOTO_END_ERROR();
 
    if (!png_write_iend(file))
@@ -354,15 +660,9 @@ static bool rpng_save_image(const char *path,
 end:
    retro_fclose(file);
    free(encode_buf);
-   free(deflate_buf);
-   free(rgba_line);
-   free(prev_encoded);
-   free(up_filtered);
-   free(sub_filtered);
-   free(avg_filtered);
-   free(paeth_filtered);
-
-   zlib_stream_free(stream);
+   free(idat_buf);
+   for (i = 0; i < num_bands; i++)
+      free(bands[i].deflate_buf);
    return ret;
 }
 
@@ -370,14 +670,28 @@ bool rpng_save_image_argb(const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
    return rpng_save_image(path, (const uint8_t*)data,
-         width, height, pitch, sizeof(uint32_t));
+         width, height, pitch, sizeof(uint32_t), RPNG_COMPRESSION_BEST);
 }
 
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
    return rpng_save_image(path, (const uint8_t*)data,
-         width, height, pitch, 3);
+         width, height, pitch, 3, RPNG_COMPRESSION_BEST);
+}
+
+bool rpng_save_image_argb_level(const char *path, const uint32_t *data,
+      unsigned width, unsigned height, unsigned pitch, int level)
+{
+   return rpng_save_image(path, (const uint8_t*)data,
+         width, height, pitch, sizeof(uint32_t), level);
+}
+
+bool rpng_save_image_bgr24_level(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, int level)
+{
+   return rpng_save_image(path, (const uint8_t*)data,
+         width, height, pitch, 3, level);
 }
 
 #endif
@@ -28,13 +28,648 @@
 #include <retro_inline.h>
 
 #include <gfx/scaler/pixconv.h>
+#include <gfx/scaler/scaler_simd.h>
 
-#ifdef SCALER_NO_SIMD
-#undef __SSE2__
+#if defined(SCALER_HAVE_SSE2)
+#include <emmintrin.h>
 #endif
 
-#if defined(__SSE2__)
-#include <emmintrin.h>
+/* Row kernels. Each one converts as much of a row as it can in
+ * whole vectors and returns the amount of pixels done; the caller
+ * finishes the row with its SSE2 and C loops. */
+
+#if defined(SCALER_HAVE_AVX2)
+static INLINE SCALER_AVX2_TARGET void unpack_0rgb1555_avx2(__m256i in,
+      __m256i *r, __m256i *g, __m256i *b)
+{
+   const __m256i pix_mask_r  = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_gb = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul15_mid   = _mm256_set1_epi16(0x4200);
+   const __m256i mul15_hi    = _mm256_set1_epi16(0x0210);
+
+   *r = _mm256_mulhi_epi16(_mm256_and_si256(in, pix_mask_r), mul15_hi);
+   *g = _mm256_mulhi_epi16(_mm256_and_si256(in, pix_mask_gb), mul15_mid);
+   *b = _mm256_mulhi_epi16(_mm256_and_si256(
+            _mm256_slli_epi16(in, 5), pix_mask_gb), mul15_mid);
+}
+
+static INLINE SCALER_AVX2_TARGET void unpack_rgb565_avx2(__m256i in,
+      __m256i *r, __m256i *g, __m256i *b)
+{
+   const __m256i pix_mask_r = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_g = _mm256_set1_epi16(0x3f <<  5);
+   const __m256i pix_mask_b = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul16_r    = _mm256_set1_epi16(0x0210);
+   const __m256i mul16_g    = _mm256_set1_epi16(0x2080);
+   const __m256i mul16_b    = _mm256_set1_epi16(0x4200);
+
+   *r = _mm256_mulhi_epi16(_mm256_and_si256(
+            _mm256_srli_epi16(in, 1), pix_mask_r), mul16_r);
+   *g = _mm256_mulhi_epi16(_mm256_and_si256(in, pix_mask_g), mul16_g);
+   *b = _mm256_mulhi_epi16(_mm256_and_si256(
+            _mm256_slli_epi16(in, 5), pix_mask_b), mul16_b);
+}
+
+/* 16-bit R, G and B channels in, 16 ARGB8888 pixels out in order. */
+static INLINE SCALER_AVX2_TARGET void pack_argb8888_avx2(
+      __m256i r, __m256i g, __m256i b, __m256i *lo, __m256i *hi)
+{
+   const __m256i a = _mm256_set1_epi16(0x00ff);
+   /* unpack works per 128-bit lane: these are pixels 0-3 | 8-11
+    * and 4-7 | 12-15. */
+   __m256i res_lo  = _mm256_or_si256(_mm256_unpacklo_epi8(b, g),
+         _mm256_slli_si256(_mm256_unpacklo_epi8(r, a), 2));
+   __m256i res_hi  = _mm256_or_si256(_mm256_unpackhi_epi8(b, g),
+         _mm256_slli_si256(_mm256_unpackhi_epi8(r, a), 2));
+
+   *lo = _mm256_permute2x128_si256(res_lo, res_hi, 0x20);
+   *hi = _mm256_permute2x128_si256(res_lo, res_hi, 0x31);
+}
+
+/* Two rows of 8 32-bit pixels in, 16 16-bit pixels out in order. */
+static INLINE SCALER_AVX2_TARGET __m256i pack_32_to_16_avx2(
+      __m256i lo, __m256i hi)
+{
+   return _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi),
+         _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static INLINE SCALER_AVX2_TARGET void store_bgr24_avx2(uint8_t *out,
+      __m256i px)
+{
+   const __m256i pack = _mm256_setr_epi8(
+         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+   const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+   px = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(px, pack), join);
+
+   _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(px));
+   _mm_storel_epi64((__m128i*)(out + 16), _mm256_extracti128_si256(px, 1));
+}
+
+static SCALER_AVX2_TARGET int conv_rgb565_0rgb1555_avx2(uint16_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const __m256i hi_mask = _mm256_set1_epi16(0x7fe0);
+   const __m256i lo_mask = _mm256_set1_epi16(0x1f);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i hi = _mm256_and_si256(_mm256_srli_epi16(in, 1), hi_mask);
+      __m256i lo = _mm256_and_si256(in, lo_mask);
+      _mm256_storeu_si256((__m256i*)(output + w), _mm256_or_si256(hi, lo));
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_0rgb1555_rgb565_avx2(uint16_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const __m256i hi_mask   = _mm256_set1_epi16(
+         (int16_t)((0x1f << 11) | (0x1f << 6)));
+   const __m256i lo_mask   = _mm256_set1_epi16(0x1f);
+   const __m256i glow_mask = _mm256_set1_epi16(1 << 5);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i rg   = _mm256_and_si256(_mm256_slli_epi16(in, 1), hi_mask);
+      __m256i b    = _mm256_and_si256(in, lo_mask);
+      __m256i glow = _mm256_and_si256(_mm256_srli_epi16(in, 4), glow_mask);
+      _mm256_storeu_si256((__m256i*)(output + w),
+            _mm256_or_si256(rg, _mm256_or_si256(b, glow)));
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_0rgb1555_argb8888_avx2(uint32_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      __m256i r, g, b, lo, hi;
+      unpack_0rgb1555_avx2(
+            _mm256_loadu_si256((const __m256i*)(input + w)), &r, &g, &b);
+      pack_argb8888_avx2(r, g, b, &lo, &hi);
+      _mm256_storeu_si256((__m256i*)(output + w + 0), lo);
+      _mm256_storeu_si256((__m256i*)(output + w + 8), hi);
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_rgb565_argb8888_avx2(uint32_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      __m256i r, g, b, lo, hi;
+      unpack_rgb565_avx2(
+            _mm256_loadu_si256((const __m256i*)(input + w)), &r, &g, &b);
+      pack_argb8888_avx2(r, g, b, &lo, &hi);
+      _mm256_storeu_si256((__m256i*)(output + w + 0), lo);
+      _mm256_storeu_si256((__m256i*)(output + w + 8), hi);
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_argb8888_rgba4444_avx2(uint16_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+   const __m256i mask_r = _mm256_set1_epi32(0xf000);
+   const __m256i mask_g = _mm256_set1_epi32(0x0f00);
+   const __m256i mask_b = _mm256_set1_epi32(0x00f0);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      __m256i res[2];
+      unsigned i;
+
+      for (i = 0; i < 2; i++)
+      {
+         const __m256i in = _mm256_loadu_si256(
+               (const __m256i*)(input + w + i * 8));
+         __m256i r = _mm256_and_si256(_mm256_srli_epi32(in, 8), mask_r);
+         __m256i g = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_g);
+         __m256i b = _mm256_and_si256(in, mask_b);
+         __m256i a = _mm256_srli_epi32(in, 28);
+
+         res[i] = _mm256_or_si256(_mm256_or_si256(r, g),
+               _mm256_or_si256(b, a));
+      }
+
+      _mm256_storeu_si256((__m256i*)(output + w),
+            pack_32_to_16_avx2(res[0], res[1]));
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_rgba4444_argb8888_avx2(uint32_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const __m256i mask_nibble = _mm256_set1_epi16(0x0f0f);
+   const __m256i mask_lo     = _mm256_set1_epi16(0x00ff);
+   const __m256i mask_hi     = _mm256_set1_epi16((int16_t)0xff00);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      __m256i res_lo, res_hi;
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      /* Widen every nibble to a byte: [B, R] and [A, G]. */
+      __m256i br = _mm256_and_si256(_mm256_srli_epi16(in, 4), mask_nibble);
+      __m256i ag = _mm256_and_si256(in, mask_nibble);
+      br = _mm256_or_si256(br, _mm256_slli_epi16(br, 4));
+      ag = _mm256_or_si256(ag, _mm256_slli_epi16(ag, 4));
+
+      {
+         __m256i bg = _mm256_or_si256(_mm256_and_si256(br, mask_lo),
+               _mm256_and_si256(ag, mask_hi));
+         __m256i ra = _mm256_or_si256(_mm256_srli_epi16(br, 8),
+               _mm256_slli_epi16(ag, 8));
+
+         res_lo = _mm256_unpacklo_epi16(bg, ra);
+         res_hi = _mm256_unpackhi_epi16(bg, ra);
+      }
+
+      _mm256_storeu_si256((__m256i*)(output + w + 0),
+            _mm256_permute2x128_si256(res_lo, res_hi, 0x20));
+      _mm256_storeu_si256((__m256i*)(output + w + 8),
+            _mm256_permute2x128_si256(res_lo, res_hi, 0x31));
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_rgba4444_rgb565_avx2(uint16_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const __m256i mask_r = _mm256_set1_epi16((int16_t)0xf000);
+   const __m256i mask_g = _mm256_set1_epi16(0x0f00);
+   const __m256i mask_b = _mm256_set1_epi16(0x00f0);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i r = _mm256_and_si256(in, mask_r);
+      __m256i g = _mm256_srli_epi16(_mm256_and_si256(in, mask_g), 1);
+      __m256i b = _mm256_srli_epi16(_mm256_and_si256(in, mask_b), 3);
+      _mm256_storeu_si256((__m256i*)(output + w),
+            _mm256_or_si256(r, _mm256_or_si256(g, b)));
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_0rgb1555_bgr24_avx2(uint8_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 16 <= width; w += 16, output += 48)
+   {
+      __m256i r, g, b, lo, hi;
+      unpack_0rgb1555_avx2(
+            _mm256_loadu_si256((const __m256i*)(input + w)), &r, &g, &b);
+      pack_argb8888_avx2(r, g, b, &lo, &hi);
+      store_bgr24_avx2(output +  0, lo);
+      store_bgr24_avx2(output + 24, hi);
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_rgb565_bgr24_avx2(uint8_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 16 <= width; w += 16, output += 48)
+   {
+      __m256i r, g, b, lo, hi;
+      unpack_rgb565_avx2(
+            _mm256_loadu_si256((const __m256i*)(input + w)), &r, &g, &b);
+      pack_argb8888_avx2(r, g, b, &lo, &hi);
+      store_bgr24_avx2(output +  0, lo);
+      store_bgr24_avx2(output + 24, hi);
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_bgr24_argb8888_avx2(uint32_t *output,
+      const uint8_t *input, int width)
+{
+   int w;
+   /* The upper lane is loaded from byte 8 so that the last load
+    * ends exactly at the last pixel. */
+   const __m256i expand = _mm256_setr_epi8(
+         0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+         4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1);
+   const __m256i a = _mm256_set1_epi32((int)0xff000000u);
+
+   for (w = 0; w + 8 <= width; w += 8, input += 24)
+   {
+      __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(
+               _mm_loadu_si128((const __m128i*)(input + 0))),
+            _mm_loadu_si128((const __m128i*)(input + 8)), 1);
+      _mm256_storeu_si256((__m256i*)(output + w),
+            _mm256_or_si256(_mm256_shuffle_epi8(in, expand), a));
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_argb8888_0rgb1555_avx2(uint16_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+   const __m256i mask_r = _mm256_set1_epi32(0x1f << 10);
+   const __m256i mask_g = _mm256_set1_epi32(0x1f <<  5);
+   const __m256i mask_b = _mm256_set1_epi32(0x1f <<  0);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      __m256i res[2];
+      unsigned i;
+
+      for (i = 0; i < 2; i++)
+      {
+         const __m256i in = _mm256_loadu_si256(
+               (const __m256i*)(input + w + i * 8));
+         __m256i r = _mm256_and_si256(_mm256_srli_epi32(in, 9), mask_r);
+         __m256i g = _mm256_and_si256(_mm256_srli_epi32(in, 6), mask_g);
+         __m256i b = _mm256_and_si256(_mm256_srli_epi32(in, 3), mask_b);
+
+         res[i] = _mm256_or_si256(r, _mm256_or_si256(g, b));
+      }
+
+      _mm256_storeu_si256((__m256i*)(output + w),
+            pack_32_to_16_avx2(res[0], res[1]));
+   }
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_argb8888_bgr24_avx2(uint8_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8, output += 24)
+      store_bgr24_avx2(output,
+            _mm256_loadu_si256((const __m256i*)(input + w)));
+
+   return w;
+}
+
+static SCALER_AVX2_TARGET int conv_argb8888_abgr8888_avx2(uint32_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+   const __m256i swap = _mm256_setr_epi8(
+         2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+         2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+   for (w = 0; w + 8 <= width; w += 8)
+      _mm256_storeu_si256((__m256i*)(output + w), _mm256_shuffle_epi8(
+               _mm256_loadu_si256((const __m256i*)(input + w)), swap));
+
+   return w;
+}
+#endif
+
+#if defined(SCALER_HAVE_NEON)
+static INLINE uint8x8_t expand5_neon(uint8x8_t c)
+{
+   return vorr_u8(vshl_n_u8(c, 3), vshr_n_u8(c, 2));
+}
+
+static INLINE uint8x8_t expand6_neon(uint8x8_t c)
+{
+   return vorr_u8(vshl_n_u8(c, 2), vshr_n_u8(c, 4));
+}
+
+static INLINE uint8x8x4_t unpack_0rgb1555_neon(uint16x8_t in)
+{
+   uint8x8x4_t px;
+   const uint8x8_t mask = vdup_n_u8(0x1f);
+
+   px.val[0] = expand5_neon(vand_u8(vmovn_u16(in), mask));
+   px.val[1] = expand5_neon(vand_u8(vshrn_n_u16(in, 5), mask));
+   px.val[2] = expand5_neon(vand_u8(vshrn_n_u16(in, 10), mask));
+   px.val[3] = vdup_n_u8(0xff);
+   return px;
+}
+
+static INLINE uint8x8x4_t unpack_rgb565_neon(uint16x8_t in)
+{
+   uint8x8x4_t px;
+
+   px.val[0] = expand5_neon(vand_u8(vmovn_u16(in), vdup_n_u8(0x1f)));
+   px.val[1] = expand6_neon(vand_u8(vshrn_n_u16(in, 5), vdup_n_u8(0x3f)));
+   px.val[2] = expand5_neon(vshrn_n_u16(in, 11));
+   px.val[3] = vdup_n_u8(0xff);
+   return px;
+}
+
+static int conv_rgb565_0rgb1555_neon(uint16_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const uint16x8_t hi_mask = vdupq_n_u16(0x7fe0);
+   const uint16x8_t lo_mask = vdupq_n_u16(0x1f);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint16x8_t in = vld1q_u16(input + w);
+      vst1q_u16(output + w, vorrq_u16(
+               vandq_u16(vshrq_n_u16(in, 1), hi_mask),
+               vandq_u16(in, lo_mask)));
+   }
+
+   return w;
+}
+
+static int conv_0rgb1555_rgb565_neon(uint16_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const uint16x8_t hi_mask   = vdupq_n_u16((0x1f << 11) | (0x1f << 6));
+   const uint16x8_t lo_mask   = vdupq_n_u16(0x1f);
+   const uint16x8_t glow_mask = vdupq_n_u16(1 << 5);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint16x8_t in   = vld1q_u16(input + w);
+      uint16x8_t rg   = vandq_u16(vshlq_n_u16(in, 1), hi_mask);
+      uint16x8_t b    = vandq_u16(in, lo_mask);
+      uint16x8_t glow = vandq_u16(vshrq_n_u16(in, 4), glow_mask);
+      vst1q_u16(output + w, vorrq_u16(rg, vorrq_u16(b, glow)));
+   }
+
+   return w;
+}
+
+static int conv_0rgb1555_argb8888_neon(uint32_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8)
+      vst4_u8((uint8_t*)(output + w),
+            unpack_0rgb1555_neon(vld1q_u16(input + w)));
+
+   return w;
+}
+
+static int conv_rgb565_argb8888_neon(uint32_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8)
+      vst4_u8((uint8_t*)(output + w),
+            unpack_rgb565_neon(vld1q_u16(input + w)));
+
+   return w;
+}
+
+static int conv_argb8888_rgba4444_neon(uint16_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+   const uint8x8_t mask_hi = vdup_n_u8(0xf0);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x2_t res;
+      uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+
+      /* Low byte is B << 4 | A, high byte R << 4 | G. */
+      res.val[0] = vorr_u8(vand_u8(in.val[0], mask_hi),
+            vshr_n_u8(in.val[3], 4));
+      res.val[1] = vorr_u8(vand_u8(in.val[2], mask_hi),
+            vshr_n_u8(in.val[1], 4));
+      vst2_u8((uint8_t*)(output + w), res);
+   }
+
+   return w;
+}
+
+static int conv_rgba4444_argb8888_neon(uint32_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const uint8x8_t mask_hi = vdup_n_u8(0xf0);
+   const uint8x8_t mask_lo = vdup_n_u8(0x0f);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t res;
+      uint8x8x2_t in = vld2_u8((const uint8_t*)(input + w));
+
+      res.val[0] = vorr_u8(vand_u8(in.val[0], mask_hi),
+            vshr_n_u8(in.val[0], 4));
+      res.val[1] = vorr_u8(vand_u8(in.val[1], mask_lo),
+            vshl_n_u8(in.val[1], 4));
+      res.val[2] = vorr_u8(vand_u8(in.val[1], mask_hi),
+            vshr_n_u8(in.val[1], 4));
+      res.val[3] = vorr_u8(vand_u8(in.val[0], mask_lo),
+            vshl_n_u8(in.val[0], 4));
+      vst4_u8((uint8_t*)(output + w), res);
+   }
+
+   return w;
+}
+
+static int conv_rgba4444_rgb565_neon(uint16_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const uint16x8_t mask_r = vdupq_n_u16(0xf000);
+   const uint16x8_t mask_g = vdupq_n_u16(0x0f00);
+   const uint16x8_t mask_b = vdupq_n_u16(0x00f0);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint16x8_t in = vld1q_u16(input + w);
+      uint16x8_t r  = vandq_u16(in, mask_r);
+      uint16x8_t g  = vshrq_n_u16(vandq_u16(in, mask_g), 1);
+      uint16x8_t b  = vshrq_n_u16(vandq_u16(in, mask_b), 3);
+      vst1q_u16(output + w, vorrq_u16(r, vorrq_u16(g, b)));
+   }
+
+   return w;
+}
+
+static int conv_0rgb1555_bgr24_neon(uint8_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8, output += 24)
+   {
+      uint8x8x3_t res;
+      uint8x8x4_t px = unpack_0rgb1555_neon(vld1q_u16(input + w));
+
+      res.val[0] = px.val[0];
+      res.val[1] = px.val[1];
+      res.val[2] = px.val[2];
+      vst3_u8(output, res);
+   }
+
+   return w;
+}
+
+static int conv_rgb565_bgr24_neon(uint8_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8, output += 24)
+   {
+      uint8x8x3_t res;
+      uint8x8x4_t px = unpack_rgb565_neon(vld1q_u16(input + w));
+
+      res.val[0] = px.val[0];
+      res.val[1] = px.val[1];
+      res.val[2] = px.val[2];
+      vst3_u8(output, res);
+   }
+
+   return w;
+}
+
+static int conv_bgr24_argb8888_neon(uint32_t *output,
+      const uint8_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8, input += 24)
+   {
+      uint8x8x4_t res;
+      uint8x8x3_t in = vld3_u8(input);
+
+      res.val[0] = in.val[0];
+      res.val[1] = in.val[1];
+      res.val[2] = in.val[2];
+      res.val[3] = vdup_n_u8(0xff);
+      vst4_u8((uint8_t*)(output + w), res);
+   }
+
+   return w;
+}
+
+static int conv_argb8888_0rgb1555_neon(uint16_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+      uint16x8_t r   = vandq_u16(vshll_n_u8(in.val[2], 7),
+            vdupq_n_u16(0x1f << 10));
+      uint16x8_t g   = vandq_u16(vshll_n_u8(in.val[1], 2),
+            vdupq_n_u16(0x1f <<  5));
+      uint16x8_t b   = vmovl_u8(vshr_n_u8(in.val[0], 3));
+      vst1q_u16(output + w, vorrq_u16(r, vorrq_u16(g, b)));
+   }
+
+   return w;
+}
+
+static int conv_argb8888_bgr24_neon(uint8_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8, output += 24)
+   {
+      uint8x8x3_t res;
+      uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+
+      res.val[0] = in.val[0];
+      res.val[1] = in.val[1];
+      res.val[2] = in.val[2];
+      vst3_u8(output, res);
+   }
+
+   return w;
+}
+
+static int conv_argb8888_abgr8888_neon(uint32_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+      uint8x8_t    b = in.val[0];
+
+      in.val[0] = in.val[2];
+      in.val[2] = b;
+      vst4_u8((uint8_t*)(output + w), in);
+   }
+
+   return w;
+}
 #endif
 
 void conv_rgb565_0rgb1555(void *output_, const void *input_,
@@ -45,7 +680,11 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output = (uint16_t*)output_;
 
-#if defined(__SSE2_)
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
+#if defined(SCALER_HAVE_SSE2)
    int max_width = width - 7;
 
    const __m128i hi_mask   = _mm_set1_epi16(0x7fe0);
@@ -56,11 +695,17 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
       int w = 0;
-#if defined(__SSE2_)
+#if defined(SCALER_HAVE_NEON)
+      w = conv_rgb565_0rgb1555_neon(output, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_rgb565_0rgb1555_avx2(output, input, width);
+#endif
+#if defined(SCALER_HAVE_SSE2)
       for (; w < max_width; w += 8)
       {
          const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i hi = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
+         __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 1), hi_mask);
          __m128i lo = _mm_and_si128(in, lo_mask);
          _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(hi, lo));
       }
@@ -84,7 +729,11 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
    const uint16_t *input   = (const uint16_t*)input_;
    uint16_t *output        = (uint16_t*)output_;
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
+#if defined(SCALER_HAVE_SSE2)
    int max_width           = width - 7;
 
    const __m128i hi_mask   = _mm_set1_epi16(
@@ -97,7 +746,13 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
       int w = 0;
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_NEON)
+      w = conv_0rgb1555_rgb565_neon(output, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_0rgb1555_rgb565_avx2(output, input, width);
+#endif
+#if defined(SCALER_HAVE_SSE2)
       for (; w < max_width; w += 8)
       {
          const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
@@ -128,7 +783,11 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
-#ifdef __SSE2__
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
+#ifdef SCALER_HAVE_SSE2
    const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
    const __m128i pix_mask_gb = _mm_set1_epi16(0x1f <<  5);
    const __m128i mul15_mid   = _mm_set1_epi16(0x4200);
@@ -142,7 +801,13 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
       int w = 0;
-#ifdef __SSE2__
+#if defined(SCALER_HAVE_NEON)
+      w = conv_0rgb1555_argb8888_neon(output, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_0rgb1555_argb8888_avx2(output, input, width);
+#endif
+#ifdef SCALER_HAVE_SSE2
       for (; w < max_width; w += 8)
       {
          __m128i res_lo_bg, res_hi_bg;
@@ -195,7 +860,11 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
    const uint16_t *input    = (const uint16_t*)input_;
    uint32_t *output         = (uint32_t*)output_;
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
+#if defined(SCALER_HAVE_SSE2)
    const __m128i pix_mask_r = _mm_set1_epi16(0x1f << 10);
    const __m128i pix_mask_g = _mm_set1_epi16(0x3f <<  5);
    const __m128i pix_mask_b = _mm_set1_epi16(0x1f <<  5);
@@ -211,7 +880,13 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
       int w = 0;
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_NEON)
+      w = conv_rgb565_argb8888_neon(output, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_rgb565_argb8888_avx2(output, input, width);
+#endif
+#if defined(SCALER_HAVE_SSE2)
       for (; w < max_width; w += 8)
       {
          __m128i res_lo, res_hi;
@@ -259,24 +934,32 @@ void conv_argb8888_rgba4444(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint32_t *input = (const uint32_t*)input_;
    uint16_t *output      = (uint16_t*)output_;
 
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
    for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
+         h++, output += out_stride >> 1, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(SCALER_HAVE_NEON)
+      w = conv_argb8888_rgba4444_neon(output, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_argb8888_rgba4444_avx2(output, input, width);
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
-         uint32_t r = (col >> 16) & 0xf;
-         uint32_t g = (col >>  8) & 0xf;
-         uint32_t b = (col) & 0xf;
-         uint32_t a = (col >>  24) & 0xf;
-         r = (r >> 4) | r;
-         g = (g >> 4) | g;
-         b = (b >> 4) | b;
-         a = (a >> 4) | a;
+         uint32_t r = (col >> 20) & 0xf;
+         uint32_t g = (col >> 12) & 0xf;
+         uint32_t b = (col >>  4) & 0xf;
+         uint32_t a = (col >> 28) & 0xf;
 
          output[w] = (r << 12) | (g << 8) | (b << 4) | a;
       }
@@ -287,14 +970,26 @@ void conv_rgba4444_argb8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint16_t *input = (const uint16_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(SCALER_HAVE_NEON)
+      w = conv_rgba4444_argb8888_neon(output, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_rgba4444_argb8888_avx2(output, input, width);
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          uint32_t r = (col >> 12) & 0xf;
@@ -315,14 +1010,26 @@ void conv_rgba4444_rgb565(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output      = (uint16_t*)output_;
 
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(SCALER_HAVE_NEON)
+      w = conv_rgba4444_rgb565_neon(output, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_rgba4444_rgb565_avx2(output, input, width);
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          uint32_t r   = (col >> 12) & 0xf;
@@ -334,7 +1041,7 @@ void conv_rgba4444_rgb565(void *output_, const void *input_,
    }
 }
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_SSE2)
 /* :( TODO: Make this saner. */
 static INLINE void store_bgr24_sse2(void *output, __m128i a,
       __m128i b, __m128i c, __m128i d)
@@ -389,7 +1096,11 @@ void conv_0rgb1555_bgr24(void *output_, const void *input_,
    const uint16_t *input     = (const uint16_t*)input_;
    uint8_t *output           = (uint8_t*)output_;
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
+#if defined(SCALER_HAVE_SSE2)
    const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
    const __m128i pix_mask_gb = _mm_set1_epi16(0x1f <<  5);
    const __m128i mul15_mid   = _mm_set1_epi16(0x4200);
@@ -404,8 +1115,15 @@ void conv_0rgb1555_bgr24(void *output_, const void *input_,
    {
       uint8_t *out = output;
       int   w = 0;
+#if defined(SCALER_HAVE_NEON)
+      w = conv_0rgb1555_bgr24_neon(out, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_0rgb1555_bgr24_avx2(out, input, width);
+#endif
+      out += w * 3;
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_SSE2)
       for (; w < max_width; w += 16, out += 48)
       {
          __m128i res_lo_bg0, res_lo_bg1, res_hi_bg0, res_hi_bg1,
@@ -475,7 +1193,11 @@ void conv_rgb565_bgr24(void *output_, const void *input_,
    const uint16_t *input    = (const uint16_t*)input_;
    uint8_t *output          = (uint8_t*)output_;
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
+#if defined(SCALER_HAVE_SSE2)
    const __m128i pix_mask_r = _mm_set1_epi16(0x1f << 10);
    const __m128i pix_mask_g = _mm_set1_epi16(0x3f <<  5);
    const __m128i pix_mask_b = _mm_set1_epi16(0x1f <<  5);
@@ -491,7 +1213,14 @@ void conv_rgb565_bgr24(void *output_, const void *input_,
    {
       uint8_t *out = output;
       int        w = 0;
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_NEON)
+      w = conv_rgb565_bgr24_neon(out, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_rgb565_bgr24_avx2(out, input, width);
+#endif
+      out += w * 3;
+#if defined(SCALER_HAVE_SSE2)
       for (; w < max_width; w += 16, out += 48)
       {
          __m128i res_lo_bg0, res_hi_bg0, res_lo_ra0, res_hi_ra0;
@@ -556,15 +1285,27 @@ void conv_bgr24_argb8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint8_t *input = (const uint8_t*)input_;
    uint32_t *output     = (uint32_t*)output_;
 
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride)
    {
       const uint8_t *inp = input;
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(SCALER_HAVE_NEON)
+      w = conv_bgr24_argb8888_neon(output, inp, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_bgr24_argb8888_avx2(output, inp, width);
+#endif
+
+      for (inp += w * 3; w < width; w++)
       {
          uint32_t b = *inp++;
          uint32_t g = *inp++;
@@ -578,14 +1319,26 @@ void conv_argb8888_0rgb1555(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint32_t *input = (const uint32_t*)input_;
    uint16_t *output      = (uint16_t*)output_;
 
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(SCALER_HAVE_NEON)
+      w = conv_argb8888_0rgb1555_neon(output, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_argb8888_0rgb1555_avx2(output, input, width);
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          uint16_t r = (col >> 19) & 0x1f;
@@ -604,7 +1357,11 @@ void conv_argb8888_bgr24(void *output_, const void *input_,
    const uint32_t *input = (const uint32_t*)input_;
    uint8_t *output       = (uint8_t*)output_;
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
+#if defined(SCALER_HAVE_SSE2)
    int max_width = width - 15;
 #endif
 
@@ -613,7 +1370,14 @@ void conv_argb8888_bgr24(void *output_, const void *input_,
    {
       uint8_t *out = output;
       int        w = 0;
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_NEON)
+      w = conv_argb8888_bgr24_neon(out, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_argb8888_bgr24_avx2(out, input, width);
+#endif
+      out += w * 3;
+#if defined(SCALER_HAVE_SSE2)
       for (; w < max_width; w += 16, out += 48)
       {
          store_bgr24_sse2(out,
@@ -638,14 +1402,26 @@ void conv_argb8888_abgr8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint32_t *input = (const uint32_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2 = scaler_simd_has_avx2();
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(SCALER_HAVE_NEON)
+      w = conv_argb8888_abgr8888_neon(output, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_argb8888_abgr8888_avx2(output, input, width);
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          output[w] = ((col << 16) & 0xff0000) | 
@@ -662,6 +1438,146 @@ void conv_argb8888_abgr8888(void *output_, const void *input_,
 #define YUV_MAT_V_R (90)
 #define YUV_MAT_V_G (-46)
 
+#if defined(SCALER_HAVE_AVX2)
+/* Same steps as the SSE2 loop below, on 32 pixels at a time.
+ * Everything stays inside 128-bit lanes until the final stores. */
+static SCALER_AVX2_TARGET int conv_yuyv_argb8888_avx2(uint32_t *output,
+      const uint8_t *input, int width)
+{
+   int w;
+   const __m256i mask_y        = _mm256_set1_epi16(0xff);
+   const __m256i mask_u        = _mm256_set1_epi32(0xff << 8);
+   const __m256i mask_v        = _mm256_set1_epi32((int)(0xffu << 24));
+   const __m256i chroma_offset = _mm256_set1_epi16(128);
+   const __m256i round_offset  = _mm256_set1_epi16(YUV_OFFSET);
+
+   const __m256i yuv_mul       = _mm256_set1_epi16(YUV_MAT_Y);
+   const __m256i u_g_mul       = _mm256_set1_epi16(YUV_MAT_U_G);
+   const __m256i u_b_mul       = _mm256_set1_epi16(YUV_MAT_U_B);
+   const __m256i v_r_mul       = _mm256_set1_epi16(YUV_MAT_V_R);
+   const __m256i v_g_mul       = _mm256_set1_epi16(YUV_MAT_V_G);
+   const __m256i a             = _mm256_set1_epi16(-1);
+
+   for (w = 0; w + 32 <= width; w += 32, input += 64)
+   {
+      __m256i u, v, u0, u1, v0, v1, r0, g0, b0, r1, g1, b1;
+      __m256i res_lo_bg, res_hi_bg, res_lo_ra, res_hi_ra;
+      __m256i res0, res1, res2, res3;
+      __m256i yuv0 = _mm256_loadu_si256((const __m256i*)(input +  0));
+      __m256i yuv1 = _mm256_loadu_si256((const __m256i*)(input + 32));
+
+      __m256i _y0  = _mm256_and_si256(yuv0, mask_y);
+      __m256i _y1  = _mm256_and_si256(yuv1, mask_y);
+
+      u0 = _mm256_srli_si256(_mm256_and_si256(yuv0, mask_u), 1);
+      v0 = _mm256_srli_si256(_mm256_and_si256(yuv0, mask_v), 3);
+      u1 = _mm256_srli_si256(_mm256_and_si256(yuv1, mask_u), 1);
+      v1 = _mm256_srli_si256(_mm256_and_si256(yuv1, mask_v), 3);
+      u  = _mm256_sub_epi16(_mm256_packs_epi32(u0, u1), chroma_offset);
+      v  = _mm256_sub_epi16(_mm256_packs_epi32(v0, v1), chroma_offset);
+
+      /* The packs above interleaved the lanes of both loads, and these
+       * unpacks undo it again: u0/v0 line up with _y0, u1/v1 with _y1. */
+      u0 = _mm256_unpacklo_epi16(u, u);
+      u1 = _mm256_unpackhi_epi16(u, u);
+      v0 = _mm256_unpacklo_epi16(v, v);
+      v1 = _mm256_unpackhi_epi16(v, v);
+
+      _y0 = _mm256_mullo_epi16(_y0, yuv_mul);
+      _y1 = _mm256_mullo_epi16(_y1, yuv_mul);
+
+      r0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y0,
+                  _mm256_mullo_epi16(v0, v_r_mul)), round_offset), YUV_SHIFT);
+      g0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                  _mm256_adds_epi16(_y0, _mm256_mullo_epi16(v0, v_g_mul)),
+                  _mm256_mullo_epi16(u0, u_g_mul)), round_offset), YUV_SHIFT);
+      b0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y0,
+                  _mm256_mullo_epi16(u0, u_b_mul)), round_offset), YUV_SHIFT);
+
+      r1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y1,
+                  _mm256_mullo_epi16(v1, v_r_mul)), round_offset), YUV_SHIFT);
+      g1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                  _mm256_adds_epi16(_y1, _mm256_mullo_epi16(v1, v_g_mul)),
+                  _mm256_mullo_epi16(u1, u_g_mul)), round_offset), YUV_SHIFT);
+      b1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y1,
+                  _mm256_mullo_epi16(u1, u_b_mul)), round_offset), YUV_SHIFT);
+
+      r0 = _mm256_packus_epi16(r0, r1);
+      g0 = _mm256_packus_epi16(g0, g1);
+      b0 = _mm256_packus_epi16(b0, b1);
+
+      res_lo_bg = _mm256_unpacklo_epi8(b0, g0);
+      res_hi_bg = _mm256_unpackhi_epi8(b0, g0);
+      res_lo_ra = _mm256_unpacklo_epi8(r0, a);
+      res_hi_ra = _mm256_unpackhi_epi8(r0, a);
+
+      /* Pixels 0-3 | 8-11, 4-7 | 12-15, 16-19 | 24-27, 20-23 | 28-31. */
+      res0 = _mm256_unpacklo_epi16(res_lo_bg, res_lo_ra);
+      res1 = _mm256_unpackhi_epi16(res_lo_bg, res_lo_ra);
+      res2 = _mm256_unpacklo_epi16(res_hi_bg, res_hi_ra);
+      res3 = _mm256_unpackhi_epi16(res_hi_bg, res_hi_ra);
+
+      _mm256_storeu_si256((__m256i*)(output + w +  0),
+            _mm256_permute2x128_si256(res0, res1, 0x20));
+      _mm256_storeu_si256((__m256i*)(output + w +  8),
+            _mm256_permute2x128_si256(res0, res1, 0x31));
+      _mm256_storeu_si256((__m256i*)(output + w + 16),
+            _mm256_permute2x128_si256(res2, res3, 0x20));
+      _mm256_storeu_si256((__m256i*)(output + w + 24),
+            _mm256_permute2x128_si256(res2, res3, 0x31));
+   }
+
+   return w;
+}
+#endif
+
+#if defined(SCALER_HAVE_NEON)
+static INLINE uint8x8_t yuv_channel_neon(int16x8_t y, int16x8_t c)
+{
+   return vqmovun_s16(vrshrq_n_s16(vaddq_s16(y, c), YUV_SHIFT));
+}
+
+static int conv_yuyv_argb8888_neon(uint32_t *output,
+      const uint8_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 16 <= width; w += 16, input += 32)
+   {
+      uint8x8x4_t res;
+      uint8x8x2_t r, g, b;
+      /* Even Y, U, odd Y, V. */
+      uint8x8x4_t yuv = vld4_u8(input);
+      int16x8_t _y0   = vreinterpretq_s16_u16(vshll_n_u8(yuv.val[0], 6));
+      int16x8_t _y1   = vreinterpretq_s16_u16(vshll_n_u8(yuv.val[2], 6));
+      int16x8_t u     = vsubq_s16(vreinterpretq_s16_u16(
+               vmovl_u8(yuv.val[1])), vdupq_n_s16(128));
+      int16x8_t v     = vsubq_s16(vreinterpretq_s16_u16(
+               vmovl_u8(yuv.val[3])), vdupq_n_s16(128));
+      int16x8_t r_c   = vmulq_n_s16(v, YUV_MAT_V_R);
+      int16x8_t g_c   = vmlaq_n_s16(vmulq_n_s16(u, YUV_MAT_U_G),
+            v, YUV_MAT_V_G);
+      int16x8_t b_c   = vmulq_n_s16(u, YUV_MAT_U_B);
+
+      r = vzip_u8(yuv_channel_neon(_y0, r_c), yuv_channel_neon(_y1, r_c));
+      g = vzip_u8(yuv_channel_neon(_y0, g_c), yuv_channel_neon(_y1, g_c));
+      b = vzip_u8(yuv_channel_neon(_y0, b_c), yuv_channel_neon(_y1, b_c));
+
+      res.val[3] = vdup_n_u8(0xff);
+      res.val[0] = b.val[0];
+      res.val[1] = g.val[0];
+      res.val[2] = r.val[0];
+      vst4_u8((uint8_t*)(output + w + 0), res);
+      res.val[0] = b.val[1];
+      res.val[1] = g.val[1];
+      res.val[2] = r.val[1];
+      vst4_u8((uint8_t*)(output + w + 8), res);
+   }
+
+   return w;
+}
+#endif
+
 void conv_yuyv_argb8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
@@ -670,7 +1586,11 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
    const uint8_t *input        = (const uint8_t*)input_;
    uint32_t *output            = (uint32_t*)output_;
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_AVX2)
+   const bool avx2             = scaler_simd_has_avx2();
+#endif
+
+#if defined(SCALER_HAVE_SSE2)
    const __m128i mask_y        = _mm_set1_epi16(0xffu);
    const __m128i mask_u        = _mm_set1_epi32(0xffu << 8);
    const __m128i mask_v        = _mm_set1_epi32(0xffu << 24);
@@ -691,8 +1611,16 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
       const uint8_t *src = input;
       uint32_t      *dst = output;
       int              w = 0;
+#if defined(SCALER_HAVE_NEON)
+      w = conv_yuyv_argb8888_neon(output, input, width);
+#elif defined(SCALER_HAVE_AVX2)
+      if (avx2)
+         w = conv_yuyv_argb8888_avx2(output, input, width);
+#endif
+      src += w * 2;
+      dst += w;
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_SSE2)
       /* Each loop processes 16 pixels. */
       for (; w + 16 <= width; w += 16, src += 32, dst += 16)
       {
@@ -273,6 +273,14 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
       ctx->scaler_horiz = scaler_argb8888_horiz;
       ctx->scaler_vert  = scaler_argb8888_vert;
       ctx->unscaled     = false;
+
+#if defined(SCALER_HAVE_AVX2)
+      if (scaler_simd_has_avx2())
+      {
+         ctx->scaler_horiz = scaler_argb8888_horiz_avx2;
+         ctx->scaler_vert  = scaler_argb8888_vert_avx2;
+      }
+#endif
    }
 
    ctx->scaler_special = NULL;
@@ -24,17 +24,21 @@
 
 #include <retro_inline.h>
 
-#ifdef SCALER_NO_SIMD
-#undef __SSE2__
-#endif
-
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_SSE2)
 #include <emmintrin.h>
 #ifdef _WIN32
 #include <intrin.h>
 #endif
 #endif
 
+/* Replicates a filter coefficient into four 16-bit lanes. Going
+ * through uint16_t keeps negative taps from borrowing into the
+ * upper lanes. */
+static INLINE int64_t filter_coeff4(int16_t coeff)
+{
+   return (int64_t)((uint16_t)coeff * 0x0001000100010001ull);
+}
+
 /* ARGB8888 scaler is split in two:
  *
  * First, horizontal scaler is applied.
@@ -53,7 +57,174 @@
  * The C version of scalers perform the exact same operations as the SIMD code for testing purposes.
  */
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_AVX2)
+/* Same arithmetic as the SSE2 versions, on two output pixels
+ * per 256-bit vector. */
+SCALER_AVX2_TARGET void scaler_argb8888_vert_avx2(const struct scaler_ctx *ctx,
+      void *output_, int stride)
+{
+   int h, w, y;
+   const uint64_t *input = ctx->scaled.frame;
+   uint32_t      *output = (uint32_t*)output_;
+
+   const int16_t *filter_vert = ctx->vert.filter;
+
+   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   {
+      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
+
+      /* Four pixels at a time. Even and odd rows are summed apart
+       * and then added, like the two halves of the SSE2 version,
+       * so saturation happens at the same places. */
+      for (w = 0; w + 4 <= ctx->out_width; w += 4)
+      {
+         __m256i res_even = _mm256_setzero_si256();
+         __m256i res_odd  = _mm256_setzero_si256();
+
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += (ctx->scaled.stride >> 2))
+         {
+            __m256i col_even = _mm256_loadu_si256((const __m256i*)input_base_y);
+            __m256i col_odd  = _mm256_loadu_si256((const __m256i*)(input_base_y + (ctx->scaled.stride >> 3)));
+
+            res_even = _mm256_adds_epi16(_mm256_mulhi_epi16(col_even, _mm256_set1_epi16(filter_vert[y + 0])), res_even);
+            res_odd  = _mm256_adds_epi16(_mm256_mulhi_epi16(col_odd,  _mm256_set1_epi16(filter_vert[y + 1])), res_odd);
+         }
+
+         for (; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
+         {
+            __m256i col = _mm256_loadu_si256((const __m256i*)input_base_y);
+
+            res_even = _mm256_adds_epi16(_mm256_mulhi_epi16(col, _mm256_set1_epi16(filter_vert[y])), res_even);
+         }
+
+         res_even = _mm256_adds_epi16(res_odd, res_even);
+         res_even = _mm256_srai_epi16(res_even, (7 - 2 - 2));
+         res_even = _mm256_permute4x64_epi64(_mm256_packus_epi16(res_even, res_even),
+               _MM_SHUFFLE(3, 1, 2, 0));
+
+         _mm_storeu_si128((__m128i*)(output + w), _mm256_castsi256_si128(res_even));
+      }
+
+      for (; w < ctx->out_width; w++)
+      {
+         __m128i res = _mm_setzero_si128();
+
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += (ctx->scaled.stride >> 2))
+         {
+            __m128i coeff = _mm_set_epi64x(filter_coeff4(filter_vert[y + 1]), filter_coeff4(filter_vert[y + 0]));
+            __m128i col   = _mm_set_epi64x(input_base_y[ctx->scaled.stride >> 3], input_base_y[0]);
+
+            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+         }
+
+         for (; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
+         {
+            __m128i coeff = _mm_set_epi64x(0, filter_coeff4(filter_vert[y]));
+            __m128i col   = _mm_set_epi64x(0, input_base_y[0]);
+
+            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+         }
+
+         res       = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
+         res       = _mm_srai_epi16(res, (7 - 2 - 2));
+         output[w] = _mm_cvtsi128_si32(_mm_packus_epi16(res, res));
+      }
+   }
+}
+
+SCALER_AVX2_TARGET void scaler_argb8888_horiz_avx2(const struct scaler_ctx *ctx,
+      const void *input_, int stride)
+{
+   int h, w, x;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint64_t *output      = ctx->scaled.frame;
+
+   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   {
+      const int16_t *filter_horiz = ctx->horiz.filter;
+
+      /* Output pixel w in the lower lane, w + 1 in the upper one. */
+      for (w = 0; w + 2 <= ctx->scaled.width; w += 2, filter_horiz += 2 * ctx->horiz.filter_stride)
+      {
+         __m256i res = _mm256_setzero_si256();
+
+         const int16_t *filter_next    = filter_horiz + ctx->horiz.filter_stride;
+         const uint32_t *input_base_x0 = input + ctx->horiz.filter_pos[w + 0];
+         const uint32_t *input_base_x1 = input + ctx->horiz.filter_pos[w + 1];
+
+         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+         {
+            __m256i coeff = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                     _mm_cvtsi32_si128((uint16_t)filter_horiz[x + 0] | ((uint16_t)filter_horiz[x + 1] << 16))),
+                  _mm_cvtsi32_si128((uint16_t)filter_next[x + 0] | ((uint16_t)filter_next[x + 1] << 16)), 1);
+
+            __m256i col = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                     _mm_loadl_epi64((const __m128i*)(input_base_x0 + x))),
+                  _mm_loadl_epi64((const __m128i*)(input_base_x1 + x)), 1);
+
+            /* [c0, c1] -> [c0, c0, c0, c0, c1, c1, c1, c1] */
+            coeff = _mm256_unpacklo_epi16(coeff, coeff);
+            coeff = _mm256_unpacklo_epi32(coeff, coeff);
+
+            col = _mm256_slli_epi16(_mm256_unpacklo_epi8(col, _mm256_setzero_si256()), 7);
+            res = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         for (; x < ctx->horiz.filter_len; x++)
+         {
+            __m256i coeff = _mm256_set_epi64x(0, filter_coeff4(filter_next[x]),
+                  0, filter_coeff4(filter_horiz[x]));
+
+            __m256i col = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                     _mm_cvtsi32_si128(input_base_x0[x])),
+                  _mm_cvtsi32_si128(input_base_x1[x]), 1);
+
+            col = _mm256_slli_epi16(_mm256_unpacklo_epi8(col, _mm256_setzero_si256()), 7);
+            res = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         res = _mm256_adds_epi16(_mm256_srli_si256(res, 8), res);
+         res = _mm256_permute4x64_epi64(res, _MM_SHUFFLE(3, 1, 2, 0));
+
+         _mm_storeu_si128((__m128i*)(output + w), _mm256_castsi256_si128(res));
+      }
+
+      for (; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
+      {
+         __m128i res = _mm_setzero_si128();
+
+         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+
+         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+         {
+            __m128i coeff = _mm_set_epi64x(filter_coeff4(filter_horiz[x + 1]), filter_coeff4(filter_horiz[x + 0]));
+            __m128i col   = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(input_base_x + x)), _mm_setzero_si128());
+
+            col = _mm_slli_epi16(col, 7);
+            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+         }
+
+         for (; x < ctx->horiz.filter_len; x++)
+         {
+            __m128i coeff = _mm_set_epi64x(0, filter_coeff4(filter_horiz[x]));
+            __m128i col   = _mm_unpacklo_epi8(_mm_cvtsi32_si128(input_base_x[x]), _mm_setzero_si128());
+
+            col = _mm_slli_epi16(col, 7);
+            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+         }
+
+         res = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
+         _mm_storel_epi64((__m128i*)(output + w), res);
+      }
+   }
+}
+#endif
+
+#if defined(SCALER_HAVE_SSE2)
 void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
 {
    int h, w, y;
@@ -75,7 +246,7 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
 
          for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += (ctx->scaled.stride >> 2))
          {
-            __m128i coeff = _mm_set_epi64x(filter_vert[y + 1] * 0x0001000100010001ll, filter_vert[y + 0] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x(filter_coeff4(filter_vert[y + 1]), filter_coeff4(filter_vert[y + 0]));
             __m128i col   = _mm_set_epi64x(input_base_y[ctx->scaled.stride >> 3], input_base_y[0]);
 
             res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
@@ -83,7 +254,7 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
 
          for (; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_vert[y] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x(0, filter_coeff4(filter_vert[y]));
             __m128i col   = _mm_set_epi64x(0, input_base_y[0]);
 
             res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
@@ -98,6 +269,60 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
       }
    }
 }
+#elif defined(SCALER_HAVE_NEON)
+static INLINE int16x8_t scaler_mulhi_neon(int16x8_t a, int16x8_t b)
+{
+   return vcombine_s16(
+         vshrn_n_s32(vmull_s16(vget_low_s16(a), vget_low_s16(b)), 16),
+         vshrn_n_s32(vmull_s16(vget_high_s16(a), vget_high_s16(b)), 16));
+}
+
+void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+{
+   int h, w, y;
+   const uint64_t *input = ctx->scaled.frame;
+   uint32_t      *output = (uint32_t*)output_;
+
+   const int16_t *filter_vert = ctx->vert.filter;
+
+   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   {
+      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
+
+      for (w = 0; w + 2 <= ctx->out_width; w += 2)
+      {
+         int16x8_t res = vdupq_n_s16(0);
+
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
+         {
+            int16x8_t col = vld1q_s16((const int16_t*)input_base_y);
+
+            res = vqaddq_s16(scaler_mulhi_neon(col, vdupq_n_s16(filter_vert[y])), res);
+         }
+
+         vst1_u8((uint8_t*)(output + w), vqmovun_s16(vshrq_n_s16(res, (7 - 2 - 2))));
+      }
+
+      if (w < ctx->out_width)
+      {
+         int16x4_t res = vdup_n_s16(0);
+
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
+         {
+            int16x4_t col = vld1_s16((const int16_t*)input_base_y);
+
+            res = vqadd_s16(vshrn_n_s32(vmull_n_s16(col, filter_vert[y]), 16), res);
+         }
+
+         res       = vshr_n_s16(res, (7 - 2 - 2));
+         output[w] = vget_lane_u32(vreinterpret_u32_u8(vqmovun_s16(vcombine_s16(res, res))), 0);
+      }
+   }
+}
 #else
 void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
 {
@@ -147,7 +372,7 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
 }
 #endif
 
-#if defined(__SSE2__)
+#if defined(SCALER_HAVE_SSE2)
 void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
 {
    int h, w, x;
@@ -166,7 +391,7 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
 
          for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
          {
-            __m128i coeff = _mm_set_epi64x(filter_horiz[x + 1] * 0x0001000100010001ll, filter_horiz[x + 0] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x(filter_coeff4(filter_horiz[x + 1]), filter_coeff4(filter_horiz[x + 0]));
 
             __m128i col = _mm_unpacklo_epi8(_mm_set_epi64x(0,
                      ((uint64_t)input_base_x[x + 1] << 32) | input_base_x[x + 0]), _mm_setzero_si128());
@@ -177,7 +402,7 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
 
          for (; x < ctx->horiz.filter_len; x++)
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_horiz[x] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x(0, filter_coeff4(filter_horiz[x]));
             __m128i col   = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, 0, input_base_x[x]), _mm_setzero_si128());
 
             col = _mm_slli_epi16(col, 7);
@@ -201,6 +426,47 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
       }
    }
 }
+#elif defined(SCALER_HAVE_NEON)
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+{
+   int h, w, x;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint64_t *output      = ctx->scaled.frame;
+
+   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   {
+      const int16_t *filter_horiz = ctx->horiz.filter;
+
+      for (w = 0; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
+      {
+         int16x4_t res_lo, res_hi;
+         int16x8_t res = vdupq_n_s16(0);
+
+         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+
+         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+         {
+            int16x8_t coeff = vcombine_s16(vdup_n_s16(filter_horiz[x + 0]), vdup_n_s16(filter_horiz[x + 1]));
+            int16x8_t col   = vreinterpretq_s16_u16(vshll_n_u8(vld1_u8((const uint8_t*)(input_base_x + x)), 7));
+
+            res = vqaddq_s16(scaler_mulhi_neon(col, coeff), res);
+         }
+
+         res_lo = vget_low_s16(res);
+         res_hi = vget_high_s16(res);
+
+         for (; x < ctx->horiz.filter_len; x++)
+         {
+            int16x4_t col = vget_low_s16(vreinterpretq_s16_u16(vshll_n_u8(
+                        vreinterpret_u8_u32(vdup_n_u32(input_base_x[x])), 7)));
+
+            res_lo = vqadd_s16(vshrn_n_s32(vmull_n_s16(col, filter_horiz[x]), 16), res_lo);
+         }
+
+         vst1_s16((int16_t*)(output + w), vqadd_s16(res_hi, res_lo));
+      }
+   }
+}
 #else
 static INLINE uint64_t build_argb64(uint16_t a, uint16_t r, uint16_t g, uint16_t b)
 {
@@ -20,6 +20,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #ifdef _WIN32
@@ -32,6 +33,10 @@
 #include <retro_endianness.h>
 #include <retro_file.h>
 
+#ifdef HAVE_ZLIB
+#include <compat/zlib.h>
+#endif
+
 #define LSL32(x, n) ((uint32_t)(x) << (n))
 #define LSR32(x, n) ((uint32_t)(x) >> (n))
 #define ROR32(x, n) (LSR32(x, n) | LSL32(x, 32 - (n)))
@@ -199,7 +204,6 @@ void sha256_hash(char *s, const uint8_t *in, size_t size)
       snprintf(s + 2 * i, 3, "%02x", (unsigned)shahash.u8[i]);
 }
 
-#ifndef HAVE_ZLIB
 /* Zlib CRC32. */
 static const uint32_t crc32_table[256] = {
     0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
@@ -260,7 +264,6 @@ uint32_t crc32_calculate(const uint8_t *data, size_t length)
       checksum = crc32_adjust(checksum, data[i]);
    return ~checksum;
 }
-#endif
 
 /* SHA-1 implementation. */
 
@@ -482,15 +485,23 @@ static void SHA1Input(SHA1Context *context,
       return;
    }
 
-   while(length-- && !context->Corrupted)
+   while(length && !context->Corrupted)
    {
-      context->Message_Block[context->Message_Block_Index++] =
-         (*message_array & 0xFF);
+      unsigned chunk = 64 - context->Message_Block_Index;
+
+      if (chunk > length)
+         chunk = length;
+
+      memcpy(&context->Message_Block[context->Message_Block_Index],
+            message_array, chunk);
+      context->Message_Block_Index += chunk;
+      message_array                += chunk;
+      length                       -= chunk;
 
-      context->Length_Low += 8;
+      context->Length_Low += chunk << 3;
       /* Force it to 32 bits */
       context->Length_Low &= 0xFFFFFFFF;
-      if (context->Length_Low == 0)
+      if (context->Length_Low < (chunk << 3))
       {
          context->Length_High++;
          /* Force it to 32 bits */
@@ -501,57 +512,162 @@ static void SHA1Input(SHA1Context *context,
 
       if (context->Message_Block_Index == 64)
          SHA1ProcessMessageBlock(context);
-
-      message_array++;
    }
 }
 
 int sha1_calculate(const char *path, char *result)
 {
-   unsigned char buff[4096] = {0};
-   SHA1Context sha;
-   int rv = 1;
-   RFILE *fd = retro_fopen(path, RFILE_MODE_READ, -1);
+   unsigned i;
+   rhash_result_t hash;
+
+   if (rhash_file(path, RHASH_SHA1, &hash) < 0)
+      return -1;
+
+   for (i = 0; i < 20; i++)
+      sprintf(result + i * 2, "%02X", (unsigned)hash.sha1[i]);
+
+   return 0;
+}
+
+uint32_t djb2_calculate(const char *str)
+{
+   const unsigned char *aux = (const unsigned char*)str;
+   uint32_t            hash = 5381;
+
+   while ( *aux )
+      hash = ( hash << 5 ) + hash + *aux++;
+
+   return hash;
+}
+
+/* Continues @crc, a finished CRC32, over @data. zlib's crc32()
+ * works on several bytes at a time, the table is the fallback. */
+static uint32_t rhash_crc32_update(uint32_t crc,
+      const uint8_t *data, unsigned length)
+{
+#ifdef HAVE_ZLIB
+   return crc32(crc, data, length);
+#else
+   unsigned i;
+
+   crc = ~crc;
+   for (i = 0; i < length; i++)
+      crc = crc32_adjust(crc, data[i]);
+   return ~crc;
+#endif
+}
+
+void rhash_init(rhash_ctx_t *ctx, unsigned flags)
+{
+   memset(ctx, 0, sizeof(*ctx));
+   ctx->flags = flags;
+
+   if (flags & RHASH_MD5)
+      MD5_Init(&ctx->md5);
+   if (flags & RHASH_SHA1)
+      SHA1Reset(&ctx->sha1);
+}
+
+void rhash_update(rhash_ctx_t *ctx, const void *data, size_t size)
+{
+   const uint8_t *in = (const uint8_t*)data;
+
+   ctx->size += size;
+
+   /* CRC32, MD5 and SHA1 take 32-bit sizes. */
+   while (size)
+   {
+      unsigned chunk = size > 0x40000000 ? 0x40000000 : (unsigned)size;
+
+      if (ctx->flags & RHASH_CRC32)
+         ctx->crc32 = rhash_crc32_update(ctx->crc32, in, chunk);
+      if (ctx->flags & RHASH_MD5)
+         MD5_Update(&ctx->md5, in, chunk);
+      if (ctx->flags & RHASH_SHA1)
+         SHA1Input(&ctx->sha1, in, chunk);
+
+      in   += chunk;
+      size -= chunk;
+   }
+}
+
+int64_t rhash_update_file(rhash_ctx_t *ctx, const char *path,
+      uint64_t offset, int64_t size)
+{
+   int64_t total = 0;
+   uint8_t *buf  = NULL;
+   RFILE *fd     = retro_fopen(path, RFILE_MODE_READ, -1);
 
    if (!fd)
+      return -1;
+
+   if (offset && retro_fseek(fd, (ssize_t)offset, SEEK_SET) < 0)
       goto error;
 
-   SHA1Reset(&sha);
+   buf = (uint8_t*)malloc(RHASH_BUFFER_SIZE);
+   if (!buf)
+      goto error;
 
-   do
+   while (size < 0 || total < size)
    {
-      rv = retro_fread(fd, buff, 4096);
-      if (rv < 0)
-         goto error;
+      size_t len = RHASH_BUFFER_SIZE;
+      ssize_t rv;
 
-      SHA1Input(&sha, buff, rv);
-   }while(rv);
+      if (size >= 0 && (uint64_t)(size - total) < len)
+         len = (size_t)(size - total);
 
-   if (!SHA1Result(&sha))
-      goto error;
+      rv = retro_fread(fd, buf, len);
+      if (rv < 0)
+         goto error;
+      if (rv == 0)
+         break;
 
-   sprintf(result, "%08X%08X%08X%08X%08X",
-         sha.Message_Digest[0],
-         sha.Message_Digest[1],
-         sha.Message_Digest[2],
-         sha.Message_Digest[3], sha.Message_Digest[4]);
+      rhash_update(ctx, buf, (size_t)rv);
+      total += rv;
+   }
 
+   free(buf);
    retro_fclose(fd);
-   return 0;
+   return total;
 
 error:
-   if (fd)
-      retro_fclose(fd);
+   free(buf);
+   retro_fclose(fd);
    return -1;
 }
 
-uint32_t djb2_calculate(const char *str)
+void rhash_final(rhash_ctx_t *ctx, rhash_result_t *result)
 {
-   const unsigned char *aux = (const unsigned char*)str;
-   uint32_t            hash = 5381;
+   unsigned i;
 
-   while ( *aux )
-      hash = ( hash << 5 ) + hash + *aux++;
+   memset(result, 0, sizeof(*result));
+   result->size  = ctx->size;
+   result->crc32 = ctx->crc32;
 
-   return hash;
+   if (ctx->flags & RHASH_MD5)
+      MD5_Final(result->md5, &ctx->md5);
+
+   if ((ctx->flags & RHASH_SHA1) && SHA1Result(&ctx->sha1))
+   {
+      for (i = 0; i < 5; i++)
+      {
+         result->sha1[i * 4 + 0] = (ctx->sha1.Message_Digest[i] >> 24) & 0xff;
+         result->sha1[i * 4 + 1] = (ctx->sha1.Message_Digest[i] >> 16) & 0xff;
+         result->sha1[i * 4 + 2] = (ctx->sha1.Message_Digest[i] >>  8) & 0xff;
+         result->sha1[i * 4 + 3] = (ctx->sha1.Message_Digest[i] >>  0) & 0xff;
+      }
+   }
+}
+
+int rhash_file(const char *path, unsigned flags, rhash_result_t *result)
+{
+   rhash_ctx_t ctx;
+
+   rhash_init(&ctx, flags);
+
+   if (rhash_update_file(&ctx, path, 0, -1) < 0)
+      return -1;
+
+   rhash_final(&ctx, result);
+   return 0;
 }
@@ -60,6 +60,13 @@ struct config_file
    unsigned include_depth;
 
    struct config_include_list *includes;
+
+   /* Open-addressed index over entries, by key.
+    * Holds the first entry for each key, which
+    * is the one lookups have always returned. */
+   struct config_entry_list **index;
+   size_t index_size;
+   size_t index_count;
 };
 
 typedef struct config_file config_file_t;
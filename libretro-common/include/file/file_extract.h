@@ -64,6 +64,13 @@ uint32_t zlib_crc32_calculate(const uint8_t *data, size_t length);
 
 uint32_t zlib_crc32_adjust(uint32_t crc, uint8_t data);
 
+uint32_t zlib_adler32_calculate(const uint8_t *data, size_t length);
+
+/* Adler-32 of two buffers back to back, from the checksum of
+ * each and the length of the second. */
+uint32_t zlib_adler32_combine(uint32_t adler1, uint32_t adler2,
+      size_t length2);
+
 /**
  * zlib_parse_file:
  * @file                        : filename path of archive
@@ -146,8 +153,22 @@ void zlib_stream_free(void *data);
 
 void zlib_deflate_init(void *data, int level);
 
+/* Deflate without the zlib header and checksum, so the output
+ * can be joined with other raw streams. */
+bool zlib_deflate_init_raw(void *data, int level);
+
+bool zlib_deflate_set_dictionary(void *data,
+      const uint8_t *dict, uint32_t size);
+
+/* Largest output deflating @size bytes at once can produce. */
+size_t zlib_deflate_bound(void *data, size_t size);
+
 int zlib_deflate_data_to_file(void *data);
 
+/* Deflates all input and ends it on a byte boundary without
+ * finishing the stream. Returns 1 once all of it is out. */
+int zlib_deflate_data_to_file_flush(void *data);
+
 void zlib_stream_deflate_free(void *data);
 
 bool zlib_inflate_init(void *data);
@@ -56,10 +56,19 @@ int rpng_nbio_load_image_argb_process(rpng_t *rpng,
 bool rpng_nbio_load_image_argb_start(rpng_t *rpng);
 
 #ifdef HAVE_ZLIB_DEFLATE
+/* zlib compression levels. The plain save functions use the best. */
+#define RPNG_COMPRESSION_FAST 1
+#define RPNG_COMPRESSION_BEST 9
+
 bool rpng_save_image_argb(const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch);
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch);
+
+bool rpng_save_image_argb_level(const char *path, const uint32_t *data,
+      unsigned width, unsigned height, unsigned pitch, int level);
+bool rpng_save_image_bgr24_level(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, int level);
 #endif
 
 #ifdef __cplusplus
@@ -24,6 +24,7 @@
 #define __LIBRETRO_SDK_SCALER_INT_H__
 
 #include <gfx/scaler/scaler.h>
+#include <gfx/scaler/scaler_simd.h>
 
 void scaler_argb8888_vert(const struct scaler_ctx *ctx,
       void *output, int stride);
@@ -31,6 +32,14 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx,
 void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
       const void *input, int stride);
 
+#if defined(SCALER_HAVE_AVX2)
+SCALER_AVX2_TARGET void scaler_argb8888_vert_avx2(const struct scaler_ctx *ctx,
+      void *output, int stride);
+
+SCALER_AVX2_TARGET void scaler_argb8888_horiz_avx2(const struct scaler_ctx *ctx,
+      const void *input, int stride);
+#endif
+
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
       void *output, const void *input,
       int out_width, int out_height,
@@ -0,0 +1,84 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (scaler_simd.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_SCALER_SIMD_H__
+#define __LIBRETRO_SDK_SCALER_SIMD_H__
+
+#include <boolean.h>
+#include <retro_inline.h>
+
+/* SIMD selection shared by the pixel converters and the scaler.
+ *
+ * SSE2 and NEON are chosen at compile time, like the rest of the code.
+ * The AVX2 kernels are built into every x86 GCC/Clang build through
+ * per-function target attributes and picked at runtime, so a generic
+ * build still gets them on CPUs that have AVX2.
+ *
+ * SCALER_NO_SIMD disables all of it, SCALER_NO_AVX2 only the AVX2 path. */
+
+#ifndef SCALER_NO_SIMD
+
+#if defined(__SSE2__)
+#define SCALER_HAVE_SSE2
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define SCALER_HAVE_NEON
+#endif
+
+#if !defined(SCALER_NO_AVX2)
+#if defined(__AVX2__)
+#define SCALER_HAVE_AVX2
+#define SCALER_AVX2_TARGET
+#elif (defined(__x86_64__) || defined(__i386__)) && \
+   ((defined(__clang__) && (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))) || \
+    (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SCALER_HAVE_AVX2
+#define SCALER_HAVE_AVX2_RUNTIME
+#define SCALER_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+#endif
+
+#ifdef SCALER_HAVE_AVX2
+#include <immintrin.h>
+
+static INLINE bool scaler_simd_has_avx2(void)
+{
+#ifdef SCALER_HAVE_AVX2_RUNTIME
+   static int has_avx2 = -1;
+
+   if (has_avx2 < 0)
+      has_avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+   return has_avx2;
+#else
+   return true;
+#endif
+}
+#endif
+
+#ifdef SCALER_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+#endif
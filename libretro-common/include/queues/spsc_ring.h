@@ -0,0 +1,133 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (spsc_ring.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_SPSC_RING_H
+#define __LIBRETRO_SDK_SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Byte ring for exactly one producer thread and one consumer thread.
+ *
+ * Reads and writes never take a lock: each side only stores its own
+ * index and loads the other one. The wait functions are optional and
+ * only ever block the caller; the other side pays for a wakeup only
+ * while someone is actually asleep. */
+typedef struct spsc_ring spsc_ring_t;
+
+/**
+ * spsc_ring_new:
+ * @size                     : capacity in bytes.
+ *
+ * Returns: new ring, or NULL on allocation failure.
+ **/
+spsc_ring_t *spsc_ring_new(size_t size);
+
+void spsc_ring_free(spsc_ring_t *ring);
+
+/**
+ * spsc_ring_clear:
+ * @ring                     : ring.
+ *
+ * Drops all buffered data. Only safe while neither side is
+ * reading or writing.
+ **/
+void spsc_ring_clear(spsc_ring_t *ring);
+
+size_t spsc_ring_capacity(spsc_ring_t *ring);
+
+/* Consumer side. */
+size_t spsc_ring_read_avail(spsc_ring_t *ring);
+
+/**
+ * spsc_ring_read:
+ * @ring                     : ring.
+ * @out_buf                  : destination.
+ * @size                     : maximum amount of bytes to read.
+ *
+ * Reads as much as is available, up to @size, in one batch.
+ *
+ * Returns: amount of bytes read.
+ **/
+size_t spsc_ring_read(spsc_ring_t *ring, void *out_buf, size_t size);
+
+/* Producer side. */
+size_t spsc_ring_write_avail(spsc_ring_t *ring);
+
+/**
+ * spsc_ring_write:
+ * @ring                     : ring.
+ * @in_buf                   : source.
+ * @size                     : maximum amount of bytes to write.
+ *
+ * Writes as much as fits, up to @size, in one batch.
+ *
+ * Returns: amount of bytes written.
+ **/
+size_t spsc_ring_write(spsc_ring_t *ring, const void *in_buf, size_t size);
+
+/**
+ * spsc_ring_wait_read:
+ * @ring                     : ring.
+ * @size                     : amount of bytes the consumer needs.
+ * @timeout_us               : give up after this many microseconds.
+ *
+ * Blocks the consumer until @size bytes are readable,
+ * spsc_ring_wake() is called, or the timeout expires.
+ *
+ * Returns: true if @size bytes are readable.
+ **/
+bool spsc_ring_wait_read(spsc_ring_t *ring, size_t size, int64_t timeout_us);
+
+/**
+ * spsc_ring_wait_write:
+ * @ring                     : ring.
+ * @size                     : amount of bytes the producer needs.
+ * @timeout_us               : give up after this many microseconds.
+ *
+ * Blocks the producer until @size bytes are writable,
+ * spsc_ring_wake() is called, or the timeout expires.
+ *
+ * Returns: true if @size bytes are writable.
+ **/
+bool spsc_ring_wait_write(spsc_ring_t *ring, size_t size, int64_t timeout_us);
+
+/**
+ * spsc_ring_wake:
+ * @ring                     : ring.
+ *
+ * Wakes up any waiter, e.g. so it can notice a shutdown flag.
+ * Safe to call from any thread.
+ **/
+void spsc_ring_wake(spsc_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
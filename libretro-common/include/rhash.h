@@ -123,4 +123,62 @@ void MD5_Init(MD5_CTX *ctx);
 void MD5_Update(MD5_CTX *ctx, const void *data, unsigned long size);
 void MD5_Final(unsigned char *result, MD5_CTX *ctx);
 
+/* Streaming hashes. Any mix of CRC32, MD5 and SHA1 is computed in one
+ * pass over the data, so content can be hashed a chunk at a time
+ * instead of being loaded whole. */
+
+#define RHASH_CRC32 (1 << 0)
+#define RHASH_MD5   (1 << 1)
+#define RHASH_SHA1  (1 << 2)
+
+/* Size of the buffer rhash_file() reads through. */
+#define RHASH_BUFFER_SIZE (256 * 1024)
+
+typedef struct rhash_ctx
+{
+   unsigned flags;
+   uint64_t size;
+   uint32_t crc32;
+   MD5_CTX md5;
+   SHA1Context sha1;
+} rhash_ctx_t;
+
+typedef struct rhash_result
+{
+   uint64_t size;
+   uint32_t crc32;
+   uint8_t md5[16];
+   uint8_t sha1[20];
+} rhash_result_t;
+
+void rhash_init(rhash_ctx_t *ctx, unsigned flags);
+
+void rhash_update(rhash_ctx_t *ctx, const void *data, size_t size);
+
+/**
+ * rhash_update_file:
+ * @ctx               : Hash context.
+ * @path              : Path to file.
+ * @offset            : Where to start hashing.
+ * @size              : How many bytes to hash, or -1 for all the rest.
+ *
+ * Feeds part of a file to @ctx through a RHASH_BUFFER_SIZE buffer.
+ *
+ * Returns: number of bytes hashed, or -1 if the file can't be read.
+ **/
+int64_t rhash_update_file(rhash_ctx_t *ctx, const char *path,
+      uint64_t offset, int64_t size);
+
+void rhash_final(rhash_ctx_t *ctx, rhash_result_t *result);
+
+/**
+ * rhash_file:
+ * @path              : Path to file.
+ * @flags             : RHASH_* hashes to compute.
+ * @result            : Filled with the hashes and the file size.
+ *
+ * Returns: 0 on success, -1 if the file can't be read.
+ **/
+int rhash_file(const char *path, unsigned flags, rhash_result_t *result);
+
 #endif
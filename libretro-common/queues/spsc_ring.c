@@ -0,0 +1,374 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (spsc_ring.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_inline.h>
+#include <queues/spsc_ring.h>
+
+#if defined(__linux__)
+#define SPSC_RING_FUTEX
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <rthreads/rthreads.h>
+#endif
+
+#if defined(__clang__) || (defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define SPSC_RING_ATOMIC_BUILTINS
+#elif defined(__GNUC__)
+#define SPSC_RING_SYNC_BUILTINS
+#elif defined(_MSC_VER)
+#define SPSC_RING_INTERLOCKED
+#include <windows.h>
+#else
+/* No usable atomics; index updates go through a lock instead. */
+#define SPSC_RING_LOCKED
+#ifdef SPSC_RING_FUTEX
+#include <rthreads/rthreads.h>
+#endif
+#endif
+
+#define SPSC_RING_CACHE_LINE 64
+
+struct spsc_ring
+{
+   uint8_t *buffer;
+   size_t size;
+   /* The backing store is rounded up to a power of two so
+    * positions can run freely and be masked; size is still the
+    * most that is ever buffered. */
+   size_t mask;
+#if !defined(SPSC_RING_FUTEX) || defined(SPSC_RING_LOCKED)
+   slock_t *lock;
+#endif
+#ifndef SPSC_RING_FUTEX
+   scond_t *cond;
+#endif
+
+   /* Owned by the consumer. write_cached is its last view of
+    * write_pos, so it only touches the producer's line when the
+    * data it already knows about runs out. */
+   uint8_t pad0[SPSC_RING_CACHE_LINE];
+   volatile size_t read_pos;
+   size_t write_cached;
+
+   /* Owned by the producer. */
+   uint8_t pad1[SPSC_RING_CACHE_LINE];
+   volatile size_t write_pos;
+   size_t read_cached;
+
+   /* Only touched when a side goes to sleep. */
+   uint8_t pad2[SPSC_RING_CACHE_LINE];
+   volatile int wake_seq;
+   volatile int sleepers;
+   uint8_t pad3[SPSC_RING_CACHE_LINE];
+};
+
+#if defined(SPSC_RING_ATOMIC_BUILTINS)
+static INLINE size_t spsc_load_acquire(spsc_ring_t *ring, volatile size_t *p)
+{
+   (void)ring;
+   return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static INLINE void spsc_store_release(spsc_ring_t *ring,
+      volatile size_t *p, size_t val)
+{
+   (void)ring;
+   __atomic_store_n(p, val, __ATOMIC_RELEASE);
+}
+
+#define spsc_fence()           __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define spsc_inc(p)            __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST)
+#define spsc_dec(p)            __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST)
+#elif defined(SPSC_RING_SYNC_BUILTINS) || defined(SPSC_RING_INTERLOCKED)
+#ifdef SPSC_RING_INTERLOCKED
+#define spsc_fence()           MemoryBarrier()
+#define spsc_inc(p)            InterlockedIncrement((volatile LONG*)(p))
+#define spsc_dec(p)            InterlockedDecrement((volatile LONG*)(p))
+#else
+#define spsc_fence()           __sync_synchronize()
+#define spsc_inc(p)            __sync_add_and_fetch(p, 1)
+#define spsc_dec(p)            __sync_sub_and_fetch(p, 1)
+#endif
+
+static INLINE size_t spsc_load_acquire(spsc_ring_t *ring, volatile size_t *p)
+{
+   size_t val = *p;
+   (void)ring;
+   spsc_fence();
+   return val;
+}
+
+static INLINE void spsc_store_release(spsc_ring_t *ring,
+      volatile size_t *p, size_t val)
+{
+   (void)ring;
+   spsc_fence();
+   *p = val;
+}
+#else
+static INLINE size_t spsc_load_acquire(spsc_ring_t *ring, volatile size_t *p)
+{
+   size_t val;
+   slock_lock(ring->lock);
+   val = *p;
+   slock_unlock(ring->lock);
+   return val;
+}
+
+static INLINE void spsc_store_release(spsc_ring_t *ring,
+      volatile size_t *p, size_t val)
+{
+   slock_lock(ring->lock);
+   *p = val;
+   slock_unlock(ring->lock);
+}
+
+static INLINE int spsc_locked_add(spsc_ring_t *ring,
+      volatile int *p, int val)
+{
+   int ret;
+   slock_lock(ring->lock);
+   ret = (*p += val);
+   slock_unlock(ring->lock);
+   return ret;
+}
+
+/* The lock already orders everything. */
+#define spsc_fence()           ((void)0)
+#define spsc_inc(p)            spsc_locked_add(ring, p, 1)
+#define spsc_dec(p)            spsc_locked_add(ring, p, -1)
+#endif
+
+spsc_ring_t *spsc_ring_new(size_t size)
+{
+   size_t capacity   = 1;
+   spsc_ring_t *ring = (spsc_ring_t*)calloc(1, sizeof(*ring));
+
+   if (!ring)
+      return NULL;
+
+   while (capacity < size)
+      capacity <<= 1;
+
+   ring->buffer = (uint8_t*)calloc(1, capacity);
+   ring->size   = size;
+   ring->mask   = capacity - 1;
+
+#if !defined(SPSC_RING_FUTEX) || defined(SPSC_RING_LOCKED)
+   ring->lock   = slock_new();
+   if (!ring->lock)
+      goto error;
+#endif
+#ifndef SPSC_RING_FUTEX
+   ring->cond   = scond_new();
+   if (!ring->cond)
+      goto error;
+#endif
+
+   if (!ring->buffer)
+      goto error;
+
+   return ring;
+
+error:
+   spsc_ring_free(ring);
+   return NULL;
+}
+
+void spsc_ring_free(spsc_ring_t *ring)
+{
+   if (!ring)
+      return;
+
+#if !defined(SPSC_RING_FUTEX) || defined(SPSC_RING_LOCKED)
+   if (ring->lock)
+      slock_free(ring->lock);
+#endif
+#ifndef SPSC_RING_FUTEX
+   if (ring->cond)
+      scond_free(ring->cond);
+#endif
+   free(ring->buffer);
+   free(ring);
+}
+
+void spsc_ring_clear(spsc_ring_t *ring)
+{
+   ring->read_pos     = 0;
+   ring->write_cached = 0;
+   ring->write_pos    = 0;
+   ring->read_cached  = 0;
+   spsc_fence();
+}
+
+size_t spsc_ring_capacity(spsc_ring_t *ring)
+{
+   return ring->size;
+}
+
+size_t spsc_ring_read_avail(spsc_ring_t *ring)
+{
+   ring->write_cached = spsc_load_acquire(ring, &ring->write_pos);
+   return ring->write_cached - ring->read_pos;
+}
+
+size_t spsc_ring_write_avail(spsc_ring_t *ring)
+{
+   ring->read_cached = spsc_load_acquire(ring, &ring->read_pos);
+   return ring->size - (ring->write_pos - ring->read_cached);
+}
+
+static void spsc_ring_notify(spsc_ring_t *ring)
+{
+   /* Pairs with the sleepers increment in the wait functions: either the
+    * sleeper sees our new position, or we see the sleeper. */
+   spsc_fence();
+   if (ring->sleepers)
+      spsc_ring_wake(ring);
+}
+
+size_t spsc_ring_read(spsc_ring_t *ring, void *out_buf, size_t size)
+{
+   size_t first_read;
+   size_t read_pos = ring->read_pos;
+   size_t avail    = ring->write_cached - read_pos;
+   size_t offset   = read_pos & ring->mask;
+
+   if (avail < size)
+      avail = spsc_ring_read_avail(ring);
+   if (size > avail)
+      size = avail;
+   if (!size)
+      return 0;
+
+   first_read = ring->mask + 1 - offset;
+   if (first_read > size)
+      first_read = size;
+
+   memcpy(out_buf, ring->buffer + offset, first_read);
+   memcpy((uint8_t*)out_buf + first_read, ring->buffer, size - first_read);
+
+   spsc_store_release(ring, &ring->read_pos, read_pos + size);
+   spsc_ring_notify(ring);
+   return size;
+}
+
+size_t spsc_ring_write(spsc_ring_t *ring, const void *in_buf, size_t size)
+{
+   size_t first_write;
+   size_t write_pos = ring->write_pos;
+   size_t avail     = ring->size - (write_pos - ring->read_cached);
+   size_t offset    = write_pos & ring->mask;
+
+   if (avail < size)
+      avail = spsc_ring_write_avail(ring);
+   if (size > avail)
+      size = avail;
+   if (!size)
+      return 0;
+
+   first_write = ring->mask + 1 - offset;
+   if (first_write > size)
+      first_write = size;
+
+   memcpy(ring->buffer + offset, in_buf, first_write);
+   memcpy(ring->buffer, (const uint8_t*)in_buf + first_write,
+         size - first_write);
+
+   spsc_store_release(ring, &ring->write_pos, write_pos + size);
+   spsc_ring_notify(ring);
+   return size;
+}
+
+static void spsc_ring_sleep(spsc_ring_t *ring, int seq, int64_t timeout_us)
+{
+#ifdef SPSC_RING_FUTEX
+   struct timespec ts;
+   ts.tv_sec  = timeout_us / 1000000;
+   ts.tv_nsec = (timeout_us % 1000000) * 1000;
+   syscall(SYS_futex, &ring->wake_seq, FUTEX_WAIT_PRIVATE,
+         seq, &ts, NULL, 0);
+#else
+   slock_lock(ring->lock);
+   if (ring->wake_seq == seq)
+      scond_wait_timeout(ring->cond, ring->lock, timeout_us);
+   slock_unlock(ring->lock);
+#endif
+}
+
+bool spsc_ring_wait_read(spsc_ring_t *ring, size_t size, int64_t timeout_us)
+{
+   int seq;
+
+   if (size > ring->size)
+      size = ring->size;
+   if (spsc_ring_read_avail(ring) >= size)
+      return true;
+
+   spsc_inc(&ring->sleepers);
+   seq = ring->wake_seq;
+   if (spsc_ring_read_avail(ring) < size)
+      spsc_ring_sleep(ring, seq, timeout_us);
+   spsc_dec(&ring->sleepers);
+
+   return spsc_ring_read_avail(ring) >= size;
+}
+
+bool spsc_ring_wait_write(spsc_ring_t *ring, size_t size, int64_t timeout_us)
+{
+   int seq;
+
+   if (size > ring->size)
+      size = ring->size;
+   if (spsc_ring_write_avail(ring) >= size)
+      return true;
+
+   spsc_inc(&ring->sleepers);
+   seq = ring->wake_seq;
+   if (spsc_ring_write_avail(ring) < size)
+      spsc_ring_sleep(ring, seq, timeout_us);
+   spsc_dec(&ring->sleepers);
+
+   return spsc_ring_write_avail(ring) >= size;
+}
+
+void spsc_ring_wake(spsc_ring_t *ring)
+{
+#ifdef SPSC_RING_FUTEX
+   spsc_inc(&ring->wake_seq);
+   syscall(SYS_futex, &ring->wake_seq, FUTEX_WAKE_PRIVATE,
+         INT_MAX, NULL, NULL, 0);
+#else
+   slock_lock(ring->lock);
+   ring->wake_seq++;
+   scond_broadcast(ring->cond);
+   slock_unlock(ring->lock);
+#endif
+}
@@ -1,4 +1,8 @@
 
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#endif
+
 #include <stdio.h>
 #include <sys/types.h>
 #ifdef _WIN32
@@ -11,23 +15,44 @@
 #include <sys/stat.h>
 #include <stdlib.h>
 
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
 #include <retro_file.h>
 #include <retro_endianness.h>
 #include <compat/strl.h>
+#include <boolean.h>
 
 #include "libretrodb.h"
 #include "rmsgpack_dom.h"
 #include "rmsgpack.h"
-#include "bintree.h"
 #include "query.h"
-#include "libretrodb.h"
 
 #define MAGIC_NUMBER "RARCHDB"
 
-struct node_iter_ctx
+/* How an index encodes the field into its fixed size keys. Entries
+ * are sorted by key, so integer keys are stored big-endian with the
+ * sign bit flipped to keep their order. Strings are hashed and only
+ * support equality lookups. Indexes written without a key type hold
+ * binary keys. */
+enum libretrodb_key_type
 {
-	libretrodb_t *db;
-	libretrodb_index_t *idx;
+   LIBRETRODB_KEY_BINARY = 0,
+   LIBRETRODB_KEY_INTEGER,
+   LIBRETRODB_KEY_STRING_HASH
+};
+
+struct libretrodb_index
+{
+	char name[50];
+	char field[50];
+	uint64_t key_size;
+	uint64_t key_type;
+	uint64_t next;
+	/* Not stored: where the entries start in the file. */
+	uint64_t entries_offset;
 };
 
 struct libretrodb
@@ -37,13 +62,21 @@ struct libretrodb
 	uint64_t count;
 	uint64_t first_index_offset;
    char path[1024];
-};
 
-struct libretrodb_index
-{
-	char name[50];
-	uint64_t key_size;
-	uint64_t next;
+   /* Read-only mapping of the whole file. Indexes are searched and
+    * records handed out in place instead of read through @fd. */
+   const uint8_t *map;
+   size_t map_size;
+
+   /* Record returned by libretrodb_find_entry_raw() without a mapping. */
+   uint8_t *raw;
+   size_t raw_size;
+
+   /* Last index found in the mapping, so repeated lookups skip the
+    * walk over the index headers. */
+   libretrodb_index_t last_index;
+   bool last_index_by_field;
+   bool last_index_valid;
 };
 
 typedef struct libretrodb_metadata
@@ -64,6 +97,21 @@ struct libretrodb_cursor
 	int eof;
 	libretrodb_query_t *query;
 	libretrodb_t *db;
+
+   /* Encoded record the query prefilter runs on, when it isn't read
+    * from the mapping. */
+   uint8_t *raw;
+   size_t raw_size;
+   /* Offset of the next record, when the database is mapped. */
+   uint64_t pos;
+
+   /* Index scan picked by the planner: the records to read, in file
+    * order, instead of walking the whole database. */
+   uint64_t *offsets;
+   size_t num_offsets;
+   size_t next_offset;
+   char plan_index[50];
+   int plan_pred;
 };
 
 static struct rmsgpack_dom_value sentinal;
@@ -120,9 +168,11 @@ int libretrodb_create(RFILE *fd, libretrodb_value_provider value_provider,
    libretrodb_metadata_t md;
    struct rmsgpack_dom_value item;
    uint64_t item_count        = 0;
-   libretrodb_header_t header = {{0}};
-   ssize_t root = retro_fseek(fd, 0, SEEK_CUR);
+   libretrodb_header_t header;
+   ssize_t root = retro_ftell(fd);
 
+   /* Zero the padding too, it ends up in the file. */
+   memset(&header, 0, sizeof(header));
    memcpy(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)-1);
 
    /* We write the header in the end because we need to know the size of
@@ -147,7 +197,7 @@ int libretrodb_create(RFILE *fd, libretrodb_value_provider value_provider,
    if ((rv = rmsgpack_dom_write(fd, &sentinal)) < 0)
       goto clean;
 
-   header.metadata_offset = swap_if_little64(retro_fseek(fd, 0, SEEK_CUR));
+   header.metadata_offset = swap_if_little64(retro_ftell(fd));
    md.count = item_count;
    libretrodb_write_metadata(fd, &md);
    retro_fseek(fd, root, SEEK_SET);
@@ -157,31 +207,177 @@ clean:
    return rv;
 }
 
-static int libretrodb_read_index_header(RFILE *fd, libretrodb_index_t *idx)
+/**
+ * libretrodb_read_raw_at:
+ * @db                  : Handle to database.
+ * @fd                  : File to read through when @db isn't mapped.
+ * @offset              : Offset of the value.
+ * @buff                : Buffer for the value when it's read, grown as
+ *                        needed.
+ * @size                : Size of @buff.
+ * @raw                 : Set to the encoded value.
+ * @len                 : Set to its length.
+ *
+ * Finds the encoded value at @offset. With a mapping @raw points into
+ * it and nothing is read or allocated.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+static int libretrodb_read_raw_at(libretrodb_t *db, RFILE *fd,
+      uint64_t offset, uint8_t **buff, size_t *size,
+      const uint8_t **raw, size_t *len)
 {
-   uint64_t name_len = 50;
-   return rmsgpack_dom_read_into(fd,
-         "name", idx->name, &name_len,
-         "key_size", &idx->key_size,
-         "next", &idx->next, NULL);
+   int rv;
+
+   if (db->map)
+   {
+      if (offset >= db->map_size)
+         return -EINVAL;
+
+      *raw = db->map + offset;
+      *len = rmsgpack_raw_size(*raw, db->map_size - (size_t)offset);
+      return *len ? 0 : -EINVAL;
+   }
+
+   if (retro_fseek(fd, (ssize_t)offset, SEEK_SET) < 0)
+      return -errno;
+
+   if ((rv = rmsgpack_read_raw(fd, buff, size, len)) < 0)
+      return rv;
+
+   *raw = *buff;
+   return 0;
+}
+
+static int libretrodb_parse_index_header(const uint8_t *raw, size_t len,
+      libretrodb_index_t *idx)
+{
+   int rv;
+   struct rmsgpack_dom_value key, value;
+   struct rmsgpack_raw_map_iter iter;
+   int found = 0;
+
+   if (rmsgpack_raw_map_begin(&iter, raw, len) < 0)
+      return -EINVAL;
+
+   memset(idx, 0, sizeof(*idx));
+
+   while ((rv = rmsgpack_raw_map_next(&iter, &key, &value)) > 0)
+   {
+      if (key.type != RDT_STRING)
+         continue;
+
+      if (value.type == RDT_STRING)
+      {
+         size_t n = value.val.string.len;
+
+         if (n > sizeof(idx->name) - 1)
+            n = sizeof(idx->name) - 1;
+
+         if (key.val.string.len == 4
+               && memcmp(key.val.string.buff, "name", 4) == 0)
+         {
+            memcpy(idx->name, value.val.string.buff, n);
+            found |= 1;
+         }
+         else if (key.val.string.len == 5
+               && memcmp(key.val.string.buff, "field", 5) == 0)
+            memcpy(idx->field, value.val.string.buff, n);
+      }
+      else if (value.type == RDT_UINT
+            || (value.type == RDT_INT && value.val.int_ >= 0))
+      {
+         if (key.val.string.len == 8
+               && memcmp(key.val.string.buff, "key_size", 8) == 0)
+         {
+            idx->key_size = value.val.uint_;
+            found |= 2;
+         }
+         else if (key.val.string.len == 8
+               && memcmp(key.val.string.buff, "key_type", 8) == 0)
+            idx->key_type = value.val.uint_;
+         else if (key.val.string.len == 4
+               && memcmp(key.val.string.buff, "next", 4) == 0)
+         {
+            idx->next = value.val.uint_;
+            found |= 4;
+         }
+      }
+   }
+
+   if (rv < 0 || found != 7 || !idx->key_size)
+      return -EINVAL;
+
+   /* Indexes from before the field was stored are named after it. */
+   if (!idx->field[0])
+      strlcpy(idx->field, idx->name, sizeof(idx->field));
+
+   return 0;
 }
 
 static void libretrodb_write_index_header(RFILE *fd, libretrodb_index_t *idx)
 {
-   rmsgpack_write_map_header(fd, 3);
+   rmsgpack_write_map_header(fd, 5);
    rmsgpack_write_string(fd, "name", strlen("name"));
    rmsgpack_write_string(fd, idx->name, strlen(idx->name));
+   rmsgpack_write_string(fd, "field", strlen("field"));
+   rmsgpack_write_string(fd, idx->field, strlen(idx->field));
    rmsgpack_write_string(fd, "key_size", strlen("key_size"));
    rmsgpack_write_uint(fd, idx->key_size);
+   rmsgpack_write_string(fd, "key_type", strlen("key_type"));
+   rmsgpack_write_uint(fd, idx->key_type);
    rmsgpack_write_string(fd, "next", strlen("next"));
    rmsgpack_write_uint(fd, idx->next);
 }
 
+#ifdef HAVE_MMAP
+static void libretrodb_unmap(libretrodb_t *db)
+{
+   if (db->map)
+      munmap((void*)db->map, db->map_size);
+   db->map              = NULL;
+   db->map_size         = 0;
+   db->last_index_valid = false;
+}
+
+/* Without a mapping everything is read through the file instead. */
+static void libretrodb_map(libretrodb_t *db)
+{
+   struct stat st;
+   void *map = NULL;
+   int fd    = open(db->path, O_RDONLY);
+
+   if (fd < 0)
+      return;
+
+   if (fstat(fd, &st) == 0 && st.st_size > 0)
+   {
+      map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+      if (map != MAP_FAILED)
+      {
+         db->map      = (const uint8_t*)map;
+         db->map_size = (size_t)st.st_size;
+      }
+   }
+
+   close(fd);
+}
+#endif
+
 void libretrodb_close(libretrodb_t *db)
 {
    if (db->fd)
       retro_fclose(db->fd);
    db->fd = NULL;
+
+#ifdef HAVE_MMAP
+   libretrodb_unmap(db);
+#endif
+
+   free(db->raw);
+   db->raw      = NULL;
+   db->raw_size = 0;
 }
 
 int libretrodb_open(const char *path, libretrodb_t *db)
@@ -195,7 +391,7 @@ int libretrodb_open(const char *path, libretrodb_t *db)
       return -errno;
 
    strlcpy(db->path, path, sizeof(db->path));
-   db->root = retro_fseek(fd, 0, SEEK_CUR);
+   db->root = retro_ftell(fd);
 
    if ((rv = retro_fread(fd, &header, sizeof(header))) == -1)
    {
@@ -203,7 +399,7 @@ int libretrodb_open(const char *path, libretrodb_t *db)
       goto error;
    }
 
-   if (strncmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)) != 0)
+   if (memcmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)-1) != 0)
    {
       rv = -EINVAL;
       goto error;
@@ -212,6 +408,7 @@ int libretrodb_open(const char *path, libretrodb_t *db)
    header.metadata_offset = swap_if_little64(header.metadata_offset);
    retro_fseek(fd, (ssize_t)header.metadata_offset, SEEK_SET);
 
+   md.count = 0;
    if (libretrodb_read_metadata(fd, &md) < 0)
    {
       rv = -EINVAL;
@@ -219,8 +416,12 @@ int libretrodb_open(const char *path, libretrodb_t *db)
    }
 
    db->count = md.count;
-   db->first_index_offset = retro_fseek(fd, 0, SEEK_CUR);
+   db->first_index_offset = retro_ftell(fd);
    db->fd = fd;
+
+#ifdef HAVE_MMAP
+   libretrodb_map(db);
+#endif
    return 0;
 
 error:
@@ -229,92 +430,486 @@ error:
    return rv;
 }
 
-static int libretrodb_find_index(libretrodb_t *db, const char *index_name,
-      libretrodb_index_t *idx)
+/* Walks the index headers after the metadata. Finds the index called
+ * @name, or with @by_field the first one over the field @name. */
+static int libretrodb_find_index(libretrodb_t *db, RFILE *fd,
+      const char *name, bool by_field, libretrodb_index_t *idx)
 {
-   ssize_t eof    = retro_fseek(db->fd, 0, SEEK_END);
-   ssize_t offset = retro_fseek(db->fd, (ssize_t)db->first_index_offset, SEEK_SET);
+   uint64_t eof;
+   uint8_t *buff   = NULL;
+   size_t size     = 0;
+   int rv          = -1;
+   uint64_t offset = db->first_index_offset;
+
+   if (     db->map && db->last_index_valid
+         && db->last_index_by_field == by_field
+         && strcmp(name, by_field ?
+            db->last_index.field : db->last_index.name) == 0)
+   {
+      *idx = db->last_index;
+      return 0;
+   }
+
+   if (db->map)
+      eof = db->map_size;
+   else
+   {
+      if (retro_fseek(fd, 0, SEEK_END) < 0)
+         return -1;
+      eof = (uint64_t)retro_ftell(fd);
+   }
 
    while (offset < eof)
    {
-      libretrodb_read_index_header(db->fd, idx);
+      size_t len;
+      const uint8_t *raw = NULL;
 
-      if (strncmp(index_name, idx->name, strlen(idx->name)) == 0)
-         return 0;
+      if (     libretrodb_read_raw_at(db, fd, offset, &buff, &size,
+               &raw, &len) < 0
+            || libretrodb_parse_index_header(raw, len, idx) < 0)
+         break;
 
-      offset = retro_fseek(db->fd, (ssize_t)idx->next, SEEK_CUR);
+      idx->entries_offset = offset + len;
+
+      if (strcmp(name, by_field ? idx->field : idx->name) == 0)
+      {
+         if (db->map)
+         {
+            db->last_index          = *idx;
+            db->last_index_by_field = by_field;
+            db->last_index_valid    = true;
+         }
+         rv = 0;
+         break;
+      }
+
+      offset = idx->entries_offset + idx->next;
    }
 
-   return -1;
+   free(buff);
+   return rv;
+}
+
+/**
+ * libretrodb_index_entries:
+ * @db                  : Handle to database.
+ * @fd                  : File to read through when @db isn't mapped.
+ * @idx                 : Index.
+ * @count               : Set to the number of entries.
+ * @owned               : Set to the buffer to free afterwards, if any.
+ *
+ * Entries are keys of idx->key_size bytes, each followed by the record
+ * offset. With a mapping they're searched where they are.
+ *
+ * Returns: the entries, or NULL if there are none or they can't be read.
+ **/
+static const uint8_t *libretrodb_index_entries(libretrodb_t *db, RFILE *fd,
+      const libretrodb_index_t *idx, size_t *count, uint8_t **owned)
+{
+   size_t entry_size = (size_t)idx->key_size + sizeof(uint64_t);
+   uint8_t *entries  = NULL;
+
+   *count = (size_t)(idx->next / entry_size);
+   *owned = NULL;
+
+   if (!*count)
+      return NULL;
+
+   if (db->map)
+   {
+      if (     idx->entries_offset > db->map_size
+            || *count * entry_size > db->map_size - idx->entries_offset)
+         return NULL;
+
+      return db->map + idx->entries_offset;
+   }
+
+   entries = (uint8_t*)malloc(*count * entry_size);
+   if (!entries)
+      return NULL;
+
+   if (     retro_fseek(fd, (ssize_t)idx->entries_offset, SEEK_SET) < 0
+         || retro_fread(fd, entries, *count * entry_size)
+         != (ssize_t)(*count * entry_size))
+   {
+      free(entries);
+      return NULL;
+   }
+
+   *owned = entries;
+   return entries;
 }
 
-static int node_compare(const void *a, const void *b, void *ctx)
+/* First entry whose key is not below @key. */
+static size_t libretrodb_lower_bound(const uint8_t *entries, size_t count,
+      size_t key_size, const uint8_t *key)
 {
-   return memcmp(a, b, *(uint8_t *)ctx);
+   size_t lo         = 0;
+   size_t hi         = count;
+   size_t entry_size = key_size + sizeof(uint64_t);
+
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (memcmp(entries + mid * entry_size, key, key_size) < 0)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   return lo;
 }
 
-static int binsearch(const void *buff, const void *item,
-      uint64_t count, uint8_t field_size, uint64_t *offset)
+/* First entry whose key is above @key. */
+static size_t libretrodb_upper_bound(const uint8_t *entries, size_t count,
+      size_t key_size, const uint8_t *key)
 {
-   int mid            = count / 2;
-   int item_size      = field_size + sizeof(uint64_t);
-   uint64_t *current  = (uint64_t *)buff + (mid * item_size);
-   int rv             = node_compare(current, item, &field_size);
+   size_t lo         = 0;
+   size_t hi         = count;
+   size_t entry_size = key_size + sizeof(uint64_t);
 
-   if (rv == 0)
+   while (lo < hi)
    {
-      *offset = *(uint64_t *)(current + field_size);
-      return 0;
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (memcmp(entries + mid * entry_size, key, key_size) <= 0)
+         lo = mid + 1;
+      else
+         hi = mid;
    }
 
-   if (count == 0)
+   return lo;
+}
+
+static void libretrodb_put_be64(uint8_t *key, uint64_t value)
+{
+   unsigned i;
+
+   for (i = 0; i < 8; i++)
+      key[i] = (uint8_t)(value >> (56 - 8 * i));
+}
+
+static uint32_t libretrodb_string_hash(const char *s, uint32_t len)
+{
+   uint32_t i;
+   uint32_t hash = 2166136261U;
+
+   for (i = 0; i < len; i++)
+      hash = (hash ^ (uint8_t)s[i]) * 16777619U;
+
+   return hash;
+}
+
+/* Signed and unsigned integers share one key space. Unsigned values
+ * above INT64_MAX all get the top key. */
+static uint64_t libretrodb_integer_key(const struct rmsgpack_dom_value *value)
+{
+   if (value->type == RDT_INT)
+      return (uint64_t)value->val.int_ ^ (UINT64_C(1) << 63);
+   if (value->val.uint_ > (uint64_t)INT64_MAX)
+      return UINT64_MAX;
+   return value->val.uint_ ^ (UINT64_C(1) << 63);
+}
+
+/**
+ * libretrodb_index_key:
+ * @value               : Field value.
+ * @key_type            : LIBRETRODB_KEY_* of the index.
+ * @key_size            : Key size of the index.
+ * @key                 : Filled with the key.
+ *
+ * Returns: 0 if @value has a key in this kind of index, otherwise -1.
+ **/
+static int libretrodb_index_key(const struct rmsgpack_dom_value *value,
+      uint64_t key_type, uint64_t key_size, uint8_t *key)
+{
+   uint32_t hash;
+
+   switch (key_type)
+   {
+      case LIBRETRODB_KEY_BINARY:
+         if (value->type != RDT_BINARY || value->val.binary.len != key_size)
+            return -1;
+         memcpy(key, value->val.binary.buff, (size_t)key_size);
+         return 0;
+      case LIBRETRODB_KEY_INTEGER:
+         if (value->type != RDT_INT && value->type != RDT_UINT)
+            return -1;
+         libretrodb_put_be64(key, libretrodb_integer_key(value));
+         return 0;
+      case LIBRETRODB_KEY_STRING_HASH:
+         if (value->type != RDT_STRING)
+            return -1;
+         hash   = libretrodb_string_hash(value->val.string.buff,
+               value->val.string.len);
+         key[0] = (uint8_t)(hash >> 24);
+         key[1] = (uint8_t)(hash >> 16);
+         key[2] = (uint8_t)(hash >>  8);
+         key[3] = (uint8_t)(hash >>  0);
+         return 0;
+   }
+
+   return -1;
+}
+
+/**
+ * libretrodb_find_entry_raw:
+ * @db                  : Handle to database.
+ * @index_name          : Index to search.
+ * @key                 : Key, of the index's key size.
+ * @record              : Set to the encoded record.
+ * @len                 : Set to its length.
+ *
+ * Looks up the first record with @key without decoding it. Fields can
+ * be read in place with rmsgpack_raw_map_value(). For a mapped
+ * database nothing is read or allocated; @record points into the
+ * mapping and stays valid until the database is closed. Otherwise it's
+ * valid until the next lookup.
+ *
+ * Returns: 0 if found, otherwise negative.
+ **/
+int libretrodb_find_entry_raw(libretrodb_t *db, const char *index_name,
+      const void *key, const uint8_t **record, size_t *len)
+{
+   libretrodb_index_t idx;
+   size_t count, pos, entry_size;
+   uint64_t offset;
+   uint8_t *owned         = NULL;
+   const uint8_t *entries = NULL;
+
+   if (libretrodb_find_index(db, db->fd, index_name, false, &idx) < 0)
+      return -1;
+
+   entries = libretrodb_index_entries(db, db->fd, &idx, &count, &owned);
+   if (!entries)
+      return -1;
+
+   entry_size = (size_t)idx.key_size + sizeof(uint64_t);
+   pos        = libretrodb_lower_bound(entries, count, (size_t)idx.key_size,
+         (const uint8_t*)key);
+
+   if (pos == count || memcmp(entries + pos * entry_size,
+            key, (size_t)idx.key_size) != 0)
+   {
+      free(owned);
       return -1;
+   }
 
-   if (rv > 0)
-      return binsearch(buff, item, mid, field_size, offset);
+   memcpy(&offset, entries + pos * entry_size + idx.key_size,
+         sizeof(offset));
+   free(owned);
 
-   return binsearch(current + item_size, item,
-         count - mid, field_size, offset);
+   return libretrodb_read_raw_at(db, db->fd, offset,
+         &db->raw, &db->raw_size, record, len);
 }
 
 int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
       const void *key, struct rmsgpack_dom_value *out)
 {
-   libretrodb_index_t idx;
-   int rv;
-   void *buff;
-   uint64_t offset;
-   ssize_t bufflen, nread = 0;
+   size_t len;
+   const uint8_t *record = NULL;
 
-   if (libretrodb_find_index(db, index_name, &idx) < 0)
+   if (libretrodb_find_entry_raw(db, index_name, key, &record, &len) < 0)
       return -1;
 
-   bufflen = idx.next;
-   buff = malloc(bufflen);
+   return rmsgpack_dom_read_raw(record, len, out);
+}
+
+static int libretrodb_offset_cmp(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t*)a;
+   uint64_t y = *(const uint64_t*)b;
+
+   return (x > y) - (x < y);
+}
+
+/* Record offsets of the entries in [lo, hi] of @entries, appended to
+ * @offsets. */
+static int libretrodb_collect_offsets(const uint8_t *entries, size_t count,
+      size_t key_size, const uint8_t *lo, const uint8_t *hi,
+      uint64_t **offsets, size_t *num_offsets)
+{
+   size_t i;
+   size_t entry_size = key_size + sizeof(uint64_t);
+   size_t first      = libretrodb_lower_bound(entries, count, key_size, lo);
+   size_t last       = libretrodb_upper_bound(entries, count, key_size, hi);
+   uint64_t *tmp     = NULL;
+
+   if (last <= first)
+      return 0;
 
-   if (!buff)
+   tmp = (uint64_t*)realloc(*offsets,
+         (*num_offsets + (last - first)) * sizeof(uint64_t));
+   if (!tmp)
       return -ENOMEM;
+   *offsets = tmp;
+
+   for (i = first; i < last; i++)
+      memcpy(&tmp[(*num_offsets)++], entries + i * entry_size + key_size,
+            sizeof(uint64_t));
+
+   return 0;
+}
+
+/**
+ * libretrodb_plan_pred:
+ * @cursor              : Cursor being opened.
+ * @pred                : Field test.
+ * @offsets             : Set to the records @pred can match, in file order.
+ * @num_offsets         : Set to the number of records.
+ * @idx                 : Set to the index used.
+ *
+ * Returns: 0 if an index over the field of @pred can answer it,
+ * otherwise -1.
+ **/
+static int libretrodb_plan_pred(libretrodb_cursor_t *cursor,
+      const libretrodb_query_pred_t *pred, uint64_t **offsets,
+      size_t *num_offsets, libretrodb_index_t *idx)
+{
+   size_t count;
+   uint8_t lo[8], hi[8];
+   uint8_t *owned         = NULL;
+   const uint8_t *entries = NULL;
+   int rv                 = -1;
+
+   *offsets     = NULL;
+   *num_offsets = 0;
 
-   while (nread < bufflen)
+   if (pred->type == LIBRETRODB_PRED_GLOB)
+      return -1;
+
+   if (libretrodb_find_index(cursor->db, cursor->fd,
+            pred->field->val.string.buff, true, idx) < 0)
+      return -1;
+
+   if (idx->key_size > sizeof(lo))
+      return -1;
+
+   if (pred->type == LIBRETRODB_PRED_BETWEEN)
    {
-      void *buff_ = (uint64_t *)buff + nread;
-      rv = retro_fread(db->fd, buff_, bufflen - nread);
+      /* Only integers can be between() anything. */
+      if (idx->key_type != LIBRETRODB_KEY_INTEGER)
+         return -1;
+   }
+   else if (pred->args[0]->type == RDT_NULL)
+      return -1; /* Records without the field aren't in the index. */
+   else if (libretrodb_index_key(pred->args[0], idx->key_type,
+            idx->key_size, lo) < 0)
+   {
+      /* A binary of another size can't match any record in the index,
+       * and the others don't have a binary there. Other value types
+       * can match records the index doesn't hold. */
+      if (     idx->key_type != LIBRETRODB_KEY_BINARY
+            || pred->args[0]->type != RDT_BINARY)
+         return -1;
+
+      return 0;
+   }
+
+   entries = libretrodb_index_entries(cursor->db, cursor->fd, idx,
+         &count, &owned);
+   if (!entries)
+      return idx->next ? -1 : 0;
 
-      if (rv <= 0)
+   if (pred->type == LIBRETRODB_PRED_BETWEEN)
+   {
+      libretrodb_index_key(pred->args[0], idx->key_type, idx->key_size, lo);
+      libretrodb_index_key(pred->args[1], idx->key_type, idx->key_size, hi);
+      rv = libretrodb_collect_offsets(entries, count, (size_t)idx->key_size,
+            lo, hi, offsets, num_offsets);
+   }
+   else
+      rv = libretrodb_collect_offsets(entries, count, (size_t)idx->key_size,
+            lo, lo, offsets, num_offsets);
+
+   /* between() takes unsigned values above INT64_MAX as negative,
+    * and an unsigned value equals a negative one when it wraps to it. */
+   if (rv == 0 && idx->key_type == LIBRETRODB_KEY_INTEGER
+         && (pred->type == LIBRETRODB_PRED_BETWEEN
+            || (pred->args[0]->type == RDT_INT && pred->args[0]->val.int_ < 0)))
+   {
+      memset(hi, 0xff, sizeof(hi));
+      if (memcmp(lo, hi, sizeof(hi)) != 0 || pred->type == LIBRETRODB_PRED_BETWEEN)
+         rv = libretrodb_collect_offsets(entries, count,
+               (size_t)idx->key_size, hi, hi, offsets, num_offsets);
+   }
+
+   free(owned);
+
+   if (rv < 0)
+   {
+      free(*offsets);
+      *offsets     = NULL;
+      *num_offsets = 0;
+      return -1;
+   }
+
+   if (*num_offsets > 1)
+   {
+      size_t i, j;
+
+      qsort(*offsets, *num_offsets, sizeof(uint64_t), libretrodb_offset_cmp);
+
+      /* A record can come from both ranges. */
+      for (i = 1, j = 1; i < *num_offsets; i++)
+         if ((*offsets)[i] != (*offsets)[j - 1])
+            (*offsets)[j++] = (*offsets)[i];
+      *num_offsets = j;
+   }
+
+   return 0;
+}
+
+/* Picks the index lookup that leaves the fewest records to read. */
+static void libretrodb_cursor_plan(libretrodb_cursor_t *cursor)
+{
+   unsigned i;
+   const libretrodb_query_pred_t *pred = NULL;
+
+   cursor->plan_pred     = -1;
+   cursor->plan_index[0] = '\0';
+
+   if (!cursor->query)
+      return;
+
+   for (i = 0; (pred = libretrodb_query_pred(cursor->query, i)); i++)
+   {
+      libretrodb_index_t idx;
+      uint64_t *offsets  = NULL;
+      size_t num_offsets = 0;
+
+      if (libretrodb_plan_pred(cursor, pred, &offsets, &num_offsets, &idx) < 0)
+         continue;
+
+      if (cursor->plan_pred >= 0 && num_offsets >= cursor->num_offsets)
       {
-         free(buff);
-         return -errno;
+         free(offsets);
+         continue;
       }
-      nread += rv;
-   }
 
-   rv = binsearch(buff, key, db->count, (ssize_t)idx.key_size, &offset);
-   free(buff);
+      free(cursor->offsets);
+      cursor->offsets     = offsets;
+      cursor->num_offsets = num_offsets;
+      cursor->plan_pred   = (int)i;
+      strlcpy(cursor->plan_index, idx.name, sizeof(cursor->plan_index));
+   }
+}
 
-   if (rv == 0)
-      retro_fseek(db->fd, (ssize_t)offset, SEEK_SET);
+static int libretrodb_cursor_set_pos(libretrodb_cursor_t *cursor,
+      uint64_t offset)
+{
+   if (cursor->db->map)
+   {
+      if (offset > cursor->db->map_size)
+         return -EINVAL;
+      cursor->pos = offset;
+      return 0;
+   }
 
-   return rmsgpack_dom_read(db->fd, out);
+   if (retro_fseek(cursor->fd, (ssize_t)offset, SEEK_SET) < 0)
+      return -errno;
+   return 0;
 }
 
 /**
@@ -327,41 +922,185 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
  **/
 int libretrodb_cursor_reset(libretrodb_cursor_t *cursor)
 {
+   cursor->eof         = 0;
+   cursor->next_offset = 0;
+   return libretrodb_cursor_set_pos(cursor,
+         cursor->db->root + sizeof(libretrodb_header_t));
+}
+
+/**
+ * libretrodb_cursor_tell:
+ * @cursor              : Handle to database cursor.
+ *
+ * Returns: file offset of the item the next
+ * libretrodb_cursor_read_item() call will read, or negative on error.
+ **/
+int64_t libretrodb_cursor_tell(libretrodb_cursor_t *cursor)
+{
+   if (!cursor->is_valid)
+      return -1;
+   if (cursor->db->map)
+      return (int64_t)cursor->pos;
+   return retro_ftell(cursor->fd);
+}
+
+/**
+ * libretrodb_cursor_seek:
+ * @cursor              : Handle to database cursor.
+ * @offset              : Item offset from libretrodb_cursor_tell().
+ *
+ * Moves the cursor to the item at @offset. Reading then carries on
+ * from there through the whole database, index scan or not.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_cursor_seek(libretrodb_cursor_t *cursor, uint64_t offset)
+{
+   if (!cursor->is_valid)
+      return -1;
+
+   free(cursor->offsets);
+   cursor->offsets     = NULL;
+   cursor->num_offsets = 0;
+   cursor->plan_pred   = -1;
+
    cursor->eof = 0;
-   return retro_fseek(cursor->fd,
-         (ssize_t)(cursor->db->root + sizeof(libretrodb_header_t)),
-         SEEK_SET);
+   return libretrodb_cursor_set_pos(cursor, offset);
 }
 
-int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
-      struct rmsgpack_dom_value *out)
+/**
+ * libretrodb_cursor_next:
+ * @cursor              : Handle to database cursor.
+ * @record              : Set to the encoded record.
+ * @len                 : Set to its length.
+ * @match               : Set to 1 if the record matches the query,
+ *                        -1 if libretrodb_query_filter() has to decide.
+ *
+ * Finds the next record the query can match, running the cheap field
+ * tests on the encoded record so records that can't match are never
+ * decoded.
+ *
+ * Returns: 0 if successful, EOF at the end, otherwise negative.
+ **/
+static int libretrodb_cursor_next(libretrodb_cursor_t *cursor,
+      const uint8_t **record, size_t *len, int *match)
 {
    int rv;
+   libretrodb_t *db = cursor->db;
 
    if (cursor->eof)
       return EOF;
 
-retry:
-   rv = rmsgpack_dom_read(cursor->fd, out);
-   if (rv < 0)
-      return rv;
+   for (;;)
+   {
+      if (cursor->plan_pred >= 0)
+      {
+         if (cursor->next_offset >= cursor->num_offsets)
+            break;
+
+         if ((rv = libretrodb_cursor_set_pos(cursor,
+                     cursor->offsets[cursor->next_offset++])) < 0)
+            return rv;
+      }
+
+      if (db->map)
+      {
+         if (cursor->pos >= db->map_size)
+            return -EINVAL;
+
+         *record = db->map + cursor->pos;
+         *len    = rmsgpack_raw_size(*record,
+               db->map_size - (size_t)cursor->pos);
+         if (!*len)
+            return -EINVAL;
+         cursor->pos += *len;
+      }
+      else
+      {
+         if ((rv = rmsgpack_read_raw(cursor->fd, &cursor->raw,
+                     &cursor->raw_size, len)) < 0)
+            return rv;
+         *record = cursor->raw;
+      }
 
-   if (out->type == RDT_NULL)
+      if (rmsgpack_raw_is_nil(*record, *len))
+         break;
+
+      *match = 1;
+      if (cursor->query)
+      {
+         *match = -1;
+         if (libretrodb_query_pred(cursor->query, 0))
+            *match = libretrodb_query_prefilter(cursor->query,
+                  *record, *len);
+      }
+
+      if (*match)
+         return 0;
+   }
+
+   cursor->eof = 1;
+   return EOF;
+}
+
+int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out)
+{
+   int rv, match;
+   size_t len;
+   const uint8_t *record = NULL;
+
+   while ((rv = libretrodb_cursor_next(cursor, &record, &len, &match)) == 0)
    {
-      cursor->eof = 1;
-      return EOF;
+      if ((rv = rmsgpack_dom_read_raw(record, len, out)) < 0)
+         return rv;
+
+      if (match > 0 || libretrodb_query_filter(cursor->query, out))
+         return 0;
+
+      rmsgpack_dom_value_free(out);
    }
 
-   if (cursor->query)
+   return rv;
+}
+
+/**
+ * libretrodb_cursor_read_raw:
+ * @cursor              : Handle to database cursor.
+ * @record              : Set to the next matching record, encoded.
+ * @len                 : Set to its length.
+ *
+ * Same as libretrodb_cursor_read_item() without decoding the record;
+ * read its fields in place with rmsgpack_raw_map_value() or
+ * rmsgpack_raw_map_begin(). For a mapped database @record points into
+ * the mapping, so nothing is allocated unless the query is more than
+ * plain field tests. @record is valid until the next read.
+ *
+ * Returns: 0 if successful, EOF at the end, otherwise negative.
+ **/
+int libretrodb_cursor_read_raw(libretrodb_cursor_t *cursor,
+      const uint8_t **record, size_t *len)
+{
+   int rv, match;
+
+   while ((rv = libretrodb_cursor_next(cursor, record, len, &match)) == 0)
    {
-      if (!libretrodb_query_filter(cursor->query, out))
-      {
-         rmsgpack_dom_value_free(out);
-         goto retry;
-      }
+      struct rmsgpack_dom_value item;
+
+      if (match > 0)
+         return 0;
+
+      if ((rv = rmsgpack_dom_read_raw(*record, *len, &item)) < 0)
+         return rv;
+
+      match = libretrodb_query_filter(cursor->query, &item);
+      rmsgpack_dom_value_free(&item);
+
+      if (match)
+         return 0;
    }
 
-   return 0;
+   return rv;
 }
 
 /**
@@ -381,11 +1120,19 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
    if (cursor->query)
       libretrodb_query_free(cursor->query);
 
-   cursor->is_valid = 0;
-   cursor->eof      = 1;
-   cursor->fd       = NULL;
-   cursor->db       = NULL;
-   cursor->query    = NULL;
+   free(cursor->raw);
+   free(cursor->offsets);
+
+   cursor->is_valid    = 0;
+   cursor->eof         = 1;
+   cursor->fd          = NULL;
+   cursor->db          = NULL;
+   cursor->query       = NULL;
+   cursor->raw         = NULL;
+   cursor->raw_size    = 0;
+   cursor->offsets     = NULL;
+   cursor->num_offsets = 0;
+   cursor->plan_pred   = -1;
 }
 
 /**
@@ -394,76 +1141,193 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
  * @cursor              : Handle to database cursor.
  * @q                   : Query to execute.
  *
- * Opens cursor to database based on query @q.
+ * Opens cursor to database based on query @q. If an index covers one
+ * of the field tests of @q, only the records it points at are read.
  *
  * Returns: 0 if successful, otherwise negative.
  **/
 int libretrodb_cursor_open(libretrodb_t *db, libretrodb_cursor_t *cursor,
       libretrodb_query_t *q)
 {
-   cursor->fd = retro_fopen(db->path, RFILE_MODE_READ, -1);
+   cursor->fd = NULL;
 
-   if (!cursor->fd)
-      return -errno;
+   /* Mapped databases are read in place. */
+   if (!db->map)
+   {
+      cursor->fd = retro_fopen(db->path, RFILE_MODE_READ, -1);
 
-   cursor->db = db;
-   cursor->is_valid = 1;
-   libretrodb_cursor_reset(cursor);
-   cursor->query = q;
+      if (!cursor->fd)
+         return -errno;
+   }
+
+   cursor->db          = db;
+   cursor->is_valid    = 1;
+   cursor->query       = q;
+   cursor->raw         = NULL;
+   cursor->raw_size    = 0;
+   cursor->pos         = 0;
+   cursor->offsets     = NULL;
+   cursor->num_offsets = 0;
 
    if (q)
       libretrodb_query_inc_ref(q);
 
+   libretrodb_cursor_plan(cursor);
+   libretrodb_cursor_reset(cursor);
+
    return 0;
 }
 
-static int node_iter(void *value, void *ctx)
+/**
+ * libretrodb_cursor_explain:
+ * @cursor              : Handle to an open database cursor.
+ * @s                   : Output buffer.
+ * @len                 : Size of @s.
+ *
+ * Describes how the cursor finds its records: the index lookup or full
+ * scan, and the field tests run before records are decoded.
+ **/
+void libretrodb_cursor_explain(libretrodb_cursor_t *cursor,
+      char *s, size_t len)
 {
-   struct node_iter_ctx *nictx = (struct node_iter_ctx*)ctx;
+   unsigned i;
+   char desc[512];
+   const libretrodb_query_pred_t *pred = NULL;
 
-   if (retro_fwrite(nictx->db->fd, value,
-            (ssize_t)(nictx->idx->key_size + sizeof(uint64_t))) > 0)
-      return 0;
+   *s = '\0';
 
-   return -1;
+   if (cursor->plan_pred >= 0)
+   {
+      libretrodb_query_pred_describe(
+            libretrodb_query_pred(cursor->query, cursor->plan_pred),
+            desc, sizeof(desc));
+      snprintf(s, len, "Index scan on '%s' for %s: %u of %u records\n",
+            cursor->plan_index, desc, (unsigned)cursor->num_offsets,
+            (unsigned)cursor->db->count);
+   }
+   else
+      snprintf(s, len, "Full scan: %u records\n",
+            (unsigned)cursor->db->count);
+
+   if (!cursor->query)
+      return;
+
+   for (i = 0; (pred = libretrodb_query_pred(cursor->query, i)); i++)
+   {
+      libretrodb_query_pred_describe(pred, desc, sizeof(desc));
+      strlcat(s, i ? ", " : "Before decoding: ", len);
+      strlcat(s, desc, len);
+   }
+   if (i)
+      strlcat(s, "\n", len);
+
+   if (!libretrodb_query_is_complete(cursor->query))
+      strlcat(s, "After decoding: full query\n", len);
 }
 
-static uint64_t libretrodb_tell(libretrodb_t *db)
+/* Sorts index entries by key, keeping records with the same key in
+ * file order. */
+static int libretrodb_sort_entries(uint8_t *entries, size_t count,
+      size_t key_size)
 {
-   return retro_fseek(db->fd, 0, SEEK_CUR);
+   size_t width;
+   size_t entry_size = key_size + sizeof(uint64_t);
+   uint8_t *tmp      = (uint8_t*)malloc(count * entry_size);
+   uint8_t *src      = entries;
+   uint8_t *dst      = tmp;
+
+   if (!tmp)
+      return -ENOMEM;
+
+   for (width = 1; width < count; width *= 2)
+   {
+      size_t start;
+      uint8_t *swap;
+
+      for (start = 0; start < count; start += 2 * width)
+      {
+         size_t mid = start + width < count ? start + width : count;
+         size_t end = start + 2 * width < count ? start + 2 * width : count;
+         size_t i   = start;
+         size_t j   = mid;
+         size_t k   = start;
+
+         while (i < mid && j < end)
+         {
+            if (memcmp(src + j * entry_size, src + i * entry_size,
+                     key_size) < 0)
+               memcpy(dst + k++ * entry_size, src + j++ * entry_size,
+                     entry_size);
+            else
+               memcpy(dst + k++ * entry_size, src + i++ * entry_size,
+                     entry_size);
+         }
+
+         if (i < mid)
+            memcpy(dst + k * entry_size, src + i * entry_size,
+                  (mid - i) * entry_size);
+         else if (j < end)
+            memcpy(dst + k * entry_size, src + j * entry_size,
+                  (end - j) * entry_size);
+      }
+
+      swap = src;
+      src  = dst;
+      dst  = swap;
+   }
+
+   if (src != entries)
+      memcpy(entries, src, count * entry_size);
+
+   free(tmp);
+   return 0;
 }
 
+/**
+ * libretrodb_create_index:
+ * @db                  : Handle to database.
+ * @name                : Name of the new index.
+ * @field_name          : Field to index.
+ *
+ * Appends an index over @field_name to the database file. The field
+ * can hold fixed size binaries, integers or strings; records where it
+ * is missing or of another type are left out. Queries testing the
+ * field for equality, or integers with between(), use the index.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
 int libretrodb_create_index(libretrodb_t *db,
       const char *name, const char *field_name)
 {
    int rv;
-   struct node_iter_ctx nictx;
    struct rmsgpack_dom_value key;
-   libretrodb_index_t idx;
    struct rmsgpack_dom_value item;
-   struct rmsgpack_dom_value *field;
-   uint64_t idx_header_offset;
+   libretrodb_index_t idx;
+   RFILE *fd                   = NULL;
    libretrodb_cursor_t cur     = {0};
-   void *buff                  = NULL;
-   uint64_t *buff_u64          = NULL;
-   uint8_t field_size          = 0;
-   uint64_t item_loc           = libretrodb_tell(db);
-   bintree_t *tree             = bintree_new(node_compare, &field_size);
+   uint8_t *entries            = NULL;
+   size_t entry_size           = 0;
+   size_t count                = 0;
+   size_t capacity             = 0;
+   int64_t item_loc            = 0;
 
-   if (!tree || (libretrodb_cursor_open(db, &cur, NULL) != 0))
-   {
-      rv = -1;
-      goto clean;
-   }
+   memset(&idx, 0, sizeof(idx));
+   item.type = RDT_NULL;
 
-   key.type = RDT_STRING;
-   key.val.string.len = strlen(field_name);
+   if (libretrodb_cursor_open(db, &cur, NULL) != 0)
+      return -1;
 
+   key.type            = RDT_STRING;
+   key.val.string.len  = strlen(field_name);
    /* We know we aren't going to change it */
    key.val.string.buff = (char *) field_name;
 
-   while (libretrodb_cursor_read_item(&cur, &item) == 0)
+   while ((item_loc = libretrodb_cursor_tell(&cur)) >= 0
+         && libretrodb_cursor_read_item(&cur, &item) == 0)
    {
+      uint64_t loc = (uint64_t)item_loc;
+      struct rmsgpack_dom_value *field = NULL;
+
       if (item.type != RDT_MAP)
       {
          rv = -EINVAL;
@@ -473,86 +1337,125 @@ int libretrodb_create_index(libretrodb_t *db,
 
       field = rmsgpack_dom_value_map_value(&item, &key);
 
-      if (!field)
-      {
-         rv = -EINVAL;
-         printf("field not found in item\n");
-         goto clean;
-      }
-
-      if (field->type != RDT_BINARY)
+      if (field && !entry_size)
       {
-         rv = -EINVAL;
-         printf("field is not binary\n");
-         goto clean;
+         switch (field->type)
+         {
+            case RDT_BINARY:
+               if (field->val.binary.len == 0 || field->val.binary.len > 8)
+               {
+                  rv = -EINVAL;
+                  printf("field is empty or longer than 8 bytes\n");
+                  goto clean;
+               }
+               idx.key_type = LIBRETRODB_KEY_BINARY;
+               idx.key_size = field->val.binary.len;
+               break;
+            case RDT_INT:
+            case RDT_UINT:
+               idx.key_type = LIBRETRODB_KEY_INTEGER;
+               idx.key_size = 8;
+               break;
+            case RDT_STRING:
+               idx.key_type = LIBRETRODB_KEY_STRING_HASH;
+               idx.key_size = 4;
+               break;
+            default:
+               rv = -EINVAL;
+               printf("field type can't be indexed\n");
+               goto clean;
+         }
+         entry_size = (size_t)idx.key_size + sizeof(uint64_t);
       }
 
-      if (field->val.binary.len == 0)
-      {
-         rv = -EINVAL;
-         printf("field is empty\n");
-         goto clean;
-      }
-
-      if (field_size == 0)
-         field_size = field->val.binary.len;
-      else if (field->val.binary.len != field_size)
+      if (field && field->type == RDT_BINARY
+            && idx.key_type == LIBRETRODB_KEY_BINARY
+            && field->val.binary.len != idx.key_size)
       {
          rv = -EINVAL;
          printf("field is not of correct size\n");
          goto clean;
       }
 
-      buff = malloc(field_size + sizeof(uint64_t));
-      if (!buff)
+      if (field)
       {
-         rv = -ENOMEM;
-         goto clean;
+         if (count == capacity)
+         {
+            size_t new_capacity = capacity ? capacity * 2 : 1024;
+            uint8_t *tmp        = (uint8_t*)realloc(entries,
+                  new_capacity * entry_size);
+
+            if (!tmp)
+            {
+               rv = -ENOMEM;
+               goto clean;
+            }
+
+            entries  = tmp;
+            capacity = new_capacity;
+         }
+
+         if (libretrodb_index_key(field, idx.key_type, idx.key_size,
+                  entries + count * entry_size) == 0)
+         {
+            memcpy(entries + count * entry_size + idx.key_size,
+                  &loc, sizeof(loc));
+            count++;
+         }
       }
 
-      memcpy(buff, field->val.binary.buff, field_size);
-
-      buff_u64 = (uint64_t *)buff + field_size;
-
-      memcpy(buff_u64, &item_loc, sizeof(uint64_t));
-
-      if (bintree_insert(tree, buff) != 0)
-      {
-         printf("Value is not unique: ");
-         rmsgpack_dom_value_print(field);
-         printf("\n");
-         rv = -EINVAL;
-         goto clean;
-      }
-      buff = NULL;
       rmsgpack_dom_value_free(&item);
-      item_loc = libretrodb_tell(db);
+      item.type = RDT_NULL;
    }
 
-   idx_header_offset = retro_fseek(db->fd, 0, SEEK_END);
+   if (!entry_size)
+   {
+      rv = -EINVAL;
+      printf("field not found in any item\n");
+      goto clean;
+   }
+
+   if ((rv = libretrodb_sort_entries(entries, count, (size_t)idx.key_size)) < 0)
+      goto clean;
 
-   (void)idx_header_offset;
-   (void)rv;
+   strlcpy(idx.name, name, sizeof(idx.name));
+   strlcpy(idx.field, field_name, sizeof(idx.field));
+   idx.next = count * entry_size;
 
-   strncpy(idx.name, name, 50);
+   fd = retro_fopen(db->path, RFILE_MODE_READ_WRITE, -1);
+   if (!fd || retro_fseek(fd, 0, SEEK_END) < 0)
+   {
+      rv = -errno;
+      goto clean;
+   }
 
-   idx.name[49] = '\0';
-   idx.key_size = field_size;
-   idx.next = db->count * (field_size + sizeof(uint64_t));
-   libretrodb_write_index_header(db->fd, &idx);
+   libretrodb_write_index_header(fd, &idx);
+   if (count && retro_fwrite(fd, entries, count * entry_size)
+         != (ssize_t)(count * entry_size))
+   {
+      rv = -EIO;
+      goto clean;
+   }
 
-   nictx.db = db;
-   nictx.idx = &idx;
-   bintree_iterate(tree, node_iter, &nictx);
-   bintree_free(tree);
+   rv = 0;
 
 clean:
    rmsgpack_dom_value_free(&item);
-   if (buff)
-      free(buff);
+   if (fd)
+      retro_fclose(fd);
+   free(entries);
    if (cur.is_valid)
       libretrodb_cursor_close(&cur);
-   return 0;
+
+#ifdef HAVE_MMAP
+   /* Map the file again so the new index is part of it. */
+   if (rv == 0 && db->map)
+   {
+      libretrodb_unmap(db);
+      libretrodb_map(db);
+   }
+#endif
+   return rv;
 }
 
 libretrodb_cursor_t *libretrodb_cursor_new(void)
@@ -563,6 +1466,8 @@ libretrodb_cursor_t *libretrodb_cursor_new(void)
    if (!dbc)
       return NULL;
 
+   dbc->plan_pred = -1;
+
    return dbc;
 }
 
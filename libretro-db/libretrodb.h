@@ -35,6 +35,25 @@ int libretrodb_create_index(libretrodb_t *db, const char *name,
 int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
         const void *key, struct rmsgpack_dom_value *out);
 
+/**
+ * libretrodb_find_entry_raw:
+ * @db                  : Handle to database.
+ * @index_name          : Index to search.
+ * @key                 : Key, of the index's key size.
+ * @record              : Set to the encoded record.
+ * @len                 : Set to its length.
+ *
+ * Looks up the first record with @key without decoding it. Fields can
+ * be read in place with rmsgpack_raw_map_value(). For a mapped
+ * database nothing is read or allocated; @record points into the
+ * mapping and stays valid until the database is closed. Otherwise it's
+ * valid until the next lookup.
+ *
+ * Returns: 0 if found, otherwise negative.
+ **/
+int libretrodb_find_entry_raw(libretrodb_t *db, const char *index_name,
+      const void *key, const uint8_t **record, size_t *len);
+
 libretrodb_t *libretrodb_new(void);
 
 void libretrodb_free(libretrodb_t *db);
@@ -67,6 +86,27 @@ int libretrodb_cursor_open(libretrodb_t *db,
  **/
 int libretrodb_cursor_reset(libretrodb_cursor_t *cursor);
 
+/**
+ * libretrodb_cursor_tell:
+ * @cursor              : Handle to database cursor.
+ *
+ * Returns: file offset of the item the next
+ * libretrodb_cursor_read_item() call will read, or negative on error.
+ **/
+int64_t libretrodb_cursor_tell(libretrodb_cursor_t *cursor);
+
+/**
+ * libretrodb_cursor_seek:
+ * @cursor              : Handle to database cursor.
+ * @offset              : Item offset from libretrodb_cursor_tell().
+ *
+ * Moves the cursor to the item at @offset. Reading then carries on
+ * from there through the whole database, index scan or not.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_cursor_seek(libretrodb_cursor_t *cursor, uint64_t offset);
+
 /**
  * libretrodb_cursor_close:
  * @cursor              : Handle to database cursor.
@@ -75,6 +115,18 @@ int libretrodb_cursor_reset(libretrodb_cursor_t *cursor);
  **/
 void libretrodb_cursor_close(libretrodb_cursor_t *cursor);
 
+/**
+ * libretrodb_cursor_explain:
+ * @cursor              : Handle to an open database cursor.
+ * @s                   : Output buffer.
+ * @len                 : Size of @s.
+ *
+ * Describes how the cursor finds its records: the index lookup or full
+ * scan, and the field tests run before records are decoded.
+ **/
+void libretrodb_cursor_explain(libretrodb_cursor_t *cursor,
+      char *s, size_t len);
+
 void *libretrodb_query_compile(libretrodb_t *db, const char *query,
         size_t buff_len, const char **error);
 
@@ -83,6 +135,23 @@ void libretrodb_query_free(void *q);
 int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       struct rmsgpack_dom_value *out);
 
+/**
+ * libretrodb_cursor_read_raw:
+ * @cursor              : Handle to database cursor.
+ * @record              : Set to the next matching record, encoded.
+ * @len                 : Set to its length.
+ *
+ * Same as libretrodb_cursor_read_item() without decoding the record;
+ * read its fields in place with rmsgpack_raw_map_value() or
+ * rmsgpack_raw_map_begin(). For a mapped database @record points into
+ * the mapping, so nothing is allocated unless the query is more than
+ * plain field tests. @record is valid until the next read.
+ *
+ * Returns: 0 if successful, EOF at the end, otherwise negative.
+ **/
+int libretrodb_cursor_read_raw(libretrodb_cursor_t *cursor,
+      const uint8_t **record, size_t *len);
+
 #ifdef __cplusplus
 }
 #endif
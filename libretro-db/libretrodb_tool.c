@@ -20,6 +20,7 @@ int main(int argc, char ** argv)
       printf("\tlist\n");
       printf("\tcreate-index <index name> <field name>\n");
       printf("\tfind <query expression>\n");
+      printf("\texplain <query expression>\n");
       return 1;
    }
 
@@ -58,11 +59,12 @@ int main(int argc, char ** argv)
          rmsgpack_dom_value_free(&item);
       }
    }
-   else if (strcmp(command, "find") == 0)
+   else if (strcmp(command, "find") == 0 || strcmp(command, "explain") == 0)
    {
       if (argc != 4)
       {
-         printf("Usage: %s <db file> find <query expression>\n", argv[0]);
+         printf("Usage: %s <db file> %s <query expression>\n",
+               argv[0], command);
          goto error;
       }
 
@@ -82,11 +84,21 @@ int main(int argc, char ** argv)
          goto error;
       }
 
-      while (libretrodb_cursor_read_item(cur, &item) == 0)
+      if (strcmp(command, "explain") == 0)
       {
-         rmsgpack_dom_value_print(&item);
-         printf("\n");
-         rmsgpack_dom_value_free(&item);
+         char plan[1024];
+
+         libretrodb_cursor_explain(cur, plan, sizeof(plan));
+         printf("%s", plan);
+      }
+      else
+      {
+         while (libretrodb_cursor_read_item(cur, &item) == 0)
+         {
+            rmsgpack_dom_value_print(&item);
+            printf("\n");
+            rmsgpack_dom_value_free(&item);
+         }
       }
    }
    else if (strcmp(command, "create-index") == 0)
@@ -13,11 +13,15 @@
 
 #include "libretrodb.h"
 #include "query.h"
+#include "rmsgpack.h"
 #include "rmsgpack_dom.h"
 
 #define MAX_ERROR_LEN   256
 #define QUERY_MAX_ARGS  50
 
+/* Longest string the prefilter copies to glob against. */
+#define QUERY_MAX_GLOB_INPUT 1024
+
 struct buffer
 {
    const char *data;
@@ -56,10 +60,24 @@ struct argument
    } a;
 };
 
+/* A top-level field test the cursor can run on the encoded record,
+ * before the record is decoded. */
+struct query_pred
+{
+   libretrodb_query_pred_t pred;
+   rarch_query_func func;
+   unsigned argc;
+   const struct argument *argv;
+};
+
 struct query
 {
    unsigned ref_count;
    struct invocation root;
+   struct query_pred preds[QUERY_MAX_ARGS / 2];
+   unsigned num_preds;
+   /* Every part of the query is one of the field tests. */
+   bool complete;
 };
 
 struct registered_func
@@ -179,6 +197,8 @@ static void argument_free(struct argument *arg)
 
    for (i = 0; i < arg->a.invocation.argc; i++)
       argument_free(&arg->a.invocation.argv[i]);
+
+   free(arg->a.invocation.argv);
 }
 
 
@@ -881,6 +901,103 @@ static struct buffer parse_argument(struct buffer buff,
    return buff;
 }
 
+static unsigned query_pred_cost(const struct query_pred *pred)
+{
+   if (pred->pred.type == LIBRETRODB_PRED_GLOB)
+      return 3;
+   if (pred->pred.type == LIBRETRODB_PRED_BETWEEN)
+      return 1;
+
+   switch (pred->pred.args[0]->type)
+   {
+      case RDT_STRING:
+      case RDT_BINARY:
+         return 2;
+      default:
+         break;
+   }
+
+   return 0;
+}
+
+/* Pulls the field tests out of a {field: test, ...} query. Tests that
+ * aren't a plain value, between() or glob() are left to the full
+ * filter, which always runs on the records that pass these. */
+static void query_plan(struct query *q)
+{
+   unsigned i, j;
+
+   q->num_preds = 0;
+
+   if (q->root.func != all_map || q->root.argc % 2 != 0)
+      return;
+
+   for (i = 0; i < q->root.argc; i += 2)
+   {
+      const struct argument *key  = &q->root.argv[i];
+      const struct argument *arg  = &q->root.argv[i + 1];
+      struct query_pred *pred     = &q->preds[q->num_preds];
+
+      if (key->type != AT_VALUE || key->a.value.type != RDT_STRING)
+         continue;
+
+      pred->pred.field = &key->a.value;
+
+      if (arg->type == AT_VALUE)
+      {
+         pred->pred.type    = LIBRETRODB_PRED_EQUALS;
+         pred->pred.args[0] = &arg->a.value;
+         pred->pred.args[1] = NULL;
+         pred->func         = equals;
+         pred->argc         = 1;
+         pred->argv         = arg;
+      }
+      else if (arg->a.invocation.func == between
+            && arg->a.invocation.argc == 2
+            && arg->a.invocation.argv[0].type == AT_VALUE
+            && arg->a.invocation.argv[1].type == AT_VALUE
+            && arg->a.invocation.argv[0].a.value.type == RDT_INT
+            && arg->a.invocation.argv[1].a.value.type == RDT_INT)
+      {
+         pred->pred.type    = LIBRETRODB_PRED_BETWEEN;
+         pred->pred.args[0] = &arg->a.invocation.argv[0].a.value;
+         pred->pred.args[1] = &arg->a.invocation.argv[1].a.value;
+         pred->func         = between;
+         pred->argc         = 2;
+         pred->argv         = arg->a.invocation.argv;
+      }
+      else if (arg->a.invocation.func == q_glob
+            && arg->a.invocation.argc == 1
+            && arg->a.invocation.argv[0].type == AT_VALUE
+            && arg->a.invocation.argv[0].a.value.type == RDT_STRING)
+      {
+         pred->pred.type    = LIBRETRODB_PRED_GLOB;
+         pred->pred.args[0] = &arg->a.invocation.argv[0].a.value;
+         pred->pred.args[1] = NULL;
+         pred->func         = q_glob;
+         pred->argc         = 1;
+         pred->argv         = arg->a.invocation.argv;
+      }
+      else
+         continue;
+
+      q->num_preds++;
+   }
+
+   q->complete = (q->num_preds * 2 == q->root.argc);
+
+   /* Cheapest tests first, so most records are rejected by them. */
+   for (i = 1; i < q->num_preds; i++)
+   {
+      struct query_pred pred = q->preds[i];
+
+      for (j = i; j > 0 && query_pred_cost(&q->preds[j - 1])
+            > query_pred_cost(&pred); j--)
+         q->preds[j] = q->preds[j - 1];
+      q->preds[j] = pred;
+   }
+}
+
 void libretrodb_query_free(void *q)
 {
    unsigned i;
@@ -934,6 +1051,8 @@ void *libretrodb_query_compile(libretrodb_t *db,
       raise_unexpected_eof(buff.offset, error);
       return NULL;
    }
+
+   query_plan(q);
    goto success;
 clean:
    if (q)
@@ -957,3 +1076,181 @@ int libretrodb_query_filter(libretrodb_query_t *q,
    return (res.type == RDT_BOOL && res.val.bool_);
 }
 
+
+/**
+ * libretrodb_query_pred:
+ * @q                   : Query.
+ * @i                   : Index of the field test.
+ *
+ * Returns: the @i-th top-level field test of @q, or NULL past the last.
+ **/
+const libretrodb_query_pred_t *libretrodb_query_pred(libretrodb_query_t *q,
+      unsigned i)
+{
+   struct query *rq = (struct query*)q;
+
+   if (!rq || i >= rq->num_preds)
+      return NULL;
+   return &rq->preds[i].pred;
+}
+
+/**
+ * libretrodb_query_is_complete:
+ * @q                   : Query.
+ *
+ * Returns: true if @q is nothing but its field tests, so
+ * libretrodb_query_prefilter() settles it without decoding.
+ **/
+bool libretrodb_query_is_complete(libretrodb_query_t *q)
+{
+   struct query *rq = (struct query*)q;
+   return rq && rq->complete;
+}
+
+/**
+ * libretrodb_query_prefilter:
+ * @q                   : Query.
+ * @raw                 : Record as read by rmsgpack_read_raw().
+ * @len                 : Length of @raw.
+ *
+ * Runs the field tests of @q on an encoded record. When they are the
+ * whole query and settle it, the record needn't be decoded at all.
+ *
+ * Returns: 0 if the record can't match, 1 if it matches, -1 if it
+ * still has to go through libretrodb_query_filter().
+ **/
+int libretrodb_query_prefilter(libretrodb_query_t *q,
+      const uint8_t *raw, size_t len)
+{
+   unsigned i;
+   struct query *rq = (struct query*)q;
+   int ret          = rq->complete ? 1 : -1;
+
+   for (i = 0; i < rq->num_preds; i++)
+   {
+      struct rmsgpack_dom_value res;
+      struct rmsgpack_dom_value value;
+      char glob_input[QUERY_MAX_GLOB_INPUT];
+      const struct query_pred *pred = &rq->preds[i];
+      int rv = rmsgpack_raw_map_value(raw, len,
+            pred->pred.field->val.string.buff,
+            pred->pred.field->val.string.len, &value);
+
+      if (rv < 0)
+      {
+         ret = -1;
+         continue;
+      }
+
+      /* All missing fields are nil */
+      if (rv == 0)
+         value.type = RDT_NULL;
+
+      /* glob() needs a terminated string. */
+      if (pred->pred.type == LIBRETRODB_PRED_GLOB && value.type == RDT_STRING)
+      {
+         if (value.val.string.len >= sizeof(glob_input))
+         {
+            ret = -1;
+            continue;
+         }
+
+         memcpy(glob_input, value.val.string.buff, value.val.string.len);
+         glob_input[value.val.string.len] = '\0';
+         value.val.string.buff            = glob_input;
+      }
+
+      res = is_true(pred->func(value, pred->argc, pred->argv), 0, NULL);
+
+      if (!res.val.bool_)
+         return 0;
+   }
+
+   return ret;
+}
+
+static void query_value_describe(const struct rmsgpack_dom_value *v,
+      char *s, size_t len)
+{
+   uint32_t i;
+
+   switch (v->type)
+   {
+      case RDT_NULL:
+         strlcpy(s, "nil", len);
+         break;
+      case RDT_BOOL:
+         strlcpy(s, v->val.bool_ ? "true" : "false", len);
+         break;
+      case RDT_INT:
+         snprintf(s, len,
+#ifdef _WIN32
+               "%I64d",
+#else
+               "%lld",
+#endif
+               (long long)v->val.int_);
+         break;
+      case RDT_UINT:
+         snprintf(s, len,
+#ifdef _WIN32
+               "%I64u",
+#else
+               "%llu",
+#endif
+               (unsigned long long)v->val.uint_);
+         break;
+      case RDT_STRING:
+         snprintf(s, len, "\"%.*s\"",
+               (int)v->val.string.len, v->val.string.buff);
+         break;
+      case RDT_BINARY:
+         strlcpy(s, "b\"", len);
+         for (i = 0; i < v->val.binary.len; i++)
+         {
+            char hex[3];
+            snprintf(hex, sizeof(hex), "%02X",
+                  (unsigned)(uint8_t)v->val.binary.buff[i]);
+            strlcat(s, hex, len);
+         }
+         strlcat(s, "\"", len);
+         break;
+      default:
+         strlcpy(s, "?", len);
+         break;
+   }
+}
+
+/**
+ * libretrodb_query_pred_describe:
+ * @pred                : Field test.
+ * @s                   : Output buffer.
+ * @len                 : Size of @s.
+ *
+ * Writes @pred in a readable form, for EXPLAIN output.
+ **/
+void libretrodb_query_pred_describe(const libretrodb_query_pred_t *pred,
+      char *s, size_t len)
+{
+   char a[256], b[256];
+
+   query_value_describe(pred->args[0], a, sizeof(a));
+
+   switch (pred->type)
+   {
+      case LIBRETRODB_PRED_EQUALS:
+         snprintf(s, len, "%.*s = %s", (int)pred->field->val.string.len,
+               pred->field->val.string.buff, a);
+         break;
+      case LIBRETRODB_PRED_BETWEEN:
+         query_value_describe(pred->args[1], b, sizeof(b));
+         snprintf(s, len, "%.*s between %s and %s",
+               (int)pred->field->val.string.len,
+               pred->field->val.string.buff, a, b);
+         break;
+      case LIBRETRODB_PRED_GLOB:
+         snprintf(s, len, "%.*s glob %s", (int)pred->field->val.string.len,
+               pred->field->val.string.buff, a);
+         break;
+   }
+}
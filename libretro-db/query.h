@@ -1,6 +1,11 @@
 #ifndef __LIBRETRODB_QUERY_H__
 #define __LIBRETRODB_QUERY_H__
 
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+
 #include "libretrodb.h"
 #include "rmsgpack_dom.h"
 
@@ -10,12 +15,40 @@ extern "C" {
 
 typedef struct libretrodb_query libretrodb_query_t;
 
+enum libretrodb_query_pred_type
+{
+   LIBRETRODB_PRED_EQUALS = 0,
+   LIBRETRODB_PRED_BETWEEN,
+   LIBRETRODB_PRED_GLOB
+};
+
+/* Test on one top-level field, from a query of the form
+ * {field: value, field: between(a, b), field: glob(pattern), ...}. */
+typedef struct libretrodb_query_pred
+{
+   enum libretrodb_query_pred_type type;
+   const struct rmsgpack_dom_value *field;
+   /* EQUALS and GLOB use the first, BETWEEN both. */
+   const struct rmsgpack_dom_value *args[2];
+} libretrodb_query_pred_t;
+
 void libretrodb_query_inc_ref(libretrodb_query_t *q);
 
 void libretrodb_query_dec_ref(libretrodb_query_t *q);
 
 int libretrodb_query_filter(libretrodb_query_t *q, struct rmsgpack_dom_value *v);
 
+const libretrodb_query_pred_t *libretrodb_query_pred(libretrodb_query_t *q,
+      unsigned i);
+
+bool libretrodb_query_is_complete(libretrodb_query_t *q);
+
+int libretrodb_query_prefilter(libretrodb_query_t *q,
+      const uint8_t *raw, size_t len);
+
+void libretrodb_query_pred_describe(const libretrodb_query_pred_t *pred,
+      char *s, size_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,6 +23,7 @@
 #include <retro_endianness.h>
 
 #include "rmsgpack.h"
+#include "rmsgpack_dom.h"
 
 #define _MPF_FIXMAP     0x80
 #define _MPF_MAP16      0xde
@@ -644,3 +645,534 @@ int rmsgpack_read(RFILE *fd,
 error:
    return -errno;
 }
+
+static int read_raw_bytes(RFILE *fd, uint8_t **buff, size_t *size,
+      size_t *len, size_t count)
+{
+   if (*len + count > *size)
+   {
+      size_t new_size = *size ? *size : 256;
+      uint8_t *tmp    = NULL;
+
+      while (new_size < *len + count)
+         new_size *= 2;
+
+      tmp = (uint8_t*)realloc(*buff, new_size);
+      if (!tmp)
+         return -ENOMEM;
+
+      *buff = tmp;
+      *size = new_size;
+   }
+
+   if (count && retro_fread(fd, *buff + *len, count) != (ssize_t)count)
+      return -EINVAL;
+
+   *len += count;
+   return 0;
+}
+
+static uint64_t raw_uint(const uint8_t *p, size_t size)
+{
+   uint64_t value = 0;
+
+   while (size--)
+      value = (value << 8) | *p++;
+
+   return value;
+}
+
+/**
+ * rmsgpack_read_raw:
+ * @fd                  : File to read from.
+ * @buff                : Buffer for the value, grown as needed.
+ * @size                : Size of @buff.
+ * @len                 : Set to the encoded length of the value.
+ *
+ * Reads the encoded bytes of the next value, maps and arrays included,
+ * without decoding it, so it can be inspected with
+ * rmsgpack_raw_map_value() and skipped without any allocation.
+ *
+ * Returns: 0 on success, otherwise negative.
+ **/
+int rmsgpack_read_raw(RFILE *fd, uint8_t **buff, size_t *size, size_t *len)
+{
+   int rv;
+   uint64_t remaining = 1;
+
+   *len = 0;
+
+   while (remaining--)
+   {
+      uint8_t type;
+      size_t at = *len;
+
+      if ((rv = read_raw_bytes(fd, buff, size, len, 1)) < 0)
+         return rv;
+
+      type = (*buff)[at];
+
+      if (type < MPF_FIXMAP || type > MPF_MAP32)
+         continue;
+      else if (type < MPF_FIXARRAY)
+      {
+         remaining += 2 * (type - MPF_FIXMAP);
+         continue;
+      }
+      else if (type < MPF_FIXSTR)
+      {
+         remaining += type - MPF_FIXARRAY;
+         continue;
+      }
+      else if (type < MPF_NIL)
+      {
+         if ((rv = read_raw_bytes(fd, buff, size, len,
+                     type - MPF_FIXSTR)) < 0)
+            return rv;
+         continue;
+      }
+
+      switch (type)
+      {
+         case _MPF_NIL:
+         case _MPF_FALSE:
+         case _MPF_TRUE:
+            break;
+         case _MPF_BIN8:
+         case _MPF_BIN16:
+         case _MPF_BIN32:
+         case _MPF_STR8:
+         case _MPF_STR16:
+         case _MPF_STR32:
+            {
+               size_t width = (type <= _MPF_BIN32) ?
+                  (size_t)1 << (type - _MPF_BIN8) :
+                  (size_t)1 << (type - _MPF_STR8);
+
+               if ((rv = read_raw_bytes(fd, buff, size, len, width)) < 0)
+                  return rv;
+               if ((rv = read_raw_bytes(fd, buff, size, len,
+                           (size_t)raw_uint(*buff + at + 1, width))) < 0)
+                  return rv;
+            }
+            break;
+         case _MPF_UINT8:
+         case _MPF_UINT16:
+         case _MPF_UINT32:
+         case _MPF_UINT64:
+            if ((rv = read_raw_bytes(fd, buff, size, len,
+                        (size_t)1 << (type - _MPF_UINT8))) < 0)
+               return rv;
+            break;
+         case _MPF_INT8:
+         case _MPF_INT16:
+         case _MPF_INT32:
+         case _MPF_INT64:
+            if ((rv = read_raw_bytes(fd, buff, size, len,
+                        (size_t)1 << (type - _MPF_INT8))) < 0)
+               return rv;
+            break;
+         case _MPF_ARRAY16:
+         case _MPF_ARRAY32:
+         case _MPF_MAP16:
+         case _MPF_MAP32:
+            {
+               size_t width = (type == _MPF_ARRAY16 || type == _MPF_MAP16)
+                  ? 2 : 4;
+
+               if ((rv = read_raw_bytes(fd, buff, size, len, width)) < 0)
+                  return rv;
+
+               if (type == _MPF_ARRAY16 || type == _MPF_ARRAY32)
+                  remaining += raw_uint(*buff + at + 1, width);
+               else
+                  remaining += 2 * raw_uint(*buff + at + 1, width);
+            }
+            break;
+         default:
+            return -EINVAL;
+      }
+   }
+
+   return 0;
+}
+
+/* Decodes the header of the value at @p. Scalars, strings and
+ * binaries are decoded whole; strings and binaries point into the
+ * buffer. Maps and arrays only get their length, their items follow.
+ * Returns the end of what was decoded, or NULL if it's malformed. */
+static const uint8_t *raw_decode(const uint8_t *p, const uint8_t *end,
+      struct rmsgpack_dom_value *out)
+{
+   uint8_t type;
+   size_t width = 0;
+
+   if (p >= end)
+      return NULL;
+
+   type = *p++;
+
+   if (type < MPF_FIXMAP)
+   {
+      out->type     = RDT_INT;
+      out->val.int_ = type;
+      return p;
+   }
+   else if (type > MPF_MAP32)
+   {
+      out->type     = RDT_INT;
+      out->val.int_ = (int8_t)type;
+      return p;
+   }
+   else if (type < MPF_FIXARRAY)
+   {
+      out->type        = RDT_MAP;
+      out->val.map.len = type - MPF_FIXMAP;
+      return p;
+   }
+   else if (type < MPF_FIXSTR)
+   {
+      out->type          = RDT_ARRAY;
+      out->val.array.len = type - MPF_FIXARRAY;
+      return p;
+   }
+   else if (type < MPF_NIL)
+   {
+      out->type            = RDT_STRING;
+      out->val.string.len  = type - MPF_FIXSTR;
+      out->val.string.buff = (char*)p;
+      p                   += out->val.string.len;
+      return (p <= end) ? p : NULL;
+   }
+
+   switch (type)
+   {
+      case _MPF_NIL:
+         out->type = RDT_NULL;
+         return p;
+      case _MPF_FALSE:
+      case _MPF_TRUE:
+         out->type      = RDT_BOOL;
+         out->val.bool_ = (type == _MPF_TRUE);
+         return p;
+      case _MPF_BIN8:
+      case _MPF_BIN16:
+      case _MPF_BIN32:
+      case _MPF_STR8:
+      case _MPF_STR16:
+      case _MPF_STR32:
+         width = (type <= _MPF_BIN32) ?
+            (size_t)1 << (type - _MPF_BIN8) :
+            (size_t)1 << (type - _MPF_STR8);
+         if (p + width > end)
+            return NULL;
+         out->type            = (type <= _MPF_BIN32) ? RDT_BINARY : RDT_STRING;
+         out->val.string.len  = (uint32_t)raw_uint(p, width);
+         out->val.string.buff = (char*)p + width;
+         p                   += width + out->val.string.len;
+         return (p <= end) ? p : NULL;
+      case _MPF_UINT8:
+      case _MPF_UINT16:
+      case _MPF_UINT32:
+      case _MPF_UINT64:
+         width = (size_t)1 << (type - _MPF_UINT8);
+         if (p + width > end)
+            return NULL;
+         out->type      = RDT_UINT;
+         out->val.uint_ = raw_uint(p, width);
+         return p + width;
+      case _MPF_INT8:
+      case _MPF_INT16:
+      case _MPF_INT32:
+      case _MPF_INT64:
+         width = (size_t)1 << (type - _MPF_INT8);
+         if (p + width > end)
+            return NULL;
+         out->type = RDT_INT;
+         switch (width)
+         {
+            case 1:
+               out->val.int_ = (int8_t)raw_uint(p, width);
+               break;
+            case 2:
+               out->val.int_ = (int16_t)raw_uint(p, width);
+               break;
+            case 4:
+               out->val.int_ = (int32_t)raw_uint(p, width);
+               break;
+            default:
+               out->val.int_ = (int64_t)raw_uint(p, width);
+               break;
+         }
+         return p + width;
+      case _MPF_ARRAY16:
+      case _MPF_ARRAY32:
+      case _MPF_MAP16:
+      case _MPF_MAP32:
+         width = (type == _MPF_ARRAY16 || type == _MPF_MAP16) ? 2 : 4;
+         if (p + width > end)
+            return NULL;
+         if (type == _MPF_ARRAY16 || type == _MPF_ARRAY32)
+         {
+            out->type          = RDT_ARRAY;
+            out->val.array.len = (uint32_t)raw_uint(p, width);
+         }
+         else
+         {
+            out->type        = RDT_MAP;
+            out->val.map.len = (uint32_t)raw_uint(p, width);
+         }
+         return p + width;
+   }
+
+   return NULL;
+}
+
+static const uint8_t *raw_skip(const uint8_t *p, const uint8_t *end)
+{
+   uint64_t remaining = 1;
+
+   while (remaining--)
+   {
+      struct rmsgpack_dom_value value;
+
+      if (!(p = raw_decode(p, end, &value)))
+         return NULL;
+
+      if (value.type == RDT_MAP)
+         remaining += 2 * (uint64_t)value.val.map.len;
+      else if (value.type == RDT_ARRAY)
+         remaining += value.val.array.len;
+   }
+
+   return p;
+}
+
+/**
+ * rmsgpack_raw_size:
+ * @buff                : Encoded values.
+ * @len                 : Length of @buff.
+ *
+ * Returns: encoded length of the value at the start of @buff, maps and
+ * arrays included, or 0 if it's malformed or runs past @len.
+ **/
+size_t rmsgpack_raw_size(const uint8_t *buff, size_t len)
+{
+   const uint8_t *end = raw_skip(buff, buff + len);
+
+   if (!end)
+      return 0;
+   return (size_t)(end - buff);
+}
+
+/**
+ * rmsgpack_raw_map_begin:
+ * @iter                : Iterator to set up.
+ * @buff                : Encoded map.
+ * @len                 : Length of @buff.
+ *
+ * Returns: 0 if @buff holds a map, otherwise negative.
+ **/
+int rmsgpack_raw_map_begin(struct rmsgpack_raw_map_iter *iter,
+      const uint8_t *buff, size_t len)
+{
+   struct rmsgpack_dom_value map;
+
+   iter->end       = buff + len;
+   iter->remaining = 0;
+   iter->p         = raw_decode(buff, iter->end, &map);
+
+   if (!iter->p || map.type != RDT_MAP)
+      return -EINVAL;
+
+   iter->remaining = map.val.map.len;
+   return 0;
+}
+
+/**
+ * rmsgpack_raw_map_next:
+ * @iter                : Iterator from rmsgpack_raw_map_begin().
+ * @key                 : Set to the next key.
+ * @value               : Set to its value.
+ *
+ * Strings and binaries point into the map and must not be freed. Maps
+ * and arrays only come back with their length.
+ *
+ * Returns: 1 if @key and @value were set, 0 at the end of the map,
+ * negative if it's malformed.
+ **/
+int rmsgpack_raw_map_next(struct rmsgpack_raw_map_iter *iter,
+      struct rmsgpack_dom_value *key, struct rmsgpack_dom_value *value)
+{
+   const uint8_t *p = NULL;
+
+   if (!iter->remaining)
+      return 0;
+
+   if (     !(p = raw_decode(iter->p, iter->end, key))
+         || !(p = raw_skip(iter->p, iter->end))
+         || !raw_decode(p, iter->end, value)
+         || !(iter->p = raw_skip(p, iter->end)))
+   {
+      iter->remaining = 0;
+      return -EINVAL;
+   }
+
+   iter->remaining--;
+   return 1;
+}
+
+/**
+ * rmsgpack_raw_map_value:
+ * @buff                : Map read by rmsgpack_read_raw().
+ * @len                 : Length of @buff.
+ * @key                 : String key to look for.
+ * @key_len             : Length of @key.
+ * @value               : Set to the value of @key. Strings and binaries
+ *                        point into @buff and must not be freed.
+ *
+ * Returns: 1 if @key was found and holds a scalar, string or binary,
+ * 0 if it's missing, negative if @buff isn't a map or the value is a
+ * map or an array.
+ **/
+int rmsgpack_raw_map_value(const uint8_t *buff, size_t len,
+      const char *key, uint32_t key_len, struct rmsgpack_dom_value *value)
+{
+   uint32_t i;
+   struct rmsgpack_dom_value map;
+   const uint8_t *end = buff + len;
+   const uint8_t *p   = raw_decode(buff, end, &map);
+
+   if (!p || map.type != RDT_MAP)
+      return -EINVAL;
+
+   for (i = 0; i < map.val.map.len; i++)
+   {
+      struct rmsgpack_dom_value item_key;
+
+      if (!(p = raw_decode(p, end, &item_key)))
+         return -EINVAL;
+
+      if (     item_key.type == RDT_STRING
+            && item_key.val.string.len == key_len
+            && memcmp(item_key.val.string.buff, key, key_len) == 0)
+      {
+         if (!raw_decode(p, end, value))
+            return -EINVAL;
+         if (value->type == RDT_MAP || value->type == RDT_ARRAY)
+            return -EINVAL;
+         return 1;
+      }
+
+      if (item_key.type == RDT_MAP || item_key.type == RDT_ARRAY)
+         return -EINVAL;
+
+      if (!(p = raw_skip(p, end)))
+         return -EINVAL;
+   }
+
+   return 0;
+}
+
+/**
+ * rmsgpack_raw_is_nil:
+ * @buff                : Value read by rmsgpack_read_raw().
+ * @len                 : Length of @buff.
+ *
+ * Returns: 1 if the value is nil, otherwise 0.
+ **/
+int rmsgpack_raw_is_nil(const uint8_t *buff, size_t len)
+{
+   return len == 1 && buff[0] == MPF_NIL;
+}
+
+static int raw_read_value(const struct rmsgpack_dom_value *value,
+      struct rmsgpack_read_callbacks *callbacks, void *data)
+{
+   char *buff = NULL;
+
+   switch (value->type)
+   {
+      case RDT_NULL:
+         if (callbacks->read_nil)
+            return callbacks->read_nil(data);
+         break;
+      case RDT_BOOL:
+         if (callbacks->read_bool)
+            return callbacks->read_bool(value->val.bool_, data);
+         break;
+      case RDT_INT:
+         if (callbacks->read_int)
+            return callbacks->read_int(value->val.int_, data);
+         break;
+      case RDT_UINT:
+         if (callbacks->read_uint)
+            return callbacks->read_uint(value->val.uint_, data);
+         break;
+      case RDT_STRING:
+      case RDT_BINARY:
+         if (value->type == RDT_STRING ?
+               !callbacks->read_string : !callbacks->read_bin)
+            break;
+
+         /* Callbacks own what they get, like with rmsgpack_read(). */
+         buff = (char*)malloc(value->val.string.len + 1);
+         if (!buff)
+            return -ENOMEM;
+         memcpy(buff, value->val.string.buff, value->val.string.len);
+         buff[value->val.string.len] = '\0';
+
+         if (value->type == RDT_STRING)
+            return callbacks->read_string(buff, value->val.string.len, data);
+         return callbacks->read_bin(buff, value->val.binary.len, data);
+      case RDT_MAP:
+         if (callbacks->read_map_start)
+            return callbacks->read_map_start(value->val.map.len, data);
+         break;
+      case RDT_ARRAY:
+         if (callbacks->read_array_start)
+            return callbacks->read_array_start(value->val.array.len, data);
+         break;
+   }
+
+   return 0;
+}
+
+/**
+ * rmsgpack_raw_read:
+ * @buff                : Value read by rmsgpack_read_raw().
+ * @len                 : Length of @buff.
+ * @callbacks           : Same as for rmsgpack_read().
+ * @data                : Passed to @callbacks.
+ *
+ * Decodes a value already in memory, calling @callbacks in the same
+ * order rmsgpack_read() would.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int rmsgpack_raw_read(const uint8_t *buff, size_t len,
+      struct rmsgpack_read_callbacks *callbacks, void *data)
+{
+   int rv;
+   const uint8_t *p   = buff;
+   const uint8_t *end = buff + len;
+   uint64_t remaining = 1;
+
+   while (remaining--)
+   {
+      struct rmsgpack_dom_value value;
+
+      if (!(p = raw_decode(p, end, &value)))
+         return -EINVAL;
+
+      if (value.type == RDT_MAP)
+         remaining += 2 * (uint64_t)value.val.map.len;
+      else if (value.type == RDT_ARRAY)
+         remaining += value.val.array.len;
+
+      if ((rv = raw_read_value(&value, callbacks, data)) < 0)
+         return rv;
+   }
+
+   return 0;
+}
@@ -2,9 +2,12 @@
 #define __RARCHDB_MSGPACK_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include <retro_file.h>
 
+struct rmsgpack_dom_value;
+
 struct rmsgpack_read_callbacks
 {
    int (*read_nil        )(void *);
@@ -17,6 +20,15 @@ struct rmsgpack_read_callbacks
    int (*read_array_start)(uint32_t, void *);
 };
 
+/* Walks an encoded map without decoding it, see
+ * rmsgpack_raw_map_begin(). */
+struct rmsgpack_raw_map_iter
+{
+   const uint8_t *p;
+   const uint8_t *end;
+   uint32_t remaining;
+};
+
 int rmsgpack_write_array_header(RFILE *fd, uint32_t size);
 
 int rmsgpack_write_map_header(RFILE *fd, uint32_t size);
@@ -35,5 +47,23 @@ int rmsgpack_write_uint(RFILE *fd, uint64_t value );
 
 int rmsgpack_read(RFILE *fd, struct rmsgpack_read_callbacks *callbacks, void *data);
 
+int rmsgpack_read_raw(RFILE *fd, uint8_t **buff, size_t *size, size_t *len);
+
+int rmsgpack_raw_map_value(const uint8_t *buff, size_t len,
+      const char *key, uint32_t key_len, struct rmsgpack_dom_value *value);
+
+int rmsgpack_raw_is_nil(const uint8_t *buff, size_t len);
+
+size_t rmsgpack_raw_size(const uint8_t *buff, size_t len);
+
+int rmsgpack_raw_map_begin(struct rmsgpack_raw_map_iter *iter,
+      const uint8_t *buff, size_t len);
+
+int rmsgpack_raw_map_next(struct rmsgpack_raw_map_iter *iter,
+      struct rmsgpack_dom_value *key, struct rmsgpack_dom_value *value);
+
+int rmsgpack_raw_read(const uint8_t *buff, size_t len,
+      struct rmsgpack_read_callbacks *callbacks, void *data);
+
 #endif
 
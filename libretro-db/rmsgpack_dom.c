@@ -404,6 +404,33 @@ int rmsgpack_dom_read(RFILE *fd, struct rmsgpack_dom_value *out)
    return rv;
 }
 
+/**
+ * rmsgpack_dom_read_raw:
+ * @buff                : Value read by rmsgpack_read_raw().
+ * @len                 : Length of @buff.
+ * @out                 : Filled with the value.
+ *
+ * Same as rmsgpack_dom_read(), for a value already in memory.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int rmsgpack_dom_read_raw(const uint8_t *buff, size_t len,
+      struct rmsgpack_dom_value *out)
+{
+   struct dom_reader_state s;
+   int rv = 0;
+
+   s.i        = 0;
+   s.stack[0] = out;
+
+   rv = rmsgpack_raw_read(buff, len, &dom_reader_callbacks, &s);
+
+   if (rv < 0)
+      rmsgpack_dom_value_free(out);
+
+   return rv;
+}
+
 int rmsgpack_dom_read_into(RFILE *fd, ...)
 {
    va_list ap;
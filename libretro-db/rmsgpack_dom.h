@@ -2,6 +2,7 @@
 #define __RARCHDB_MSGPACK_DOM_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include <retro_file.h>
 
@@ -70,6 +71,9 @@ struct rmsgpack_dom_value *rmsgpack_dom_value_map_value(
 
 int rmsgpack_dom_read(RFILE *fd, struct rmsgpack_dom_value *out);
 
+int rmsgpack_dom_read_raw(const uint8_t *buff, size_t len,
+      struct rmsgpack_dom_value *out);
+
 int rmsgpack_dom_write(RFILE *fd, const struct rmsgpack_dom_value *obj);
 
 int rmsgpack_dom_read_into(RFILE *fd, ...);
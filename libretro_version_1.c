@@ -53,6 +53,7 @@ static void video_frame(const void *data, unsigned width,
       unsigned height, size_t pitch)
 {
    uint64_t *frame_count  = NULL;
+   retro_time_t output_start, output_time;
    unsigned output_width  = 0;
    unsigned output_height = 0;
    unsigned  output_pitch = 0;
@@ -104,10 +105,15 @@ static void video_frame(const void *data, unsigned width,
 
    frame_count = video_driver_get_frame_count();
 
+   output_start = retro_get_time_usec();
+
    if (!video->frame(driver->video_data, data, width, height, *frame_count,
             pitch, driver->current_msg))
       driver->video_active = false;
 
+   output_time = retro_get_time_usec() - output_start;
+   rarch_main_ctl(RARCH_MAIN_CTL_ADD_OUTPUT_TIME, &output_time);
+
    *frame_count = *frame_count + 1;
 }
 
@@ -392,6 +392,12 @@ static const char *menu_hash_to_str_us_label(uint32_t hash)
          return "video_monitor_index";
       case MENU_LABEL_VIDEO_FRAME_DELAY:
          return "video_frame_delay";
+      case MENU_LABEL_VIDEO_FRAME_DELAY_AUTO:
+         return "video_frame_delay_auto";
+      case MENU_LABEL_RUN_AHEAD_ENABLE:
+         return "run_ahead_enable";
+      case MENU_LABEL_RUN_AHEAD_FRAMES:
+         return "run_ahead_frames";
       case MENU_LABEL_INPUT_DUTY_CYCLE:
          return "input_duty_cycle";
       case MENU_LABEL_INPUT_TURBO_PERIOD:
@@ -408,6 +414,8 @@ static const char *menu_hash_to_str_us_label(uint32_t hash)
          return "audio_output_rate";
       case MENU_LABEL_AUDIO_MAX_TIMING_SKEW:
          return "audio_max_timing_skew";
+      case MENU_LABEL_AUDIO_RESAMPLER_QUALITY:
+         return "audio_resampler_quality";
       case MENU_LABEL_CHEAT_APPLY_CHANGES:
          return "cheat_apply_changes";
       case MENU_LABEL_REMAP_FILE_SAVE_CORE:
@@ -500,6 +508,12 @@ static const char *menu_hash_to_str_us_label(uint32_t hash)
          return "load_open_zip";
       case MENU_LABEL_REWIND_GRANULARITY:
          return "rewind_granularity";
+      case MENU_LABEL_REWIND_THREADED:
+         return "rewind_threaded";
+      case MENU_LABEL_REWIND_KEYFRAME_INTERVAL:
+         return "rewind_keyframe_interval";
+      case MENU_LABEL_REWIND_PERSISTENT:
+         return "rewind_persistent";
       case MENU_LABEL_REMAP_FILE_LOAD:
          return "remap_file_load";
       case MENU_LABEL_REMAP_FILE_SAVE_AS:
@@ -1092,6 +1106,12 @@ const char *menu_hash_to_str_us(uint32_t hash)
          return "Monitor Index";
       case MENU_LABEL_VALUE_VIDEO_FRAME_DELAY:
          return "Frame Delay";
+      case MENU_LABEL_VALUE_VIDEO_FRAME_DELAY_AUTO:
+         return "Automatic Frame Delay";
+      case MENU_LABEL_VALUE_RUN_AHEAD_ENABLE:
+         return "Run-Ahead";
+      case MENU_LABEL_VALUE_RUN_AHEAD_FRAMES:
+         return "Run-Ahead Frames";
       case MENU_LABEL_VALUE_INPUT_DUTY_CYCLE:
          return "Duty Cycle";
       case MENU_LABEL_VALUE_INPUT_TURBO_PERIOD:
@@ -1108,6 +1128,8 @@ const char *menu_hash_to_str_us(uint32_t hash)
          return "Audio Output Rate (KHz)";
       case MENU_LABEL_VALUE_AUDIO_MAX_TIMING_SKEW:
          return "Audio Maximum Timing Skew";
+      case MENU_LABEL_VALUE_AUDIO_RESAMPLER_QUALITY:
+         return "Audio Resampler Quality";
       case MENU_LABEL_VALUE_CHEAT_NUM_PASSES:
          return "Cheat Passes";
       case MENU_LABEL_VALUE_REMAP_FILE_SAVE_CORE:
@@ -1148,6 +1170,12 @@ const char *menu_hash_to_str_us(uint32_t hash)
          return "Load Configuration";
       case MENU_LABEL_VALUE_REWIND_GRANULARITY:
          return "Rewind Granularity";
+      case MENU_LABEL_VALUE_REWIND_THREADED:
+         return "Threaded Rewind";
+      case MENU_LABEL_VALUE_REWIND_KEYFRAME_INTERVAL:
+         return "Rewind Keyframe Interval";
+      case MENU_LABEL_VALUE_REWIND_PERSISTENT:
+         return "Persistent Rewind History";
       case MENU_LABEL_VALUE_REMAP_FILE_LOAD:
          return "Load Remap File";
       case MENU_LABEL_VALUE_REMAP_FILE_SAVE_AS:
@@ -2256,6 +2284,13 @@ int menu_hash_get_help_us(uint32_t hash, char *s, size_t len)
                " Input rate is defined as: \n"
                " input rate * (1.0 +/- (max timing skew))");
          break;
+      case MENU_LABEL_AUDIO_RESAMPLER_QUALITY:
+         snprintf(s, len,
+               "Quality of the sinc resampler.\n"
+               " \n"
+               "Higher quality filters out more aliasing\n"
+               "but costs more CPU time.");
+         break;
       case MENU_LABEL_OVERLAY_NEXT:
          snprintf(s, len,
                "Toggles to next overlay.\n"
@@ -2332,6 +2367,37 @@ int menu_hash_get_help_us(uint32_t hash, char *s, size_t len)
                "at a time, increasing the rewinding \n"
                "speed.");
          break;
+      case MENU_LABEL_REWIND_THREADED:
+         snprintf(s, len,
+               "Threaded rewind compression. \n"
+               " \n"
+               "Compresses rewind deltas on a separate \n"
+               "thread while the next frame runs. \n"
+               " \n"
+               "Reduces the per-frame cost of rewind \n"
+               "for cores with large save states.");
+         break;
+      case MENU_LABEL_REWIND_KEYFRAME_INTERVAL:
+         snprintf(s, len,
+               "Rewind keyframe interval. \n"
+               " \n"
+               "Stores a full save state every N rewind \n"
+               "steps, so rewinding far back in one go \n"
+               "does not have to go through every step \n"
+               "in between. \n"
+               " \n"
+               "0 disables keyframes.");
+         break;
+      case MENU_LABEL_REWIND_PERSISTENT:
+         snprintf(s, len,
+               "Persistent rewind history. \n"
+               " \n"
+               "Keeps the rewind buffer in a file next to \n"
+               "the save states instead of in memory. \n"
+               " \n"
+               "Allows for much larger rewind buffers, \n"
+               "and the history is kept across sessions.");
+         break;
       case MENU_LABEL_SCREENSHOT:
          snprintf(s, len,
                "Take screenshot.");
@@ -2346,6 +2412,37 @@ int menu_hash_get_help_us(uint32_t hash, char *s, size_t len)
                " \n"
                "Maximum is 15.");
          break;
+      case MENU_LABEL_VIDEO_FRAME_DELAY_AUTO:
+         snprintf(s, len,
+               "Picks the frame delay every frame \n"
+               "from how long the core took to run \n"
+               "over the last frames. \n"
+               " \n"
+               "Backs off when the core gets slower \n"
+               "or a frame is missed. Overrides \n"
+               "Frame Delay.");
+         break;
+      case MENU_LABEL_RUN_AHEAD_ENABLE:
+         snprintf(s, len,
+               "Runs the core ahead every frame \n"
+               "and shows the last of the hidden \n"
+               "frames, then loads the state from \n"
+               "before them again. \n"
+               " \n"
+               "Hides the input lag of the game \n"
+               "itself, at the cost of running the \n"
+               "core several times per frame. \n"
+               " \n"
+               "Needs save state support.");
+         break;
+      case MENU_LABEL_RUN_AHEAD_FRAMES:
+         snprintf(s, len,
+               "Number of frames to run ahead. \n"
+               " \n"
+               "Should match the number of lag \n"
+               "frames of the game, more than that \n"
+               "visibly skips frames.");
+         break;
       case MENU_LABEL_VIDEO_HARD_SYNC_FRAMES:
          snprintf(s, len,
                "Sets how many frames CPU can \n"
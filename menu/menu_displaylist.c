@@ -1103,7 +1103,7 @@ static int create_string_list_rdb_entry_int(const char *desc, const char *label,
 static int menu_displaylist_parse_database_entry(menu_displaylist_info_t *info)
 {
 #ifdef HAVE_LIBRETRODB
-   unsigned i, j, k;
+   unsigned i, k;
    char path_playlist[PATH_MAX_LENGTH];
    content_playlist_t *playlist        = NULL;
    database_info_list_t *db_info       = NULL;
@@ -1148,48 +1148,36 @@ static int menu_displaylist_parse_database_entry(menu_displaylist_info_t *info)
 
       if (playlist)
       {
-         for (j = 0; j < playlist->size; j++)
+         unsigned h;
+         size_t idx                = 0;
+         size_t last               = 0;
+         char key[PATH_MAX_LENGTH] = {0};
+         bool match_found          = false;
+         const char *hashes[3];
+         static const char *hash_types[3] = { "crc", "sha1", "md5" };
+
+         hashes[0] = crc_str;
+         hashes[1] = db_info_entry->sha1;
+         hashes[2] = db_info_entry->md5;
+
+         /* The scanner tags entries with whichever hash matched.
+          * The last entry matching any of them is selected. */
+         for (h = 0; h < 3; h++)
          {
-            char elem0[PATH_MAX_LENGTH]      = {0};
-            char elem1[PATH_MAX_LENGTH]      = {0};
-            bool match_found                 = false;
-            struct string_list *tmp_str_list = string_split(
-                  playlist->entries[j].crc32, "|");
-            uint32_t hash_value              = 0;
-
-            if (!tmp_str_list)
+            if (!hashes[h])
                continue;
 
-            if (tmp_str_list->size > 0)
-               strlcpy(elem0, tmp_str_list->elems[0].data, sizeof(elem0));
-            if (tmp_str_list->size > 1)
-               strlcpy(elem1, tmp_str_list->elems[1].data, sizeof(elem1));
-
-            hash_value = menu_hash_calculate(elem1);
-
-            switch (hash_value)
-            {
-               case MENU_VALUE_CRC:
-                  if (!strcmp(crc_str, elem0))
-                     match_found = true;
-                  break;
-               case MENU_VALUE_SHA1:
-                  if (!strcmp(db_info_entry->sha1, elem0))
-                     match_found = true;
-                  break;
-               case MENU_VALUE_MD5:
-                  if (!strcmp(db_info_entry->md5, elem0))
-                     match_found = true;
-                  break;
-            }
-
-            string_list_free(tmp_str_list);
-
-            if (!match_found)
+            snprintf(key, sizeof(key), "%s|%s", hashes[h], hash_types[h]);
+            if (!content_playlist_find_crc32(playlist, key, &idx))
                continue;
 
-            rdb_entry_start_game_selection_ptr = j;
+            if (!match_found || idx > last)
+               last = idx;
+            match_found = true;
          }
+
+         if (match_found)
+            rdb_entry_start_game_selection_ptr = last;
       }
 
       if (db_info_entry->name)
@@ -300,9 +300,21 @@ extern "C" {
 #define MENU_LABEL_VALUE_VIDEO_HARD_SYNC_FRAMES                                0x1edcab0bU
 #define MENU_LABEL_VIDEO_FRAME_DELAY                                           0xd4aa9df4U
 #define MENU_LABEL_VALUE_VIDEO_FRAME_DELAY                                     0x990d36bfU
+#define MENU_LABEL_VIDEO_FRAME_DELAY_AUTO                                      0xc8edc02cU
+#define MENU_LABEL_VALUE_VIDEO_FRAME_DELAY_AUTO                                0x8ead5406U
+#define MENU_LABEL_RUN_AHEAD_ENABLE                                            0xfa550a72U
+#define MENU_LABEL_VALUE_RUN_AHEAD_ENABLE                                      0xbd6041baU
+#define MENU_LABEL_RUN_AHEAD_FRAMES                                            0xfcf2c309U
+#define MENU_LABEL_VALUE_RUN_AHEAD_FRAMES                                      0x9b1877f8U
 #define MENU_LABEL_SCREENSHOT                                                  0x9a37f083U
 #define MENU_LABEL_REWIND_GRANULARITY                                          0xe859cbdfU
 #define MENU_LABEL_VALUE_REWIND_GRANULARITY                                    0x6e1ae4c0U
+#define MENU_LABEL_REWIND_THREADED                                             0x2931d74eU
+#define MENU_LABEL_VALUE_REWIND_THREADED                                       0xa809228fU
+#define MENU_LABEL_REWIND_KEYFRAME_INTERVAL                                    0xbb6c7e65U
+#define MENU_LABEL_VALUE_REWIND_KEYFRAME_INTERVAL                              0xb8b490a7U
+#define MENU_LABEL_REWIND_PERSISTENT                                           0x18d59efeU
+#define MENU_LABEL_VALUE_REWIND_PERSISTENT                                     0x11e5faf1U
 #define MENU_LABEL_VALUE_VIDEO_ROTATION                                        0x9efcecf5U
 #define MENU_LABEL_THREADED_DATA_RUNLOOP_ENABLE                                0xdf5c6d33U
 #define MENU_LABEL_VALUE_THREADED_DATA_RUNLOOP_ENABLE                          0x04d8c10fU
@@ -416,6 +428,8 @@ extern "C" {
 #define MENU_LABEL_VALUE_AUDIO_RATE_CONTROL_DELTA                              0x8d242b0eU
 #define MENU_LABEL_AUDIO_MAX_TIMING_SKEW                                       0x4c96f75cU
 #define MENU_LABEL_VALUE_AUDIO_MAX_TIMING_SKEW                                 0x8e873f6eU
+#define MENU_LABEL_AUDIO_RESAMPLER_QUALITY                                     0x965f4909U
+#define MENU_LABEL_VALUE_AUDIO_RESAMPLER_QUALITY                               0xd981cf2bU
 
 #define MENU_LABEL_INPUT_PLAYER1_JOYPAD_INDEX                                  0xfad6ab2fU
 #define MENU_LABEL_INPUT_PLAYER2_JOYPAD_INDEX                                  0x3616e4d0U
@@ -1746,6 +1746,37 @@ static void setting_get_string_representation_uint_aspect_ratio_index(void *data
             len);
 }
 
+static void setting_get_string_representation_uint_audio_resampler_quality(
+      void *data, char *s, size_t len)
+{
+   rarch_setting_t *setting = (rarch_setting_t*)data;
+
+   if (!setting)
+      return;
+
+   switch (*setting->value.unsigned_integer)
+   {
+      case RESAMPLER_QUALITY_LOWEST:
+         strlcpy(s, "Lowest", len);
+         break;
+      case RESAMPLER_QUALITY_LOWER:
+         strlcpy(s, "Lower", len);
+         break;
+      case RESAMPLER_QUALITY_NORMAL:
+         strlcpy(s, "Normal", len);
+         break;
+      case RESAMPLER_QUALITY_HIGHER:
+         strlcpy(s, "Higher", len);
+         break;
+      case RESAMPLER_QUALITY_HIGHEST:
+         strlcpy(s, "Highest", len);
+         break;
+      default:
+         strlcpy(s, "Default", len);
+         break;
+   }
+}
+
 static void setting_get_string_representation_uint_libretro_device(void *data,
       char *s, size_t len)
 {
@@ -2604,6 +2635,7 @@ static void general_write_handler(void *data)
          audio_driver_set_volume_gain(db_to_gain(*setting->value.fraction));
          break;
       case MENU_LABEL_AUDIO_LATENCY:
+      case MENU_LABEL_AUDIO_RESAMPLER_QUALITY:
          rarch_cmd = EVENT_CMD_AUDIO_REINIT;
          break;
       case MENU_LABEL_PAL60_ENABLE:
@@ -3809,6 +3841,51 @@ static bool setting_append_list_rewind_options(
    menu_settings_list_current_add_range(list, list_info, 1, 32768, 1, true, false);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+#ifdef HAVE_THREADS
+   CONFIG_BOOL(
+         settings->rewind_threaded,
+         menu_hash_to_str(MENU_LABEL_REWIND_THREADED),
+         menu_hash_to_str(MENU_LABEL_VALUE_REWIND_THREADED),
+         rewind_threaded,
+         menu_hash_to_str(MENU_VALUE_OFF),
+         menu_hash_to_str(MENU_VALUE_ON),
+         group_info.name,
+         subgroup_info.name,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+#endif
+
+   CONFIG_UINT(
+         settings->rewind_keyframe_interval,
+         menu_hash_to_str(MENU_LABEL_REWIND_KEYFRAME_INTERVAL),
+         menu_hash_to_str(MENU_LABEL_VALUE_REWIND_KEYFRAME_INTERVAL),
+         rewind_keyframe_interval,
+         group_info.name,
+         subgroup_info.name,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   menu_settings_list_current_add_range(list, list_info, 0, 32768, 60, true, false);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+#ifdef HAVE_MMAP
+   CONFIG_BOOL(
+         settings->rewind_persistent,
+         menu_hash_to_str(MENU_LABEL_REWIND_PERSISTENT),
+         menu_hash_to_str(MENU_LABEL_VALUE_REWIND_PERSISTENT),
+         rewind_persistent,
+         menu_hash_to_str(MENU_VALUE_OFF),
+         menu_hash_to_str(MENU_VALUE_ON),
+         group_info.name,
+         subgroup_info.name,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+#endif
+
    END_SUB_GROUP(list, list_info, parent_group);
    END_GROUP(list, list_info, parent_group);
 
@@ -4424,6 +4501,47 @@ static bool setting_append_list_video_options(
    menu_settings_list_current_add_range(list, list_info, 0, 15, 1, true, true);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_BOOL(
+         settings->video.frame_delay_auto,
+         menu_hash_to_str(MENU_LABEL_VIDEO_FRAME_DELAY_AUTO),
+         menu_hash_to_str(MENU_LABEL_VALUE_VIDEO_FRAME_DELAY_AUTO),
+         frame_delay_auto,
+         menu_hash_to_str(MENU_VALUE_OFF),
+         menu_hash_to_str(MENU_VALUE_ON),
+         group_info.name,
+         subgroup_info.name,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+   CONFIG_BOOL(
+         settings->run_ahead_enable,
+         menu_hash_to_str(MENU_LABEL_RUN_AHEAD_ENABLE),
+         menu_hash_to_str(MENU_LABEL_VALUE_RUN_AHEAD_ENABLE),
+         run_ahead_enable,
+         menu_hash_to_str(MENU_VALUE_OFF),
+         menu_hash_to_str(MENU_VALUE_ON),
+         group_info.name,
+         subgroup_info.name,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+   CONFIG_UINT(
+         settings->run_ahead_frames,
+         menu_hash_to_str(MENU_LABEL_RUN_AHEAD_FRAMES),
+         menu_hash_to_str(MENU_LABEL_VALUE_RUN_AHEAD_FRAMES),
+         run_ahead_frames,
+         group_info.name,
+         subgroup_info.name,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   menu_settings_list_current_add_range(list, list_info, 1, 6, 1, true, true);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
 #if !defined(RARCH_MOBILE)
    CONFIG_BOOL(
          settings->video.black_frame_insertion,
@@ -4785,6 +4903,22 @@ static bool setting_append_list_audio_options(
          true);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_UINT(
+         settings->audio.resampler_quality,
+         menu_hash_to_str(MENU_LABEL_AUDIO_RESAMPLER_QUALITY),
+         menu_hash_to_str(MENU_LABEL_VALUE_AUDIO_RESAMPLER_QUALITY),
+         audio_resampler_quality,
+         group_info.name,
+         subgroup_info.name,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   menu_settings_list_current_add_range(list, list_info,
+         RESAMPLER_QUALITY_LOWEST, RESAMPLER_QUALITY_HIGHEST, 1, true, true);
+   (*list)[list_info->index - 1].get_string_representation = 
+      &setting_get_string_representation_uint_audio_resampler_quality;
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
    CONFIG_UINT(
          settings->audio.block_frames,
          menu_hash_to_str(MENU_LABEL_AUDIO_BLOCK_FRAMES),
@@ -57,6 +57,7 @@
 
 #define MSG_TAKING_SCREENSHOT                         0xdcfda0e0U
 #define MSG_FAILED_TO_TAKE_SCREENSHOT                 0x7a480a2dU
+#define MSG_SCREENSHOT_SAVED_TO                       0xa2bca7f7U
 
 #define MSG_CUSTOM_TIMING_GIVEN                       0x259c95dfU
 
@@ -21,10 +21,359 @@
 
 #include <boolean.h>
 #include <compat/posix_string.h>
+#include <retro_endianness.h>
+#include <retro_file.h>
 #include <retro_log.h>
+#include <rhash.h>
 
 #include "playlist.h"
 
+/* Compact playlist format, integers are little-endian:
+ *
+ *   "RPLB", uint32 version, uint32 entry count, then for every entry
+ *   its path and crc32 hashes as uint32, and path, label, core path,
+ *   core name, crc32 and db name, each as a uint32 length followed by
+ *   the string and its NUL. Length 0 is an unset field, and
+ *   PLAYLIST_COMPACT_REPEAT repeats the field of the entry before,
+ *   which is what core and db names mostly do.
+ *
+ * Strings are used in place from the file contents and the stored
+ * hashes go straight into the indexes, so loading is a single read
+ * and no copies or hashing. */
+#define PLAYLIST_COMPACT_MAGIC   "RPLB"
+#define PLAYLIST_COMPACT_VERSION 1
+#define PLAYLIST_COMPACT_REPEAT  0xffffffffU
+
+#ifndef PLAYLIST_ENTRIES
+#define PLAYLIST_ENTRIES 6
+#endif
+
+/* Index slots map a key hash to a stamp rather than to a position,
+ * since pushing to the top moves every entry down by one. An entry
+ * sits at playlist->stamp minus its stamp, so a push only bumps
+ * playlist->stamp. Stamps start at 1, 0 marks an empty slot. */
+struct content_playlist_slot
+{
+   uint32_t hash;
+   size_t stamp;
+};
+
+static uint32_t content_playlist_hash(const char *str)
+{
+   uint32_t hash = djb2_calculate(str ? str : "");
+
+   /* djb2 leaves the low bits of similar paths close together. */
+   hash ^= hash >> 16;
+   hash *= 0x85ebca6bU;
+   hash ^= hash >> 13;
+   return hash;
+}
+
+static bool content_playlist_string_equal(const char *a, const char *b)
+{
+   if (!a || !b)
+      return a == b;
+   return !strcmp(a, b);
+}
+
+static bool content_playlist_index_grow(content_playlist_index_t *index)
+{
+   size_t i;
+   size_t size = index->size ? index->size * 2 : 64;
+   struct content_playlist_slot *slots = (struct content_playlist_slot*)
+      calloc(size, sizeof(*slots));
+
+   if (!slots)
+      return false;
+
+   for (i = 0; i < index->size; i++)
+   {
+      size_t j;
+
+      if (!index->slots[i].stamp)
+         continue;
+
+      for (j = index->slots[i].hash & (size - 1); slots[j].stamp;
+            j = (j + 1) & (size - 1));
+      slots[j] = index->slots[i];
+   }
+
+   free(index->slots);
+   index->slots = slots;
+   index->size  = size;
+   return true;
+}
+
+static bool content_playlist_index_insert(content_playlist_index_t *index,
+      uint32_t hash, size_t stamp)
+{
+   size_t i, mask;
+
+   if ((index->count + 1) * 2 > index->size
+         && !content_playlist_index_grow(index))
+      return false;
+
+   mask = index->size - 1;
+   for (i = hash & mask; index->slots[i].stamp; i = (i + 1) & mask);
+
+   index->slots[i].hash  = hash;
+   index->slots[i].stamp = stamp;
+   index->count++;
+   return true;
+}
+
+static struct content_playlist_slot *content_playlist_index_slot(
+      const content_playlist_index_t *index, uint32_t hash, size_t stamp)
+{
+   size_t i, mask;
+
+   if (!index->size)
+      return NULL;
+
+   mask = index->size - 1;
+   for (i = hash & mask; index->slots[i].stamp; i = (i + 1) & mask)
+   {
+      if (index->slots[i].stamp == stamp)
+         return &index->slots[i];
+   }
+
+   return NULL;
+}
+
+static void content_playlist_index_remove(content_playlist_index_t *index,
+      uint32_t hash, size_t stamp)
+{
+   size_t i, j, mask;
+   struct content_playlist_slot *slot =
+      content_playlist_index_slot(index, hash, stamp);
+
+   if (!slot)
+      return;
+
+   /* Shift the rest of the run back so probes never stop early. */
+   mask = index->size - 1;
+   i    = slot - index->slots;
+
+   for (j = (i + 1) & mask; index->slots[j].stamp; j = (j + 1) & mask)
+   {
+      size_t home = index->slots[j].hash & mask;
+
+      if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+         continue;
+
+      index->slots[i] = index->slots[j];
+      i               = j;
+   }
+
+   index->slots[i].stamp = 0;
+   index->count--;
+}
+
+static void content_playlist_index_entry(content_playlist_t *playlist,
+      size_t idx)
+{
+   const content_playlist_entry_t *entry = &playlist->entries[idx];
+   size_t stamp                          = playlist->stamp - idx;
+
+   if (!playlist->indexed)
+      return;
+
+   if (!content_playlist_index_insert(&playlist->path_index,
+            entry->path_hash, stamp))
+      playlist->indexed = false;
+   else if (entry->crc32 && !content_playlist_index_insert(
+            &playlist->crc32_index, entry->crc32_hash, stamp))
+      playlist->indexed = false;
+}
+
+static void content_playlist_unindex_entry(content_playlist_t *playlist,
+      size_t idx)
+{
+   const content_playlist_entry_t *entry = &playlist->entries[idx];
+   size_t stamp                          = playlist->stamp - idx;
+
+   if (!playlist->indexed)
+      return;
+
+   content_playlist_index_remove(&playlist->path_index,
+         entry->path_hash, stamp);
+   if (entry->crc32)
+      content_playlist_index_remove(&playlist->crc32_index,
+            entry->crc32_hash, stamp);
+}
+
+static void content_playlist_restamp_entry(content_playlist_t *playlist,
+      size_t idx, size_t stamp)
+{
+   struct content_playlist_slot *slot    = NULL;
+   const content_playlist_entry_t *entry = &playlist->entries[idx];
+
+   if (!playlist->indexed)
+      return;
+
+   slot = content_playlist_index_slot(&playlist->path_index,
+         entry->path_hash, playlist->stamp - idx);
+   if (slot)
+      slot->stamp = stamp;
+
+   if (!entry->crc32)
+      return;
+
+   slot = content_playlist_index_slot(&playlist->crc32_index,
+         entry->crc32_hash, playlist->stamp - idx);
+   if (slot)
+      slot->stamp = stamp;
+}
+
+/* Empties @index, sized so @count keys go in without growing. */
+static void content_playlist_index_reset(content_playlist_index_t *index,
+      size_t count)
+{
+   size_t size = 64;
+
+   while (size < (count + 1) * 2)
+      size *= 2;
+
+   if (size > index->size)
+   {
+      free(index->slots);
+      index->slots = (struct content_playlist_slot*)
+         calloc(size, sizeof(*index->slots));
+      index->size  = index->slots ? size : 0;
+   }
+   else if (index->slots)
+      memset(index->slots, 0, index->size * sizeof(*index->slots));
+
+   index->count = 0;
+}
+
+static void content_playlist_reindex(content_playlist_t *playlist)
+{
+   size_t i;
+
+   content_playlist_index_reset(&playlist->path_index, playlist->size);
+   content_playlist_index_reset(&playlist->crc32_index, playlist->size);
+
+   playlist->stamp   = playlist->size;
+   playlist->indexed = true;
+
+   for (i = 0; i < playlist->size; i++)
+      content_playlist_index_entry(playlist, i);
+}
+
+/* Lowest index of an entry with @path, and @core_path if set. */
+static bool content_playlist_find_path(content_playlist_t *playlist,
+      const char *path, const char *core_path, size_t *idx)
+{
+   size_t i, mask;
+   size_t best   = 0;
+   uint32_t hash = 0;
+   bool found    = false;
+
+   if (!playlist->indexed)
+   {
+      for (i = 0; i < playlist->size; i++)
+      {
+         if (!content_playlist_string_equal(playlist->entries[i].path, path))
+            continue;
+         if (core_path && strcmp(playlist->entries[i].core_path, core_path))
+            continue;
+
+         *idx = i;
+         return true;
+      }
+
+      return false;
+   }
+
+   if (!playlist->path_index.size)
+      return false;
+
+   hash = content_playlist_hash(path);
+   mask = playlist->path_index.size - 1;
+
+   for (i = hash & mask; playlist->path_index.slots[i].stamp;
+         i = (i + 1) & mask)
+   {
+      const struct content_playlist_slot *slot = &playlist->path_index.slots[i];
+      size_t pos = playlist->stamp - slot->stamp;
+
+      if (slot->hash != hash || (found && pos > best))
+         continue;
+      if (!content_playlist_string_equal(playlist->entries[pos].path, path))
+         continue;
+      if (core_path && strcmp(playlist->entries[pos].core_path, core_path))
+         continue;
+
+      best  = pos;
+      found = true;
+   }
+
+   if (found)
+      *idx = best;
+   return found;
+}
+
+/**
+ * content_playlist_find_crc32:
+ * @playlist            : Playlist handle.
+ * @crc32               : crc32 field to look for, e.g. "1234ABCD|crc".
+ * @idx                 : Set to the index of the last matching entry.
+ *
+ * Returns: true if an entry matched, otherwise false.
+ **/
+bool content_playlist_find_crc32(content_playlist_t *playlist,
+      const char *crc32, size_t *idx)
+{
+   size_t i, mask;
+   size_t best   = 0;
+   uint32_t hash = 0;
+   bool found    = false;
+
+   if (!playlist || !crc32)
+      return false;
+
+   if (!playlist->indexed)
+   {
+      for (i = playlist->size; i-- > 0; )
+      {
+         if (!playlist->entries[i].crc32
+               || strcmp(playlist->entries[i].crc32, crc32))
+            continue;
+
+         *idx = i;
+         return true;
+      }
+
+      return false;
+   }
+
+   if (!playlist->crc32_index.size)
+      return false;
+
+   hash = content_playlist_hash(crc32);
+   mask = playlist->crc32_index.size - 1;
+
+   for (i = hash & mask; playlist->crc32_index.slots[i].stamp;
+         i = (i + 1) & mask)
+   {
+      const struct content_playlist_slot *slot = &playlist->crc32_index.slots[i];
+      size_t pos = playlist->stamp - slot->stamp;
+
+      if (slot->hash != hash || (found && pos < best))
+         continue;
+      if (strcmp(playlist->entries[pos].crc32, crc32))
+         continue;
+
+      best  = pos;
+      found = true;
+   }
+
+   if (found)
+      *idx = best;
+   return found;
+}
+
 /**
  * content_playlist_get_index:
  * @playlist        	   : Playlist handle.
@@ -32,8 +381,8 @@
  * @path                : Path of playlist entry.
  * @core_path           : Core path of playlist entry.
  * @core_name           : Core name of playlist entry.
- * 
- * Gets values of playlist index: 
+ *
+ * Gets values of playlist index:
  **/
 void content_playlist_get_index(content_playlist_t *playlist,
       size_t idx,
@@ -70,64 +419,66 @@ void content_playlist_get_index_by_path(content_playlist_t *playlist,
    if (!playlist)
       return;
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      if (strcmp(playlist->entries[i].path, search_path) != 0)
-         continue;
+   if (!content_playlist_find_path(playlist, search_path, NULL, &i))
+      return;
 
-      if (path)
-         *path      = playlist->entries[i].path;
-      if (label)
-         *label     = playlist->entries[i].label;
-      if (core_path)
-         *core_path = playlist->entries[i].core_path;
-      if (core_name)
-         *core_name = playlist->entries[i].core_name;
-      if (db_name)
-         *db_name   = playlist->entries[i].db_name;
-      if (crc32)
-         *crc32     = playlist->entries[i].crc32;
-      break;
-   }
+   if (path)
+      *path      = playlist->entries[i].path;
+   if (label)
+      *label     = playlist->entries[i].label;
+   if (core_path)
+      *core_path = playlist->entries[i].core_path;
+   if (core_name)
+      *core_name = playlist->entries[i].core_name;
+   if (db_name)
+      *db_name   = playlist->entries[i].db_name;
+   if (crc32)
+      *crc32     = playlist->entries[i].crc32;
+}
 
+static void content_playlist_free_string(content_playlist_t *playlist,
+      char *str)
+{
+   /* Strings read from the playlist file live in playlist->buf. */
+   if (str && (!playlist->buf || str < playlist->buf
+            || str >= playlist->buf + playlist->buf_size))
+      free(str);
 }
 
 /**
  * content_playlist_free_entry:
+ * @playlist        	   : Playlist handle.
  * @entry           	   : Playlist entry handle.
  *
  * Frees playlist entry.
  **/
-static void content_playlist_free_entry(content_playlist_entry_t *entry)
+static void content_playlist_free_entry(content_playlist_t *playlist,
+      content_playlist_entry_t *entry)
 {
    if (!entry)
       return;
 
-   if (entry->path)
-      free(entry->path);
-   entry->path = NULL;
-
-   if (entry->label)
-      free(entry->label);
-   entry->label = NULL;
-
-   if (entry->core_path)
-      free(entry->core_path);
-   entry->core_path = NULL;
+   content_playlist_free_string(playlist, entry->path);
+   content_playlist_free_string(playlist, entry->label);
+   content_playlist_free_string(playlist, entry->core_path);
+   content_playlist_free_string(playlist, entry->core_name);
+   content_playlist_free_string(playlist, entry->db_name);
+   content_playlist_free_string(playlist, entry->crc32);
 
-   if (entry->core_name)
-      free(entry->core_name);
-   entry->core_name = NULL;
+   memset(entry, 0, sizeof(*entry));
+}
 
-   if (entry->db_name)
-      free(entry->db_name);
-   entry->core_name = NULL;
+static void content_playlist_update_string(content_playlist_t *playlist,
+      char **str, const char *val)
+{
+   char *old = *str;
 
-   if (entry->crc32)
-      free(entry->crc32);
-   entry->crc32 = NULL;
+   /* Callers pass the entry's own strings for fields they keep. */
+   if (!val || val == old)
+      return;
 
-   memset(entry, 0, sizeof(*entry));
+   *str = strdup(val);
+   content_playlist_free_string(playlist, old);
 }
 
 void content_playlist_update(content_playlist_t *playlist, size_t idx,
@@ -139,20 +490,24 @@ void content_playlist_update(content_playlist_t *playlist, size_t idx,
    content_playlist_entry_t *entry = NULL;
    if (!playlist)
       return;
-   if (idx > playlist->size)
+   if (idx >= playlist->size)
       return;
 
    entry = &playlist->entries[idx];
-   
-   if (!entry)
-      return;
 
-   entry->path      = path ?  strdup(path)          : entry->path;
-   entry->label     = label ? strdup(label)         : entry->label;
-   entry->core_path = core_path ? strdup(core_path) : entry->core_path;
-   entry->core_name = core_name ? strdup(core_name) : entry->core_name;
-   entry->db_name   = db_name ? strdup(db_name)     : entry->db_name;
-   entry->crc32     = crc32 ? strdup(crc32)         : entry->crc32;
+   content_playlist_unindex_entry(playlist, idx);
+
+   content_playlist_update_string(playlist, &entry->path,      path);
+   content_playlist_update_string(playlist, &entry->label,     label);
+   content_playlist_update_string(playlist, &entry->core_path, core_path);
+   content_playlist_update_string(playlist, &entry->core_name, core_name);
+   content_playlist_update_string(playlist, &entry->db_name,   db_name);
+   content_playlist_update_string(playlist, &entry->crc32,     crc32);
+
+   entry->path_hash  = content_playlist_hash(entry->path);
+   entry->crc32_hash = content_playlist_hash(entry->crc32);
+
+   content_playlist_index_entry(playlist, idx);
 }
 
 /**
@@ -172,7 +527,7 @@ void content_playlist_push(content_playlist_t *playlist,
 {
    size_t i;
 
-   if (!playlist)
+   if (!playlist || !playlist->cap)
       return;
 
    if (!core_path || !*core_path || !core_name || !*core_name)
@@ -184,43 +539,43 @@ void content_playlist_push(content_playlist_t *playlist,
    if (path && !*path)
       path = NULL;
 
-   for (i = 0; i < playlist->size; i++)
+   /* Core name can have changed while still being the same core.
+    * Differentiate based on the core path only. */
+   if (content_playlist_find_path(playlist, path, core_path, &i))
    {
+      size_t j;
       content_playlist_entry_t tmp;
-      bool equal_path = (!path && !playlist->entries[i].path) ||
-         (path && playlist->entries[i].path &&
-          !strcmp(path,playlist->entries[i].path));
-
-      /* Core name can have changed while still being the same core.
-       * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
-      if (strcmp(playlist->entries[i].core_path, core_path))
-         continue;
 
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
       if (i == 0)
          return;
 
-      /* Seen it before, bump to top. */
+      /* Seen it before, bump to top. Everything above it moves
+       * down one, so takes the stamp of the entry below. */
+      content_playlist_unindex_entry(playlist, i);
+      for (j = i; j-- > 0; )
+         content_playlist_restamp_entry(playlist, j, playlist->stamp - j - 1);
+
       tmp = playlist->entries[i];
       memmove(playlist->entries + 1, playlist->entries,
 		      i * sizeof(content_playlist_entry_t));
       playlist->entries[0] = tmp;
 
+      content_playlist_index_entry(playlist, 0);
       return;
    }
 
    if (playlist->size == playlist->cap)
    {
-      content_playlist_free_entry(&playlist->entries[playlist->cap - 1]);
+      content_playlist_unindex_entry(playlist, playlist->cap - 1);
+      content_playlist_free_entry(playlist,
+            &playlist->entries[playlist->cap - 1]);
       playlist->size--;
    }
 
    memmove(playlist->entries + 1, playlist->entries,
-         (playlist->cap - 1) * sizeof(content_playlist_entry_t));
+         playlist->size * sizeof(content_playlist_entry_t));
 
    playlist->entries[0].path      = path ? strdup(path) : NULL;
    playlist->entries[0].label     = label ? strdup(label) : NULL;
@@ -228,7 +583,60 @@ void content_playlist_push(content_playlist_t *playlist,
    playlist->entries[0].core_name = core_name ? strdup(core_name) : NULL;
    playlist->entries[0].db_name   = db_name ? strdup(db_name) : NULL;
    playlist->entries[0].crc32     = crc32 ? strdup(crc32) : NULL;
+   playlist->entries[0].path_hash  = content_playlist_hash(path);
+   playlist->entries[0].crc32_hash = content_playlist_hash(crc32);
    playlist->size++;
+   playlist->stamp++;
+
+   content_playlist_index_entry(playlist, 0);
+}
+
+static void content_playlist_write_uint32(FILE *file, uint32_t val)
+{
+   val = swap_if_big32(val);
+   fwrite(&val, sizeof(val), 1, file);
+}
+
+static void content_playlist_write_string(FILE *file, const char *str,
+      const char *prev)
+{
+   uint32_t len = str ? (uint32_t)strlen(str) : 0;
+
+   if (len && prev && !strcmp(str, prev))
+   {
+      content_playlist_write_uint32(file, PLAYLIST_COMPACT_REPEAT);
+      return;
+   }
+
+   content_playlist_write_uint32(file, len);
+   if (len)
+      fwrite(str, 1, len + 1, file);
+}
+
+static void content_playlist_write_compact(content_playlist_t *playlist,
+      FILE *file)
+{
+   size_t i;
+   const content_playlist_entry_t none = {0};
+
+   fwrite(PLAYLIST_COMPACT_MAGIC, 1, 4, file);
+   content_playlist_write_uint32(file, PLAYLIST_COMPACT_VERSION);
+   content_playlist_write_uint32(file, (uint32_t)playlist->size);
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      const content_playlist_entry_t *entry = &playlist->entries[i];
+      const content_playlist_entry_t *prev  = i ? entry - 1 : &none;
+
+      content_playlist_write_uint32(file, entry->path_hash);
+      content_playlist_write_uint32(file, entry->crc32_hash);
+      content_playlist_write_string(file, entry->path,      prev->path);
+      content_playlist_write_string(file, entry->label,     prev->label);
+      content_playlist_write_string(file, entry->core_path, prev->core_path);
+      content_playlist_write_string(file, entry->core_name, prev->core_name);
+      content_playlist_write_string(file, entry->crc32,     prev->crc32);
+      content_playlist_write_string(file, entry->db_name,   prev->db_name);
+   }
 }
 
 void content_playlist_write_file(content_playlist_t *playlist)
@@ -239,20 +647,25 @@ void content_playlist_write_file(content_playlist_t *playlist)
    if (!playlist)
       return;
 
-   file = fopen(playlist->conf_path, "w");
+   file = fopen(playlist->conf_path, "wb");
 
    if (!file)
       return;
 
-   for (i = 0; i < playlist->size; i++)
-      fprintf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
-            playlist->entries[i].path  ? playlist->entries[i].path : "",
-            playlist->entries[i].label ? playlist->entries[i].label : "",
-            playlist->entries[i].core_path,
-            playlist->entries[i].core_name,
-            playlist->entries[i].crc32 ? playlist->entries[i].crc32 : "",
-            playlist->entries[i].db_name ? playlist->entries[i].db_name : ""
-            );
+   if (playlist->compact)
+      content_playlist_write_compact(playlist, file);
+   else
+   {
+      for (i = 0; i < playlist->size; i++)
+         fprintf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
+               playlist->entries[i].path  ? playlist->entries[i].path : "",
+               playlist->entries[i].label ? playlist->entries[i].label : "",
+               playlist->entries[i].core_path,
+               playlist->entries[i].core_name,
+               playlist->entries[i].crc32 ? playlist->entries[i].crc32 : "",
+               playlist->entries[i].db_name ? playlist->entries[i].db_name : ""
+               );
+   }
 
    fclose(file);
 }
@@ -275,12 +688,18 @@ void content_playlist_free(content_playlist_t *playlist)
 
    playlist->conf_path = NULL;
 
-   for (i = 0; i < playlist->cap; i++)
-      content_playlist_free_entry(&playlist->entries[i]);
+   if (playlist->entries)
+   {
+      for (i = 0; i < playlist->size; i++)
+         content_playlist_free_entry(playlist, &playlist->entries[i]);
+   }
 
    free(playlist->entries);
    playlist->entries = NULL;
 
+   free(playlist->path_index.slots);
+   free(playlist->crc32_index.slots);
+   free(playlist->buf);
    free(playlist);
 }
 
@@ -296,9 +715,15 @@ void content_playlist_clear(content_playlist_t *playlist)
    if (!playlist)
       return;
 
-   for (i = 0; i < playlist->cap; i++)
-      content_playlist_free_entry(&playlist->entries[i]);
+   for (i = 0; i < playlist->size; i++)
+      content_playlist_free_entry(playlist, &playlist->entries[i]);
    playlist->size = 0;
+
+   free(playlist->buf);
+   playlist->buf      = NULL;
+   playlist->buf_size = 0;
+
+   content_playlist_reindex(playlist);
 }
 
 /**
@@ -315,59 +740,172 @@ size_t content_playlist_size(content_playlist_t *playlist)
    return playlist->size;
 }
 
-#ifndef PLAYLIST_ENTRIES
-#define PLAYLIST_ENTRIES 6
-#endif
-
-static bool content_playlist_read_file(
-      content_playlist_t *playlist, const char *path)
+static void content_playlist_read_text(content_playlist_t *playlist)
 {
-   unsigned i;
-   char buf[PLAYLIST_ENTRIES][1024] = {{0}};
-   content_playlist_entry_t *entry  = NULL;
-   char *last                       = NULL;
-   FILE *file                       = fopen(path, "r");
-
-   /* If playlist file does not exist,
-    * create an empty playlist instead.
-    */
-   if (!file)
-      return true;
+   char *line = playlist->buf;
+   char *end  = playlist->buf + playlist->buf_size;
 
-   for (playlist->size = 0; playlist->size < playlist->cap; )
+   while (playlist->size < playlist->cap)
    {
+      unsigned i;
+      char *buf[PLAYLIST_ENTRIES];
+      content_playlist_entry_t *entry = NULL;
+
       for (i = 0; i < PLAYLIST_ENTRIES; i++)
       {
-         *buf[i] = '\0';
+         char *last = NULL;
 
-         if (!fgets(buf[i], sizeof(buf[i]), file))
-            goto end;
+         if (line >= end)
+            return;
 
-         last = strrchr(buf[i], '\n');
+         buf[i] = line;
+         last   = (char*)memchr(line, '\n', end - line);
          if (last)
+         {
             *last = '\0';
+            line  = last + 1;
+         }
+         else
+         {
+            last  = end;
+            line  = end;
+         }
+
+         /* Playlists written in text mode on Windows end in CRLF. */
+         if (last > buf[i] && last[-1] == '\r')
+            last[-1] = '\0';
       }
 
-      entry = &playlist->entries[playlist->size];
-
       if (!*buf[2] || !*buf[3])
          continue;
 
-      if (*buf[0])
-         entry->path      = strdup(buf[0]);
-      if (*buf[1])
-         entry->label     = strdup(buf[1]);
-      entry->core_path    = strdup(buf[2]);
-      entry->core_name    = strdup(buf[3]);
-      if (*buf[4])
-         entry->crc32     = strdup(buf[4]);
-      if (*buf[5])
-         entry->db_name   = strdup(buf[5]);
-      playlist->size++;
+      entry            = &playlist->entries[playlist->size++];
+      entry->path      = *buf[0] ? buf[0] : NULL;
+      entry->label     = *buf[1] ? buf[1] : NULL;
+      entry->core_path = buf[2];
+      entry->core_name = buf[3];
+      entry->crc32     = *buf[4] ? buf[4] : NULL;
+      entry->db_name   = *buf[5] ? buf[5] : NULL;
+      entry->path_hash  = content_playlist_hash(entry->path);
+      entry->crc32_hash = content_playlist_hash(entry->crc32);
    }
+}
+
+static uint32_t content_playlist_read_uint32(char **ptr, const char *end,
+      bool *ok)
+{
+   uint32_t val = 0;
+
+   if (!*ok || end - *ptr < (ptrdiff_t)sizeof(val))
+   {
+      *ok = false;
+      return 0;
+   }
+
+   memcpy(&val, *ptr, sizeof(val));
+   *ptr += sizeof(val);
+   return swap_if_big32(val);
+}
+
+static char *content_playlist_read_string(char **ptr, const char *end,
+      char *prev, bool *ok)
+{
+   char *str    = NULL;
+   uint32_t len = content_playlist_read_uint32(ptr, end, ok);
+
+   if (!*ok || !len)
+      return NULL;
+
+   if (len == PLAYLIST_COMPACT_REPEAT)
+   {
+      if (!prev)
+         *ok = false;
+      return prev;
+   }
+
+   str = *ptr;
+
+   if ((size_t)(end - str) <= len || str[len] != '\0')
+   {
+      *ok = false;
+      return NULL;
+   }
+
+   *ptr = str + len + 1;
+   return str;
+}
+
+static void content_playlist_read_compact(content_playlist_t *playlist)
+{
+   size_t i, count;
+   content_playlist_entry_t prev = {0};
+   char *ptr                     = playlist->buf + 4;
+   const char *end               = playlist->buf + playlist->buf_size;
+   bool ok                       = true;
+
+   if (content_playlist_read_uint32(&ptr, end, &ok)
+         != PLAYLIST_COMPACT_VERSION)
+   {
+      RARCH_ERR("Unsupported compact playlist version.\n");
+      return;
+   }
+
+   count = content_playlist_read_uint32(&ptr, end, &ok);
+
+   for (i = 0; i < count && playlist->size < playlist->cap; i++)
+   {
+      content_playlist_entry_t entry;
+
+      entry.path_hash  = content_playlist_read_uint32(&ptr, end, &ok);
+      entry.crc32_hash = content_playlist_read_uint32(&ptr, end, &ok);
+      entry.path       = content_playlist_read_string(&ptr, end, prev.path,      &ok);
+      entry.label      = content_playlist_read_string(&ptr, end, prev.label,     &ok);
+      entry.core_path  = content_playlist_read_string(&ptr, end, prev.core_path, &ok);
+      entry.core_name  = content_playlist_read_string(&ptr, end, prev.core_name, &ok);
+      entry.crc32      = content_playlist_read_string(&ptr, end, prev.crc32,     &ok);
+      entry.db_name    = content_playlist_read_string(&ptr, end, prev.db_name,   &ok);
+
+      if (!ok)
+      {
+         RARCH_ERR("Truncated compact playlist.\n");
+         return;
+      }
+
+      prev = entry;
+
+      if (!entry.core_path || !entry.core_name)
+         continue;
+
+      playlist->entries[playlist->size++] = entry;
+   }
+}
+
+static bool content_playlist_read_file(
+      content_playlist_t *playlist, const char *path)
+{
+   void *buf   = NULL;
+   ssize_t len = 0;
+
+   /* If playlist file does not exist,
+    * create an empty playlist instead.
+    */
+   if (retro_read_file(path, &buf, &len) <= 0 || len <= 0)
+   {
+      free(buf);
+      return true;
+   }
+
+   playlist->buf      = (char*)buf;
+   playlist->buf_size = len;
+
+   if (len >= 4 && !memcmp(buf, PLAYLIST_COMPACT_MAGIC, 4))
+   {
+      playlist->compact = true;
+      content_playlist_read_compact(playlist);
+   }
+   else
+      content_playlist_read_text(playlist);
 
-end:
-   fclose(file);
    return true;
 }
 
@@ -395,6 +933,7 @@ content_playlist_t *content_playlist_init(const char *path, size_t size)
    playlist->cap = size;
 
    content_playlist_read_file(playlist, path);
+   content_playlist_reindex(playlist);
 
    playlist->conf_path = strdup(path);
    return playlist;
@@ -408,4 +947,5 @@ void content_playlist_qsort(content_playlist_t *playlist, content_playlist_sort_
 {
    qsort(playlist->entries, playlist->size, sizeof(content_playlist_entry_t),
          (int (*)(const void *, const void *))fn);
+   content_playlist_reindex(playlist);
 }
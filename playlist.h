@@ -19,6 +19,9 @@
 #define CONTENT_HISTORY_H__
 
 #include <stddef.h>
+#include <stdint.h>
+
+#include <boolean.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,8 +35,22 @@ typedef struct content_playlist_entry
    char *core_name;
    char *db_name;
    char *crc32;
+
+   /* Index keys, kept with the entry so moving it
+    * around doesn't mean hashing its strings again. */
+   uint32_t path_hash;
+   uint32_t crc32_hash;
 } content_playlist_entry_t;
 
+struct content_playlist_slot;
+
+typedef struct content_playlist_index
+{
+   struct content_playlist_slot *slots;
+   size_t size;
+   size_t count;
+} content_playlist_index_t;
+
 typedef struct content_playlist
 {
    struct content_playlist_entry *entries;
@@ -41,6 +58,22 @@ typedef struct content_playlist
    size_t cap;
 
    char *conf_path;
+
+   /* Entries by path and by crc32 field. Lookups walk
+    * the entries instead when indexed is false. */
+   content_playlist_index_t path_index;
+   content_playlist_index_t crc32_index;
+   size_t stamp;
+   bool indexed;
+
+   /* Contents of the file the playlist was read from.
+    * Entry strings pointing into it are not owned. */
+   char *buf;
+   size_t buf_size;
+
+   /* Write the compact binary format instead of text.
+    * Set when the playlist was read from a compact file. */
+   bool compact;
 } content_playlist_t;
 
 typedef int (content_playlist_sort_fun_t)(const content_playlist_entry_t *a,
@@ -96,8 +129,8 @@ void content_playlist_get_index(content_playlist_t *playlist,
       size_t idx,
       const char **path, const char **label,
       const char **core_path, const char **core_name,
-      const char **db_name,
-      const char **crc32);
+      const char **crc32,
+      const char **db_name);
 
 /**
  * content_playlist_push:
@@ -111,21 +144,32 @@ void content_playlist_get_index(content_playlist_t *playlist,
 void content_playlist_push(content_playlist_t *playlist,
       const char *path, const char *label,
       const char *core_path, const char *core_name,
-      const char *db_name,
-      const char *crc32);
+      const char *crc32,
+      const char *db_name);
 
 void content_playlist_update(content_playlist_t *playlist, size_t idx,
       const char *path, const char *label,
       const char *core_path, const char *core_name,
-      const char *db_name,
-      const char *crc32);
+      const char *crc32,
+      const char *db_name);
 
 void content_playlist_get_index_by_path(content_playlist_t *playlist,
       const char *search_path,
       char **path, char **label,
       char **core_path, char **core_name,
-      char **db_name,
-      char **crc32);
+      char **crc32,
+      char **db_name);
+
+/**
+ * content_playlist_find_crc32:
+ * @playlist            : Playlist handle.
+ * @crc32               : crc32 field to look for, e.g. "1234ABCD|crc".
+ * @idx                 : Set to the index of the last matching entry.
+ *
+ * Returns: true if an entry matched, otherwise false.
+ **/
+bool content_playlist_find_crc32(content_playlist_t *playlist,
+      const char *crc32, size_t *idx);
 
 void content_playlist_write_file(content_playlist_t *playlist);
 
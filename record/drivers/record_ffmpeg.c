@@ -54,7 +54,7 @@ extern "C" {
 #include <compat/msvc.h>
 
 #include <boolean.h>
-#include <queues/fifo_buffer.h>
+#include <queues/spsc_ring.h>
 #include <rthreads/rthreads.h>
 #include <gfx/scaler/scaler.h>
 #include <file/config_file.h>
@@ -88,6 +88,15 @@ extern "C" {
 #define av_frame_free avcodec_free_frame
 #endif
 
+/* Frame buffers in the pool unless the config sets queue_depth. */
+#define FF_QUEUE_DEPTH 8
+/* Queue slots per buffer, for frames queued without one. */
+#define FF_QUEUE_REPEATS 4
+
+/* Timeouts so waiters notice a shutdown. */
+#define FF_WAIT_US      100000
+#define FF_IDLE_WAIT_US 5000
+
 struct ff_video_info
 {
    AVCodecContext *codec;
@@ -173,10 +182,12 @@ struct ff_config_param
    enum PixelFormat out_pix_fmt;
    unsigned threads;
    unsigned frame_drop_ratio;
+   unsigned queue_depth;
    unsigned sample_rate;
    unsigned scale_factor;
 
    bool audio_enable;
+   bool drop_late_frames;
    /* Keep same naming conventions as libavcodec. */
    bool audio_qscale;
    int audio_global_quality;
@@ -189,25 +200,51 @@ struct ff_config_param
    AVDictionary *audio_opts;
 };
 
+/* Frame on its way to the encoder thread. */
+struct ff_queued_frame
+{
+   struct ffemu_video_data attr;
+   /* Pool buffer holding the frame, or FF_FRAME_REPEAT. */
+   unsigned index;
+   /* Frames dropped before this one. They are not encoded,
+    * only the timestamp moves past them. */
+   unsigned skip;
+};
+
+#define FF_FRAME_REPEAT ((unsigned)-1)
+
+/* Frame buffers are handed to the encoder thread through one ring
+ * and come back through another, so each frame is copied once and
+ * neither thread ever takes a lock. Dupes are queued without a
+ * buffer and repeat the last encoded frame. Dropped frames aren't
+ * queued at all, the next frame carries them in its skip count. */
+struct ff_frame_pool
+{
+   uint8_t **buffers;
+   unsigned count;
+   spsc_ring_t *queue;  /* struct ff_queued_frame, main to encoder. */
+   spsc_ring_t *free;   /* Buffer indices, encoder to main. */
+
+   /* Main thread only. */
+   unsigned pending_skip;
+   unsigned frames_dropped;
+   unsigned frames_late;
+};
+
 typedef struct ffmpeg
 {
    struct ff_video_info video;
    struct ff_audio_info audio;
    struct ff_muxer_info muxer;
    struct ff_config_param config;
+   struct ff_frame_pool pool;
    
    struct ffemu_params params;
 
-   scond_t *cond;
-   slock_t *cond_lock;
-   slock_t *lock;
-   fifo_buffer_t *audio_fifo;
-   fifo_buffer_t *video_fifo;
-   fifo_buffer_t *attr_fifo;
+   spsc_ring_t *audio_ring;
    sthread_t *thread;
 
    volatile bool alive;
-   volatile bool can_sleep;
 } ffmpeg_t;
 
 static bool ffmpeg_codec_has_sample_format(enum AVSampleFormat fmt,
@@ -331,6 +368,7 @@ static bool ffmpeg_init_audio(ffmpeg_t *handle)
       rarch_resampler_realloc(&audio->resampler_data,
             &audio->resampler,
             settings->audio.resampler,
+            (enum resampler_quality)settings->audio.resampler_quality,
             audio->ratio);
    }
    else
@@ -524,6 +562,8 @@ static bool ffmpeg_init_config(struct ff_config_param *params,
    params->scale_factor = 1;
    params->threads = 1;
    params->frame_drop_ratio = 1;
+   params->queue_depth = FF_QUEUE_DEPTH;
+   params->drop_late_frames = true;
 
    if (!config)
       return true;
@@ -551,6 +591,13 @@ static bool ffmpeg_init_config(struct ff_config_param *params,
    if (!config_get_bool(params->conf, "audio_enable", &params->audio_enable))
       params->audio_enable = true;
 
+   if (!config_get_uint(params->conf, "queue_depth",
+            &params->queue_depth) || !params->queue_depth)
+      params->queue_depth = FF_QUEUE_DEPTH;
+
+   config_get_bool(params->conf, "drop_late_frames",
+         &params->drop_late_frames);
+
    config_get_uint(params->conf, "sample_rate", &params->sample_rate);
    config_get_uint(params->conf, "scale_factor", &params->scale_factor);
 
@@ -643,24 +690,50 @@ static bool ffmpeg_init_muxer_post(ffmpeg_t *handle)
 
 static void ffmpeg_thread(void *data);
 
+static bool init_frame_pool(ffmpeg_t *handle)
+{
+   unsigned i;
+   struct ff_frame_pool *pool = &handle->pool;
+   /* For some reason, FFmpeg has a tendency to crash 
+    * if we don't overallocate a bit. */
+   size_t size = 2 * handle->params.fb_width *
+      handle->params.fb_height * handle->video.pix_size;
+
+   pool->count   = handle->config.queue_depth;
+   pool->buffers = (uint8_t**)calloc(pool->count, sizeof(*pool->buffers));
+   /* Dupes take a slot in the queue but no buffer, so let
+    * the queue run ahead of the pool. */
+   pool->queue   = spsc_ring_new(sizeof(struct ff_queued_frame) *
+         pool->count * FF_QUEUE_REPEATS);
+   pool->free    = spsc_ring_new(sizeof(unsigned) * pool->count);
+
+   if (!pool->buffers || !pool->queue || !pool->free)
+      return false;
+
+   for (i = 0; i < pool->count; i++)
+   {
+      pool->buffers[i] = (uint8_t*)av_malloc(size);
+      if (!pool->buffers[i])
+         return false;
+
+      spsc_ring_write(pool->free, &i, sizeof(i));
+   }
+
+   return true;
+}
+
 static bool init_thread(ffmpeg_t *handle)
 {
-   handle->lock = slock_new();
-   handle->cond_lock = slock_new();
-   handle->cond = scond_new();
-   handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
+   handle->audio_ring = spsc_ring_new(32000 * sizeof(int16_t) *
          handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
-   handle->attr_fifo = fifo_new(sizeof(struct ffemu_video_data) * MAX_FRAMES);
-   handle->video_fifo = fifo_new(handle->params.fb_width * handle->params.fb_height *
-            handle->video.pix_size * MAX_FRAMES);
+
+   if (!handle->audio_ring || !init_frame_pool(handle))
+      return false;
 
    handle->alive = true;
-   handle->can_sleep = true;
    handle->thread = sthread_create(ffmpeg_thread, handle);
 
-   assert(handle->lock && handle->cond_lock &&
-      handle->cond && handle->audio_fifo &&
-      handle->attr_fifo && handle->video_fifo && handle->thread);
+   assert(handle->thread);
 
    return true;
 }
@@ -670,39 +743,43 @@ static void deinit_thread(ffmpeg_t *handle)
    if (!handle->thread)
       return;
 
-   slock_lock(handle->cond_lock);
    handle->alive = false;
-   handle->can_sleep = false;
-   slock_unlock(handle->cond_lock);
 
-   scond_signal(handle->cond);
+   spsc_ring_wake(handle->pool.queue);
    sthread_join(handle->thread);
 
-   slock_free(handle->lock);
-   slock_free(handle->cond_lock);
-   scond_free(handle->cond);
-
    handle->thread = NULL;
 }
 
 static void deinit_thread_buf(ffmpeg_t *handle)
 {
-   if (handle->audio_fifo)
+   unsigned i;
+   struct ff_frame_pool *pool = &handle->pool;
+
+   if (handle->audio_ring)
    {
-      fifo_free(handle->audio_fifo);
-      handle->audio_fifo = NULL;
+      spsc_ring_free(handle->audio_ring);
+      handle->audio_ring = NULL;
    }
-   
-   if (handle->attr_fifo)
+
+   if (pool->buffers)
+   {
+      for (i = 0; i < pool->count; i++)
+         av_free(pool->buffers[i]);
+      free(pool->buffers);
+      pool->buffers = NULL;
+   }
+
+   if (pool->queue)
    {
-      fifo_free(handle->attr_fifo);
-      handle->attr_fifo = NULL;
+      spsc_ring_free(pool->queue);
+      pool->queue = NULL;
    }
 
-   if (handle->video_fifo)
+   if (pool->free)
    {
-      fifo_free(handle->video_fifo);
-      handle->video_fifo = NULL;
+      spsc_ring_free(pool->free);
+      pool->free = NULL;
    }
 }
 
@@ -793,14 +870,39 @@ error:
    return NULL;
 }
 
+/* Waits until @size bytes can be read from @ring, or written to
+ * it when @write is set. Returns false if the encoder thread was
+ * shut down in the meantime. */
+static bool ffmpeg_wait_ring(ffmpeg_t *handle, spsc_ring_t *ring,
+      size_t size, bool write)
+{
+   for (;;)
+   {
+      size_t avail = write ? spsc_ring_write_avail(ring)
+         : spsc_ring_read_avail(ring);
+
+      if (avail >= size)
+         return true;
+
+      if (!handle->alive)
+         return false;
+
+      if (write)
+         spsc_ring_wait_write(ring, size, FF_WAIT_US);
+      else
+         spsc_ring_wait_read(ring, size, FF_WAIT_US);
+   }
+}
+
 static bool ffmpeg_push_video(void *data,
       const struct ffemu_video_data *video_data)
 {
    unsigned y;
    bool drop_frame;
-   struct ffemu_video_data attr_data;
+   struct ff_queued_frame frame;
    ffmpeg_t *handle = (ffmpeg_t*)data;
-   int offset = 0;
+   struct ff_frame_pool *pool;
+   bool late = false;
 
    if (!handle || !video_data)
       return false;
@@ -813,52 +915,67 @@ static bool ffmpeg_push_video(void *data,
    if (drop_frame)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->attr_fifo);
-      slock_unlock(handle->lock);
-
-      if (!handle->alive)
-         return false;
+   pool        = &handle->pool;
+   frame.attr  = *video_data;
+   frame.index = FF_FRAME_REPEAT;
 
-      if (avail >= sizeof(*video_data))
-         break;
+   /* The encoder is behind: it holds every buffer, or the
+    * queue is full. Drop the frame rather than wait for it. */
+   if (handle->config.drop_late_frames
+         && (spsc_ring_write_avail(pool->queue) < sizeof(frame)
+            || (!frame.attr.is_dupe && spsc_ring_read_avail(pool->free)
+               < sizeof(frame.index))))
+   {
+      pool->pending_skip++;
+      pool->frames_dropped++;
+      return true;
+   }
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
+   if (!frame.attr.is_dupe)
+   {
+      if (spsc_ring_read_avail(pool->free) < sizeof(frame.index))
       {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
+         if (!ffmpeg_wait_ring(handle, pool->free,
+                  sizeof(frame.index), false))
+            return false;
+         late = true;
       }
-      else
-         scond_signal(handle->cond);
 
-      slock_unlock(handle->cond_lock);
+      spsc_ring_read(pool->free, &frame.index, sizeof(frame.index));
    }
 
-   slock_lock(handle->lock);
+   if (frame.index != FF_FRAME_REPEAT)
+   {
+      /* Tightly pack our frame to conserve memory.
+       * libretro tends to use a very large pitch.
+       */
+      const uint8_t *src = (const uint8_t*)video_data->data;
+      uint8_t *dst       = pool->buffers[frame.index];
 
-   /* Tightly pack our frame to conserve memory.
-    * libretro tends to use a very large pitch.
-    */
-   attr_data = *video_data;
+      frame.attr.pitch   = frame.attr.width * handle->video.pix_size;
 
-   if (attr_data.is_dupe)
-      attr_data.width = attr_data.height = attr_data.pitch = 0;
+      for (y = 0; y < frame.attr.height; y++,
+            src += video_data->pitch, dst += frame.attr.pitch)
+         memcpy(dst, src, frame.attr.pitch);
+   }
    else
-      attr_data.pitch = attr_data.width * handle->video.pix_size;
+      frame.attr.width = frame.attr.height = frame.attr.pitch = 0;
 
-   fifo_write(handle->attr_fifo, &attr_data, sizeof(attr_data));
+   frame.attr.data = NULL;
+   frame.skip      = pool->pending_skip;
 
-   for (y = 0; y < attr_data.height; y++, offset += video_data->pitch)
-      fifo_write(handle->video_fifo,
-            (const uint8_t*)video_data->data + offset, attr_data.pitch);
+   if (spsc_ring_write_avail(pool->queue) < sizeof(frame))
+   {
+      if (!ffmpeg_wait_ring(handle, pool->queue, sizeof(frame), true))
+         return false;
+      late = true;
+   }
 
-   slock_unlock(handle->lock);
-   scond_signal(handle->cond);
+   spsc_ring_write(pool->queue, &frame, sizeof(frame));
+   pool->pending_skip = 0;
+
+   if (late)
+      pool->frames_late++;
 
    return true;
 }
@@ -866,6 +983,7 @@ static bool ffmpeg_push_video(void *data,
 static bool ffmpeg_push_audio(void *data,
       const struct ffemu_audio_data *audio_data)
 {
+   size_t size;
    ffmpeg_t *handle = (ffmpeg_t*)data;
 
    if (!handle || !audio_data)
@@ -874,38 +992,12 @@ static bool ffmpeg_push_audio(void *data,
    if (!handle->config.audio_enable)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->audio_fifo);
-      slock_unlock(handle->lock);
-
-      if (!handle->alive)
-         return false;
+   size = audio_data->frames * handle->params.channels * sizeof(int16_t);
 
-      if (avail >= audio_data->frames * handle->params.channels
-            * sizeof(int16_t))
-         break;
-
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
-
-      slock_unlock(handle->cond_lock);
-   }
+   if (!ffmpeg_wait_ring(handle, handle->audio_ring, size, true))
+      return false;
 
-   slock_lock(handle->lock);
-   fifo_write(handle->audio_fifo, audio_data->data,
-         audio_data->frames * handle->params.channels * sizeof(int16_t));
-   slock_unlock(handle->lock);
-   scond_signal(handle->cond);
+   spsc_ring_write(handle->audio_ring, audio_data->data, size);
 
    return true;
 }
@@ -1014,6 +1106,30 @@ static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
    return true;
 }
 
+/* Encodes the next queued frame and hands its buffer back
+ * to the pool. Returns false if the queue is empty. */
+static bool ffmpeg_pop_video_thread(ffmpeg_t *handle)
+{
+   struct ff_queued_frame frame;
+   struct ff_frame_pool *pool = &handle->pool;
+
+   if (spsc_ring_read_avail(pool->queue) < sizeof(frame))
+      return false;
+
+   spsc_ring_read(pool->queue, &frame, sizeof(frame));
+
+   if (frame.index != FF_FRAME_REPEAT)
+      frame.attr.data = pool->buffers[frame.index];
+
+   handle->video.frame_cnt += frame.skip;
+   ffmpeg_push_video_thread(handle, &frame.attr);
+
+   if (frame.index != FF_FRAME_REPEAT)
+      spsc_ring_write(pool->free, &frame.index, sizeof(frame.index));
+
+   return true;
+}
+
 static void planarize_float(float *out, const float *in, size_t frames)
 {
    size_t i;
@@ -1246,13 +1362,13 @@ static bool ffmpeg_push_audio_thread(ffmpeg_t *handle,
 static void ffmpeg_flush_audio(ffmpeg_t *handle, void *audio_buf,
       size_t audio_buf_size)
 {
-   size_t avail = fifo_read_avail(handle->audio_fifo);
+   size_t avail = spsc_ring_read_avail(handle->audio_ring);
 
    if (avail)
    {
       struct ffemu_audio_data aud = {0};
 
-      fifo_read(handle->audio_fifo, audio_buf, avail);
+      spsc_ring_read(handle->audio_ring, audio_buf, avail);
 
       aud.frames = avail / (sizeof(int16_t) * handle->params.channels);
       aud.data = audio_buf;
@@ -1283,8 +1399,6 @@ static void ffmpeg_flush_video(ffmpeg_t *handle)
 static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 {
    bool did_work;
-   void *video_buf = av_malloc(2 * handle->params.fb_width * 
-         handle->params.fb_height * handle->video.pix_size);
    size_t audio_buf_size = handle->config.audio_enable ? 
       (handle->audio.codec->frame_size * 
        handle->params.channels * sizeof(int16_t)) : 0;
@@ -1297,17 +1411,15 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 
    do
    {
-      struct ffemu_video_data attr_buf;
-
       did_work = false;
 
       if (handle->config.audio_enable)
       {
-         if (fifo_read_avail(handle->audio_fifo) >= audio_buf_size)
+         if (spsc_ring_read_avail(handle->audio_ring) >= audio_buf_size)
          {
             struct ffemu_audio_data aud = {0};
 
-            fifo_read(handle->audio_fifo, audio_buf, audio_buf_size);
+            spsc_ring_read(handle->audio_ring, audio_buf, audio_buf_size);
 
             aud.frames = handle->audio.codec->frame_size;
             aud.data = audio_buf;
@@ -1317,16 +1429,8 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
          }
       }
 
-      if (fifo_read_avail(handle->attr_fifo) >= sizeof(attr_buf))
-      {
-         fifo_read(handle->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(handle->video_fifo, video_buf, 
-               attr_buf.height * attr_buf.pitch);
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(handle, &attr_buf);
-
+      if (ffmpeg_pop_video_thread(handle))
          did_work = true;
-      }
    } while (did_work);
 
    /* Flush out last audio. */
@@ -1336,7 +1440,6 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
    /* Flush out last video. */
    ffmpeg_flush_video(handle);
 
-   av_free(video_buf);
    av_free(audio_buf);
 }
 
@@ -1354,6 +1457,11 @@ static bool ffmpeg_finalize(void *data)
 
    deinit_thread_buf(handle);
 
+   if (handle->pool.frames_dropped || handle->pool.frames_late)
+      RARCH_WARN("[FFmpeg]: Encoder fell behind: %u frames dropped, "
+            "%u frames waited for.\n",
+            handle->pool.frames_dropped, handle->pool.frames_late);
+
    /* Write final data. */
    av_write_trailer(handle->muxer.ctx);
 
@@ -1366,77 +1474,36 @@ static void ffmpeg_thread(void *data)
    void *audio_buf;
    ffmpeg_t *ff = (ffmpeg_t*)data;
 
-   /* For some reason, FFmpeg has a tendency to crash 
-    * if we don't overallocate a bit. */
-   void *video_buf = av_malloc(2 * ff->params.fb_width *
-         ff->params.fb_height * ff->video.pix_size);
-   assert(video_buf);
-
    audio_buf_size = ff->config.audio_enable ? 
       (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
    audio_buf      = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
 
    while (ff->alive)
    {
-      struct ffemu_video_data attr_buf;
-
-      bool avail_video = false;
+      bool avail_video = ffmpeg_pop_video_thread(ff);
       bool avail_audio = false;
 
-      slock_lock(ff->lock);
-      if (fifo_read_avail(ff->attr_fifo) >= sizeof(attr_buf))
-         avail_video = true;
-
-      if (ff->config.audio_enable)
-         if (fifo_read_avail(ff->audio_fifo) >= audio_buf_size)
-            avail_audio = true;
-      slock_unlock(ff->lock);
-
-      if (!avail_video && !avail_audio)
-      {
-         slock_lock(ff->cond_lock);
-         if (ff->can_sleep)
-         {
-            ff->can_sleep = false;
-            scond_wait(ff->cond, ff->cond_lock);
-            ff->can_sleep = true;
-         }
-         else
-            scond_signal(ff->cond);
-
-         slock_unlock(ff->cond_lock);
-      }
-
-      if (avail_video)
-      {
-         slock_lock(ff->lock);
-         fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(ff->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(ff, &attr_buf);
-      }
-
-      if (avail_audio)
+      if (ff->config.audio_enable &&
+            spsc_ring_read_avail(ff->audio_ring) >= audio_buf_size)
       {
          struct ffemu_audio_data aud = {0};
 
-         slock_lock(ff->lock);
-         fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
+         spsc_ring_read(ff->audio_ring, audio_buf, audio_buf_size);
 
          aud.frames = ff->audio.codec->frame_size;
          aud.data = audio_buf;
 
          ffmpeg_push_audio_thread(ff, &aud, true);
+         avail_audio = true;
       }
+
+      /* Frames wake us up as they are queued. Audio is only
+       * picked up on the next frame or after a short timeout. */
+      if (!avail_video && !avail_audio)
+         spsc_ring_wait_read(ff->pool.queue,
+               sizeof(struct ff_queued_frame), FF_IDLE_WAIT_US);
    }
 
-   av_free(video_buf);
    av_free(audio_buf);
 }
 
@@ -47,6 +47,7 @@
 #include "cheats.h"
 #include "system.h"
 #include "retro_file.h"
+#include "screenshot.h"
 
 #include "git_version.h"
 
@@ -1086,6 +1087,7 @@ void rarch_main_new(void)
 
 void rarch_main_free(void)
 {
+   screenshot_deinit();
    event_command(EVENT_CMD_MSG_QUEUE_DEINIT);
    event_command(EVENT_CMD_DRIVERS_DEINIT);
    event_command(EVENT_CMD_LOG_FILE_DEINIT);
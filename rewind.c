@@ -21,10 +21,35 @@
 
 #include <retro_inline.h>
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <memmap.h>
+#endif
+
+#include "libretro.h"
+#include "rewind.h"
+
+#ifdef RARCH_INTERNAL
+#include <file/file_path.h>
+
 #include "general.h"
 #include "msg_hash.h"
-#include "rewind.h"
 #include "performance.h"
+#else
+#define rarch_perf_init(perf, name) ((void)(perf))
+#define retro_perf_start(perf)      ((void)(perf))
+#define retro_perf_stop(perf)       ((void)(perf))
+#endif
 
 /* This makes Valgrind throw errors if a core overflows its savestate size. */
 /* Keep it off unless you're chasing a core bug, it slows things down. */
@@ -48,6 +73,36 @@
 #define NO_UNALIGNED_MEM
 #endif
 
+#ifdef HAVE_MMAP
+/* Layout of a rewind backing file: this header, the newest state 
+ * (thisblock), then the ring itself, each starting on its own page. */
+#define REWIND_FILE_MAGIC "RAREWND1"
+#define REWIND_FILE_ALIGN 4096
+
+struct state_manager_file_header
+{
+   char magic[8];
+   uint32_t word_size;
+   uint32_t clean;
+   uint64_t state_size;
+   uint64_t capacity;
+   uint64_t keyframe_interval;
+   uint64_t head;
+   uint64_t tail;
+   uint64_t serial;
+   uint64_t tail_serial;
+   uint32_t entries;
+   uint32_t thisblock_valid;
+};
+#endif
+
+struct state_manager_keyframe
+{
+   /* Offset of the ring entry holding the full state. */
+   size_t offset;
+   uint64_t serial;
+};
+
 struct state_manager
 {
    uint8_t *data;
@@ -70,13 +125,47 @@ struct state_manager
 
    unsigned entries;
    bool thisblock_valid;
+
+   /* Serial number of the state in thisblock, and of the oldest 
+    * state that can still be reached through the ring. */
+   uint64_t serial;
+   uint64_t tail_serial;
+
+   /* Every keyframe_interval'th state is stored whole instead of 
+    * as a delta. They are indexed here, oldest first, so a seek can 
+    * jump straight to the closest one and only walk the rest. */
+   unsigned keyframe_interval;
+   struct state_manager_keyframe *keyframes;
+   size_t keyframes_size;
+   size_t keyframes_first;
+   size_t keyframes_count;
+
+#ifdef HAVE_THREADS
+   /* In threaded mode, the delta between spareblock (older) and 
+    * thisblock (newer) is compressed on 'thread' while the core 
+    * serializes the next frame into nextblock. */
+   uint8_t *spareblock;
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   bool job_pending;
+   bool job_keyframe;
+   bool quit;
+#endif
+#ifdef HAVE_MMAP
+   /* If the ring lives in a backing file, this is the whole mapping. */
+   int fd;
+   uint8_t *map;
+   size_t map_size;
+#endif
 #if STRICT_BUF_SIZE
    size_t debugsize;
    uint8_t *debugblock;
 #endif
 };
 
-/* Format per frame (pseudocode): */
+/* Format per frame (pseudocode), unless the frame is a keyframe,
+ * in which case it is the uncompressed state, padded to 16 bits: */
 #if 0
 size nextstart;
 repeat {
@@ -112,7 +201,7 @@ void *state_manager_raw_alloc(size_t len, uint16_t uniq)
 {
    size_t  len16 = (len + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
 
-   uint16_t *ret = (uint16_t*)calloc(len16 + sizeof(uint16_t) * 4 + 16, 1);
+   uint16_t *ret = (uint16_t*)calloc(len16 + sizeof(uint16_t) * 4 + 32, 1);
 
    /* Force in a different byte at the end, so we don't need to check 
     * bounds in the innermost loop (it's expensive).
@@ -123,14 +212,14 @@ void *state_manager_raw_alloc(size_t len, uint16_t uniq)
     * There is also some padding at the end. This is so we don't 
     * read outside the buffer end if we're reading in large blocks;
     *
-    * It doesn't make any difference to us, but sacrificing 16 bytes to get 
-    * Valgrind happy is worth it. */
+    * It doesn't make any difference to us, but sacrificing 32 bytes 
+    * (one AVX2 load) to get Valgrind happy is worth it. */
    ret[len16/sizeof(uint16_t) + 3] = uniq;
 
    return ret;
 }
 
-#if __SSE2__
+#if defined(__SSE2__)
 #if defined(__GNUC__)
 static INLINE int compat_ctz(unsigned x)
 {
@@ -159,7 +248,7 @@ static INLINE int compat_ctz(unsigned x)
 /* There's no equivalent in libc, you'd think so ...
  * std::mismatch exists, but it's not optimized at all. */
 
-static INLINE size_t find_change(const uint16_t *a, const uint16_t *b)
+static INLINE size_t find_change_sse2(const uint16_t *a, const uint16_t *b)
 {
    const __m128i *a128 = (const __m128i*)a;
    const __m128i *b128 = (const __m128i*)b;
@@ -182,8 +271,136 @@ static INLINE size_t find_change(const uint16_t *a, const uint16_t *b)
       b128++;
    }
 }
-#else
-static INLINE size_t find_change(const uint16_t *a, const uint16_t *b)
+#endif
+
+/* The AVX2 scanners are built into every x86 GCC/Clang build through
+ * a target attribute and picked at runtime, like the scaler does. */
+#if defined(__SSE2__) && defined(__AVX2__)
+#define REWIND_HAVE_AVX2
+#define REWIND_AVX2_TARGET
+#elif defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__)) && \
+   ((defined(__clang__) && (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))) || \
+    (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define REWIND_HAVE_AVX2
+#define REWIND_HAVE_AVX2_RUNTIME
+#define REWIND_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+#ifdef REWIND_HAVE_AVX2
+#include <immintrin.h>
+
+/* compat_ctz only has to work on 16-bit masks, 
+ * movemask on 256-bit vectors gives us 32. */
+static INLINE REWIND_AVX2_TARGET int compat_ctz32(uint32_t x)
+{
+   if (x & 0xffff)
+      return compat_ctz(x & 0xffff);
+   return 16 + compat_ctz(x >> 16);
+}
+
+static INLINE REWIND_AVX2_TARGET size_t find_change_avx2(const uint16_t *a, const uint16_t *b)
+{
+   const __m256i *a256 = (const __m256i*)a;
+   const __m256i *b256 = (const __m256i*)b;
+
+   for (;;)
+   {
+      __m256i v0    = _mm256_loadu_si256(a256);
+      __m256i v1    = _mm256_loadu_si256(b256);
+      __m256i c     = _mm256_cmpeq_epi32(v0, v1);
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(c);
+
+      if (mask != 0xffffffffu)
+      {
+         size_t ret = (((uint8_t*)a256 - (uint8_t*)a) |
+               (compat_ctz32(~mask))) >> 1;
+         return ret | (a[ret] == b[ret]);
+      }
+
+      a256++;
+      b256++;
+   }
+}
+
+/* Same semantics as find_same_c(), 
+ * just 8 words at a time. */
+static INLINE REWIND_AVX2_TARGET size_t find_same_avx2(const uint16_t *a, const uint16_t *b)
+{
+   const __m256i *a256 = (const __m256i*)a;
+   const __m256i *b256 = (const __m256i*)b;
+
+   for (;;)
+   {
+      __m256i v0    = _mm256_loadu_si256(a256);
+      __m256i v1    = _mm256_loadu_si256(b256);
+      __m256i c     = _mm256_cmpeq_epi32(v0, v1);
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(c);
+
+      if (mask)
+      {
+         size_t ret = (((uint8_t*)a256 - (uint8_t*)a) |
+               (compat_ctz32(mask))) >> 1;
+         if (ret && a[ret - 1] == b[ret - 1])
+            ret--;
+         return ret;
+      }
+
+      a256++;
+      b256++;
+   }
+}
+#endif
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+/* Narrows a 4x32 compare result to 4x16, so we can look at 
+ * it as a single 64-bit value. */
+static INLINE uint64_t neon_cmpeq_mask(const uint16_t *a, const uint16_t *b)
+{
+   uint32x4_t v0 = vreinterpretq_u32_u8(vld1q_u8((const uint8_t*)a));
+   uint32x4_t v1 = vreinterpretq_u32_u8(vld1q_u8((const uint8_t*)b));
+   uint16x4_t c  = vmovn_u32(vceqq_u32(v0, v1));
+
+   return vget_lane_u64(vreinterpret_u64_u16(c), 0);
+}
+
+static INLINE size_t find_change_neon(const uint16_t *a, const uint16_t *b)
+{
+   size_t i;
+
+   for (i = 0; ; i += 8)
+   {
+      uint64_t mask = neon_cmpeq_mask(a + i, b + i);
+
+      if (mask != UINT64_C(0xffffffffffffffff))
+      {
+         size_t ret = i + (__builtin_ctzll(~mask) >> 4) * 2;
+         return ret | (a[ret] == b[ret]);
+      }
+   }
+}
+
+static INLINE size_t find_same_neon(const uint16_t *a, const uint16_t *b)
+{
+   size_t i;
+
+   for (i = 0; ; i += 8)
+   {
+      uint64_t mask = neon_cmpeq_mask(a + i, b + i);
+
+      if (mask)
+      {
+         size_t ret = i + (__builtin_ctzll(mask) >> 4) * 2;
+         if (ret && a[ret - 1] == b[ret - 1])
+            ret--;
+         return ret;
+      }
+   }
+}
+#endif
+
+static INLINE size_t find_change_c(const uint16_t *a, const uint16_t *b)
 {
    const uint16_t *a_org = a;
 #ifdef NO_UNALIGNED_MEM
@@ -214,9 +431,8 @@ static INLINE size_t find_change(const uint16_t *a, const uint16_t *b)
    }
    return a - a_org;
 }
-#endif
 
-static INLINE size_t find_same(const uint16_t *a, const uint16_t *b)
+static INLINE size_t find_same_c(const uint16_t *a, const uint16_t *b)
 {
    const uint16_t *a_org = a;
 #ifdef NO_UNALIGNED_MEM
@@ -256,8 +472,13 @@ static INLINE size_t find_same(const uint16_t *a, const uint16_t *b)
    return a - a_org;
 }
 
-size_t state_manager_raw_compress(const void *src,
-      const void *dst, size_t len, void *patch)
+typedef size_t (*find_func_t)(const uint16_t *a, const uint16_t *b);
+
+/* Instantiated once per scanner pair below; the scanners are 
+ * constants there, so they get inlined into the loop. */
+static INLINE size_t raw_compress(const void *src,
+      const void *dst, size_t len, void *patch,
+      find_func_t find_change, find_func_t find_same)
 {
    const uint16_t  *old16 = (const uint16_t*)src;
    const uint16_t  *new16 = (const uint16_t*)dst;
@@ -316,6 +537,72 @@ size_t state_manager_raw_compress(const void *src,
    return (uint8_t*)(compressed16+3) - (uint8_t*)patch;
 }
 
+typedef size_t (*raw_compress_func_t)(const void *src,
+      const void *dst, size_t len, void *patch);
+
+#if defined(__SSE2__)
+static size_t raw_compress_sse2(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   return raw_compress(src, dst, len, patch,
+         find_change_sse2, find_same_c);
+}
+#define raw_compress_default raw_compress_sse2
+#else
+static size_t raw_compress_c(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   return raw_compress(src, dst, len, patch,
+         find_change_c, find_same_c);
+}
+#define raw_compress_default raw_compress_c
+#endif
+
+#ifdef REWIND_HAVE_AVX2
+static REWIND_AVX2_TARGET size_t raw_compress_avx2(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   return raw_compress(src, dst, len, patch,
+         find_change_avx2, find_same_avx2);
+}
+#endif
+
+#if defined(__ARM_NEON__)
+static size_t raw_compress_neon(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   return raw_compress(src, dst, len, patch,
+         find_change_neon, find_same_neon);
+}
+#endif
+
+static raw_compress_func_t raw_compress_func = raw_compress_default;
+
+void state_manager_raw_init_simd(uint64_t simd_mask)
+{
+   raw_compress_func = raw_compress_default;
+
+   (void)simd_mask;
+#ifdef REWIND_HAVE_AVX2
+#ifdef REWIND_HAVE_AVX2_RUNTIME
+   if (!__builtin_cpu_supports("avx2"))
+      simd_mask &= ~(uint64_t)RETRO_SIMD_AVX2;
+#endif
+   if (simd_mask & RETRO_SIMD_AVX2)
+      raw_compress_func = raw_compress_avx2;
+#endif
+#if defined(__ARM_NEON__)
+   if (simd_mask & RETRO_SIMD_NEON)
+      raw_compress_func = raw_compress_neon;
+#endif
+}
+
+size_t state_manager_raw_compress(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   return raw_compress_func(src, dst, len, patch);
+}
+
 void state_manager_raw_decompress(const void *patch,
       size_t patchlen, void *data, size_t datalen)
 {
@@ -395,17 +682,306 @@ static INLINE size_t read_size_t(const void *ptr)
 }
 
 
-state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
+static struct retro_perf_counter gen_deltas = {0};
+
+/* Appends the patch turning 'newb' back into 'oldb' at the head 
+ * of the ring, or 'oldb' itself if it is a keyframe. 
+ * Room for it must have been made by the caller. */
+static void state_manager_push_delta(state_manager_t *state,
+      const uint8_t *oldb, const uint8_t *newb, bool keyframe)
+{
+   uint8_t *compressed = state->head + sizeof(size_t);
+
+   retro_perf_start(&gen_deltas);
+
+   if (keyframe)
+   {
+      memcpy(compressed, oldb, state->blocksize);
+      compressed += (state->blocksize + sizeof(uint16_t) - 1) 
+         & -sizeof(uint16_t);
+   }
+   else
+      compressed += state_manager_raw_compress(oldb, newb,
+            state->blocksize, compressed);
+
+   if (compressed - state->data + state->maxcompsize > state->capacity)
+   {
+      compressed = state->data;
+      if (state->tail == state->data + sizeof(size_t))
+      {
+         state->tail = state->data + read_size_t(state->tail);
+         state->tail_serial++;
+      }
+   }
+   write_size_t(compressed, state->head-state->data);
+   compressed += sizeof(size_t);
+   write_size_t(state->head, compressed-state->data);
+   state->head = compressed;
+
+   retro_perf_stop(&gen_deltas);
+}
+
+#ifdef HAVE_THREADS
+/**
+ * state_manager_thread:
+ * @data            : pointer to state manager object
+ *
+ * Compresses each frame handed over by state_manager_push_do()
+ * while the core runs the next one.
+ **/
+static void state_manager_thread(void *data)
+{
+   state_manager_t *state = (state_manager_t*)data;
+
+   slock_lock(state->lock);
+
+   for (;;)
+   {
+      while (!state->job_pending && !state->quit)
+         scond_wait(state->cond, state->lock);
+
+      if (state->quit)
+         break;
+
+      slock_unlock(state->lock);
+      state_manager_push_delta(state, state->spareblock,
+            state->thisblock, state->job_keyframe);
+      slock_lock(state->lock);
+
+      state->job_pending = false;
+      scond_signal(state->cond);
+   }
+
+   slock_unlock(state->lock);
+}
+#endif
+
+/**
+ * state_manager_wait:
+ * @state           : pointer to state manager object
+ *
+ * Waits for a pending threaded compression to finish. 
+ * Everything touching the ring or thisblock has to call this first.
+ **/
+static void state_manager_wait(state_manager_t *state)
+{
+#ifdef HAVE_THREADS
+   static struct retro_perf_counter rewind_wait = {0};
+
+   if (!state->thread)
+      return;
+
+   rarch_perf_init(&rewind_wait, "rewind_wait");
+   retro_perf_start(&rewind_wait);
+
+   slock_lock(state->lock);
+   while (state->job_pending)
+      scond_wait(state->cond, state->lock);
+   slock_unlock(state->lock);
+
+   retro_perf_stop(&rewind_wait);
+#else
+   (void)state;
+#endif
+}
+
+static struct state_manager_keyframe *state_manager_keyframe_at(
+      state_manager_t *state, size_t i)
+{
+   return &state->keyframes[(state->keyframes_first + i) 
+      % state->keyframes_size];
+}
+
+/* Forgets keyframes whose ring entry has been evicted. */
+static void state_manager_prune_keyframes(state_manager_t *state)
+{
+   while (state->keyframes_count && state_manager_keyframe_at(
+            state, 0)->serial < state->tail_serial)
+   {
+      state->keyframes_first = (state->keyframes_first + 1) 
+         % state->keyframes_size;
+      state->keyframes_count--;
+   }
+}
+
+/**
+ * state_manager_pop_entry:
+ * @state           : pointer to state manager object
+ *
+ * Replaces thisblock with the state before it, 
+ * consuming the newest entry of the ring.
+ **/
+static void state_manager_pop_entry(state_manager_t *state)
+{
+   size_t start                 = read_size_t(state->head - sizeof(size_t));
+   const uint8_t *compressed    = state->data + start + sizeof(size_t);
+
+   state->head = state->data + start;
+
+   if (state->keyframes_count && state_manager_keyframe_at(state,
+            state->keyframes_count - 1)->serial == state->serial - 1)
+   {
+      memcpy(state->thisblock, compressed, state->blocksize);
+      state->keyframes_count--;
+   }
+   else
+      state_manager_raw_decompress(compressed,
+            state->maxcompsize, state->thisblock, state->blocksize);
+
+   state->serial--;
+   state->entries--;
+}
+
+#ifdef HAVE_MMAP
+static size_t state_manager_file_block_size(state_manager_t *state)
+{
+   return (state->blocksize + REWIND_FILE_ALIGN - 1) 
+      & -(size_t)REWIND_FILE_ALIGN;
+}
+
+/**
+ * state_manager_map_file:
+ * @state           : pointer to state manager object
+ * @path            : path to backing file
+ * @buffer_size     : size of the ring
+ *
+ * Maps the ring into @path, so that the kernel can page old 
+ * history out to disk instead of keeping it resident.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool state_manager_map_file(state_manager_t *state,
+      const char *path, size_t buffer_size)
+{
+   void *map;
+
+   state->map_size = REWIND_FILE_ALIGN +
+      state_manager_file_block_size(state) + buffer_size;
+   state->fd       = open(path, O_RDWR | O_CREAT, 0644);
+
+   if (state->fd < 0)
+      return false;
+
+   if (ftruncate(state->fd, state->map_size) != 0)
+      return false;
+
+   map = mmap(NULL, state->map_size, PROT_READ | PROT_WRITE,
+         MAP_SHARED, state->fd, 0);
+   if (map == MAP_FAILED)
+      return false;
+
+   state->map  = (uint8_t*)map;
+   state->data = state->map + REWIND_FILE_ALIGN +
+      state_manager_file_block_size(state);
+   return true;
+}
+
+static void state_manager_write_header(state_manager_t *state, bool clean)
+{
+   struct state_manager_file_header header = {{0}};
+
+   memcpy(header.magic, REWIND_FILE_MAGIC, sizeof(header.magic));
+   header.word_size         = sizeof(size_t);
+   header.clean             = clean;
+   header.state_size        = state->blocksize;
+   header.capacity          = state->capacity;
+   header.keyframe_interval = state->keyframe_interval;
+   header.head              = state->head - state->data;
+   header.tail              = state->tail - state->data;
+   header.serial            = state->serial;
+   header.tail_serial       = state->tail_serial;
+   header.entries           = state->entries;
+   header.thisblock_valid   = state->thisblock_valid;
+
+   memcpy(state->map, &header, sizeof(header));
+   msync(state->map, REWIND_FILE_ALIGN, MS_SYNC);
+}
+
+/**
+ * state_manager_restore_file:
+ * @state           : pointer to state manager object
+ *
+ * Picks up the history left in the backing file by a previous 
+ * session, as long as it was closed cleanly with the same 
+ * state size and ring layout.
+ *
+ * Returns: true (1) if history was restored, otherwise false (0).
+ **/
+static bool state_manager_restore_file(state_manager_t *state)
+{
+   size_t pos;
+   uint64_t serial;
+   struct state_manager_file_header header;
+
+   memcpy(&header, state->map, sizeof(header));
+
+   if (memcmp(header.magic, REWIND_FILE_MAGIC, sizeof(header.magic))
+         || !header.clean
+         || header.word_size         != sizeof(size_t)
+         || header.state_size        != state->blocksize
+         || header.capacity          != state->capacity
+         || header.keyframe_interval != state->keyframe_interval
+         || header.head >= state->capacity
+         || header.tail >= state->capacity)
+      return false;
+
+   state->head            = state->data + header.head;
+   state->tail            = state->data + header.tail;
+   state->serial          = header.serial;
+   state->tail_serial     = header.tail_serial;
+   state->entries         = header.entries;
+   state->thisblock_valid = header.thisblock_valid;
+
+   memcpy(state->thisblock, state->map + REWIND_FILE_ALIGN,
+         state->blocksize);
+
+   if (!state->keyframe_interval)
+      return true;
+
+   /* The keyframe index isn't stored, walk the ring 
+    * from oldest to newest entry to rebuild it. */
+   for (pos = header.tail, serial = state->tail_serial;
+         state->data + pos != state->head && serial < state->serial
+         && pos < state->capacity;
+         pos = read_size_t(state->data + pos), serial++)
+   {
+      if (serial % state->keyframe_interval == 0)
+      {
+         struct state_manager_keyframe *key = state_manager_keyframe_at(
+               state, state->keyframes_count++);
+
+         key->offset = pos;
+         key->serial = serial;
+      }
+   }
+
+   return true;
+}
+#endif
+
+state_manager_t *state_manager_new(size_t state_size,
+      size_t buffer_size, bool threaded, unsigned keyframe_interval,
+      const char *backing_path)
 {
    state_manager_t *state = (state_manager_t*)calloc(1, sizeof(*state));
 
    if (!state)
       return NULL;
 
-   state->blocksize   = (state_size + sizeof(uint16_t) - 1) & ~sizeof(uint16_t);
+   state->blocksize   = (state_size + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
    /* the compressed data is surrounded by pointers to the other side */
    state->maxcompsize = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 2;
-   state->data        = (uint8_t*)malloc(buffer_size);
+
+#ifdef HAVE_MMAP
+   state->fd          = -1;
+   if (backing_path && !state_manager_map_file(state,
+            backing_path, buffer_size))
+      goto error;
+#else
+   (void)backing_path;
+#endif
+   if (!state->data)
+      state->data     = (uint8_t*)malloc(buffer_size);
 
    state->thisblock   = (uint8_t*)state_manager_raw_alloc(state_size, 0);
    state->nextblock   = (uint8_t*)state_manager_raw_alloc(state_size, 1);
@@ -417,6 +993,52 @@ state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
    state->head = state->data + sizeof(size_t);
    state->tail = state->data + sizeof(size_t);
 
+   if (keyframe_interval)
+   {
+      /* Each keyframe takes up at least blocksize bytes of the ring. */
+      state->keyframe_interval = keyframe_interval;
+      state->keyframes_size    = buffer_size / state->blocksize + 2;
+      state->keyframes         = (struct state_manager_keyframe*)
+         calloc(state->keyframes_size, sizeof(*state->keyframes));
+
+      if (!state->keyframes)
+         goto error;
+   }
+
+#ifdef HAVE_MMAP
+   if (state->map)
+   {
+      if (!state_manager_restore_file(state))
+      {
+         state->head = state->data + sizeof(size_t);
+         state->tail = state->data + sizeof(size_t);
+      }
+
+      /* Until we close it cleanly, the file can't be trusted. */
+      state_manager_write_header(state, false);
+   }
+#endif
+
+#ifdef HAVE_THREADS
+   if (threaded)
+   {
+      /* Three blocks rotate through here, so they 
+       * all need a different end marker. */
+      state->spareblock = (uint8_t*)state_manager_raw_alloc(state_size, 2);
+      state->lock       = slock_new();
+      state->cond       = scond_new();
+
+      if (!state->spareblock || !state->lock || !state->cond)
+         goto error;
+
+      state->thread     = sthread_create(state_manager_thread, state);
+      if (!state->thread)
+         goto error;
+   }
+#else
+   (void)threaded;
+#endif
+
 #if STRICT_BUF_SIZE
    state->debugsize = state_size;
    state->debugblock = (uint8_t*)malloc(state_size);
@@ -434,9 +1056,52 @@ void state_manager_free(state_manager_t *state)
    if (!state)
       return;
 
+#ifdef HAVE_THREADS
+   if (state->thread)
+   {
+      slock_lock(state->lock);
+      while (state->job_pending)
+         scond_wait(state->cond, state->lock);
+      state->quit = true;
+      scond_signal(state->cond);
+      slock_unlock(state->lock);
+
+      sthread_join(state->thread);
+   }
+
+   if (state->lock)
+      slock_free(state->lock);
+   if (state->cond)
+      scond_free(state->cond);
+   free(state->spareblock);
+#endif
+
+#ifdef HAVE_MMAP
+   if (state->map)
+   {
+      if (state->thisblock)
+      {
+         memcpy(state->map + REWIND_FILE_ALIGN, state->thisblock,
+               state->blocksize);
+
+         /* Everything else has to hit the disk before 
+          * the header claims it's consistent. */
+         msync(state->map + REWIND_FILE_ALIGN,
+               state->map_size - REWIND_FILE_ALIGN, MS_SYNC);
+         state_manager_write_header(state, true);
+      }
+
+      munmap(state->map, state->map_size);
+      state->data = NULL;
+   }
+   if (state->fd >= 0)
+      close(state->fd);
+#endif
+
    free(state->data);
    free(state->thisblock);
    free(state->nextblock);
+   free(state->keyframes);
 #if STRICT_BUF_SIZE
    free(state->debugblock);
 #endif
@@ -445,12 +1110,10 @@ void state_manager_free(state_manager_t *state)
 
 bool state_manager_pop(state_manager_t *state, const void **data)
 {
-   size_t start;
-   uint8_t *out                 = NULL;
-   const uint8_t *compressed    = NULL;
-
    *data = NULL;
 
+   state_manager_wait(state);
+
    if (state->thisblock_valid)
    {
       state->thisblock_valid = false;
@@ -462,15 +1125,70 @@ bool state_manager_pop(state_manager_t *state, const void **data)
    if (state->head == state->tail)
       return false;
 
-   start = read_size_t(state->head - sizeof(size_t));
-   state->head = state->data + start;
+   state_manager_pop_entry(state);
+
+   *data = state->thisblock;
+   return true;
+}
 
-   compressed = state->data + start + sizeof(size_t);
-   out = state->thisblock;
+bool state_manager_seek(state_manager_t *state,
+      unsigned frames, const void **data)
+{
+   uint64_t target;
 
-   state_manager_raw_decompress(compressed, state->maxcompsize, out, state->blocksize);
+   *data = NULL;
+
+   if (!frames)
+      return false;
+
+   state_manager_wait(state);
+   state_manager_prune_keyframes(state);
+
+   if (state->thisblock_valid)
+   {
+      state->thisblock_valid = false;
+      state->entries--;
+      *data = state->thisblock;
+      if (!--frames)
+         return true;
+   }
+
+   if (state->head == state->tail)
+      return *data != NULL;
+
+   target = state->serial - state->tail_serial > frames ?
+      state->serial - frames : state->tail_serial;
+
+   if (state->keyframes_count)
+   {
+      /* Keyframes sit at every multiple of the interval, 
+       * so the first one at or after target can be computed. */
+      uint64_t first = state_manager_keyframe_at(state, 0)->serial;
+      size_t i       = target <= first ? 0 :
+         (size_t)((target - first + state->keyframe_interval - 1) 
+               / state->keyframe_interval);
+
+      if (i < state->keyframes_count)
+      {
+         const struct state_manager_keyframe *key = 
+            state_manager_keyframe_at(state, i);
+
+         if (key->serial >= target && key->serial < state->serial)
+         {
+            state->head = state->data + key->offset;
+            memcpy(state->thisblock, state->head + sizeof(size_t),
+                  state->blocksize);
+
+            state->entries        -= (unsigned)(state->serial - key->serial);
+            state->serial          = key->serial;
+            state->keyframes_count = i;
+         }
+      }
+   }
+
+   while (state->serial > target && state->head != state->tail)
+      state_manager_pop_entry(state);
 
-   state->entries--;
    *data = state->thisblock;
    return true;
 }
@@ -499,21 +1217,21 @@ void state_manager_push_where(state_manager_t *state, void **data)
 
 void state_manager_push_do(state_manager_t *state)
 {
+   uint8_t *swap = NULL;
+
 #if STRICT_BUF_SIZE
    memcpy(state->nextblock, state->debugblock, state->debugsize);
 #endif
 
-   static struct retro_perf_counter gen_deltas = {0};
-   uint8_t *swap = NULL;
-
    if (state->thisblock_valid)
    {
-      const uint8_t *oldb, *newb;
-      uint8_t *compressed;
+      bool keyframe;
       size_t headpos, tailpos, remaining;
       if (state->capacity < sizeof(size_t) + state->maxcompsize)
          return;
 
+      state_manager_wait(state);
+
 recheckcapacity:;
 
       headpos = state->head - state->data;
@@ -525,30 +1243,52 @@ recheckcapacity:;
       {
          state->tail = state->data + read_size_t(state->tail);
          state->entries--;
+         state->tail_serial++;
          goto recheckcapacity;
       }
 
       rarch_perf_init(&gen_deltas, "gen_deltas");
-      retro_perf_start(&gen_deltas);
 
-      oldb = state->thisblock;
-      newb = state->nextblock;
-      compressed = state->head + sizeof(size_t);
+      state_manager_prune_keyframes(state);
+
+      keyframe = state->keyframe_interval &&
+         state->serial % state->keyframe_interval == 0;
+
+      if (keyframe)
+      {
+         struct state_manager_keyframe *key = state_manager_keyframe_at(
+               state, state->keyframes_count++);
+
+         key->offset = state->head - state->data;
+         key->serial = state->serial;
+      }
 
-      compressed += state_manager_raw_compress(oldb, newb, state->blocksize, compressed);
+      state->serial++;
 
-      if (compressed - state->data + state->maxcompsize > state->capacity)
+#ifdef HAVE_THREADS
+      if (state->thread)
       {
-         compressed = state->data;
-         if (state->tail == state->data + sizeof(size_t))
-            state->tail = state->data + read_size_t(state->tail);
+         /* The old current block becomes the reference for the 
+          * compressor, the block just pushed becomes current, 
+          * and the core gets the spare block to write into. */
+         swap              = state->spareblock;
+         state->spareblock = state->thisblock;
+         state->thisblock  = state->nextblock;
+         state->nextblock  = swap;
+
+         slock_lock(state->lock);
+         state->job_pending  = true;
+         state->job_keyframe = keyframe;
+         scond_signal(state->cond);
+         slock_unlock(state->lock);
+
+         state->entries++;
+         return;
       }
-      write_size_t(compressed, state->head-state->data);
-      compressed += sizeof(size_t);
-      write_size_t(state->head, compressed-state->data);
-      state->head = compressed;
+#endif
 
-      retro_perf_stop(&gen_deltas);
+      state_manager_push_delta(state, state->thisblock,
+            state->nextblock, keyframe);
    }
    else
       state->thisblock_valid = true;
@@ -563,9 +1303,13 @@ recheckcapacity:;
 void state_manager_capacity(state_manager_t *state,
       unsigned *entries, size_t *bytes, bool *full)
 {
-   size_t headpos   = state->head - state->data;
-   size_t tailpos   = state->tail - state->data;
-   size_t remaining = (tailpos + state->capacity -
+   size_t headpos, tailpos, remaining;
+
+   state_manager_wait(state);
+
+   headpos   = state->head - state->data;
+   tailpos   = state->tail - state->data;
+   remaining = (tailpos + state->capacity -
          sizeof(size_t) - headpos - 1) % state->capacity + 1;
 
    if (entries)
@@ -576,8 +1320,10 @@ void state_manager_capacity(state_manager_t *state,
       *full = remaining <= state->maxcompsize * 2;
 }
 
+#ifdef RARCH_INTERNAL
 void init_rewind(void)
 {
+   char backing_path[PATH_MAX_LENGTH] = {0};
    void *state          = NULL;
    settings_t *settings = config_get_ptr();
    global_t *global     = global_get_ptr();
@@ -604,17 +1350,68 @@ void init_rewind(void)
          msg_hash_to_str(MSG_REWIND_INIT),
          (unsigned)(settings->rewind_buffer_size / 1000000));
 
+   state_manager_raw_init_simd(retro_get_cpu_features());
+
+   if (settings->rewind_persistent)
+   {
+      fill_pathname(backing_path, global->name.savestate,
+            ".rewind", sizeof(backing_path));
+      RARCH_LOG("Rewind history is kept in \"%s\".\n", backing_path);
+   }
+
    global->rewind.state = state_manager_new(global->rewind.size,
-         settings->rewind_buffer_size);
+         settings->rewind_buffer_size, settings->rewind_threaded,
+         settings->rewind_keyframe_interval,
+         *backing_path ? backing_path : NULL);
 
    if (!global->rewind.state)
+   {
       RARCH_WARN("%s.\n", msg_hash_to_str(MSG_REWIND_INIT_FAILED));
+      return;
+   }
 
    state_manager_push_where(global->rewind.state, &state);
    core.retro_serialize(state, global->rewind.size);
    state_manager_push_do(global->rewind.state);
 }
 
+/**
+ * rewind_seek_seconds:
+ * @seconds         : how far to go back
+ *
+ * Rewinds the core by (roughly) @seconds worth of frames in one go.
+ *
+ * Returns: true (1) if the core was rewound, otherwise false (0).
+ **/
+bool rewind_seek_seconds(float seconds)
+{
+   unsigned frames;
+   const void *buf                      = NULL;
+   settings_t *settings                 = config_get_ptr();
+   global_t *global                     = global_get_ptr();
+   struct retro_system_av_info *av_info = video_viewport_get_system_av_info();
+
+   /* Movies are rewound one frame at a time, skipping would desync them. */
+   if (!global->rewind.state || global->bsv.movie || seconds <= 0.0f)
+      return false;
+
+   frames = (unsigned)(seconds * av_info->timing.fps / 
+         (settings->rewind_granularity ? settings->rewind_granularity : 1));
+   if (!frames)
+      frames = 1;
+
+   if (!state_manager_seek(global->rewind.state, frames, &buf))
+   {
+      rarch_main_msg_queue_push_new(MSG_REWIND_REACHED_END, 0, 30, true);
+      return false;
+   }
+
+   rarch_main_msg_queue_push_new(MSG_REWINDING, 0, 30, true);
+   core.retro_unserialize(buf, global->rewind.size);
+   return true;
+}
+#endif
+
 static bool frame_is_reversed;
 
 bool state_manager_frame_is_reversed(void)
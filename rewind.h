@@ -28,12 +28,28 @@ extern "C" {
 
 typedef struct state_manager state_manager_t;
 
-state_manager_t *state_manager_new(size_t state_size, size_t buffer_size);
+/* If 'threaded' is set (and threads are available), the delta of each 
+ * pushed frame is compressed on a worker thread while the next frame 
+ * runs; the state manager waits for it whenever it needs the result.
+ * If 'keyframe_interval' is non-zero, every keyframe_interval'th state 
+ * is stored uncompressed, which bounds the cost of state_manager_seek().
+ * If 'backing_path' is set (and mmap is available), the buffer is a mapping
+ * of that file instead of heap memory, so it doesn't have to stay resident,
+ * and history left there by a previous session is picked up again. */
+state_manager_t *state_manager_new(size_t state_size,
+      size_t buffer_size, bool threaded, unsigned keyframe_interval,
+      const char *backing_path);
 
 void state_manager_free(state_manager_t *state);
 
 bool state_manager_pop(state_manager_t *state, const void **data);
 
+/* Same as calling state_manager_pop() 'frames' times, 
+ * but jumps over whole keyframe intervals where it can.
+ * Stops early at the oldest state available. */
+bool state_manager_seek(state_manager_t *state,
+      unsigned frames, const void **data);
+
 void state_manager_push_where(state_manager_t *state, void **data);
 
 void state_manager_push_do(state_manager_t *state);
@@ -43,10 +59,18 @@ void state_manager_capacity(state_manager_t *state,
 
 void init_rewind(void);
 
+bool rewind_seek_seconds(float seconds);
+
 
 /* Returns the maximum compressed size of a savestate. It is very likely to compress to far less. */
 size_t state_manager_raw_maxsize(size_t uncomp);
 
+/*
+ * Selects the SIMD variant used by state_manager_raw_compress from a RETRO_SIMD_* mask.
+ * Variants which were not compiled in are ignored. Defaults to the baseline variant.
+ */
+void state_manager_raw_init_simd(uint64_t simd_mask);
+
 /*
  * See state_manager_raw_compress for information about this.
  * When you're done with it, send it to free().
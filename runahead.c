@@ -0,0 +1,532 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/file_path.h>
+#include <retro_file.h>
+#include <retro_log.h>
+
+#include "runahead.h"
+#include "dynamic.h"
+#include "general.h"
+#include "performance.h"
+#include "rewind.h"
+#include "system.h"
+#include "gfx/video_driver.h"
+
+typedef struct runahead
+{
+   void *state;
+   size_t state_size;
+
+   /* Set once the core failed to save a state, so run-ahead
+    * doesn't try again every frame. */
+   bool unsupported;
+
+#ifdef HAVE_DYNAMIC
+   struct retro_core_t secondary;
+   dylib_t lib;
+   char lib_path[PATH_MAX_LENGTH];
+   bool secondary_loaded;
+   bool show_frame;
+   /* Set once the first instance has picked up changed core
+    * options, until the secondary asks for them. */
+   bool variables_updated;
+   unsigned devices[MAX_USERS];
+#endif
+} runahead_t;
+
+static runahead_t runahead_st;
+
+static void runahead_video_null(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   (void)data;
+   (void)width;
+   (void)height;
+   (void)pitch;
+}
+
+static void runahead_audio_null(int16_t left, int16_t right)
+{
+   (void)left;
+   (void)right;
+}
+
+static size_t runahead_audio_batch_null(const int16_t *data, size_t frames)
+{
+   (void)data;
+   return frames;
+}
+
+static void runahead_input_poll_null(void)
+{
+}
+
+/**
+ * runahead_save_state:
+ *
+ * Saves the state of the core into the run-ahead buffer,
+ * growing it if the core needs more room than before.
+ *
+ * Returns: size of the saved state, or 0 if the core can't
+ * save states.
+ **/
+static size_t runahead_save_state(void)
+{
+   static struct retro_perf_counter runahead_serialize = {0};
+   size_t size = core.retro_serialize_size();
+   bool ret    = false;
+
+   if (size > runahead_st.state_size)
+   {
+      void *state = realloc(runahead_st.state, size);
+
+      if (!state)
+         return 0;
+
+      runahead_st.state      = state;
+      runahead_st.state_size = size;
+   }
+
+   if (size)
+   {
+      rarch_perf_init(&runahead_serialize, "runahead_serialize");
+      retro_perf_start(&runahead_serialize);
+      ret = core.retro_serialize(runahead_st.state, size);
+      retro_perf_stop(&runahead_serialize);
+   }
+
+   if (!ret)
+   {
+      RARCH_WARN("Run-ahead needs save state support, which this core lacks. Disabling it.\n");
+      runahead_st.unsupported = true;
+      return 0;
+   }
+
+   return size;
+}
+
+#ifdef HAVE_DYNAMIC
+static void runahead_secondary_video(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   driver_t *driver = driver_get_ptr();
+
+   if (runahead_st.show_frame)
+      driver->retro_ctx.frame_cb(data, width, height, pitch);
+}
+
+static int16_t runahead_secondary_input_state(unsigned port,
+      unsigned device, unsigned idx, unsigned id)
+{
+   driver_t *driver = driver_get_ptr();
+   return driver->retro_ctx.state_cb(port, device, idx, id);
+}
+
+/**
+ * runahead_secondary_environment:
+ * @cmd              : Identifier of command.
+ * @data             : Pointer to data.
+ *
+ * Environment callback of the secondary instance. Only queries
+ * and what the first instance has set the same way already are
+ * passed on, so the secondary instance can't take over the
+ * callbacks or core options of the first one. Option changes
+ * are reported once the first instance has picked them up.
+ **/
+static bool runahead_secondary_environment(unsigned cmd, void *data)
+{
+   switch (cmd)
+   {
+      case RETRO_ENVIRONMENT_GET_OVERSCAN:
+      case RETRO_ENVIRONMENT_GET_CAN_DUPE:
+      case RETRO_ENVIRONMENT_GET_VARIABLE:
+      case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_USERNAME:
+      case RETRO_ENVIRONMENT_GET_LANGUAGE:
+      case RETRO_ENVIRONMENT_GET_LIBRETRO_PATH:
+      case RETRO_ENVIRONMENT_GET_CORE_ASSETS_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_RUMBLE_INTERFACE:
+      case RETRO_ENVIRONMENT_GET_INPUT_DEVICE_CAPABILITIES:
+      case RETRO_ENVIRONMENT_GET_SENSOR_INTERFACE:
+      case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+      case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+      case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+      case RETRO_ENVIRONMENT_SET_ROTATION:
+         return rarch_environment_cb(cmd, data);
+
+      case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+         *(bool*)data = runahead_st.variables_updated;
+         runahead_st.variables_updated = false;
+         return true;
+
+      case RETRO_ENVIRONMENT_SET_VARIABLES:
+      case RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS:
+      case RETRO_ENVIRONMENT_SET_MESSAGE:
+      case RETRO_ENVIRONMENT_SET_PERFORMANCE_LEVEL:
+      case RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME:
+      case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
+         return true;
+
+      default:
+         break;
+   }
+
+   return false;
+}
+
+static void runahead_secondary_unload(void)
+{
+   if (runahead_st.secondary_loaded)
+   {
+      runahead_st.secondary.retro_unload_game();
+      runahead_st.secondary.retro_deinit();
+   }
+
+   if (runahead_st.lib)
+      dylib_close(runahead_st.lib);
+
+   if (*runahead_st.lib_path)
+      remove(runahead_st.lib_path);
+
+   memset(&runahead_st.secondary, 0, sizeof(runahead_st.secondary));
+   runahead_st.lib               = NULL;
+   runahead_st.lib_path[0]       = '\0';
+   runahead_st.secondary_loaded  = false;
+   runahead_st.variables_updated = false;
+}
+
+/**
+ * runahead_secondary_copy_lib:
+ *
+ * dlopen() hands back the handle it already has for a path, so
+ * the secondary instance is loaded from a copy of the core, put
+ * in the cache directory, or next to the core if there is none.
+ *
+ * Returns: true (1) if the copy was written, otherwise false (0).
+ **/
+static bool runahead_secondary_copy_lib(settings_t *settings)
+{
+   char dir[PATH_MAX_LENGTH]  = {0};
+   char name[PATH_MAX_LENGTH] = {0};
+   void *buf                  = NULL;
+   ssize_t len                = 0;
+   bool ret                   = false;
+
+   if (*settings->cache_directory)
+      strlcpy(dir, settings->cache_directory, sizeof(dir));
+   else
+      fill_pathname_basedir(dir, settings->libretro, sizeof(dir));
+
+   snprintf(name, sizeof(name), "runahead_%s",
+         path_basename(settings->libretro));
+   fill_pathname_join(runahead_st.lib_path, dir, name,
+         sizeof(runahead_st.lib_path));
+
+   if (retro_read_file(settings->libretro, &buf, &len) == 1 && len > 0)
+      ret = retro_write_file(runahead_st.lib_path, buf, len);
+   free(buf);
+
+   if (!ret)
+      runahead_st.lib_path[0] = '\0';
+
+   return ret;
+}
+
+/* Controller changes go to the first instance only, so they
+ * are picked up from the settings. */
+static void runahead_secondary_sync_ports(settings_t *settings)
+{
+   unsigned i;
+
+   for (i = 0; i < settings->input.max_users && i < MAX_USERS; i++)
+   {
+      unsigned device = settings->input.libretro_device[i];
+
+      if (device == runahead_st.devices[i])
+         continue;
+
+      runahead_st.secondary.retro_set_controller_port_device(i, device);
+      runahead_st.devices[i] = device;
+   }
+}
+
+/**
+ * runahead_run_secondary:
+ * @frames           : Number of frames to run ahead.
+ *
+ * Runs the frame on the core with its audio only, then
+ * copies its state over to the secondary instance and runs
+ * that @frames ahead, showing the last one.
+ **/
+static void runahead_run_secondary(settings_t *settings,
+      driver_t *driver, unsigned frames)
+{
+   unsigned i;
+   size_t size;
+   rarch_system_info_t *system = rarch_system_info_get_ptr();
+   bool updated = core_option_updated(system->core_options);
+   static struct retro_perf_counter runahead_core_run = {0};
+   static struct retro_perf_counter runahead_unserialize = {0};
+   static struct retro_perf_counter runahead_hidden_frames = {0};
+
+   rarch_perf_init(&runahead_core_run, "runahead_core_run");
+   retro_perf_start(&runahead_core_run);
+   core.retro_set_video_refresh(runahead_video_null);
+   core.retro_run();
+   core.retro_set_video_refresh(driver->retro_ctx.frame_cb);
+   retro_perf_stop(&runahead_core_run);
+
+   /* Reading the options clears their updated flag, so the
+    * secondary has to be told itself. */
+   if (updated && !core_option_updated(system->core_options))
+      runahead_st.variables_updated = true;
+
+   size = runahead_save_state();
+   if (!size)
+      return;
+
+   rarch_perf_init(&runahead_unserialize, "runahead_unserialize");
+   retro_perf_start(&runahead_unserialize);
+   if (!runahead_st.secondary.retro_unserialize(runahead_st.state, size))
+   {
+      retro_perf_stop(&runahead_unserialize);
+      RARCH_WARN("Run-ahead secondary instance failed to load the state, unloading it.\n");
+      runahead_secondary_unload();
+      return;
+   }
+   retro_perf_stop(&runahead_unserialize);
+
+   runahead_secondary_sync_ports(settings);
+
+   rarch_perf_init(&runahead_hidden_frames, "runahead_hidden_frames");
+   retro_perf_start(&runahead_hidden_frames);
+   for (i = 1; i <= frames; i++)
+   {
+      runahead_st.show_frame = (i == frames);
+      runahead_st.secondary.retro_run();
+   }
+   runahead_st.show_frame = false;
+   retro_perf_stop(&runahead_hidden_frames);
+}
+#endif
+
+/**
+ * runahead_run_single:
+ * @frames           : Number of frames to run ahead.
+ *
+ * Runs the frame on the core with its audio only, saves the
+ * state, then runs @frames more without audio and input
+ * polling, showing the last one, and loads the state back.
+ **/
+static void runahead_run_single(driver_t *driver, unsigned frames)
+{
+   unsigned i;
+   size_t size;
+   static struct retro_perf_counter runahead_core_run = {0};
+   static struct retro_perf_counter runahead_unserialize = {0};
+   static struct retro_perf_counter runahead_hidden_frames = {0};
+
+   rarch_perf_init(&runahead_core_run, "runahead_core_run");
+   retro_perf_start(&runahead_core_run);
+   core.retro_set_video_refresh(runahead_video_null);
+   core.retro_run();
+   retro_perf_stop(&runahead_core_run);
+
+   size = runahead_save_state();
+   if (!size)
+   {
+      core.retro_set_video_refresh(driver->retro_ctx.frame_cb);
+      return;
+   }
+
+   rarch_perf_init(&runahead_hidden_frames, "runahead_hidden_frames");
+   retro_perf_start(&runahead_hidden_frames);
+   core.retro_set_audio_sample(runahead_audio_null);
+   core.retro_set_audio_sample_batch(runahead_audio_batch_null);
+   core.retro_set_input_poll(runahead_input_poll_null);
+
+   for (i = 1; i <= frames; i++)
+   {
+      if (i == frames)
+         core.retro_set_video_refresh(driver->retro_ctx.frame_cb);
+      core.retro_run();
+   }
+
+   core.retro_set_audio_sample(driver->retro_ctx.sample_cb);
+   core.retro_set_audio_sample_batch(driver->retro_ctx.sample_batch_cb);
+   core.retro_set_input_poll(driver->retro_ctx.poll_cb);
+   retro_perf_stop(&runahead_hidden_frames);
+
+   rarch_perf_init(&runahead_unserialize, "runahead_unserialize");
+   retro_perf_start(&runahead_unserialize);
+   core.retro_unserialize(runahead_st.state, size);
+   retro_perf_stop(&runahead_unserialize);
+}
+
+void runahead_run(void)
+{
+   static struct retro_perf_counter runahead_frame = {0};
+   driver_t *driver     = driver_get_ptr();
+   global_t *global     = global_get_ptr();
+   settings_t *settings = config_get_ptr();
+   bool active          = settings->run_ahead_enable
+      && !runahead_st.unsupported
+      && !global->bsv.movie
+      && !state_manager_frame_is_reversed();
+
+#ifdef HAVE_NETPLAY
+   active = active && !driver->netplay_data;
+#endif
+
+   if (!active)
+   {
+      core.retro_run();
+      return;
+   }
+
+   rarch_perf_init(&runahead_frame, "runahead_frame");
+   retro_perf_start(&runahead_frame);
+
+#ifdef HAVE_DYNAMIC
+   if (runahead_st.secondary_loaded)
+      runahead_run_secondary(settings, driver, settings->run_ahead_frames);
+   else
+#endif
+      runahead_run_single(driver, settings->run_ahead_frames);
+
+   retro_perf_stop(&runahead_frame);
+}
+
+bool runahead_load_secondary(const struct retro_subsystem_info *special,
+      const struct retro_game_info *info, size_t num_info)
+{
+#ifdef HAVE_DYNAMIC
+   unsigned i;
+   bool ret             = false;
+   global_t *global     = global_get_ptr();
+   settings_t *settings = config_get_ptr();
+   const struct retro_hw_render_callback *hw_render =
+      (const struct retro_hw_render_callback*)video_driver_callback();
+
+   runahead_secondary_unload();
+
+   if (!settings->run_ahead_enable || !settings->run_ahead_secondary_instance)
+      return false;
+   if (global->inited.core.type != CORE_TYPE_PLAIN)
+      return false;
+
+   /* The secondary instance would need a context of its own. */
+   if (hw_render && hw_render->context_type != RETRO_HW_CONTEXT_NONE)
+   {
+      RARCH_WARN("Run-ahead secondary instance is not available with hardware rendered cores.\n");
+      return false;
+   }
+
+   if (!runahead_secondary_copy_lib(settings))
+   {
+      RARCH_ERR("Failed to copy libretro core for the run-ahead secondary instance.\n");
+      return false;
+   }
+
+   runahead_st.lib = dylib_load(runahead_st.lib_path);
+   if (!runahead_st.lib)
+   {
+      RARCH_ERR("Failed to open run-ahead secondary instance: \"%s\"\n",
+            runahead_st.lib_path);
+      RARCH_ERR("Error(s): %s\n", dylib_error());
+      goto end;
+   }
+
+   if (!libretro_load_core_symbols(runahead_st.lib, &runahead_st.secondary))
+      goto end;
+
+   runahead_st.secondary.retro_set_environment(runahead_secondary_environment);
+   runahead_st.secondary.retro_init();
+
+   runahead_st.secondary.retro_set_video_refresh(runahead_secondary_video);
+   runahead_st.secondary.retro_set_audio_sample(runahead_audio_null);
+   runahead_st.secondary.retro_set_audio_sample_batch(runahead_audio_batch_null);
+   runahead_st.secondary.retro_set_input_state(runahead_secondary_input_state);
+   runahead_st.secondary.retro_set_input_poll(runahead_input_poll_null);
+
+   if (special)
+      ret = runahead_st.secondary.retro_load_game_special(special->id,
+            info, num_info);
+   else
+      ret = runahead_st.secondary.retro_load_game(info);
+
+   if (!ret)
+   {
+      RARCH_ERR("Run-ahead secondary instance failed to load the content.\n");
+      runahead_st.secondary.retro_deinit();
+      goto end;
+   }
+
+   for (i = 0; i < MAX_USERS; i++)
+      runahead_st.devices[i] = RETRO_DEVICE_JOYPAD;
+
+   runahead_st.secondary_loaded = true;
+   RARCH_LOG("Loaded run-ahead secondary instance from \"%s\".\n",
+         runahead_st.lib_path);
+
+end:
+   if (!runahead_st.secondary_loaded)
+      runahead_secondary_unload();
+   return runahead_st.secondary_loaded;
+#else
+   (void)special;
+   (void)info;
+   (void)num_info;
+   return false;
+#endif
+}
+
+void runahead_cheat_reset(void)
+{
+#ifdef HAVE_DYNAMIC
+   if (runahead_st.secondary_loaded)
+      runahead_st.secondary.retro_cheat_reset();
+#endif
+}
+
+void runahead_cheat_set(unsigned idx, bool enabled, const char *code)
+{
+#ifdef HAVE_DYNAMIC
+   if (runahead_st.secondary_loaded)
+      runahead_st.secondary.retro_cheat_set(idx, enabled, code);
+#else
+   (void)idx;
+   (void)enabled;
+   (void)code;
+#endif
+}
+
+void runahead_deinit(void)
+{
+#ifdef HAVE_DYNAMIC
+   runahead_secondary_unload();
+#endif
+
+   free(runahead_st.state);
+   runahead_st.state       = NULL;
+   runahead_st.state_size  = 0;
+   runahead_st.unsupported = false;
+}
@@ -0,0 +1,89 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_RUNAHEAD_H
+#define __RARCH_RUNAHEAD_H
+
+#include <stddef.h>
+#include <boolean.h>
+
+#include "libretro.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * runahead_run:
+ *
+ * Runs the core for one frame. With run-ahead enabled, the frame
+ * is run without video, then run_ahead_frames more are run
+ * without audio and the last of them is shown. Those run either
+ * on the secondary instance, or on the core itself, which then
+ * gets the state from before them loaded back.
+ *
+ * Falls back to a plain retro_run() while netplay, a movie or
+ * rewinding is active, or if the core can't save states.
+ **/
+void runahead_run(void);
+
+/**
+ * runahead_load_secondary:
+ * @special          : subsystem the content was loaded with. Can be NULL.
+ * @info             : content the core was just loaded with. Can be NULL.
+ * @num_info         : number of entries in @info.
+ *
+ * Loads a second copy of the current core with the same content,
+ * if run_ahead_secondary_instance is set. Must be called while
+ * @info is still valid, right after the core loaded it.
+ *
+ * Returns: true (1) if the secondary instance was loaded,
+ * otherwise false (0).
+ **/
+bool runahead_load_secondary(const struct retro_subsystem_info *special,
+      const struct retro_game_info *info, size_t num_info);
+
+/**
+ * runahead_cheat_reset:
+ *
+ * Clears the cheats of the secondary instance, if one is loaded.
+ * Called along with the core's retro_cheat_reset().
+ **/
+void runahead_cheat_reset(void);
+
+/**
+ * runahead_cheat_set:
+ * @idx              : index of the cheat.
+ * @enabled          : whether the cheat is enabled.
+ * @code             : cheat code.
+ *
+ * Sets a cheat on the secondary instance, if one is loaded.
+ * Called along with the core's retro_cheat_set().
+ **/
+void runahead_cheat_set(unsigned idx, bool enabled, const char *code);
+
+/**
+ * runahead_deinit:
+ *
+ * Unloads the secondary instance and frees the state buffer.
+ * Called before the core unloads its content.
+ **/
+void runahead_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -28,6 +28,7 @@
 #include "retroarch.h"
 #include "runloop.h"
 #include "runloop_data.h"
+#include "runahead.h"
 
 #include "msg_hash.h"
 
@@ -53,6 +54,24 @@ static unsigned main_max_frames;
 static retro_time_t frame_limit_last_time;
 static retro_time_t frame_limit_minimum_time;
 
+/* Frames of core run time the automatic frame delay looks back on,
+ * and how long the delay has to hold before it is raised again. */
+#define FRAME_DELAY_AUTO_WINDOW 64
+#define FRAME_DELAY_AUTO_MAX    15
+
+typedef struct frame_delay_auto
+{
+   retro_time_t core_time[FRAME_DELAY_AUTO_WINDOW];
+   retro_time_t output_time;
+   retro_time_t last_frame;
+   unsigned pos;
+   unsigned delay;
+   unsigned held;
+   unsigned missed;
+} frame_delay_auto_t;
+
+static frame_delay_auto_t frame_delay_auto;
+
 /**
  * check_pause:
  * @pressed              : was libretro pause key pressed?
@@ -529,6 +548,14 @@ bool rarch_main_ctl(enum rarch_main_ctl_state state, void *data)
          rarch_main_ctl(RARCH_MAIN_CTL_STATE_FREE,  NULL);
          rarch_main_ctl(RARCH_MAIN_CTL_GLOBAL_FREE, NULL);
          break;
+      case RARCH_MAIN_CTL_ADD_OUTPUT_TIME:
+         {
+            retro_time_t *ptr = (retro_time_t*)data;
+            if (!ptr)
+               return false;
+            frame_delay_auto.output_time += *ptr;
+         }
+         break;
       case RARCH_MAIN_CTL_SET_MAX_FRAMES:
          {
             unsigned *ptr = (unsigned*)data;
@@ -877,6 +904,76 @@ static INLINE int rarch_main_iterate_time_to_exit(event_cmd_state_t *cmd)
    return 1;
 }
 
+/**
+ * frame_delay_auto_get:
+ * @current              : time the frame starts at.
+ *
+ * Picks the frame delay for this frame from how long the core
+ * took to run over the last FRAME_DELAY_AUTO_WINDOW frames, not
+ * counting time blocked on video or audio output. The
+ * delay leaves room for the slowest of them plus an eighth of a
+ * frame. It drops right away when the core gets slower or a
+ * frame is missed, and goes up by a millisecond at a time after
+ * holding for a whole window.
+ *
+ * Returns: frame delay in milliseconds.
+ **/
+static unsigned frame_delay_auto_get(settings_t *settings,
+      retro_time_t current)
+{
+   unsigned i;
+   retro_time_t worst  = 0;
+   retro_time_t period = 0;
+   retro_time_t budget = 0;
+   unsigned target     = 0;
+   unsigned old_delay  = frame_delay_auto.delay;
+   retro_time_t since  = current - frame_delay_auto.last_frame;
+
+   if (!settings->video.vsync || settings->video.refresh_rate <= 0.0f)
+      return 0;
+
+   period = (retro_time_t)(1000000.0f / settings->video.refresh_rate);
+
+   for (i = 0; i < FRAME_DELAY_AUTO_WINDOW; i++)
+   {
+      if (frame_delay_auto.core_time[i] > worst)
+         worst = frame_delay_auto.core_time[i];
+   }
+
+   budget = period - worst - period / 8;
+   if (budget > 0)
+      target = budget / 1000;
+   if (target > FRAME_DELAY_AUTO_MAX)
+      target = FRAME_DELAY_AUTO_MAX;
+
+   /* Longer gaps come from pausing, the menu or loading. */
+   if (frame_delay_auto.last_frame
+         && since > period + period / 2 && since < period * 8)
+   {
+      frame_delay_auto.missed++;
+      if (target > frame_delay_auto.delay / 2)
+         target = frame_delay_auto.delay / 2;
+   }
+
+   frame_delay_auto.last_frame = current;
+   frame_delay_auto.held++;
+
+   if (target < frame_delay_auto.delay)
+      frame_delay_auto.delay = target;
+   else if (target > frame_delay_auto.delay
+         && frame_delay_auto.held >= FRAME_DELAY_AUTO_WINDOW)
+      frame_delay_auto.delay++;
+
+   if (frame_delay_auto.delay != old_delay)
+   {
+      frame_delay_auto.held = 0;
+      RARCH_LOG("Frame delay: %u ms (slowest core frame %.2f ms, %u missed frames).\n",
+            frame_delay_auto.delay, worst / 1000.0, frame_delay_auto.missed);
+   }
+
+   return frame_delay_auto.delay;
+}
+
 /**
  * rarch_main_iterate:
  *
@@ -891,7 +988,8 @@ int rarch_main_iterate(unsigned *sleep_ms)
    unsigned i;
    retro_input_t trigger_input;
    event_cmd_state_t    cmd;
-   retro_time_t current, target, to_sleep_ms;
+   retro_time_t current, target, to_sleep_ms, core_start;
+   static struct retro_perf_counter core_run = {0};
    static retro_input_t last_input = 0;
    driver_t *driver                = driver_get_ptr();
    settings_t *settings            = config_get_ptr();
@@ -1029,11 +1127,31 @@ int rarch_main_iterate(unsigned *sleep_ms)
             settings->input.analog_dpad_mode[i]);
    }
 
-   if ((settings->video.frame_delay > 0) && !driver->nonblock_state)
-      retro_sleep(settings->video.frame_delay);
+   if (!driver->nonblock_state)
+   {
+      unsigned frame_delay = settings->video.frame_delay;
+
+      if (settings->video.frame_delay_auto)
+         frame_delay = frame_delay_auto_get(settings, retro_get_time_usec());
+
+      if (frame_delay > 0)
+         retro_sleep(frame_delay);
+   }
 
    /* Run libretro for one frame. */
-   core.retro_run();
+   rarch_perf_init(&core_run, "core_run");
+   retro_perf_start(&core_run);
+   core_start = retro_get_time_usec();
+   frame_delay_auto.output_time = 0;
+
+   runahead_run();
+
+   /* Leave out the swap and audio writes, with vsync they
+    * block for most of the frame. */
+   frame_delay_auto.core_time[frame_delay_auto.pos] =
+      retro_get_time_usec() - core_start - frame_delay_auto.output_time;
+   frame_delay_auto.pos = (frame_delay_auto.pos + 1) % FRAME_DELAY_AUTO_WINDOW;
+   retro_perf_stop(&core_run);
 
 #ifdef HAVE_CHEEVOS
    /* Test the achievements. */
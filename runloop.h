@@ -43,6 +43,9 @@ enum rarch_main_ctl_state
    RARCH_MAIN_CTL_SET_PAUSED,
    RARCH_MAIN_CTL_SET_MAX_FRAMES,
    RARCH_MAIN_CTL_SET_FRAME_LIMIT_LAST_TIME,
+   /* Adds time the core's frame spent blocked on video or
+    * audio output, which isn't counted as core run time. */
+   RARCH_MAIN_CTL_ADD_OUTPUT_TIME,
    RARCH_MAIN_CTL_CLEAR_STATE,
    RARCH_MAIN_CTL_STATE_FREE,
    RARCH_MAIN_CTL_GLOBAL_FREE,
@@ -20,6 +20,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stddef.h>
 #include <time.h>
 #include <boolean.h>
@@ -32,6 +33,10 @@
 #include <compat/strl.h>
 
 #include <formats/rbmp.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <rthreads/async_job.h>
+#endif
 
 #if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
 #include <formats/rpng.h>
@@ -52,25 +57,309 @@
 #include "config.h"
 #endif
 
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG) && !defined(_XBOX1)
+#define HAVE_SCREENSHOT_TASKS
+#define SCREENSHOT_TASKS 4
+#endif
+
+/* Names the file after the current time. Screenshots taken in
+ * the same second get -2, -3, ... appended instead of replacing
+ * each other. */
+static void screenshot_filename(char *filename, const char *folder,
+      size_t size)
+{
+   static char last_shotname[PATH_MAX_LENGTH] = {0};
+   static unsigned count                      = 0;
+   char shotname[PATH_MAX_LENGTH]             = {0};
+
+   fill_dated_filename(shotname, IMG_EXT, sizeof(shotname));
+
+   if (!strcmp(shotname, last_shotname))
+   {
+      char basename[PATH_MAX_LENGTH] = {0};
+
+      strlcpy(basename, shotname, sizeof(basename));
+      path_remove_extension(basename);
+      snprintf(shotname, sizeof(shotname), "%s-%u.%s",
+            basename, ++count + 1, IMG_EXT);
+   }
+   else
+   {
+      strlcpy(last_shotname, shotname, sizeof(last_shotname));
+      count = 0;
+   }
+
+   fill_pathname_join(filename, folder, shotname, size);
+}
+
+#if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG) && !defined(_XBOX1)
+static enum scaler_pix_fmt screenshot_pix_fmt(bool bgr24)
+{
+   if (bgr24)
+      return SCALER_FMT_BGR24;
+   else if (video_driver_get_pixel_format() == RETRO_PIXEL_FORMAT_XRGB8888)
+      return SCALER_FMT_ARGB8888;
+   return SCALER_FMT_RGB565;
+}
+
+/* Converts the frame, starting at its top row, to BGR24 in
+ * @out_buffer and saves it as PNG. */
+static bool screenshot_save_png(const char *filename, uint8_t *out_buffer,
+      const uint8_t *frame, unsigned width, unsigned height, int stride,
+      enum scaler_pix_fmt in_fmt)
+{
+   struct scaler_ctx scaler = {0};
+
+   scaler.in_width    = width;
+   scaler.in_height   = height;
+   scaler.out_width   = width;
+   scaler.out_height  = height;
+   scaler.in_stride   = stride;
+   scaler.out_stride  = width * 3;
+   scaler.in_fmt      = in_fmt;
+   scaler.out_fmt     = SCALER_FMT_BGR24;
+   scaler.scaler_type = SCALER_TYPE_POINT;
+
+   scaler_ctx_gen_filter(&scaler);
+   scaler_ctx_scale(&scaler, out_buffer, frame);
+   scaler_ctx_gen_reset(&scaler);
+
+   return rpng_save_image_bgr24(filename,
+         out_buffer, width, height, width * 3);
+}
+#endif
+
+#ifdef HAVE_SCREENSHOT_TASKS
+typedef struct screenshot_task
+{
+   /* Frame copied top-down, without padding. */
+   uint8_t *frame;
+   size_t frame_size;
+   uint8_t *out_buffer;
+   size_t out_size;
+
+   unsigned width;
+   unsigned height;
+   enum scaler_pix_fmt in_fmt;
+   bool busy;
+   char filename[PATH_MAX_LENGTH];
+} screenshot_task_t;
+
+typedef struct screenshot_tasks
+{
+   async_job_t *job;
+   slock_t *lock;
+   scond_t *cond;
+   unsigned pending;
+   screenshot_task_t tasks[SCREENSHOT_TASKS];
+} screenshot_tasks_t;
+
+static screenshot_tasks_t screenshot_st;
+
+static unsigned screenshot_pix_fmt_size(enum scaler_pix_fmt fmt)
+{
+   switch (fmt)
+   {
+      case SCALER_FMT_ARGB8888:
+         return 4;
+      case SCALER_FMT_BGR24:
+         return 3;
+      default:
+         break;
+   }
+
+   return 2;
+}
+
+static bool screenshot_tasks_init(void)
+{
+   if (screenshot_st.job)
+      return true;
+
+   screenshot_st.lock = slock_new();
+   screenshot_st.cond = scond_new();
+   screenshot_st.job  = async_job_new();
+
+   if (screenshot_st.lock && screenshot_st.cond && screenshot_st.job)
+      return true;
+
+   screenshot_deinit();
+   return false;
+}
+
+static void screenshot_task_run(void *payload)
+{
+   /* Room for the message and a whole path. */
+   char tmp[PATH_MAX_LENGTH + 128] = {0};
+   const char *msg                 = NULL;
+   screenshot_task_t *task         = (screenshot_task_t*)payload;
+   unsigned stride                 = task->width * screenshot_pix_fmt_size(task->in_fmt);
+   bool ret                        = screenshot_save_png(task->filename,
+         task->out_buffer, task->frame, task->width, task->height,
+         stride, task->in_fmt);
+
+   if (ret)
+   {
+      snprintf(tmp, sizeof(tmp), "%s %s",
+            msg_hash_to_str(MSG_SCREENSHOT_SAVED_TO), task->filename);
+      RARCH_LOG("%s.\n", tmp);
+      msg = tmp;
+   }
+   else
+   {
+      RARCH_ERR("%s.\n", msg_hash_to_str(MSG_FAILED_TO_TAKE_SCREENSHOT));
+      msg = msg_hash_to_str(MSG_FAILED_TO_TAKE_SCREENSHOT);
+   }
+
+   rarch_main_msg_queue_push(msg, 1, 180, false);
+
+   slock_lock(screenshot_st.lock);
+   task->busy = false;
+   screenshot_st.pending--;
+   scond_signal(screenshot_st.cond);
+   slock_unlock(screenshot_st.lock);
+}
+
+/* Returns a task whose buffers fit the frame, or NULL if all
+ * of them are still being written. */
+static screenshot_task_t *screenshot_task_get(unsigned width,
+      unsigned height, enum scaler_pix_fmt in_fmt)
+{
+   unsigned i;
+   size_t frame_size       = (size_t)width * height * screenshot_pix_fmt_size(in_fmt);
+   size_t out_size         = (size_t)width * height * 3;
+   screenshot_task_t *task = NULL;
+
+   slock_lock(screenshot_st.lock);
+   for (i = 0; i < SCREENSHOT_TASKS; i++)
+   {
+      if (!screenshot_st.tasks[i].busy)
+      {
+         task = &screenshot_st.tasks[i];
+         break;
+      }
+   }
+   slock_unlock(screenshot_st.lock);
+
+   if (!task)
+      return NULL;
+
+   if (task->frame_size < frame_size)
+   {
+      uint8_t *frame = (uint8_t*)realloc(task->frame, frame_size);
+      if (!frame)
+         return NULL;
+      task->frame      = frame;
+      task->frame_size = frame_size;
+   }
+
+   if (task->out_size < out_size)
+   {
+      uint8_t *out_buffer = (uint8_t*)realloc(task->out_buffer, out_size);
+      if (!out_buffer)
+         return NULL;
+      task->out_buffer = out_buffer;
+      task->out_size   = out_size;
+   }
+
+   task->width  = width;
+   task->height = height;
+   task->in_fmt = in_fmt;
+
+   return task;
+}
+
+/* Copies the frame and leaves converting and saving it to the
+ * screenshot thread. */
+static bool screenshot_dump_async(const char *filename, const void *frame,
+      unsigned width, unsigned height, int pitch, bool bgr24)
+{
+   unsigned y, row_size;
+   screenshot_task_t *task    = NULL;
+   enum scaler_pix_fmt in_fmt = screenshot_pix_fmt(bgr24);
+
+   if (!screenshot_tasks_init())
+      return false;
+
+   if (!(task = screenshot_task_get(width, height, in_fmt)))
+      return false;
+
+   row_size = width * screenshot_pix_fmt_size(in_fmt);
+
+   for (y = 0; y < height; y++)
+      memcpy(task->frame + y * row_size,
+            (const uint8_t*)frame + ((int)height - 1 - (int)y) * pitch,
+            row_size);
+
+   strlcpy(task->filename, filename, sizeof(task->filename));
+
+   slock_lock(screenshot_st.lock);
+   task->busy = true;
+   screenshot_st.pending++;
+   slock_unlock(screenshot_st.lock);
+
+   if (async_job_add(screenshot_st.job, screenshot_task_run, task) < 0)
+   {
+      slock_lock(screenshot_st.lock);
+      task->busy = false;
+      screenshot_st.pending--;
+      slock_unlock(screenshot_st.lock);
+      return false;
+   }
+
+   return true;
+}
+#endif
+
+/**
+ * screenshot_deinit:
+ *
+ * Waits for the screenshots still being saved, then frees
+ * the screenshot thread and its buffers.
+ **/
+void screenshot_deinit(void)
+{
+#ifdef HAVE_SCREENSHOT_TASKS
+   unsigned i;
+
+   if (screenshot_st.lock && screenshot_st.cond)
+   {
+      slock_lock(screenshot_st.lock);
+      while (screenshot_st.pending)
+         scond_wait(screenshot_st.cond, screenshot_st.lock);
+      slock_unlock(screenshot_st.lock);
+   }
+
+   if (screenshot_st.job)
+      async_job_free(screenshot_st.job);
+   if (screenshot_st.cond)
+      scond_free(screenshot_st.cond);
+   if (screenshot_st.lock)
+      slock_free(screenshot_st.lock);
+
+   for (i = 0; i < SCREENSHOT_TASKS; i++)
+   {
+      free(screenshot_st.tasks[i].frame);
+      free(screenshot_st.tasks[i].out_buffer);
+   }
+
+   memset(&screenshot_st, 0, sizeof(screenshot_st));
+#endif
+}
+
 /* Take frame bottom-up. */
 static bool screenshot_dump(const char *folder, const void *frame,
       unsigned width, unsigned height, int pitch, bool bgr24)
 {
    bool ret;
    char filename[PATH_MAX_LENGTH] = {0};
-   char shotname[PATH_MAX_LENGTH] = {0};
-   struct scaler_ctx scaler       = {0};
-   RFILE *file                    = NULL;
    uint8_t *out_buffer            = NULL;
    driver_t *driver               = driver_get_ptr();
 
-   (void)file;
    (void)out_buffer;
-   (void)scaler;
    (void)driver;
 
-   fill_dated_filename(shotname, IMG_EXT, sizeof(shotname));
-   fill_pathname_join(filename, folder, shotname, sizeof(filename));
+   screenshot_filename(filename, folder, sizeof(filename));
 
 #ifdef _XBOX1
    d3d_video_t *d3d = (d3d_video_t*)driver->video_data;
@@ -86,34 +375,21 @@ static bool screenshot_dump(const char *folder, const void *frame,
    else
       ret = false;
 #elif defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_RPNG)
+#ifdef HAVE_SCREENSHOT_TASKS
+   /* Saved on the screenshot thread, unless all its buffers
+    * are in use. */
+   if (screenshot_dump_async(filename, frame, width, height, pitch, bgr24))
+      return true;
+#endif
+
    out_buffer = (uint8_t*)malloc(width * height * 3);
    if (!out_buffer)
       return false;
 
-   scaler.in_width    = width;
-   scaler.in_height   = height;
-   scaler.out_width   = width;
-   scaler.out_height  = height;
-   scaler.in_stride   = -pitch;
-   scaler.out_stride  = width * 3;
-   scaler.out_fmt     = SCALER_FMT_BGR24;
-   scaler.scaler_type = SCALER_TYPE_POINT;
-
-   if (bgr24)
-      scaler.in_fmt = SCALER_FMT_BGR24;
-   else if (video_driver_get_pixel_format() == RETRO_PIXEL_FORMAT_XRGB8888)
-      scaler.in_fmt = SCALER_FMT_ARGB8888;
-   else
-      scaler.in_fmt = SCALER_FMT_RGB565;
-
-   scaler_ctx_gen_filter(&scaler);
-   scaler_ctx_scale(&scaler, out_buffer,
-         (const uint8_t*)frame + ((int)height - 1) * pitch);
-   scaler_ctx_gen_reset(&scaler);
-
    RARCH_LOG("Using RPNG for PNG screenshots.\n");
-   ret = rpng_save_image_bgr24(filename,
-         out_buffer, width, height, width * 3);
+   ret = screenshot_save_png(filename, out_buffer,
+         (const uint8_t*)frame + ((int)height - 1) * pitch,
+         width, height, -pitch, screenshot_pix_fmt(bgr24));
    free(out_buffer);
 #else
    ret = rbmp_save_image(filename, frame, width, height, pitch, bgr24,
@@ -27,6 +27,8 @@ extern "C" {
 
 bool take_screenshot(void);
 
+void screenshot_deinit(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,17 +16,20 @@
 #include <compat/strcasestr.h>
 #include <compat/strl.h>
 #include <retro_endianness.h>
+#include <rhash.h>
 
 #include "tasks.h"
 
 #ifdef HAVE_LIBRETRODB
 #include "../database_info.h"
+#include "../database_index.h"
 #endif
 
 #include "../dir_list_special.h"
 #include "../file_ops.h"
 #include "../msg_hash.h"
 #include "../general.h"
+#include "../performance.h"
 
 #define CB_DB_SCAN_FILE                0x70ce56d2U
 #define CB_DB_SCAN_FOLDER              0xde2bef8eU
@@ -41,14 +44,28 @@
 #define COLLECTION_SIZE                99999
 #endif
 
+#define DATABASE_INDEX_FILE            "content_database.idx"
+#define DATABASE_INDEX_MAX_MATCHES     64
+
+#define DATABASE_SCAN_MAX_THREADS      8
+/* Files each worker may read ahead of the lookups. */
+#define DATABASE_SCAN_WINDOW           4
+/* Files looked up per iteration once the index is built. */
+#define DATABASE_SCAN_BATCH            64
+/* How long the data thread waits for the next file. */
+#define DATABASE_SCAN_WAIT_US          10000
+
 typedef struct database_state_handle
 {
    database_info_list_t *info;
    struct string_list *list;
+   database_index_t *index;
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+   database_scan_t *scan;
+#endif
    size_t list_index;
    size_t entry_index;
    uint32_t crc;
-   uint8_t *buf;
    char zip_name[PATH_MAX_LENGTH];
    char serial[4096];
 } database_state_handle_t;
@@ -204,16 +221,12 @@ static int database_info_iterate_playlist(
          return 1;
       default:
          {
-            ssize_t ret;
-            int read_from            = read_file(name, (void**)&db_state->buf, &ret);
+            rhash_result_t hash;
 
-            if (read_from != 1 || ret <= 0)
+            if (rhash_file(name, RHASH_CRC32, &hash) < 0 || !hash.size)
                return 0;
 
-
-#ifdef HAVE_ZLIB
-            db_state->crc = zlib_crc32_calculate(db_state->buf, ret);
-#endif
+            db_state->crc = hash.crc32;
             db->type = DATABASE_TYPE_CRC_LOOKUP;
          }
          break;
@@ -222,6 +235,76 @@ static int database_info_iterate_playlist(
    return 1;
 }
 
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+static int database_info_scan_zip_cb(const char *name, const char *valid_exts,
+      const uint8_t *cdata, unsigned cmode, uint32_t csize, uint32_t size,
+      uint32_t crc32, void *userdata)
+{
+   database_scan_result_t *result = (database_scan_result_t*)userdata;
+
+   result->crc = crc32;
+   strlcpy(result->zip_name, name, sizeof(result->zip_name));
+
+   /* Only the first entry is looked up. */
+   return 0;
+}
+
+/* Runs on the scan workers: does the file reading and hashing that
+ * database_info_iterate_playlist() does on the data thread. */
+static void database_info_scan_file(const char *name,
+      database_scan_result_t *result, void *userdata)
+{
+   uint32_t extension_hash = msg_hash_calculate(path_get_extension(name));
+
+   (void)userdata;
+
+   switch (extension_hash)
+   {
+      case HASH_EXTENSION_ZIP:
+         zlib_parse_file(name, NULL, database_info_scan_zip_cb, result);
+         if (result->crc)
+            result->type = DATABASE_SCAN_ZIP_CRC;
+         break;
+      case HASH_EXTENSION_CUE:
+      case HASH_EXTENSION_CUE_UPPERCASE:
+         cue_get_serial(NULL, NULL, name, result->serial);
+         result->type = DATABASE_SCAN_SERIAL;
+         break;
+      case HASH_EXTENSION_ISO:
+      case HASH_EXTENSION_ISO_UPPERCASE:
+         iso_get_serial(NULL, NULL, name, result->serial);
+         result->type = DATABASE_SCAN_SERIAL;
+         break;
+      default:
+         {
+            rhash_result_t hash;
+
+            if (rhash_file(name, RHASH_CRC32, &hash) == 0 && hash.size)
+            {
+               result->crc  = hash.crc32;
+               result->type = DATABASE_SCAN_CRC;
+            }
+         }
+         break;
+   }
+}
+
+static database_scan_t *database_info_scan_new(const struct string_list *list)
+{
+   unsigned threads = retro_get_cpu_cores() * 2;
+
+   /* Oversubscribed on purpose, most of the time goes to waiting
+    * on the disk or the network. */
+   if (threads > DATABASE_SCAN_MAX_THREADS)
+      threads = DATABASE_SCAN_MAX_THREADS;
+   if (threads < 2)
+      threads = 2;
+
+   return database_scan_new(list, threads, threads * DATABASE_SCAN_WINDOW,
+         database_info_scan_file, NULL);
+}
+#endif
+
 static int database_info_list_iterate_end_no_match(database_state_handle_t *db_state)
 {
    /* Reached end of database list, CRC match probably didn't succeed. */
@@ -306,6 +389,8 @@ static int database_info_list_iterate_found_match(
    content_playlist_push(playlist, entry_path_str,
          db_info_entry->name, "DETECT", "DETECT", db_crc, db_playlist_base_str);
 
+   if (playlist)
+      playlist->compact = settings->playlist_compact;
    content_playlist_write_file(playlist);
    content_playlist_free(playlist);
    return 0;
@@ -326,11 +411,89 @@ static int database_info_list_iterate_next(
    return 1;
 }
 
+static database_index_t *database_info_index_new(
+      const struct string_list *list)
+{
+   char index_path[PATH_MAX_LENGTH] = {0};
+   settings_t *settings             = config_get_ptr();
+   const char *dir                  = settings->cache_directory;
+   database_index_t *index          = NULL;
+
+   if (!*dir)
+      dir = settings->playlist_directory;
+
+   if (*dir)
+      fill_pathname_join(index_path, dir, DATABASE_INDEX_FILE,
+            sizeof(index_path));
+
+   index = database_index_new(list, *index_path ? index_path : NULL);
+
+   if (index)
+      RARCH_LOG("Database index: %u keys from %u databases.\n",
+            (unsigned)database_index_size(index), (unsigned)list->size);
+
+   return index;
+}
+
+/* Looks the content up in the database index and adds every
+ * matching record, all in one step. */
+static int database_info_index_lookup(
+      database_state_handle_t *db_state,
+      database_info_handle_t *db,
+      const char *zip_entry, bool serial)
+{
+   size_t i, count;
+   database_index_match_t matches[DATABASE_INDEX_MAX_MATCHES];
+
+   if (serial)
+      count = database_index_find_serial(db_state->index,
+            db_state->serial, matches, DATABASE_INDEX_MAX_MATCHES);
+   else
+      count = database_index_find_crc(db_state->index,
+            db_state->crc, matches, DATABASE_INDEX_MAX_MATCHES);
+
+   for (i = 0; i < count; i++)
+   {
+      database_info_t *db_info_entry = NULL;
+      const char *db_path            =
+         db_state->list->elems[matches[i].db].data;
+
+      if (db_state->info)
+         database_info_list_free(db_state->info);
+      db_state->info        = database_info_list_new_at(db_path,
+            matches[i].offset);
+      db_state->list_index  = matches[i].db;
+      db_state->entry_index = 0;
+
+      if (!db_state->info)
+         continue;
+
+      db_info_entry = &db_state->info->list[0];
+
+      if (serial)
+      {
+         if (db_info_entry->serial &&
+               !strcmp(db_state->serial, db_info_entry->serial))
+            database_info_list_iterate_found_match(db_state, db, NULL);
+      }
+      else if (db_state->crc == db_info_entry->crc32)
+         database_info_list_iterate_found_match(db_state, db, zip_entry);
+   }
+
+   if (db_state->info)
+      database_info_list_free(db_state->info);
+   db_state->info = NULL;
+
+   return database_info_list_iterate_end_no_match(db_state);
+}
+
 static int database_info_iterate_crc_lookup(
       database_state_handle_t *db_state,
       database_info_handle_t *db,
       const char *zip_entry)
 {
+   if (db_state->index)
+      return database_info_index_lookup(db_state, db, zip_entry, false);
 
    if (!db_state->list || (unsigned)db_state->list_index == (unsigned)db_state->list->size)
       return database_info_list_iterate_end_no_match(db_state);
@@ -402,6 +565,9 @@ static int database_info_iterate_serial_lookup(
       database_state_handle_t *db_state,
       database_info_handle_t *db, const char *name)
 {
+   if (db_state->index)
+      return database_info_index_lookup(db_state, db, NULL, true);
+
    if (!db_state->list || (unsigned)db_state->list_index == (unsigned)db_state->list->size)
       return database_info_list_iterate_end_no_match(db_state);
 
@@ -478,6 +644,72 @@ static int database_info_iterate(database_state_handle_t *db_state, database_inf
    return 0;
 }
 
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+/* Takes the next results off the scan workers, in list order. With
+ * the index built every lookup is a single step, so whole batches of
+ * files are matched per call; otherwise the lookup is left to step
+ * through the databases as usual. Returns 0 when db->list_ptr is the
+ * last file handled, to move on through DATABASE_STATUS_ITERATE_NEXT. */
+static int database_info_iterate_scan(database_state_handle_t *db_state,
+      database_info_handle_t *db, bool is_thread)
+{
+   unsigned i;
+
+   for (i = 0; i < DATABASE_SCAN_BATCH; i++)
+   {
+      database_scan_result_t result;
+
+      if (!database_scan_fetch(db_state->scan, db->list_ptr, &result,
+               (is_thread && i == 0) ? DATABASE_SCAN_WAIT_US : 0))
+      {
+         if (!i)
+            return 1;
+
+         /* Leave the file that isn't ready to ITERATE_NEXT. */
+         db->list_ptr--;
+         return 0;
+      }
+
+      switch (result.type)
+      {
+         case DATABASE_SCAN_NONE:
+            break;
+         case DATABASE_SCAN_CRC:
+            db_state->crc = result.crc;
+            db->type      = DATABASE_TYPE_CRC_LOOKUP;
+            break;
+         case DATABASE_SCAN_ZIP_CRC:
+            db_state->crc = result.crc;
+            strlcpy(db_state->zip_name, result.zip_name,
+                  sizeof(db_state->zip_name));
+            db->type      = DATABASE_TYPE_ITERATE_ZIP;
+            break;
+         case DATABASE_SCAN_SERIAL:
+            strlcpy(db_state->serial, result.serial,
+                  sizeof(db_state->serial));
+            db->type      = DATABASE_TYPE_SERIAL_LOOKUP;
+            break;
+      }
+
+      if (db->type != DATABASE_TYPE_ITERATE)
+      {
+         if (!db_state->index)
+            return 1;
+
+         database_info_iterate(db_state, db);
+         db->type = DATABASE_TYPE_ITERATE;
+      }
+
+      if (i + 1 == DATABASE_SCAN_BATCH || db->list_ptr + 1 >= db->list->size)
+         break;
+
+      db->list_ptr++;
+   }
+
+   return 0;
+}
+#endif
+
 static int database_info_poll(db_handle_t *db)
 {
    char elem0[PATH_MAX_LENGTH];
@@ -520,18 +752,9 @@ error:
    return -1;
 }
 
-static void rarch_main_data_db_cleanup_state(database_state_handle_t *db_state)
-{
-   if (!db_state)
-      return;
-
-   if (db_state->buf)
-      free(db_state->buf);
-   db_state->buf = NULL;
-}
-
 void rarch_main_data_db_iterate(bool is_thread)
 {
+   int ret;
    database_info_handle_t      *db   = (db_ptr) ? db_ptr->handle : NULL;
    database_state_handle_t *db_state = (db_ptr) ? &db_ptr->state : NULL;
    const char *name = db ? db->list->elems[db->list_ptr].data    : NULL;
@@ -544,16 +767,28 @@ void rarch_main_data_db_iterate(bool is_thread)
       case DATABASE_STATUS_ITERATE_BEGIN:
          if (db_state && !db_state->list)
             db_state->list = dir_list_new_special(NULL, DIR_LIST_DATABASES, NULL);
+         if (db_state && db_state->list && !db_state->index)
+            db_state->index = database_info_index_new(db_state->list);
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+         if (db_state && !db_state->scan)
+            db_state->scan = database_info_scan_new(db->list);
+#endif
          db->status = DATABASE_STATUS_ITERATE_START;
          break;
       case DATABASE_STATUS_ITERATE_START:
-         rarch_main_data_db_cleanup_state(db_state);
          db_state->list_index  = 0;
          db_state->entry_index = 0;
          database_info_iterate_start(db, name);
          break;
       case DATABASE_STATUS_ITERATE:
-         if (database_info_iterate(&db_ptr->state, db) == 0)
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+         if (db_state->scan && db->type == DATABASE_TYPE_ITERATE)
+            ret = database_info_iterate_scan(db_state, db, is_thread);
+         else
+#endif
+            ret = database_info_iterate(db_state, db);
+
+         if (ret == 0)
          {
             db->status = DATABASE_STATUS_ITERATE_NEXT;
             db->type   = DATABASE_TYPE_ITERATE;
@@ -576,7 +811,12 @@ void rarch_main_data_db_iterate(bool is_thread)
          if (db_state->list)
             dir_list_free(db_state->list);
          db_state->list = NULL;
-         rarch_main_data_db_cleanup_state(db_state);
+         database_index_free(db_state->index);
+         db_state->index = NULL;
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+         database_scan_free(db_state->scan);
+         db_state->scan = NULL;
+#endif
          database_info_free(db);
          if (db_ptr->handle)
             free(db_ptr->handle);
@@ -619,6 +859,11 @@ msg_queue_t *rarch_main_data_db_get_msg_queue_ptr(void)
 
 void rarch_main_data_db_uninit(void)
 {
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+   /* Workers still point at the file list. */
+   if (db_ptr)
+      database_scan_free(db_ptr->state.scan);
+#endif
    if (db_ptr)
       free(db_ptr);
    db_ptr = NULL;
@@ -0,0 +1,228 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rthreads/rthreads.h>
+
+#include "tasks.h"
+
+#ifdef HAVE_THREADS
+/* Worker pool behind the database scan. Workers take files in list
+ * order and read, inflate and hash them; the scan task collects the
+ * results in the same order. Workers only run up to one window of
+ * files ahead of the scan task, which bounds the memory in flight and
+ * stops a slow consumer from being buried by fast disks. */
+
+typedef struct database_scan_slot
+{
+   database_scan_result_t result;
+   bool done;
+} database_scan_slot_t;
+
+struct database_scan
+{
+   const struct string_list *list;
+   database_scan_file_t scan_file;
+   void *userdata;
+
+   database_scan_slot_t *slots;
+   unsigned window;
+
+   /* Next file handed to a worker. */
+   size_t next;
+   /* Next file the scan task collects. */
+   size_t consumed;
+   bool quit;
+
+   slock_t *lock;
+   /* Workers wait here for room in the window. */
+   scond_t *space;
+   /* The scan task waits here for the next result. */
+   scond_t *ready;
+
+   sthread_t **threads;
+   unsigned num_threads;
+};
+
+static void database_scan_worker(void *data)
+{
+   database_scan_t *scan = (database_scan_t*)data;
+
+   slock_lock(scan->lock);
+
+   for (;;)
+   {
+      size_t index;
+      database_scan_slot_t *slot = NULL;
+
+      while (!scan->quit && scan->next < scan->list->size
+            && scan->next >= scan->consumed + scan->window)
+         scond_wait(scan->space, scan->lock);
+
+      if (scan->quit || scan->next >= scan->list->size)
+         break;
+
+      index = scan->next++;
+      slot  = &scan->slots[index % scan->window];
+      slock_unlock(scan->lock);
+
+      memset(&slot->result, 0, sizeof(slot->result));
+      scan->scan_file(scan->list->elems[index].data,
+            &slot->result, scan->userdata);
+
+      slock_lock(scan->lock);
+      slot->done = true;
+      if (index == scan->consumed)
+         scond_signal(scan->ready);
+   }
+
+   slock_unlock(scan->lock);
+}
+
+/**
+ * database_scan_new:
+ * @list                : Files to scan; must outlive the scan.
+ * @threads             : Number of workers.
+ * @window              : How many files workers may run ahead.
+ * @scan_file           : Called on a worker for every file.
+ * @userdata            : Passed to @scan_file.
+ *
+ * Returns: scan handle, or NULL on failure.
+ **/
+database_scan_t *database_scan_new(const struct string_list *list,
+      unsigned threads, unsigned window,
+      database_scan_file_t scan_file, void *userdata)
+{
+   unsigned i;
+   database_scan_t *scan = NULL;
+
+   if (!list || !threads || !window || !scan_file)
+      return NULL;
+
+   scan = (database_scan_t*)calloc(1, sizeof(*scan));
+   if (!scan)
+      return NULL;
+
+   scan->list      = list;
+   scan->scan_file = scan_file;
+   scan->userdata  = userdata;
+   scan->window    = window;
+   scan->slots     = (database_scan_slot_t*)
+      calloc(window, sizeof(*scan->slots));
+   scan->threads   = (sthread_t**)calloc(threads, sizeof(*scan->threads));
+   scan->lock      = slock_new();
+   scan->space     = scond_new();
+   scan->ready     = scond_new();
+
+   if (!scan->slots || !scan->threads || !scan->lock
+         || !scan->space || !scan->ready)
+      goto error;
+
+   for (i = 0; i < threads; i++)
+   {
+      scan->threads[i] = sthread_create(database_scan_worker, scan);
+      if (!scan->threads[i])
+         break;
+      scan->num_threads++;
+   }
+
+   if (!scan->num_threads)
+      goto error;
+
+   return scan;
+
+error:
+   database_scan_free(scan);
+   return NULL;
+}
+
+/**
+ * database_scan_fetch:
+ * @scan                : Scan handle.
+ * @index               : List index of the result to collect.
+ * @result              : Filled with the result.
+ * @timeout_us          : How long to wait for it, 0 to just poll.
+ *
+ * Results have to be collected in list order.
+ *
+ * Returns: true if @result was filled, false if it isn't ready yet.
+ **/
+bool database_scan_fetch(database_scan_t *scan, size_t index,
+      database_scan_result_t *result, int64_t timeout_us)
+{
+   database_scan_slot_t *slot = NULL;
+   bool ret                   = false;
+
+   if (!scan || index != scan->consumed || index >= scan->list->size)
+      return false;
+
+   slot = &scan->slots[index % scan->window];
+
+   slock_lock(scan->lock);
+
+   if (!slot->done && timeout_us > 0)
+      scond_wait_timeout(scan->ready, scan->lock, timeout_us);
+
+   if (slot->done)
+   {
+      memcpy(result, &slot->result, sizeof(*result));
+      slot->done = false;
+      scan->consumed++;
+      scond_broadcast(scan->space);
+      ret = true;
+   }
+
+   slock_unlock(scan->lock);
+
+   return ret;
+}
+
+/**
+ * database_scan_free:
+ * @scan                : Scan handle.
+ *
+ * Stops the workers, after the files they're on, and frees the scan.
+ **/
+void database_scan_free(database_scan_t *scan)
+{
+   unsigned i;
+
+   if (!scan)
+      return;
+
+   if (scan->lock && scan->space)
+   {
+      slock_lock(scan->lock);
+      scan->quit = true;
+      scond_broadcast(scan->space);
+      slock_unlock(scan->lock);
+   }
+
+   for (i = 0; i < scan->num_threads; i++)
+      sthread_join(scan->threads[i]);
+
+   if (scan->ready)
+      scond_free(scan->ready);
+   if (scan->space)
+      scond_free(scan->space);
+   if (scan->lock)
+      slock_free(scan->lock);
+   free(scan->threads);
+   free(scan->slots);
+   free(scan);
+}
+#endif
@@ -20,6 +20,8 @@
 #include <boolean.h>
 
 #include <queues/message_queue.h>
+#include <string/string_list.h>
+#include <retro_miscellaneous.h>
 
 #include "../runloop_data.h"
 
@@ -87,6 +89,38 @@ void rarch_main_data_db_uninit(void);
 void rarch_main_data_db_init(void);
 
 bool rarch_main_data_db_is_active(void);
+
+#ifdef HAVE_THREADS
+enum database_scan_type
+{
+   DATABASE_SCAN_NONE = 0,
+   DATABASE_SCAN_CRC,
+   DATABASE_SCAN_ZIP_CRC,
+   DATABASE_SCAN_SERIAL
+};
+
+typedef struct database_scan_result
+{
+   enum database_scan_type type;
+   uint32_t crc;
+   char zip_name[PATH_MAX_LENGTH];
+   char serial[4096];
+} database_scan_result_t;
+
+typedef struct database_scan database_scan_t;
+
+typedef void (*database_scan_file_t)(const char *path,
+      database_scan_result_t *result, void *userdata);
+
+database_scan_t *database_scan_new(const struct string_list *list,
+      unsigned threads, unsigned window,
+      database_scan_file_t scan_file, void *userdata);
+
+bool database_scan_fetch(database_scan_t *scan, size_t index,
+      database_scan_result_t *result, int64_t timeout_us);
+
+void database_scan_free(database_scan_t *scan);
+#endif
 #endif
 
 #ifdef HAVE_OVERLAY
@@ -0,0 +1,293 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Loads generated config files of growing size, one of them pulling
+ * in an #include, then reads every key back the way config_load()
+ * does. Times the indexed lookups against walking the entry list, as
+ * config_get_entry() used to. Fails if the two disagree, if keys from
+ * an #include stop taking precedence the way they used to, or if
+ * writing the file back changes its order. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <compat/strl.h>
+#include <file/config_file.h>
+#include <rhash.h>
+
+#define BENCH_INCLUDE_KEYS  100
+#define BENCH_PASSES        5
+#define BENCH_DIR           "/tmp"
+
+static const unsigned bench_sizes[] = { 100, 1000, 10000 };
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+/* These live in the frontend; the bench only reads plain values. */
+void fill_pathname_expand_special(char *out_path,
+      const char *in_path, size_t size)
+{
+   strlcpy(out_path, in_path, size);
+}
+
+void fill_pathname_abbreviate_special(char *out_path,
+      const char *in_path, size_t size)
+{
+   strlcpy(out_path, in_path, size);
+}
+
+/* What config_get_entry() did before the index. */
+static const char *list_lookup(config_file_t *conf, const char *key)
+{
+   const struct config_entry_list *entry = NULL;
+   uint32_t hash                         = djb2_calculate(key);
+
+   for (entry = conf->entries; entry; entry = entry->next)
+   {
+      if (hash == entry->key_hash && !strcmp(key, entry->key))
+         return entry->value;
+   }
+
+   return NULL;
+}
+
+static void key_name(char *buf, size_t size, unsigned i)
+{
+   /* Shaped like retroarch.cfg keys, which share long prefixes. */
+   snprintf(buf, size, "input_player%u_btn_%u", i % 16, i);
+}
+
+static bool write_config(const char *path, const char *include,
+      unsigned keys)
+{
+   unsigned i;
+   FILE *file = fopen(path, "w");
+
+   if (!file)
+      return false;
+
+   fprintf(file, "# Generated by config-file-bench.\n");
+   if (include)
+      fprintf(file, "#include \"%s\"\n", include);
+
+   for (i = 0; i < keys; i++)
+   {
+      char key[64];
+      key_name(key, sizeof(key), i);
+      fprintf(file, "%s = \"%u\"\n", key, i);
+   }
+
+   fclose(file);
+   return true;
+}
+
+static bool check_include(config_file_t *conf, unsigned keys)
+{
+   char buf[64];
+   unsigned i;
+   int val = 0;
+
+   /* Keys only the include has. */
+   for (i = 0; i < BENCH_INCLUDE_KEYS; i++)
+   {
+      snprintf(buf, sizeof(buf), "include_only_%u", i);
+      if (!config_get_int(conf, buf, &val) || val != (int)i)
+         return false;
+   }
+
+   /* The include comes first in the file, so it wins over the same
+    * key further down, and config_set_* can't overwrite it. */
+   key_name(buf, sizeof(buf), 0);
+   if (!config_get_int(conf, buf, &val) || val != -1)
+      return false;
+
+   config_set_int(conf, buf, 1234);
+   if (!config_get_int(conf, buf, &val) || val != -1)
+      return false;
+
+   /* A new key has to be found right after it's set. */
+   config_set_int(conf, "bench_new_key", (int)keys);
+   return config_get_int(conf, "bench_new_key", &val) && val == (int)keys;
+}
+
+static bool check_write(config_file_t *conf, const char *path, unsigned keys)
+{
+   unsigned i;
+   char line[256], expected[128];
+   FILE *file = NULL;
+   bool ret   = false;
+
+   if (!config_file_write(conf, path) || !(file = fopen(path, "r")))
+      return false;
+
+   /* Includes first, then only this file's keys, in file order. */
+   if (!fgets(line, sizeof(line), file) || strncmp(line, "#include ", 9))
+      goto end;
+
+   for (i = 0; i < keys; i++)
+   {
+      char key[64];
+      key_name(key, sizeof(key), i);
+      snprintf(expected, sizeof(expected), "%s = \"%u\"\n", key, i);
+      if (!fgets(line, sizeof(line), file) || strcmp(line, expected))
+         goto end;
+   }
+
+   /* Then what check_include() set, appended in order. */
+   if (!fgets(line, sizeof(line), file)
+         || strcmp(line, "input_player0_btn_0 = \"1234\"\n"))
+      goto end;
+
+   snprintf(expected, sizeof(expected), "bench_new_key = \"%u\"\n", keys);
+   ret = fgets(line, sizeof(line), file) && !strcmp(line, expected);
+
+end:
+   fclose(file);
+   return ret;
+}
+
+static bool run_size(const char *path, const char *include, unsigned keys)
+{
+   unsigned i, pass;
+   double start, load, indexed, walked;
+   unsigned *found       = NULL;
+   config_file_t *conf   = NULL;
+   bool ret              = false;
+
+   if (!write_config(path, include, keys))
+      return false;
+
+   start = get_time();
+   conf  = config_file_new(path);
+   load  = get_time() - start;
+   if (!conf)
+      return false;
+
+   found = (unsigned*)calloc(keys, sizeof(*found));
+   if (!found)
+      goto end;
+
+   start = get_time();
+   for (pass = 0; pass < BENCH_PASSES; pass++)
+   {
+      for (i = 0; i < keys; i++)
+      {
+         char key[64];
+         unsigned val = 0;
+         key_name(key, sizeof(key), i);
+         if (config_get_uint(conf, key, &val))
+            found[i] = val;
+      }
+   }
+   indexed = get_time() - start;
+
+   start = get_time();
+   for (pass = 0; pass < BENCH_PASSES; pass++)
+   {
+      for (i = 0; i < keys; i++)
+      {
+         char key[64];
+         const char *val = NULL;
+         key_name(key, sizeof(key), i);
+         val = list_lookup(conf, key);
+         if (!val || strtoul(val, NULL, 0) != found[i])
+         {
+            /* Key 0 is overridden by the include with -1. */
+            if (!(i == 0 && include && val && !strcmp(val, "-1")))
+            {
+               fprintf(stderr, "%u keys: lookup of key %u differs.\n",
+                     keys, i);
+               goto end;
+            }
+         }
+      }
+   }
+   walked = get_time() - start;
+
+   if (!config_entry_exists(conf, "input_player0_btn_0")
+         || config_entry_exists(conf, "input_player0_btn_missing"))
+   {
+      fprintf(stderr, "%u keys: config_entry_exists() is wrong.\n", keys);
+      goto end;
+   }
+
+   if (include && !check_include(conf, keys))
+   {
+      fprintf(stderr, "%u keys: #include semantics changed.\n", keys);
+      goto end;
+   }
+
+   if (include && !check_write(conf, path, keys))
+   {
+      fprintf(stderr, "%u keys: written file differs.\n", keys);
+      goto end;
+   }
+
+   printf("%6u keys: load %8.2f ms, lookups indexed %8.1f ns, walked %10.1f ns\n",
+         keys, load * 1000.0,
+         indexed * 1000000000.0 / (keys * BENCH_PASSES),
+         walked * 1000000000.0 / (keys * BENCH_PASSES));
+   ret = true;
+
+end:
+   free(found);
+   config_file_free(conf);
+   return ret;
+}
+
+int main(void)
+{
+   unsigned i;
+   char path[256], include[256];
+   FILE *file = NULL;
+   int ret    = 1;
+
+   snprintf(path, sizeof(path), "%s/config-bench-%d.cfg",
+         BENCH_DIR, (int)getpid());
+   snprintf(include, sizeof(include), "%s/config-bench-%d-include.cfg",
+         BENCH_DIR, (int)getpid());
+
+   file = fopen(include, "w");
+   if (!file)
+      return 1;
+   fprintf(file, "input_player0_btn_0 = \"-1\"\n");
+   for (i = 0; i < BENCH_INCLUDE_KEYS; i++)
+      fprintf(file, "include_only_%u = \"%u\"\n", i, i);
+   fclose(file);
+
+   for (i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++)
+   {
+      if (!run_size(path, NULL, bench_sizes[i]))
+         goto end;
+   }
+
+   if (!run_size(path, include, bench_sizes[1]))
+      goto end;
+
+   ret = 0;
+
+end:
+   remove(path);
+   remove(include);
+   return ret;
+}
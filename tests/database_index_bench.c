@@ -0,0 +1,343 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Content scan lookups against a set of generated .rdb files.
+ * Compares the old per-database CRC query with the database index
+ * (cold build, cache load and lookups), and reports files/s for both.
+ * Fails if the two find different records. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <retro_file.h>
+#include <retro_endianness.h>
+
+#include "database_index.h"
+#include "libretro-db/libretrodb.h"
+
+#define BENCH_DATABASES      40
+#define BENCH_RECORDS        1000
+#define BENCH_QUERY_FILES    50
+#define BENCH_INDEX_FILES    200000
+#define BENCH_DIR            "/tmp"
+
+struct record_gen
+{
+   unsigned db;
+   unsigned record;
+   struct rmsgpack_dom_value item;
+};
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+/* Every CRC shows up in two databases, so lookups have to return
+ * more than one match; odd file numbers are misses. */
+static uint32_t record_crc(unsigned db, unsigned record)
+{
+   uint32_t x = (uint32_t)((db / 2) * BENCH_RECORDS + record) * 2;
+   x ^= x >> 15;
+   x *= 0x2c1b3c6dU;
+   x ^= x >> 12;
+   return x;
+}
+
+static uint32_t file_crc(unsigned file)
+{
+   unsigned slot = (file / 2) % (BENCH_DATABASES / 2 * BENCH_RECORDS);
+
+   if (file & 1)
+      return ~record_crc(0, 0) ^ file;
+   return record_crc((slot / BENCH_RECORDS) * 2, slot % BENCH_RECORDS);
+}
+
+static int record_provider(void *ctx, struct rmsgpack_dom_value *out)
+{
+   char name[64];
+   uint32_t crc;
+   struct rmsgpack_dom_pair *items;
+   struct record_gen *gen = (struct record_gen*)ctx;
+
+   /* libretrodb_create() only frees the item it has at the end. */
+   rmsgpack_dom_value_free(&gen->item);
+   gen->item.type = RDT_NULL;
+   out->type      = RDT_NULL;
+
+   if (gen->record == BENCH_RECORDS)
+      return 1;
+
+   items = (struct rmsgpack_dom_pair*)calloc(3, sizeof(*items));
+   if (!items)
+      return -1;
+
+   snprintf(name, sizeof(name), "Game %u-%u", gen->db, gen->record);
+   crc = swap_if_little32(record_crc(gen->db, gen->record));
+
+   items[0].key.type             = RDT_STRING;
+   items[0].key.val.string.buff  = strdup("name");
+   items[0].key.val.string.len   = 4;
+   items[0].value.type           = RDT_STRING;
+   items[0].value.val.string.buff = strdup(name);
+   items[0].value.val.string.len = strlen(name);
+
+   items[1].key.type             = RDT_STRING;
+   items[1].key.val.string.buff  = strdup("crc");
+   items[1].key.val.string.len   = 3;
+   items[1].value.type           = RDT_BINARY;
+   items[1].value.val.binary.buff = (char*)malloc(4);
+   items[1].value.val.binary.len = 4;
+   memcpy(items[1].value.val.binary.buff, &crc, 4);
+
+   snprintf(name, sizeof(name), "SLUS-%05u", gen->db * BENCH_RECORDS + gen->record);
+   items[2].key.type             = RDT_STRING;
+   items[2].key.val.string.buff  = strdup("serial");
+   items[2].key.val.string.len   = 6;
+   items[2].value.type           = RDT_STRING;
+   items[2].value.val.string.buff = strdup(name);
+   items[2].value.val.string.len = strlen(name);
+
+   out->type          = RDT_MAP;
+   out->val.map.len   = 3;
+   out->val.map.items = items;
+   gen->item          = *out;
+
+   gen->record++;
+   return 0;
+}
+
+static bool create_database(const char *path, unsigned db)
+{
+   int rv;
+   struct record_gen gen = {0};
+   RFILE *fd = retro_fopen(path, RFILE_MODE_WRITE, -1);
+
+   if (!fd)
+      return false;
+
+   gen.db     = db;
+   rv         = libretrodb_create(fd, record_provider, &gen);
+   retro_fclose(fd);
+   return rv >= 0;
+}
+
+static bool append_byte(const char *path)
+{
+   FILE *file = fopen(path, "ab");
+
+   if (!file)
+      return false;
+   fputc(0, file);
+   fclose(file);
+   return true;
+}
+
+/* What the scanner did before the index: compile a CRC query and
+ * walk every database with it. */
+static unsigned query_lookup(const struct string_list *list, uint32_t crc,
+      unsigned *found)
+{
+   size_t i;
+   unsigned count = 0;
+
+   for (i = 0; i < list->size; i++)
+   {
+      char query[50];
+      struct rmsgpack_dom_value item;
+      const char *error        = NULL;
+      libretrodb_query_t *q    = NULL;
+      libretrodb_t *db         = libretrodb_new();
+      libretrodb_cursor_t *cur = libretrodb_cursor_new();
+
+      snprintf(query, sizeof(query), "{crc: b\"%08X\"}", swap_if_big32(crc));
+
+      if (libretrodb_open(list->elems[i].data, db) == 0)
+      {
+         q = (libretrodb_query_t*)libretrodb_query_compile(db, query,
+               strlen(query), &error);
+         if (!error && libretrodb_cursor_open(db, cur, q) == 0)
+         {
+            while (libretrodb_cursor_read_item(cur, &item) == 0)
+            {
+               found[count++] = (unsigned)i;
+               rmsgpack_dom_value_free(&item);
+            }
+            libretrodb_cursor_close(cur);
+         }
+         if (q)
+            libretrodb_query_free(q);
+         libretrodb_close(db);
+      }
+
+      libretrodb_cursor_free(cur);
+      libretrodb_free(db);
+   }
+
+   return count;
+}
+
+/* Index lookup plus reading each matching record, which is what the
+ * scanner needs to fill in the playlist entry. */
+static unsigned index_lookup(const database_index_t *index,
+      const struct string_list *list, uint32_t crc, unsigned *found)
+{
+   size_t i, count;
+   database_index_match_t matches[16];
+
+   count = database_index_find_crc(index, crc, matches, 16);
+
+   for (i = 0; i < count; i++)
+   {
+      struct rmsgpack_dom_value item;
+      libretrodb_t *db         = libretrodb_new();
+      libretrodb_cursor_t *cur = libretrodb_cursor_new();
+
+      found[i] = matches[i].db;
+
+      if (     libretrodb_open(list->elems[matches[i].db].data, db) == 0
+            && libretrodb_cursor_open(db, cur, NULL) == 0)
+      {
+         if (     libretrodb_cursor_seek(cur, matches[i].offset) == 0
+               && libretrodb_cursor_read_item(cur, &item) == 0)
+            rmsgpack_dom_value_free(&item);
+         else
+            found[i] = ~0u;
+         libretrodb_cursor_close(cur);
+      }
+      libretrodb_close(db);
+
+      libretrodb_cursor_free(cur);
+      libretrodb_free(db);
+   }
+
+   return (unsigned)count;
+}
+
+int main(void)
+{
+   unsigned i;
+   double start, elapsed;
+   char cache_path[256];
+   union string_list_elem_attr attr;
+   database_index_match_t matches[4];
+   database_index_t *index  = NULL;
+   struct string_list *list = string_list_new();
+   unsigned hits            = 0;
+   int ret                  = 1;
+
+   attr.i = 0;
+   snprintf(cache_path, sizeof(cache_path), "%s/rdb-bench-%d.idx",
+         BENCH_DIR, (int)getpid());
+
+   if (!list)
+      return 1;
+
+   for (i = 0; i < BENCH_DATABASES; i++)
+   {
+      char path[256];
+      snprintf(path, sizeof(path), "%s/rdb-bench-%d-%u.rdb",
+            BENCH_DIR, (int)getpid(), i);
+      if (!create_database(path, i) || !string_list_append(list, path, attr))
+         goto end;
+   }
+
+   printf("%u databases, %u records each.\n", BENCH_DATABASES, BENCH_RECORDS);
+
+   start = get_time();
+   index = database_index_new(list, cache_path);
+   printf("Index build:       %8.1f ms (%u keys)\n",
+         (get_time() - start) * 1000.0, (unsigned)database_index_size(index));
+   database_index_free(index);
+
+   start = get_time();
+   index = database_index_new(list, cache_path);
+   printf("Index cache load:  %8.1f ms\n", (get_time() - start) * 1000.0);
+   database_index_free(index);
+
+   /* Growing the file changes its size, so only it is read again. */
+   if (!append_byte(list->elems[BENCH_DATABASES / 2].data))
+      goto end;
+
+   start = get_time();
+   index = database_index_new(list, cache_path);
+   printf("Index one changed: %8.1f ms\n", (get_time() - start) * 1000.0);
+   if (!index)
+      goto end;
+
+   start = get_time();
+   for (i = 0; i < BENCH_QUERY_FILES; i++)
+   {
+      unsigned j, found_query[BENCH_DATABASES], found_index[16];
+      unsigned count = query_lookup(list, file_crc(i), found_query);
+
+      if (     count != index_lookup(index, list, file_crc(i), found_index)
+            || count != ((i & 1) ? 0 : 2))
+      {
+         fprintf(stderr, "File %u: match count differs.\n", i);
+         goto end;
+      }
+
+      for (j = 0; j < count; j++)
+      {
+         if (found_query[j] != found_index[j])
+         {
+            fprintf(stderr, "File %u: match %u differs.\n", i, j);
+            goto end;
+         }
+      }
+   }
+   elapsed = get_time() - start;
+   printf("Query scan:        %8.1f files/s\n", BENCH_QUERY_FILES / elapsed);
+
+   start = get_time();
+   for (i = 0; i < BENCH_INDEX_FILES; i++)
+      hits += (unsigned)database_index_find_crc(index, file_crc(i), matches, 4);
+   elapsed = get_time() - start;
+   printf("Index lookup:      %8.1f files/s (%u matches)\n",
+         BENCH_INDEX_FILES / elapsed, hits);
+
+   start = get_time();
+   for (i = 0; i < BENCH_INDEX_FILES / 100; i++)
+   {
+      unsigned found[16];
+      index_lookup(index, list, file_crc(i), found);
+   }
+   elapsed = get_time() - start;
+   printf("Index + record:    %8.1f files/s\n",
+         BENCH_INDEX_FILES / 100 / elapsed);
+
+   if (     database_index_find_serial(index, "SLUS-01234", matches, 4) != 1
+         || matches[0].db != 1234 / BENCH_RECORDS)
+   {
+      fprintf(stderr, "Serial lookup failed.\n");
+      goto end;
+   }
+
+   ret = 0;
+
+end:
+   database_index_free(index);
+   for (i = 0; i < list->size; i++)
+      remove(list->elems[i].data);
+   remove(cache_path);
+   string_list_free(list);
+   return ret;
+}
@@ -0,0 +1,183 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Runs the database scan worker pool over generated files, once with
+ * a single worker and no read-ahead, as the scan task used to work,
+ * and once with the full pool. Every read also sleeps for a fixed
+ * time to stand in for a network share. Reports files/s and fails if
+ * any result is missing, wrong or out of order. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tasks/tasks.h"
+
+#define BENCH_FILES       1000
+#define BENCH_FILE_SIZE   (64 * 1024)
+#define BENCH_LATENCY_US  2000
+#define BENCH_THREADS     8
+#define BENCH_WINDOW      32
+#define BENCH_DIR         "/tmp"
+
+static uint32_t crc_table[256];
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void crc_init(void)
+{
+   unsigned i, j;
+
+   for (i = 0; i < 256; i++)
+   {
+      uint32_t c = i;
+      for (j = 0; j < 8; j++)
+         c = (c & 1) ? 0xedb88320U ^ (c >> 1) : c >> 1;
+      crc_table[i] = c;
+   }
+}
+
+static uint32_t crc_calculate(const uint8_t *data, size_t len)
+{
+   size_t i;
+   uint32_t crc = 0xffffffffU;
+
+   for (i = 0; i < len; i++)
+      crc = crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+   return ~crc;
+}
+
+static void fill_file(uint8_t *buf, unsigned file)
+{
+   unsigned i;
+   uint32_t state = file * 2654435761U + 1;
+
+   for (i = 0; i < BENCH_FILE_SIZE; i++)
+   {
+      state  = state * 1664525 + 1013904223;
+      buf[i] = (uint8_t)(state >> 24);
+   }
+}
+
+static void scan_file(const char *path, database_scan_result_t *result,
+      void *userdata)
+{
+   uint8_t *buf = (uint8_t*)malloc(BENCH_FILE_SIZE);
+   FILE *file   = fopen(path, "rb");
+
+   (void)userdata;
+
+   usleep(BENCH_LATENCY_US);
+
+   if (file && buf && fread(buf, 1, BENCH_FILE_SIZE, file) == BENCH_FILE_SIZE)
+   {
+      result->crc  = crc_calculate(buf, BENCH_FILE_SIZE);
+      result->type = DATABASE_SCAN_CRC;
+   }
+
+   if (file)
+      fclose(file);
+   free(buf);
+}
+
+static bool run_scan(const struct string_list *list, const uint32_t *crcs,
+      unsigned threads, unsigned window)
+{
+   size_t i;
+   double start;
+   database_scan_t *scan = NULL;
+
+   start = get_time();
+   scan  = database_scan_new(list, threads, window, scan_file, NULL);
+   if (!scan)
+      return false;
+
+   for (i = 0; i < list->size; )
+   {
+      database_scan_result_t result;
+
+      if (!database_scan_fetch(scan, i, &result, 10000))
+         continue;
+
+      if (result.type != DATABASE_SCAN_CRC || result.crc != crcs[i])
+      {
+         fprintf(stderr, "File %u: wrong result.\n", (unsigned)i);
+         database_scan_free(scan);
+         return false;
+      }
+      i++;
+   }
+
+   database_scan_free(scan);
+
+   printf("%2u workers, window %3u: %8.1f files/s\n", threads, window,
+         list->size / (get_time() - start));
+   return true;
+}
+
+int main(void)
+{
+   unsigned i;
+   union string_list_elem_attr attr;
+   uint32_t *crcs           = (uint32_t*)malloc(BENCH_FILES * sizeof(*crcs));
+   uint8_t *buf             = (uint8_t*)malloc(BENCH_FILE_SIZE);
+   struct string_list *list = string_list_new();
+   int ret                  = 1;
+
+   if (!crcs || !buf || !list)
+      return 1;
+
+   attr.i = 0;
+   crc_init();
+
+   for (i = 0; i < BENCH_FILES; i++)
+   {
+      char path[256];
+      FILE *file;
+
+      snprintf(path, sizeof(path), "%s/scan-bench-%d-%u.bin",
+            BENCH_DIR, (int)getpid(), i);
+      fill_file(buf, i);
+      crcs[i] = crc_calculate(buf, BENCH_FILE_SIZE);
+
+      file = fopen(path, "wb");
+      if (!file || !string_list_append(list, path, attr))
+         goto end;
+      fwrite(buf, 1, BENCH_FILE_SIZE, file);
+      fclose(file);
+   }
+
+   printf("%u files of %u KB, %u us added per read.\n",
+         BENCH_FILES, BENCH_FILE_SIZE / 1024, BENCH_LATENCY_US);
+
+   if (     run_scan(list, crcs, 1, 1)
+         && run_scan(list, crcs, BENCH_THREADS, BENCH_WINDOW))
+      ret = 0;
+
+end:
+   for (i = 0; i < list->size; i++)
+      remove(list->elems[i].data);
+   string_list_free(list);
+   free(crcs);
+   free(buf);
+   return ret;
+}
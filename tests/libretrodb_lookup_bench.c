@@ -0,0 +1,318 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Metadata lookups against a generated, mapped database with a crc
+ * index. Compares decoding every record found with reading its fields
+ * in place, for index lookups and for a full cursor walk. Counts heap
+ * allocations through a malloc() wrapper and fails if the in-place
+ * paths allocate or see different field values. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <boolean.h>
+#include <retro_file.h>
+
+#include "libretro-db/libretrodb.h"
+#include "libretro-db/rmsgpack.h"
+
+#define BENCH_RECORDS        50000
+#define BENCH_LOOKUPS        200000
+#define BENCH_DIR            "/tmp"
+
+struct record_gen
+{
+   unsigned record;
+   struct rmsgpack_dom_value item;
+};
+
+static unsigned long allocations;
+
+void *__real_malloc(size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+   allocations++;
+   return __real_malloc(size);
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void set_string(struct rmsgpack_dom_value *v, const char *s)
+{
+   v->type            = RDT_STRING;
+   v->val.string.buff = strdup(s);
+   v->val.string.len  = strlen(s);
+}
+
+static void record_crc(unsigned record, uint8_t *crc)
+{
+   uint32_t x = record * 0x9e3779b9U;
+
+   crc[0] = (uint8_t)(x >> 24);
+   crc[1] = (uint8_t)(x >> 16);
+   crc[2] = (uint8_t)(x >>  8);
+   crc[3] = (uint8_t)(x >>  0);
+}
+
+static int record_provider(void *ctx, struct rmsgpack_dom_value *out)
+{
+   char buf[64];
+   struct rmsgpack_dom_pair *items;
+   struct record_gen *gen = (struct record_gen*)ctx;
+
+   /* libretrodb_create() only frees the item it has at the end. */
+   rmsgpack_dom_value_free(&gen->item);
+   gen->item.type = RDT_NULL;
+   out->type      = RDT_NULL;
+
+   if (gen->record == BENCH_RECORDS)
+      return 1;
+
+   items = (struct rmsgpack_dom_pair*)calloc(6, sizeof(*items));
+   if (!items)
+      return -1;
+
+   snprintf(buf, sizeof(buf), "Game %u: The Adventure Continues", gen->record);
+   set_string(&items[0].key, "name");
+   set_string(&items[0].value, buf);
+
+   set_string(&items[1].key, "description");
+   set_string(&items[1].value, "A game that exists to fill a database.");
+
+   snprintf(buf, sizeof(buf), "Developer %u|Studio %u",
+         gen->record % 97, gen->record % 13);
+   set_string(&items[2].key, "developer");
+   set_string(&items[2].value, buf);
+
+   set_string(&items[3].key, "releaseyear");
+   items[3].value.type      = RDT_UINT;
+   items[3].value.val.uint_ = 1980 + gen->record % 36;
+
+   snprintf(buf, sizeof(buf), "SLUS-%05u", gen->record);
+   set_string(&items[4].key, "serial");
+   set_string(&items[4].value, buf);
+
+   set_string(&items[5].key, "crc");
+   items[5].value.type            = RDT_BINARY;
+   items[5].value.val.binary.buff = (char*)malloc(4);
+   items[5].value.val.binary.len  = 4;
+   record_crc(gen->record, (uint8_t*)items[5].value.val.binary.buff);
+
+   out->type          = RDT_MAP;
+   out->val.map.len   = 6;
+   out->val.map.items = items;
+   gen->item          = *out;
+
+   gen->record++;
+   return 0;
+}
+
+static bool create_database(const char *path)
+{
+   int rv;
+   struct record_gen gen = {0};
+   RFILE *fd = retro_fopen(path, RFILE_MODE_WRITE, -1);
+
+   if (!fd)
+      return false;
+
+   rv = libretrodb_create(fd, record_provider, &gen);
+   retro_fclose(fd);
+   return rv >= 0;
+}
+
+/* What menu code needs from a record: a couple of fields. */
+static uint64_t decoded_fields(const struct rmsgpack_dom_value *item)
+{
+   unsigned i;
+   uint64_t sum = 0;
+
+   for (i = 0; i < item->val.map.len; i++)
+   {
+      const struct rmsgpack_dom_value *key   = &item->val.map.items[i].key;
+      const struct rmsgpack_dom_value *value = &item->val.map.items[i].value;
+
+      if (key->val.string.len == 4 && !memcmp(key->val.string.buff, "name", 4))
+         sum += value->val.string.len;
+      else if (key->val.string.len == 11
+            && !memcmp(key->val.string.buff, "releaseyear", 11))
+         sum += value->val.uint_;
+   }
+
+   return sum;
+}
+
+static uint64_t raw_fields(const uint8_t *record, size_t len)
+{
+   struct rmsgpack_dom_value name, year;
+   uint64_t sum = 0;
+
+   if (rmsgpack_raw_map_value(record, len, "name", 4, &name) > 0)
+      sum += name.val.string.len;
+   if (rmsgpack_raw_map_value(record, len, "releaseyear", 11, &year) > 0)
+      sum += year.val.uint_;
+
+   return sum;
+}
+
+static bool run_lookups(libretrodb_t *db, bool raw, uint64_t *sum)
+{
+   unsigned i;
+   double start;
+   unsigned long before = allocations;
+
+   *sum  = 0;
+   start = get_time();
+
+   for (i = 0; i < BENCH_LOOKUPS; i++)
+   {
+      uint8_t crc[4];
+
+      record_crc((i * 7919) % BENCH_RECORDS, crc);
+
+      if (raw)
+      {
+         size_t len;
+         const uint8_t *record = NULL;
+
+         if (libretrodb_find_entry_raw(db, "crc", crc, &record, &len) != 0)
+            return false;
+         *sum += raw_fields(record, len);
+      }
+      else
+      {
+         struct rmsgpack_dom_value item;
+
+         if (libretrodb_find_entry(db, "crc", crc, &item) != 0)
+            return false;
+         *sum += decoded_fields(&item);
+         rmsgpack_dom_value_free(&item);
+      }
+   }
+
+   printf("Lookup, %-9s %10.1f lookups/s, %6.1f allocations each\n",
+         raw ? "in place:" : "decoded:",
+         BENCH_LOOKUPS / (get_time() - start),
+         (double)(allocations - before) / BENCH_LOOKUPS);
+
+   return !raw || allocations == before;
+}
+
+static bool run_walk(libretrodb_t *db, bool raw, uint64_t *sum)
+{
+   double start;
+   unsigned long before;
+   unsigned count           = 0;
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+
+   if (!cur || libretrodb_cursor_open(db, cur, NULL) != 0)
+   {
+      libretrodb_cursor_free(cur);
+      return false;
+   }
+
+   *sum   = 0;
+   before = allocations;
+   start  = get_time();
+
+   if (raw)
+   {
+      size_t len;
+      const uint8_t *record = NULL;
+
+      while (libretrodb_cursor_read_raw(cur, &record, &len) == 0)
+      {
+         *sum += raw_fields(record, len);
+         count++;
+      }
+   }
+   else
+   {
+      struct rmsgpack_dom_value item;
+
+      while (libretrodb_cursor_read_item(cur, &item) == 0)
+      {
+         *sum += decoded_fields(&item);
+         rmsgpack_dom_value_free(&item);
+         count++;
+      }
+   }
+
+   printf("Walk, %-11s %10.1f records/s, %6.1f allocations each\n",
+         raw ? "in place:" : "decoded:",
+         count / (get_time() - start),
+         (double)(allocations - before) / count);
+
+   libretrodb_cursor_close(cur);
+   libretrodb_cursor_free(cur);
+   return count == BENCH_RECORDS && (!raw || allocations == before);
+}
+
+int main(void)
+{
+   char path[256];
+   uint64_t decoded_sum, raw_sum;
+   libretrodb_t *db = NULL;
+   int ret          = 1;
+
+   snprintf(path, sizeof(path), "%s/rdb-lookup-bench-%d.rdb",
+         BENCH_DIR, (int)getpid());
+
+   if (!create_database(path))
+      goto end;
+
+   db = libretrodb_new();
+   if (     !db || libretrodb_open(path, db) != 0
+         || libretrodb_create_index(db, "crc", "crc") != 0)
+      goto end;
+
+   printf("%u records, %u lookups.\n", BENCH_RECORDS, BENCH_LOOKUPS);
+
+   if (     !run_lookups(db, false, &decoded_sum)
+         || !run_lookups(db, true, &raw_sum)
+         || decoded_sum != raw_sum)
+   {
+      fprintf(stderr, "Lookups failed, allocated or differ.\n");
+      goto end;
+   }
+
+   if (     !run_walk(db, false, &decoded_sum)
+         || !run_walk(db, true, &raw_sum)
+         || decoded_sum != raw_sum)
+   {
+      fprintf(stderr, "Walks failed, allocated or differ.\n");
+      goto end;
+   }
+
+   ret = 0;
+
+end:
+   if (db)
+   {
+      libretrodb_close(db);
+      libretrodb_free(db);
+   }
+   remove(path);
+   return ret;
+}
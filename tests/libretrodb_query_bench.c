@@ -0,0 +1,292 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Runs libretro-db queries against a generated database with indexes
+ * on crc, developer and releaseyear. Each query runs through the
+ * planned cursor and as a plain scan that decodes every record and
+ * filters it, the way cursors used to work. Reports queries/s for
+ * both and fails if they return different records. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <boolean.h>
+#include <retro_file.h>
+
+#include "libretro-db/libretrodb.h"
+
+#define BENCH_RECORDS        50000
+#define BENCH_DEVELOPERS     200
+#define BENCH_MIN_TIME       0.5
+#define BENCH_DIR            "/tmp"
+
+struct record_gen
+{
+   unsigned record;
+   struct rmsgpack_dom_value item;
+};
+
+static const char *queries[] = {
+   "{crc: b\"0000BEBE\"}",
+   "{developer: \"Developer 42\"}",
+   "{releaseyear: between(1994, 1995)}",
+   "{developer: \"Developer 7\", releaseyear: 1999}",
+   "{developer: glob(\"Developer 1?\")}",
+   "{releaseyear: 1990, rating: between(3, 4)}",
+   "{name: glob(\"*Quest*\")}",
+};
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static uint32_t record_hash(unsigned record)
+{
+   uint32_t x = record * 0x9e3779b9U;
+   x ^= x >> 15;
+   x *= 0x2c1b3c6dU;
+   x ^= x >> 12;
+   return x;
+}
+
+static void set_string(struct rmsgpack_dom_value *v, const char *s)
+{
+   v->type            = RDT_STRING;
+   v->val.string.buff = strdup(s);
+   v->val.string.len  = strlen(s);
+}
+
+static int record_provider(void *ctx, struct rmsgpack_dom_value *out)
+{
+   char buf[64];
+   uint32_t crc;
+   struct rmsgpack_dom_pair *items;
+   struct record_gen *gen = (struct record_gen*)ctx;
+   uint32_t hash          = record_hash(gen->record);
+
+   /* libretrodb_create() only frees the item it has at the end. */
+   rmsgpack_dom_value_free(&gen->item);
+   gen->item.type = RDT_NULL;
+   out->type      = RDT_NULL;
+
+   if (gen->record == BENCH_RECORDS)
+      return 1;
+
+   items = (struct rmsgpack_dom_pair*)calloc(5, sizeof(*items));
+   if (!items)
+      return -1;
+
+   snprintf(buf, sizeof(buf), "%s %u",
+         (hash & 0x100) ? "Quest" : "Racer", gen->record);
+   set_string(&items[0].key, "name");
+   set_string(&items[0].value, buf);
+
+   crc = gen->record * 0x101U;
+   set_string(&items[1].key, "crc");
+   items[1].value.type            = RDT_BINARY;
+   items[1].value.val.binary.buff = (char*)malloc(4);
+   items[1].value.val.binary.len  = 4;
+   items[1].value.val.binary.buff[0] = (char)(crc >> 24);
+   items[1].value.val.binary.buff[1] = (char)(crc >> 16);
+   items[1].value.val.binary.buff[2] = (char)(crc >>  8);
+   items[1].value.val.binary.buff[3] = (char)(crc >>  0);
+
+   snprintf(buf, sizeof(buf), "Developer %u", hash % BENCH_DEVELOPERS);
+   set_string(&items[2].key, "developer");
+   set_string(&items[2].value, buf);
+
+   set_string(&items[3].key, "releaseyear");
+   items[3].value.type     = RDT_UINT;
+   items[3].value.val.uint_ = 1980 + (hash >> 9) % 36;
+
+   set_string(&items[4].key, "rating");
+   items[4].value.type     = RDT_UINT;
+   items[4].value.val.uint_ = (hash >> 20) % 6;
+
+   /* Some records have no rating. */
+   out->type          = RDT_MAP;
+   out->val.map.len   = (hash & 0x7) ? 5 : 4;
+   out->val.map.items = items;
+   gen->item          = *out;
+   gen->item.val.map.len = 5;
+
+   gen->record++;
+   return 0;
+}
+
+static bool create_database(const char *path)
+{
+   int rv;
+   struct record_gen gen = {0};
+   RFILE *fd = retro_fopen(path, RFILE_MODE_WRITE, -1);
+
+   if (!fd)
+      return false;
+
+   rv = libretrodb_create(fd, record_provider, &gen);
+   retro_fclose(fd);
+   return rv >= 0;
+}
+
+/* Appends the crc of every record the query returns to @out. */
+static int run_query(libretrodb_t *db, libretrodb_query_t *q, bool planned,
+      uint32_t *out)
+{
+   struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_value key;
+   int count                = 0;
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+
+   set_string(&key, "crc");
+
+   if (!cur || libretrodb_cursor_open(db, cur, planned ? q : NULL) != 0)
+   {
+      libretrodb_cursor_free(cur);
+      rmsgpack_dom_value_free(&key);
+      return -1;
+   }
+
+   while (libretrodb_cursor_read_item(cur, &item) == 0)
+   {
+      if (planned || libretrodb_query_filter(q, &item))
+      {
+         const struct rmsgpack_dom_value *crc =
+            rmsgpack_dom_value_map_value(&item, &key);
+         const uint8_t *b = (const uint8_t*)crc->val.binary.buff;
+
+         if (out)
+            out[count] = ((uint32_t)b[0] << 24) | (b[1] << 16)
+               | (b[2] << 8) | b[3];
+         count++;
+      }
+      rmsgpack_dom_value_free(&item);
+   }
+
+   libretrodb_cursor_close(cur);
+   libretrodb_cursor_free(cur);
+   rmsgpack_dom_value_free(&key);
+   return count;
+}
+
+static double queries_per_second(libretrodb_t *db, libretrodb_query_t *q,
+      bool planned)
+{
+   unsigned runs = 0;
+   double start  = get_time();
+   double elapsed;
+
+   do
+   {
+      run_query(db, q, planned, NULL);
+      runs++;
+   } while ((elapsed = get_time() - start) < BENCH_MIN_TIME);
+
+   return runs / elapsed;
+}
+
+int main(void)
+{
+   unsigned i;
+   char path[256];
+   uint32_t *planned  = (uint32_t*)malloc(BENCH_RECORDS * sizeof(uint32_t));
+   uint32_t *scanned  = (uint32_t*)malloc(BENCH_RECORDS * sizeof(uint32_t));
+   libretrodb_t *db   = NULL;
+   int ret            = 1;
+
+   snprintf(path, sizeof(path), "%s/rdb-query-bench-%d.rdb",
+         BENCH_DIR, (int)getpid());
+
+   if (!planned || !scanned || !create_database(path))
+      goto end;
+
+   db = libretrodb_new();
+   if (!db || libretrodb_open(path, db) != 0)
+      goto end;
+
+   if (     libretrodb_create_index(db, "crc", "crc") != 0
+         || libretrodb_create_index(db, "developer", "developer") != 0
+         || libretrodb_create_index(db, "releaseyear", "releaseyear") != 0)
+   {
+      fprintf(stderr, "Index creation failed.\n");
+      goto end;
+   }
+
+   printf("%u records, indexes on crc, developer and releaseyear.\n\n",
+         BENCH_RECORDS);
+
+   for (i = 0; i < sizeof(queries) / sizeof(queries[0]); i++)
+   {
+      int j, count;
+      char plan[1024];
+      const char *error        = NULL;
+      libretrodb_cursor_t *cur = libretrodb_cursor_new();
+      libretrodb_query_t *q    = (libretrodb_query_t*)
+         libretrodb_query_compile(db, queries[i], strlen(queries[i]), &error);
+
+      if (error || !cur || libretrodb_cursor_open(db, cur, q) != 0)
+      {
+         fprintf(stderr, "%s: %s\n", queries[i], error ? error : "no cursor");
+         libretrodb_cursor_free(cur);
+         goto end;
+      }
+      libretrodb_cursor_explain(cur, plan, sizeof(plan));
+      libretrodb_cursor_close(cur);
+      libretrodb_cursor_free(cur);
+
+      count = run_query(db, q, true, planned);
+      if (count < 0 || count != run_query(db, q, false, scanned))
+      {
+         fprintf(stderr, "%s: match count differs.\n", queries[i]);
+         libretrodb_query_free(q);
+         goto end;
+      }
+
+      for (j = 0; j < count; j++)
+      {
+         if (planned[j] != scanned[j])
+         {
+            fprintf(stderr, "%s: match %d differs.\n", queries[i], j);
+            libretrodb_query_free(q);
+            goto end;
+         }
+      }
+
+      printf("%s (%d matches)\n%s", queries[i], count, plan);
+      printf("  scan %8.1f queries/s, planned %8.1f queries/s\n\n",
+            queries_per_second(db, q, false),
+            queries_per_second(db, q, true));
+
+      libretrodb_query_free(q);
+   }
+
+   ret = 0;
+
+end:
+   if (db)
+   {
+      libretrodb_close(db);
+      libretrodb_free(db);
+   }
+   remove(path);
+   free(planned);
+   free(scanned);
+   return ret;
+}
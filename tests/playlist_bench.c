@@ -0,0 +1,367 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Builds a collection-sized playlist the way the database scanner does
+ * and times loading it as text, the old line by line way and now, and
+ * in the compact format. Then times path and crc32 lookups against a
+ * walk over the entries, and pushes that hit and miss. Fails if the
+ * compact file, or the text file with CRLF line endings, loads
+ * different entries than the text one, or if any lookup disagrees
+ * with walking the entries. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "playlist.h"
+
+#define BENCH_ENTRIES     20000
+#define BENCH_LOOKUPS     20000
+#define BENCH_PUSHES      2000
+#define BENCH_DIR         "/tmp"
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void entry_path(char *buf, size_t size, unsigned i)
+{
+   snprintf(buf, size,
+         "/storage/roms/Nintendo - Super Nintendo Entertainment System/"
+         "Game %05u (USA) (Rev %u).zip#Game %05u (USA).sfc", i, i % 3, i);
+}
+
+static void entry_crc32(char *buf, size_t size, unsigned i)
+{
+   snprintf(buf, size, "%08X|crc", i * 2654435761U);
+}
+
+static void push_entry(content_playlist_t *playlist, unsigned i)
+{
+   char path[512], label[64], crc32[32];
+
+   entry_path(path, sizeof(path), i);
+   entry_crc32(crc32, sizeof(crc32), i);
+   snprintf(label, sizeof(label), "Game %05u (USA)", i);
+
+   content_playlist_push(playlist, path, label, "DETECT", "DETECT", crc32,
+         "Nintendo - Super Nintendo Entertainment System.lpl");
+}
+
+/* What content_playlist_read_file() did before. */
+static unsigned read_lines(const char *path)
+{
+   unsigned i, count = 0;
+   char buf[6][1024];
+   FILE *file = fopen(path, "r");
+
+   if (!file)
+      return 0;
+
+   for (;;)
+   {
+      char *strs[6];
+
+      for (i = 0; i < 6; i++)
+      {
+         char *last = NULL;
+
+         if (!fgets(buf[i], sizeof(buf[i]), file))
+            goto end;
+         last = strrchr(buf[i], '\n');
+         if (last)
+            *last = '\0';
+         strs[i] = *buf[i] ? strdup(buf[i]) : NULL;
+      }
+
+      for (i = 0; i < 6; i++)
+         free(strs[i]);
+      count++;
+   }
+
+end:
+   fclose(file);
+   return count;
+}
+
+/* Copies the text playlist @src with CRLF line endings, as text
+ * mode writes it on Windows. */
+static bool write_crlf(const char *src, const char *dst)
+{
+   int c;
+   FILE *in  = fopen(src, "rb");
+   FILE *out = in ? fopen(dst, "wb") : NULL;
+
+   if (!out)
+   {
+      if (in)
+         fclose(in);
+      return false;
+   }
+
+   while ((c = fgetc(in)) != EOF)
+   {
+      if (c == '\n')
+         fputc('\r', out);
+      fputc(c, out);
+   }
+
+   fclose(in);
+   fclose(out);
+   return true;
+}
+
+static bool entries_equal(const content_playlist_t *a,
+      const content_playlist_t *b)
+{
+   size_t i;
+
+   if (a->size != b->size)
+      return false;
+
+   for (i = 0; i < a->size; i++)
+   {
+      const content_playlist_entry_t *x = &a->entries[i];
+      const content_playlist_entry_t *y = &b->entries[i];
+
+      if (     strcmp(x->path, y->path)
+            || strcmp(x->label, y->label)
+            || strcmp(x->core_path, y->core_path)
+            || strcmp(x->core_name, y->core_name)
+            || strcmp(x->crc32, y->crc32)
+            || strcmp(x->db_name, y->db_name))
+         return false;
+   }
+
+   return true;
+}
+
+static bool walk_path(content_playlist_t *playlist, const char *path,
+      size_t *idx)
+{
+   size_t i;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      if (playlist->entries[i].path && !strcmp(playlist->entries[i].path, path))
+      {
+         *idx = i;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+static bool walk_crc32(content_playlist_t *playlist, const char *crc32,
+      size_t *idx)
+{
+   size_t i;
+
+   for (i = playlist->size; i-- > 0; )
+   {
+      if (playlist->entries[i].crc32 && !strcmp(playlist->entries[i].crc32, crc32))
+      {
+         *idx = i;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+/* Looks up every path and crc32 ever pushed, present or evicted. */
+static bool check_lookups(content_playlist_t *playlist, unsigned count)
+{
+   unsigned i;
+
+   for (i = 0; i < count; i++)
+   {
+      char path[512], crc32[32];
+      char *found    = NULL;
+      size_t idx     = 0;
+      size_t walked  = 0;
+      bool in_list   = false;
+
+      entry_path(path, sizeof(path), i);
+      entry_crc32(crc32, sizeof(crc32), i);
+
+      in_list = walk_path(playlist, path, &walked);
+      content_playlist_get_index_by_path(playlist, path,
+            &found, NULL, NULL, NULL, NULL, NULL);
+      if (in_list != (found != NULL)
+            || (found && found != playlist->entries[walked].path))
+      {
+         fprintf(stderr, "Path lookup of entry %u differs.\n", i);
+         return false;
+      }
+
+      in_list = walk_crc32(playlist, crc32, &walked);
+      if (in_list != content_playlist_find_crc32(playlist, crc32, &idx)
+            || (in_list && idx != walked))
+      {
+         fprintf(stderr, "crc32 lookup of entry %u differs.\n", i);
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static int sort_label(const content_playlist_entry_t *a,
+      const content_playlist_entry_t *b)
+{
+   return strcmp(b->label, a->label);
+}
+
+static content_playlist_t *load(const char *path, const char *name,
+      unsigned lines)
+{
+   double start                 = get_time();
+   content_playlist_t *playlist = content_playlist_init(path, BENCH_ENTRIES);
+
+   if (playlist)
+      printf("Load %-12s %8.2f ms\n", name, (get_time() - start) * 1000.0);
+
+   if (playlist && playlist->size != lines)
+   {
+      fprintf(stderr, "%s: loaded %u of %u entries.\n", name,
+            (unsigned)playlist->size, lines);
+      content_playlist_free(playlist);
+      return NULL;
+   }
+
+   return playlist;
+}
+
+int main(void)
+{
+   unsigned i;
+   double start;
+   char text_path[256], compact_path[256], crlf_path[256];
+   size_t hits                  = 0;
+   content_playlist_t *playlist = NULL;
+   content_playlist_t *text     = NULL;
+   content_playlist_t *compact  = NULL;
+   content_playlist_t *crlf     = NULL;
+   int ret                      = 1;
+
+   snprintf(text_path, sizeof(text_path), "%s/playlist-bench-%d.lpl",
+         BENCH_DIR, (int)getpid());
+   snprintf(compact_path, sizeof(compact_path), "%s/playlist-bench-%d.rpl",
+         BENCH_DIR, (int)getpid());
+   snprintf(crlf_path, sizeof(crlf_path), "%s/playlist-bench-crlf-%d.lpl",
+         BENCH_DIR, (int)getpid());
+
+   /* Pushes past capacity, with every fourth one a repeat. */
+   start    = get_time();
+   playlist = content_playlist_init(text_path, BENCH_ENTRIES);
+   if (!playlist)
+      return 1;
+
+   for (i = 0; i < BENCH_ENTRIES + BENCH_ENTRIES / 4; i++)
+      push_entry(playlist, (i & 3) == 3 ? i / 2 : i);
+   printf("%u entries, %u pushes: %8.2f ms\n", BENCH_ENTRIES,
+         BENCH_ENTRIES + BENCH_ENTRIES / 4, (get_time() - start) * 1000.0);
+
+   if (!check_lookups(playlist, BENCH_ENTRIES + BENCH_ENTRIES / 4))
+      goto end;
+
+   content_playlist_write_file(playlist);
+   free(playlist->conf_path);
+   playlist->conf_path = strdup(compact_path);
+   playlist->compact   = true;
+   content_playlist_write_file(playlist);
+
+   start = get_time();
+   if (read_lines(text_path) != playlist->size)
+      goto end;
+   printf("Load %-12s %8.2f ms\n", "text, before", (get_time() - start) * 1000.0);
+
+   if (!(text = load(text_path, "text", (unsigned)playlist->size)))
+      goto end;
+   if (!(compact = load(compact_path, "compact", (unsigned)playlist->size)))
+      goto end;
+
+   if (!write_crlf(text_path, crlf_path))
+      goto end;
+   if (!(crlf = load(crlf_path, "text, CRLF", (unsigned)playlist->size)))
+      goto end;
+
+   if (!entries_equal(playlist, text) || !entries_equal(text, compact)
+         || !entries_equal(text, crlf))
+   {
+      fprintf(stderr, "Loaded entries differ.\n");
+      goto end;
+   }
+
+   if (!check_lookups(crlf, BENCH_ENTRIES + BENCH_ENTRIES / 4))
+      goto end;
+
+   start = get_time();
+   for (i = 0; i < BENCH_LOOKUPS; i++)
+   {
+      char path[512];
+      size_t idx;
+      entry_path(path, sizeof(path), i * 7 % BENCH_ENTRIES);
+      hits += walk_path(compact, path, &idx);
+   }
+   printf("Path walk:        %8.1f lookups/s (%u hits)\n",
+         BENCH_LOOKUPS / (get_time() - start), (unsigned)hits);
+
+   hits  = 0;
+   start = get_time();
+   for (i = 0; i < BENCH_LOOKUPS; i++)
+   {
+      char path[512];
+      char *found = NULL;
+      entry_path(path, sizeof(path), i * 7 % BENCH_ENTRIES);
+      content_playlist_get_index_by_path(compact, path,
+            &found, NULL, NULL, NULL, NULL, NULL);
+      hits += found != NULL;
+   }
+   printf("Path index:       %8.1f lookups/s (%u hits)\n",
+         BENCH_LOOKUPS / (get_time() - start), (unsigned)hits);
+
+   /* Repeats bump an entry to the top, new ones evict the last. */
+   start = get_time();
+   for (i = 0; i < BENCH_PUSHES; i++)
+      push_entry(compact, (i & 1) ? i * 7 % BENCH_ENTRIES : BENCH_ENTRIES * 2 + i);
+   printf("Push:             %8.1f pushes/s\n",
+         BENCH_PUSHES / (get_time() - start));
+
+   /* Sorting moves every entry, so the indexes are rebuilt. */
+   content_playlist_qsort(compact, sort_label);
+
+   if (!check_lookups(compact, BENCH_ENTRIES * 2 + BENCH_PUSHES))
+      goto end;
+
+   ret = 0;
+
+end:
+   content_playlist_free(playlist);
+   content_playlist_free(text);
+   content_playlist_free(compact);
+   content_playlist_free(crlf);
+   remove(text_path);
+   remove(compact_path);
+   remove(crlf_path);
+   return ret;
+}
@@ -0,0 +1,176 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2014-2015 - Alfred Agrell
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Microbenchmark for the rewind delta compressor.
+ * Runs every compiled-in SIMD variant over synthetic save states
+ * and reports throughput in MB/s, then compares synchronous and
+ * threaded pushes through the state manager. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../libretro.h"
+#include "../rewind.h"
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+/* Emulates a frame of a core: a couple of hot areas
+ * (work RAM, registers) change, the rest stays put. */
+static void mutate_state(uint8_t *state, size_t size, unsigned frame)
+{
+   unsigned i;
+
+   for (i = 0; i < 64; i++)
+   {
+      size_t run = 16 + (rand() % 256);
+      size_t pos = rand() % (size - run);
+      memset(state + pos, (int)(frame + i), run);
+   }
+}
+
+static void bench_kernel(const char *ident, uint64_t simd_mask,
+      size_t size, unsigned frames)
+{
+   unsigned i;
+   double start, elapsed;
+   size_t total_patch = 0;
+   uint8_t *prev      = (uint8_t*)state_manager_raw_alloc(size, 0);
+   uint8_t *next      = (uint8_t*)state_manager_raw_alloc(size, 1);
+   uint8_t *patch     = (uint8_t*)malloc(state_manager_raw_maxsize(size));
+
+   state_manager_raw_init_simd(simd_mask);
+   srand(0);
+
+   for (i = 0; i < size; i++)
+      prev[i] = rand();
+   memcpy(next, prev, size);
+
+   elapsed = 0.0;
+
+   for (i = 0; i < frames; i++)
+   {
+      uint8_t *tmp;
+      mutate_state(next, size, i);
+
+      start        = get_time();
+      total_patch += state_manager_raw_compress(prev, next, size, patch);
+      elapsed     += get_time() - start;
+
+      /* Patch applied to the new state must give back the old one. */
+      if (i == 0)
+      {
+         uint8_t *check = (uint8_t*)malloc(size);
+         memcpy(check, next, size);
+         state_manager_raw_decompress(patch, 0, check, size);
+         if (memcmp(check, prev, size) != 0)
+            fprintf(stderr, "[%s]: Patch does not round-trip!\n", ident);
+         free(check);
+      }
+
+      memcpy(prev, next, size);
+      tmp  = prev;
+      prev = next;
+      next = tmp;
+      memcpy(next, prev, size);
+   }
+
+   printf("%-8s %8.1f MB/s (avg patch %u bytes)\n", ident,
+         (double)size * frames / elapsed / 1000000.0,
+         (unsigned)(total_patch / frames));
+
+   free(prev);
+   free(next);
+   free(patch);
+}
+
+static void bench_push(bool threaded, size_t size, unsigned frames)
+{
+   unsigned i;
+   double start;
+   uint8_t *core_state    = (uint8_t*)malloc(size);
+   state_manager_t *state = state_manager_new(size, size * 64, threaded, 0, NULL);
+
+   if (!state || !core_state)
+   {
+      fprintf(stderr, "Failed to create state manager.\n");
+      goto end;
+   }
+
+   srand(0);
+   for (i = 0; i < size; i++)
+      core_state[i] = rand();
+
+   start = get_time();
+
+   for (i = 0; i < frames; i++)
+   {
+      void *where = NULL;
+
+      mutate_state(core_state, size, i);
+
+      state_manager_push_where(state, &where);
+      memcpy(where, core_state, size);
+      state_manager_push_do(state);
+   }
+
+   printf("%-8s %8.1f frames/s\n", threaded ? "threaded" : "sync",
+         frames / (get_time() - start));
+
+end:
+   state_manager_free(state);
+   free(core_state);
+}
+
+int main(int argc, char *argv[])
+{
+   size_t size     = 4 * 1024 * 1024;
+   unsigned frames = 200;
+
+   if (argc > 1)
+      size   = strtoul(argv[1], NULL, 0) * 1024;
+   if (argc > 2)
+      frames = strtoul(argv[2], NULL, 0);
+
+   if (size < 4096 || !frames)
+   {
+      fprintf(stderr, "Usage: %s [state size in KiB] [frames]\n", argv[0]);
+      return 1;
+   }
+
+   printf("State size: %u KiB, %u frames.\n", (unsigned)(size / 1024), frames);
+
+   bench_kernel("baseline", 0, size, frames);
+#if defined(__AVX2__)
+   bench_kernel("avx2", RETRO_SIMD_AVX2, size, frames);
+#endif
+#if defined(__ARM_NEON__)
+   bench_kernel("neon", RETRO_SIMD_NEON, size, frames);
+#endif
+
+   state_manager_raw_init_simd(~UINT64_C(0));
+   bench_push(false, size, frames);
+#ifdef HAVE_THREADS
+   bench_push(true, size, frames);
+#endif
+
+   return 0;
+}
@@ -0,0 +1,173 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the streaming hashes against known CRC32, MD5 and SHA1
+ * values, then hashes a generated file with rhash_file() and compares
+ * the result with hashing the whole file from memory, the way the
+ * scanner and cheevos used to. Reports MB/s for both. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <boolean.h>
+#include <rhash.h>
+
+#define BENCH_FILE_SIZE   (64 * 1024 * 1024)
+#define BENCH_DIR         "/tmp"
+
+#define RHASH_ALL (RHASH_CRC32 | RHASH_MD5 | RHASH_SHA1)
+
+struct hash_vector
+{
+   const char *data;
+   unsigned repeat;
+   uint32_t crc32;
+   const char *md5;
+   const char *sha1;
+};
+
+static const struct hash_vector vectors[] = {
+   { "", 1, 0x00000000,
+      "d41d8cd98f00b204e9800998ecf8427e",
+      "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+   { "123456789", 1, 0xcbf43926,
+      "25f9e794323b453885f5181f1b624d0b",
+      "f7c3bc1d808e04732adf679965ccc34ca7ae3441" },
+   { "The quick brown fox jumps over the lazy dog", 1, 0x414fa339,
+      "9e107d9d372bb6826bd81d3542a419d6",
+      "2fd4e1c67a2d28fced849ee1bb76e7391b93eb12" },
+   { "a", 1000000, 0xdc25bfbc,
+      "7707d6ae4e027c70eea2a935c2296f21",
+      "34aa973cd4c4daa4f61eeb2bdbad27316534016f" },
+};
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void to_hex(char *out, const uint8_t *in, size_t size)
+{
+   size_t i;
+
+   for (i = 0; i < size; i++)
+      sprintf(out + i * 2, "%02x", (unsigned)in[i]);
+}
+
+static bool check_vector(const struct hash_vector *vec)
+{
+   unsigned i;
+   char md5[33], sha1[41];
+   rhash_ctx_t ctx;
+   rhash_result_t result;
+
+   rhash_init(&ctx, RHASH_ALL);
+   for (i = 0; i < vec->repeat; i++)
+      rhash_update(&ctx, vec->data, strlen(vec->data));
+   rhash_final(&ctx, &result);
+
+   to_hex(md5, result.md5, sizeof(result.md5));
+   to_hex(sha1, result.sha1, sizeof(result.sha1));
+
+   if (     result.crc32 != vec->crc32
+         || strcmp(md5, vec->md5)
+         || strcmp(sha1, vec->sha1))
+   {
+      fprintf(stderr, "Wrong hash for \"%s\" x %u.\n", vec->data, vec->repeat);
+      return false;
+   }
+
+   return true;
+}
+
+static bool run_file(const char *path, const uint8_t *data, unsigned flags,
+      const char *name)
+{
+   double start, streamed, whole;
+   rhash_ctx_t ctx;
+   rhash_result_t ref, result;
+
+   start = get_time();
+   rhash_init(&ctx, flags);
+   rhash_update(&ctx, data, BENCH_FILE_SIZE);
+   rhash_final(&ctx, &ref);
+   whole = get_time() - start;
+
+   start = get_time();
+   if (rhash_file(path, flags, &result) < 0)
+      return false;
+   streamed = get_time() - start;
+
+   if (memcmp(&ref, &result, sizeof(ref)))
+   {
+      fprintf(stderr, "%s: streamed hash differs.\n", name);
+      return false;
+   }
+
+   printf("%-16s in memory %7.1f MB/s, streamed %7.1f MB/s\n", name,
+         BENCH_FILE_SIZE / whole / 1048576.0,
+         BENCH_FILE_SIZE / streamed / 1048576.0);
+   return true;
+}
+
+int main(void)
+{
+   unsigned i;
+   char path[256];
+   FILE *file;
+   uint32_t state = 1;
+   uint8_t *data  = (uint8_t*)malloc(BENCH_FILE_SIZE);
+   int ret        = 1;
+
+   if (!data)
+      return 1;
+
+   for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+      if (!check_vector(&vectors[i]))
+         goto end;
+
+   for (i = 0; i < BENCH_FILE_SIZE; i++)
+   {
+      state   = state * 1664525 + 1013904223;
+      data[i] = (uint8_t)(state >> 24);
+   }
+
+   snprintf(path, sizeof(path), "%s/rhash-bench-%d.bin",
+         BENCH_DIR, (int)getpid());
+   file = fopen(path, "wb");
+   if (!file)
+      goto end;
+   fwrite(data, 1, BENCH_FILE_SIZE, file);
+   fclose(file);
+
+   printf("%u MB file, %u KB read buffer.\n",
+         BENCH_FILE_SIZE / 1048576, RHASH_BUFFER_SIZE / 1024);
+
+   if (     run_file(path, data, RHASH_CRC32, "CRC32")
+         && run_file(path, data, RHASH_MD5, "MD5")
+         && run_file(path, data, RHASH_ALL, "CRC32+MD5+SHA1"))
+      ret = 0;
+
+   remove(path);
+
+end:
+   free(data);
+   return ret;
+}
@@ -0,0 +1,247 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Decodes a corpus of boxart and thumbnail sized PNGs with rpng and
+ * reports the time per image. The corpus is saved with rpng first,
+ * as RGB and RGBA, and every decode is compared with the source.
+ * PNGs in the directory given on the command line, such as a
+ * thumbnails folder, are timed as well. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include <boolean.h>
+#include <formats/rpng.h>
+
+#define BENCH_RUNS        10
+#define BENCH_DIR         "/tmp"
+
+struct corpus_image
+{
+   const char *name;
+   unsigned width;
+   unsigned height;
+   bool alpha;
+};
+
+static const struct corpus_image corpus[] = {
+   { "boxart",        512,  720, false },
+   { "boxart alpha",  512,  512, true  },
+   { "snap",          320,  240, false },
+   { "title",         256,  224, false },
+   { "logo",          320,  120, true  },
+   { "icon",           64,   64, true  },
+   { "wallpaper",    1920, 1080, false },
+};
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+/* Smooth gradients with a few flat panels and some grain, which
+ * gives the encoder's filter choice every filter to pick from. */
+static uint32_t *make_image(unsigned width, unsigned height, bool alpha)
+{
+   unsigned x, y;
+   uint32_t *data = (uint32_t*)malloc(width * height * sizeof(uint32_t));
+
+   if (!data)
+      return NULL;
+
+   for (y = 0; y < height; y++)
+   {
+      for (x = 0; x < width; x++)
+      {
+         uint32_t grain = (x * 2654435761U ^ y * 40503U) >> 28;
+         uint32_t r     = ((x + y) * 255) / (width + height) + grain;
+         uint32_t g     = (y * 255) / height;
+         uint32_t b     = (x * 255) / width ^ grain;
+         uint32_t a     = alpha ? (x * 255) / width : 0xff;
+
+         if ((x / 48 + y / 80) % 5 == 0)
+            r = g = b = 0x18;
+
+         data[y * width + x] = (a << 24) | ((r & 0xff) << 16) | (g << 8) | b;
+      }
+   }
+
+   return data;
+}
+
+static bool save_image(const char *path, const uint32_t *argb,
+      unsigned width, unsigned height, bool alpha)
+{
+   unsigned i;
+   bool ret;
+   uint8_t *bgr24;
+
+   if (alpha)
+      return rpng_save_image_argb(path, argb, width, height,
+            width * sizeof(uint32_t));
+
+   bgr24 = (uint8_t*)malloc(width * height * 3);
+   if (!bgr24)
+      return false;
+
+   for (i = 0; i < width * height; i++)
+   {
+      bgr24[i * 3 + 0] = (uint8_t)(argb[i] >>  0);
+      bgr24[i * 3 + 1] = (uint8_t)(argb[i] >>  8);
+      bgr24[i * 3 + 2] = (uint8_t)(argb[i] >> 16);
+   }
+
+   ret = rpng_save_image_bgr24(path, bgr24, width, height, width * 3);
+   free(bgr24);
+   return ret;
+}
+
+/* Returns the time of one decode in milliseconds, or a negative
+ * value if it failed or didn't match @expected. */
+static double bench_file(const char *path, const uint32_t *expected,
+      unsigned width, unsigned height, unsigned runs)
+{
+   unsigned i;
+   double start = get_time();
+
+   for (i = 0; i < runs; i++)
+   {
+      uint32_t *data         = NULL;
+      unsigned loaded_width  = 0;
+      unsigned loaded_height = 0;
+
+      if (!rpng_load_image_argb(path, &data, &loaded_width, &loaded_height))
+      {
+         fprintf(stderr, "%s: can't load.\n", path);
+         return -1.0;
+      }
+
+      if (expected && (loaded_width != width || loaded_height != height
+               || memcmp(data, expected, width * height * sizeof(uint32_t))))
+      {
+         fprintf(stderr, "%s: doesn't match the source.\n", path);
+         free(data);
+         return -1.0;
+      }
+
+      free(data);
+   }
+
+   return (get_time() - start) * 1000.0 / runs;
+}
+
+static bool bench_corpus(const char *path)
+{
+   unsigned i;
+   double total = 0.0;
+
+   printf("Corpus, %u runs:\n", BENCH_RUNS);
+
+   for (i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++)
+   {
+      double ms;
+      const struct corpus_image *img = &corpus[i];
+      uint32_t *argb = make_image(img->width, img->height, img->alpha);
+
+      if (!argb)
+         return false;
+
+      if (!save_image(path, argb, img->width, img->height, img->alpha))
+      {
+         fprintf(stderr, "%s: save failed.\n", img->name);
+         free(argb);
+         return false;
+      }
+
+      ms = bench_file(path, argb, img->width, img->height, BENCH_RUNS);
+      free(argb);
+
+      if (ms < 0.0)
+         return false;
+
+      printf("%-14s %4ux%-4u %8.3f ms\n", img->name,
+            img->width, img->height, ms);
+      total += ms;
+   }
+
+   printf("%-24s %8.3f ms\n", "total", total);
+   return true;
+}
+
+static bool bench_dir(const char *dir)
+{
+   struct dirent *entry;
+   unsigned count = 0;
+   double total   = 0.0;
+   DIR *handle    = opendir(dir);
+
+   if (!handle)
+   {
+      fprintf(stderr, "%s: can't open.\n", dir);
+      return false;
+   }
+
+   while ((entry = readdir(handle)))
+   {
+      char path[1024];
+      double ms;
+      size_t len = strlen(entry->d_name);
+
+      if (len < 4 || strcmp(entry->d_name + len - 4, ".png"))
+         continue;
+
+      snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+
+      ms = bench_file(path, NULL, 0, 0, BENCH_RUNS);
+      if (ms < 0.0)
+         continue;
+
+      total += ms;
+      count++;
+   }
+
+   closedir(handle);
+
+   printf("%s: %u PNGs, %.3f ms total, %.3f ms each\n", dir, count,
+         total, count ? total / count : 0.0);
+   return true;
+}
+
+int main(int argc, char *argv[])
+{
+   char path[256];
+   int ret = 1;
+
+   snprintf(path, sizeof(path), "%s/rpng-decode-bench-%d.png",
+         BENCH_DIR, (int)getpid());
+
+   if (!bench_corpus(path))
+      goto end;
+
+   if (argc > 1 && !bench_dir(argv[1]))
+      goto end;
+
+   ret = 0;
+
+end:
+   remove(path);
+   return ret;
+}
@@ -0,0 +1,232 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Saves screenshot-like ARGB and BGR24 images with rpng at the best
+ * and fast compression levels, and reports the time and file size of
+ * each. Every file is loaded back with rpng and compared with the
+ * source, along with small and odd sizes that end up in one band or
+ * in bands of uneven height. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <boolean.h>
+#include <formats/rpng.h>
+
+#define BENCH_WIDTH       1920
+#define BENCH_HEIGHT      1080
+#define BENCH_RUNS        5
+#define BENCH_DIR         "/tmp"
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+/* Flat tiles, gradients and a little noise, roughly what a
+ * scaled up game frame looks like. */
+static uint32_t pixel(unsigned x, unsigned y, unsigned width, unsigned height)
+{
+   uint32_t r     = (x * 255) / (width  ? width  : 1);
+   uint32_t g     = (y * 255) / (height ? height : 1);
+   uint32_t b     = ((x / 24) ^ (y / 24)) & 1 ? 0xc0 : 0x30;
+   uint32_t noise = (x * 2654435761U ^ y * 40503U) >> 29;
+
+   if ((x / 96 + y / 64) % 3 == 0)
+      r = g = 0x20;
+
+   return 0xff000000 | ((r ^ noise) << 16) | (g << 8) | b;
+}
+
+static uint32_t *make_argb(unsigned width, unsigned height, bool alpha)
+{
+   unsigned x, y;
+   uint32_t *data = (uint32_t*)malloc(width * height * sizeof(uint32_t));
+
+   if (!data)
+      return NULL;
+
+   for (y = 0; y < height; y++)
+      for (x = 0; x < width; x++)
+         data[y * width + x] = pixel(x, y, width, height)
+            ^ (alpha ? (x + y) << 24 : 0);
+
+   return data;
+}
+
+static uint8_t *make_bgr24(const uint32_t *argb, unsigned width,
+      unsigned height)
+{
+   unsigned i;
+   uint8_t *data = (uint8_t*)malloc(width * height * 3);
+
+   if (!data)
+      return NULL;
+
+   for (i = 0; i < width * height; i++)
+   {
+      data[i * 3 + 0] = (uint8_t)(argb[i] >>  0);
+      data[i * 3 + 1] = (uint8_t)(argb[i] >>  8);
+      data[i * 3 + 2] = (uint8_t)(argb[i] >> 16);
+   }
+
+   return data;
+}
+
+static bool check_file(const char *path, const uint32_t *expected,
+      unsigned width, unsigned height, bool opaque)
+{
+   unsigned i;
+   uint32_t *data   = NULL;
+   unsigned loaded_width  = 0;
+   unsigned loaded_height = 0;
+   bool ret               = true;
+
+   if (!rpng_load_image_argb(path, &data, &loaded_width, &loaded_height))
+   {
+      fprintf(stderr, "%ux%u: can't load %s.\n", width, height, path);
+      return false;
+   }
+
+   if (loaded_width != width || loaded_height != height)
+   {
+      fprintf(stderr, "%ux%u: loaded as %ux%u.\n", width, height,
+            loaded_width, loaded_height);
+      ret = false;
+   }
+   else
+   {
+      for (i = 0; i < width * height; i++)
+      {
+         uint32_t want = opaque ? expected[i] | 0xff000000 : expected[i];
+
+         if (data[i] != want)
+         {
+            fprintf(stderr, "%ux%u: pixel %u is %08x, not %08x.\n",
+                  width, height, i, (unsigned)data[i], (unsigned)want);
+            ret = false;
+            break;
+         }
+      }
+   }
+
+   free(data);
+   return ret;
+}
+
+static bool check_size(const char *path, unsigned width, unsigned height)
+{
+   bool ret       = false;
+   uint32_t *argb = make_argb(width, height, true);
+   uint8_t *bgr24 = argb ? make_bgr24(argb, width, height) : NULL;
+
+   if (!bgr24)
+      goto end;
+
+   if (!rpng_save_image_argb(path, argb, width, height,
+            width * sizeof(uint32_t))
+         || !check_file(path, argb, width, height, false))
+      goto end;
+
+   if (!rpng_save_image_bgr24_level(path, bgr24, width, height,
+            width * 3, RPNG_COMPRESSION_FAST)
+         || !check_file(path, argb, width, height, true))
+      goto end;
+
+   ret = true;
+
+end:
+   free(argb);
+   free(bgr24);
+   return ret;
+}
+
+static long file_size(const char *path)
+{
+   struct stat st;
+   return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+static bool bench(const char *name, const char *path, const void *data,
+      unsigned bpp, int level, const uint32_t *expected)
+{
+   unsigned i;
+   double start = get_time();
+
+   for (i = 0; i < BENCH_RUNS; i++)
+   {
+      bool ok = bpp == 4
+         ? rpng_save_image_argb_level(path, (const uint32_t*)data,
+               BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH * 4, level)
+         : rpng_save_image_bgr24_level(path, (const uint8_t*)data,
+               BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH * 3, level);
+
+      if (!ok)
+      {
+         fprintf(stderr, "%s: save failed.\n", name);
+         return false;
+      }
+   }
+
+   printf("%-14s %8.2f ms %10ld bytes\n", name,
+         (get_time() - start) * 1000.0 / BENCH_RUNS, file_size(path));
+
+   return check_file(path, expected, BENCH_WIDTH, BENCH_HEIGHT, bpp == 3);
+}
+
+int main(void)
+{
+   static const unsigned sizes[][2] = {
+      { 1, 1 }, { 3, 5 }, { 17, 1 }, { 1, 700 },
+      { 257, 300 }, { 640, 481 }, { 1023, 769 }, { 30000, 20 },
+   };
+   unsigned i;
+   char path[256];
+   int ret        = 1;
+   uint32_t *argb = make_argb(BENCH_WIDTH, BENCH_HEIGHT, false);
+   uint8_t *bgr24 = argb ? make_bgr24(argb, BENCH_WIDTH, BENCH_HEIGHT) : NULL;
+
+   snprintf(path, sizeof(path), "%s/rpng-bench-%d.png",
+         BENCH_DIR, (int)getpid());
+
+   if (!bgr24)
+      goto end;
+
+   for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+      if (!check_size(path, sizes[i][0], sizes[i][1]))
+         goto end;
+
+   printf("%ux%u, %u runs:\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_RUNS);
+
+   if (     !bench("ARGB best",  path, argb,  4, RPNG_COMPRESSION_BEST, argb)
+         || !bench("ARGB fast",  path, argb,  4, RPNG_COMPRESSION_FAST, argb)
+         || !bench("BGR24 best", path, bgr24, 3, RPNG_COMPRESSION_BEST, argb)
+         || !bench("BGR24 fast", path, bgr24, 3, RPNG_COMPRESSION_FAST, argb))
+      goto end;
+
+   ret = 0;
+
+end:
+   remove(path);
+   free(argb);
+   free(bgr24);
+   return ret;
+}
@@ -0,0 +1,281 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmarks every pixel converter and the ARGB8888 scaler passes.
+ * Each kernel runs as plain C, as the SSE2-only build and as the
+ * kernel the CPU gets at runtime, and is reported in Mpix/s.
+ * Fails if any SIMD output differs from the C output. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <gfx/scaler/scaler.h>
+#include <gfx/scaler/scaler_int.h>
+#include <gfx/scaler/pixconv.h>
+
+/* Odd enough that every kernel also runs its tail loops. */
+#define BENCH_WIDTH       1286
+#define BENCH_HEIGHT      720
+#define BENCH_ITERATIONS  20
+
+#define BENCH_SCALE_IN_W  643
+#define BENCH_SCALE_IN_H  480
+#define BENCH_SCALE_OUT_W 1283
+#define BENCH_SCALE_OUT_H 960
+
+typedef void (*conv_func_t)(void*, const void*, int, int, int, int);
+typedef void (*horiz_func_t)(const struct scaler_ctx*, const void*, int);
+typedef void (*vert_func_t)(const struct scaler_ctx*, void*, int);
+
+#define PIXCONV_KERNELS(X) \
+   X(conv_rgb565_0rgb1555,   2, 2) \
+   X(conv_0rgb1555_rgb565,   2, 2) \
+   X(conv_0rgb1555_argb8888, 2, 4) \
+   X(conv_rgb565_argb8888,   2, 4) \
+   X(conv_argb8888_rgba4444, 4, 2) \
+   X(conv_rgba4444_argb8888, 2, 4) \
+   X(conv_rgba4444_rgb565,   2, 2) \
+   X(conv_0rgb1555_bgr24,    2, 3) \
+   X(conv_rgb565_bgr24,      2, 3) \
+   X(conv_bgr24_argb8888,    3, 4) \
+   X(conv_argb8888_0rgb1555, 4, 2) \
+   X(conv_argb8888_bgr24,    4, 3) \
+   X(conv_argb8888_abgr8888, 4, 4) \
+   X(conv_yuyv_argb8888,     2, 4)
+
+#define DECLARE_KERNEL(name, in_bpp, out_bpp) \
+   void ref_##name(void*, const void*, int, int, int, int); \
+   void sse2_##name(void*, const void*, int, int, int, int);
+
+#define LIST_KERNEL(name, in_bpp, out_bpp) \
+   { #name, { ref_##name, sse2_##name, name }, in_bpp, out_bpp },
+
+PIXCONV_KERNELS(DECLARE_KERNEL)
+
+void ref_scaler_argb8888_horiz(const struct scaler_ctx*, const void*, int);
+void ref_scaler_argb8888_vert(const struct scaler_ctx*, void*, int);
+
+struct pixconv_kernel
+{
+   const char *ident;
+   conv_func_t func[3];
+   unsigned in_bpp;
+   unsigned out_bpp;
+};
+
+static const struct pixconv_kernel kernels[] = {
+   PIXCONV_KERNELS(LIST_KERNEL)
+};
+
+static const char *variants[] = { "C", "SSE2", "runtime" };
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void fill_random(uint8_t *buf, size_t size)
+{
+   size_t i;
+   uint32_t state = 0x12345678;
+
+   for (i = 0; i < size; i++)
+   {
+      state  = state * 1664525 + 1013904223;
+      buf[i] = (uint8_t)(state >> 24);
+   }
+}
+
+static void report(const char *ident, const char *variant,
+      double elapsed, double pixels)
+{
+   printf("%-24s %-8s %9.1f Mpix/s\n", ident, variant,
+         pixels / elapsed / 1e6);
+}
+
+static bool bench_pixconv(const struct pixconv_kernel *kernel,
+      const uint8_t *input, uint8_t *output, uint8_t *ref)
+{
+   unsigned v, i;
+   int in_stride  = BENCH_WIDTH * kernel->in_bpp;
+   int out_stride = BENCH_WIDTH * kernel->out_bpp;
+   size_t size    = (size_t)out_stride * BENCH_HEIGHT;
+
+   kernel->func[0](ref, input, BENCH_WIDTH, BENCH_HEIGHT,
+         out_stride, in_stride);
+
+   for (v = 0; v < 3; v++)
+   {
+      double start;
+
+      memset(output, 0, size);
+      kernel->func[v](output, input, BENCH_WIDTH, BENCH_HEIGHT,
+            out_stride, in_stride);
+
+      if (memcmp(output, ref, size))
+      {
+         fprintf(stderr, "%s (%s) differs from C.\n",
+               kernel->ident, variants[v]);
+         return false;
+      }
+
+      start = get_time();
+      for (i = 0; i < BENCH_ITERATIONS; i++)
+         kernel->func[v](output, input, BENCH_WIDTH, BENCH_HEIGHT,
+               out_stride, in_stride);
+      report(kernel->ident, variants[v], get_time() - start,
+            (double)BENCH_WIDTH * BENCH_HEIGHT * BENCH_ITERATIONS);
+   }
+
+   return true;
+}
+
+static bool bench_scaler(enum scaler_type type, const char *ident,
+      const uint8_t *input)
+{
+   unsigned v, i;
+   struct scaler_ctx ctx = {0};
+   horiz_func_t horiz[3];
+   vert_func_t vert[3];
+   uint64_t *scaled_ref  = NULL;
+   uint32_t *output      = NULL;
+   uint32_t *output_ref  = NULL;
+   size_t scaled_size, out_size;
+   bool ret              = false;
+
+   ctx.in_width    = BENCH_SCALE_IN_W;
+   ctx.in_height   = BENCH_SCALE_IN_H;
+   ctx.in_stride   = BENCH_SCALE_IN_W * 4;
+   ctx.out_width   = BENCH_SCALE_OUT_W;
+   ctx.out_height  = BENCH_SCALE_OUT_H;
+   ctx.out_stride  = BENCH_SCALE_OUT_W * 4;
+   ctx.in_fmt      = SCALER_FMT_ARGB8888;
+   ctx.out_fmt     = SCALER_FMT_ARGB8888;
+   ctx.scaler_type = type;
+
+   if (!scaler_ctx_gen_filter(&ctx))
+      return false;
+
+   horiz[0] = ref_scaler_argb8888_horiz;
+   horiz[1] = scaler_argb8888_horiz;
+   horiz[2] = ctx.scaler_horiz;
+   vert[0]  = ref_scaler_argb8888_vert;
+   vert[1]  = scaler_argb8888_vert;
+   vert[2]  = ctx.scaler_vert;
+
+   scaled_size = (size_t)ctx.scaled.stride * ctx.scaled.height;
+   out_size    = (size_t)ctx.out_stride * ctx.out_height;
+   scaled_ref  = (uint64_t*)malloc(scaled_size);
+   output      = (uint32_t*)malloc(out_size);
+   output_ref  = (uint32_t*)malloc(out_size);
+   if (!scaled_ref || !output || !output_ref)
+      goto end;
+
+   horiz[0](&ctx, input, ctx.in_stride);
+   memcpy(scaled_ref, ctx.scaled.frame, scaled_size);
+   vert[0](&ctx, output_ref, ctx.out_stride);
+
+   for (v = 0; v < 3; v++)
+   {
+      char name[64];
+      double start;
+
+      memset(ctx.scaled.frame, 0, scaled_size);
+      horiz[v](&ctx, input, ctx.in_stride);
+      if (memcmp(ctx.scaled.frame, scaled_ref, scaled_size))
+      {
+         fprintf(stderr, "%s horizontal pass (%s) differs from C.\n",
+               ident, variants[v]);
+         goto end;
+      }
+
+      memset(output, 0, out_size);
+      vert[v](&ctx, output, ctx.out_stride);
+      if (memcmp(output, output_ref, out_size))
+      {
+         fprintf(stderr, "%s vertical pass (%s) differs from C.\n",
+               ident, variants[v]);
+         goto end;
+      }
+
+      start = get_time();
+      for (i = 0; i < BENCH_ITERATIONS; i++)
+         horiz[v](&ctx, input, ctx.in_stride);
+      snprintf(name, sizeof(name), "%s horiz", ident);
+      report(name, variants[v], get_time() - start,
+            (double)ctx.scaled.width * ctx.scaled.height * BENCH_ITERATIONS);
+
+      start = get_time();
+      for (i = 0; i < BENCH_ITERATIONS; i++)
+         vert[v](&ctx, output, ctx.out_stride);
+      snprintf(name, sizeof(name), "%s vert", ident);
+      report(name, variants[v], get_time() - start,
+            (double)ctx.out_width * ctx.out_height * BENCH_ITERATIONS);
+   }
+
+   ret = true;
+
+end:
+   free(scaled_ref);
+   free(output);
+   free(output_ref);
+   scaler_ctx_gen_reset(&ctx);
+   return ret;
+}
+
+int main(void)
+{
+   unsigned i;
+   size_t size     = (size_t)BENCH_WIDTH * BENCH_HEIGHT * 4;
+   uint8_t *input  = (uint8_t*)malloc(size);
+   uint8_t *output = (uint8_t*)malloc(size);
+   uint8_t *ref    = (uint8_t*)malloc(size);
+   int ret         = 0;
+
+   if (!input || !output || !ref)
+      return 1;
+
+   fill_random(input, size);
+
+   printf("%ux%u frames, %u iterations.\n",
+         BENCH_WIDTH, BENCH_HEIGHT, BENCH_ITERATIONS);
+
+   for (i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++)
+   {
+      if (!bench_pixconv(&kernels[i], input, output, ref))
+      {
+         ret = 1;
+         goto end;
+      }
+   }
+
+   printf("Scaling %ux%u -> %ux%u.\n",
+         BENCH_SCALE_IN_W, BENCH_SCALE_IN_H,
+         BENCH_SCALE_OUT_W, BENCH_SCALE_OUT_H);
+
+   if (     !bench_scaler(SCALER_TYPE_BILINEAR, "bilinear", input)
+         || !bench_scaler(SCALER_TYPE_SINC, "sinc", input))
+      ret = 1;
+
+end:
+   free(input);
+   free(output);
+   free(ref);
+   return ret;
+}
@@ -0,0 +1,47 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Builds the pixel converters and scaler kernels once more with
+ * every public symbol prefixed by BENCH_PREFIX, so scaler-bench can
+ * link the plain C (SCALER_NO_SIMD) and SSE2-only (SCALER_NO_AVX2)
+ * kernels next to the dispatched ones. */
+
+#define BENCH_CAT2(a, b) a##b
+#define BENCH_CAT(a, b) BENCH_CAT2(a, b)
+#define BENCH_NAME(name) BENCH_CAT(BENCH_PREFIX, name)
+
+#define conv_rgb565_0rgb1555          BENCH_NAME(conv_rgb565_0rgb1555)
+#define conv_0rgb1555_rgb565          BENCH_NAME(conv_0rgb1555_rgb565)
+#define conv_0rgb1555_argb8888        BENCH_NAME(conv_0rgb1555_argb8888)
+#define conv_rgb565_argb8888          BENCH_NAME(conv_rgb565_argb8888)
+#define conv_argb8888_rgba4444        BENCH_NAME(conv_argb8888_rgba4444)
+#define conv_rgba4444_argb8888        BENCH_NAME(conv_rgba4444_argb8888)
+#define conv_rgba4444_rgb565          BENCH_NAME(conv_rgba4444_rgb565)
+#define conv_0rgb1555_bgr24           BENCH_NAME(conv_0rgb1555_bgr24)
+#define conv_rgb565_bgr24             BENCH_NAME(conv_rgb565_bgr24)
+#define conv_bgr24_argb8888           BENCH_NAME(conv_bgr24_argb8888)
+#define conv_argb8888_0rgb1555        BENCH_NAME(conv_argb8888_0rgb1555)
+#define conv_argb8888_bgr24           BENCH_NAME(conv_argb8888_bgr24)
+#define conv_argb8888_abgr8888        BENCH_NAME(conv_argb8888_abgr8888)
+#define conv_yuyv_argb8888            BENCH_NAME(conv_yuyv_argb8888)
+#define conv_copy                     BENCH_NAME(conv_copy)
+#define scaler_argb8888_vert          BENCH_NAME(scaler_argb8888_vert)
+#define scaler_argb8888_horiz         BENCH_NAME(scaler_argb8888_horiz)
+#define scaler_argb8888_vert_avx2     BENCH_NAME(scaler_argb8888_vert_avx2)
+#define scaler_argb8888_horiz_avx2    BENCH_NAME(scaler_argb8888_horiz_avx2)
+#define scaler_argb8888_point_special BENCH_NAME(scaler_argb8888_point_special)
+
+#include "../libretro-common/gfx/scaler/pixconv.c"
+#include "../libretro-common/gfx/scaler/scaler_int.c"
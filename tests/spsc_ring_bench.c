@@ -0,0 +1,129 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Stress test for the SPSC ring used by the threaded audio drivers.
+ * A producer thread pushes a known byte pattern in odd-sized
+ * batches, the consumer checks every byte, and both block through
+ * the ring's own wait functions when it runs full or empty.
+ * Reports throughput, and fails on the first corrupted byte. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <rthreads/rthreads.h>
+#include <queues/spsc_ring.h>
+
+#define RING_SIZE     (3 * 1024)
+#define RING_BYTES    (256u * 1024 * 1024)
+#define RING_WAIT_US  1000
+
+static spsc_ring_t *ring;
+static volatile unsigned bad_offset;
+static volatile bool failed;
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static uint8_t pattern(unsigned offset)
+{
+   return (uint8_t)(offset * 7 + (offset >> 11));
+}
+
+static void producer(void *data)
+{
+   uint8_t buf[1000];
+   unsigned offset = 0;
+
+   (void)data;
+
+   while (offset < RING_BYTES && !failed)
+   {
+      unsigned i;
+      size_t written;
+      size_t size = 1 + (offset % sizeof(buf));
+
+      if (size > RING_BYTES - offset)
+         size = RING_BYTES - offset;
+
+      for (i = 0; i < size; i++)
+         buf[i] = pattern(offset + i);
+
+      written = spsc_ring_write(ring, buf, size);
+      if (!written)
+         spsc_ring_wait_write(ring, 1, RING_WAIT_US);
+      offset += written;
+   }
+}
+
+int main(void)
+{
+   double start, elapsed;
+   uint8_t buf[333];
+   unsigned offset = 0;
+   sthread_t *thread;
+
+   ring = spsc_ring_new(RING_SIZE);
+   if (!ring)
+      return 1;
+
+   start  = get_time();
+   thread = sthread_create(producer, NULL);
+   if (!thread)
+      return 1;
+
+   while (offset < RING_BYTES)
+   {
+      size_t i;
+      size_t size = spsc_ring_read(ring, buf, sizeof(buf));
+
+      if (!size)
+      {
+         spsc_ring_wait_read(ring, 1, RING_WAIT_US);
+         continue;
+      }
+
+      for (i = 0; i < size; i++, offset++)
+      {
+         if (buf[i] != pattern(offset))
+         {
+            bad_offset = offset;
+            failed     = true;
+            break;
+         }
+      }
+
+      if (failed)
+         break;
+   }
+
+   sthread_join(thread);
+   elapsed = get_time() - start;
+   spsc_ring_free(ring);
+
+   if (failed)
+   {
+      fprintf(stderr, "Corrupted byte at offset %u.\n", bad_offset);
+      return 1;
+   }
+
+   printf("%u MB through a %u byte ring: %.1f MB/s\n",
+         RING_BYTES >> 20, RING_SIZE, (RING_BYTES >> 20) / elapsed);
+   return 0;
+}
@@ -65,6 +65,7 @@ extern "C" {
 #include "../libretro-common/file/config_file.c"
 #include "../libretro-common/file/file_path.c"
 #include "../libretro-common/hash/rhash.c"
+#include "../libretro-common/utils/md5.c"
 #include "../file_path_special.c"
 #include "../libretro-common/string/string_list.c"
 #include "../libretro-common/compat/compat_strl.c"